@@ -132,6 +132,15 @@ class Compilation {
   /// Whether to keep temporary files regardless of -save-temps.
   bool ForceKeepTempFiles = false;
 
+  /// Maximum number of jobs executed concurrently. Only jobs of the device
+  /// compilations of SYCL targets which do not depend on each other are run in
+  /// parallel.
+  unsigned MaxParallelJobs = 1;
+
+  /// File the timings of the jobs are written to when jobs are executed in
+  /// parallel, or nullptr.
+  const char *JobsTimeTraceFile = nullptr;
+
 public:
   Compilation(const Driver &D, const ToolChain &DefaultToolChain,
               llvm::opt::InputArgList *Args,
@@ -236,6 +245,14 @@ public:
     PostCallback = CB;
   }
 
+  /// Sets the maximum number of independent SYCL device jobs which are
+  /// executed concurrently.
+  void setMaxParallelJobs(unsigned N) { MaxParallelJobs = N; }
+
+  /// Sets the file the timings of jobs executed in parallel are written to,
+  /// in the Chrome trace event format used by -ftime-trace.
+  void setJobsTimeTraceFile(const char *File) { JobsTimeTraceFile = File; }
+
   /// Returns the sysroot path.
   StringRef getSysRoot() const;
 
@@ -327,6 +344,23 @@ public:
               SmallVectorImpl<std::pair<int, const Command *>> &FailingCommands,
               bool LogOnly = false) const;
 
+private:
+  /// Handles the result \p Res of the execution of the command \p C, and
+  /// returns the exit status of the command. See ExecuteCommand().
+  int FinishCommand(const Command &C, int Res, const std::string &Error,
+                    bool ExecutionFailed,
+                    const Command *&FailingCommand) const;
+
+  /// Returns whether ExecuteJobs() may run jobs of \p Jobs concurrently.
+  bool canExecuteJobsInParallel(const JobList &Jobs, bool LogOnly) const;
+
+  /// Executes \p Jobs, running jobs which do not depend on each other
+  /// concurrently. Failures are handled as in ExecuteJobs().
+  void ExecuteJobsInParallel(
+      const JobList &Jobs,
+      SmallVectorImpl<std::pair<int, const Command *>> &FailingCommands) const;
+
+public:
   /// initCompilationForDiagnostics - Remove stale state and suppress output
   /// so compilation can be reexecuted to generate additional diagnostic
   /// information (e.g., preprocessed source(s)).
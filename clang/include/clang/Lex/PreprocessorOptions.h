@@ -97,6 +97,16 @@ public:
   /// The implicit PCH included at the start of the translation unit, or empty.
   std::string ImplicitPCHInclude;
 
+  /// If non-empty, a header whose precompiled version is looked up in
+  /// ImplicitPCHCachePath, or built there, and used as the implicit PCH if
+  /// the main file starts with an include of the header. The header is parsed
+  /// as usual if no compatible PCH can be found or built.
+  std::string ImplicitPCHHeader;
+
+  /// The directory holding the precompiled versions of ImplicitPCHHeader,
+  /// one for each set of compiler options the header was built with.
+  std::string ImplicitPCHCachePath;
+
   /// Headers that will be converted to chained PCHs in memory.
   std::vector<std::string> ChainedIncludes;
 
@@ -255,6 +265,8 @@ public:
     ChainedIncludes.clear();
     DumpDeserializedPCHDecls = false;
     ImplicitPCHInclude.clear();
+    ImplicitPCHHeader.clear();
+    ImplicitPCHCachePath.clear();
     SingleFileParseMode = false;
     LexEditorPlaceholders = true;
     RetainRemappedFileBuffers = true;
@@ -16,16 +16,25 @@
 #include "clang/Driver/ToolChain.h"
 #include "clang/Driver/Util.h"
 #include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/Option/ArgList.h"
 #include "llvm/Option/OptSpecifier.h"
 #include "llvm/Option/Option.h"
 #include "llvm/Support/FileSystem.h"
+#include "llvm/Support/JSON.h"
+#include "llvm/Support/Path.h"
 #include "llvm/Support/SimpleTable.h"
+#include "llvm/Support/ThreadPool.h"
+#include "llvm/Support/Threading.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/TargetParser/Triple.h"
 #include <cassert>
+#include <chrono>
+#include <condition_variable>
 #include <fstream>
+#include <mutex>
+#include <set>
 #include <string>
 #include <system_error>
 #include <utility>
@@ -232,6 +241,12 @@ int Compilation::ExecuteCommand(const Command &C,
   std::string Error;
   bool ExecutionFailed;
   int Res = C.Execute(Redirects, &Error, &ExecutionFailed);
+  return FinishCommand(C, Res, Error, ExecutionFailed, FailingCommand);
+}
+
+int Compilation::FinishCommand(const Command &C, int Res,
+                               const std::string &Error, bool ExecutionFailed,
+                               const Command *&FailingCommand) const {
   if (PostCallback)
     PostCallback(C, Res);
   if (!Error.empty()) {
@@ -290,6 +305,9 @@ static bool InputsOk(const Command &C,
 void Compilation::ExecuteJobs(const JobList &Jobs,
                               FailingCommandList &FailingCommands,
                               bool LogOnly) const {
+  if (canExecuteJobsInParallel(Jobs, LogOnly))
+    return ExecuteJobsInParallel(Jobs, FailingCommands);
+
   // According to UNIX standard, driver need to continue compiling all the
   // inputs on the command line even one of them failed.
   // In all but CLMode, execute all the jobs unless the necessary inputs for the
@@ -309,6 +327,173 @@ void Compilation::ExecuteJobs(const JobList &Jobs,
   }
 }
 
+bool Compilation::canExecuteJobsInParallel(const JobList &Jobs,
+                                           bool LogOnly) const {
+  if (MaxParallelJobs <= 1 || Jobs.size() <= 1 || LogOnly)
+    return false;
+  // Keep the serial execution when commands are printed or diagnostics are
+  // being generated, so that the output is not interleaved, and in cl mode,
+  // which stops at the first failure.
+  if (getDriver().CCPrintOptions || getDriver().CCGenDiagnostics ||
+      getArgs().hasArg(options::OPT_v) || TheDriver.IsCLMode())
+    return false;
+  // Commands run in the driver process are not thread-safe.
+  return llvm::none_of(Jobs, [](const Command &Job) { return Job.InProcess; });
+}
+
+void Compilation::ExecuteJobsInParallel(
+    const JobList &Jobs, FailingCommandList &FailingCommands) const {
+  const size_t NumJobs = Jobs.size();
+  SmallVector<const Command *, 32> Cmds;
+  for (const auto &Job : Jobs)
+    Cmds.push_back(&Job);
+
+  // Only the jobs of SYCL device compilations run concurrently. Every other
+  // job runs on its own, after all the jobs before it and before all the jobs
+  // after it. A device job depends on the earlier jobs of the actions it is
+  // built from, which are found by walking its inputs.
+  auto IsConcurrent = [](const Command *Cmd) {
+    return Cmd->getSource().isDeviceOffloading(Action::OFK_SYCL);
+  };
+  SmallVector<llvm::SmallPtrSet<const Action *, 16>, 32> Reachable(NumJobs);
+  for (size_t I = 0; I < NumJobs; ++I) {
+    if (!IsConcurrent(Cmds[I]))
+      continue;
+    SmallVector<const Action *, 16> Worklist{&Cmds[I]->getSource()};
+    while (!Worklist.empty()) {
+      const Action *A = Worklist.pop_back_val();
+      if (Reachable[I].insert(A).second)
+        Worklist.append(A->input_begin(), A->input_end());
+    }
+  }
+  SmallVector<SmallVector<size_t, 4>, 32> Users(NumJobs);
+  SmallVector<unsigned, 32> NumPendingDeps(NumJobs, 0);
+  for (size_t I = 0; I < NumJobs; ++I)
+    for (size_t J = 0; J < I; ++J)
+      if (!IsConcurrent(Cmds[I]) || !IsConcurrent(Cmds[J]) ||
+          Reachable[I].count(&Cmds[J]->getSource())) {
+        Users[J].push_back(I);
+        ++NumPendingDeps[I];
+      }
+
+  struct JobResult {
+    int Res = 0;
+    std::string Error;
+    bool ExecutionFailed = false;
+    unsigned Lane = 0;
+    std::chrono::steady_clock::time_point Start, End;
+  };
+  SmallVector<JobResult, 32> Results(NumJobs);
+
+  // Ready jobs are started in job order. Lanes number the jobs running at the
+  // same time for the time trace.
+  std::set<size_t> Ready;
+  for (size_t I = 0; I < NumJobs; ++I)
+    if (!NumPendingDeps[I])
+      Ready.insert(I);
+  SmallVector<bool, 16> LaneBusy;
+  auto Release = [&](size_t I) {
+    for (size_t User : Users[I])
+      if (!--NumPendingDeps[User])
+        Ready.insert(User);
+  };
+
+  std::mutex Mutex;
+  std::condition_variable Finished;
+  SmallVector<size_t, 16> FinishedJobs;
+  llvm::ThreadPool Pool(llvm::hardware_concurrency(MaxParallelJobs));
+  const auto Origin = std::chrono::steady_clock::now();
+  size_t NumRunning = 0;
+  SmallVector<size_t, 32> Executed;
+  while (!Ready.empty() || NumRunning) {
+    while (!Ready.empty() && NumRunning < MaxParallelJobs) {
+      size_t I = *Ready.begin();
+      Ready.erase(Ready.begin());
+      // Skip the job if its inputs failed, as the serial execution does.
+      if (!InputsOk(*Cmds[I], FailingCommands)) {
+        Release(I);
+        continue;
+      }
+      auto FreeLane = llvm::find(LaneBusy, false);
+      Results[I].Lane = FreeLane - LaneBusy.begin();
+      if (FreeLane == LaneBusy.end())
+        LaneBusy.push_back(true);
+      else
+        *FreeLane = true;
+      ++NumRunning;
+      Pool.async([&, I] {
+        JobResult &R = Results[I];
+        R.Start = std::chrono::steady_clock::now();
+        R.Res = Cmds[I]->Execute(Redirects, &R.Error, &R.ExecutionFailed);
+        R.End = std::chrono::steady_clock::now();
+        std::lock_guard<std::mutex> Lock(Mutex);
+        FinishedJobs.push_back(I);
+        Finished.notify_one();
+      });
+    }
+    if (!NumRunning)
+      continue;
+
+    SmallVector<size_t, 16> Done;
+    {
+      std::unique_lock<std::mutex> Lock(Mutex);
+      Finished.wait(Lock, [&] { return !FinishedJobs.empty(); });
+      std::swap(Done, FinishedJobs);
+    }
+    // Results are handled on this thread, as diagnostics and the post
+    // callback are not thread-safe.
+    for (size_t I : Done) {
+      --NumRunning;
+      JobResult &R = Results[I];
+      LaneBusy[R.Lane] = false;
+      Executed.push_back(I);
+      const Command *FailingCommand = nullptr;
+      if (int Res = FinishCommand(*Cmds[I], R.Res, R.Error, R.ExecutionFailed,
+                                  FailingCommand))
+        FailingCommands.push_back(std::make_pair(Res, FailingCommand));
+      Release(I);
+    }
+  }
+
+  if (!JobsTimeTraceFile)
+    return;
+  std::error_code EC;
+  llvm::raw_fd_ostream OS(JobsTimeTraceFile, EC, llvm::sys::fs::OF_Text);
+  if (EC) {
+    getDriver().Diag(clang::diag::err_cannot_open_file)
+        << JobsTimeTraceFile << EC.message();
+    return;
+  }
+  auto Microseconds = [&](std::chrono::steady_clock::time_point T) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(T - Origin)
+        .count();
+  };
+  llvm::json::OStream J(OS);
+  J.objectBegin();
+  J.attributeBegin("traceEvents");
+  J.arrayBegin();
+  for (size_t I : Executed) {
+    const JobResult &R = Results[I];
+    const Command &Cmd = *Cmds[I];
+    J.object([&] {
+      J.attribute("pid", 1);
+      J.attribute("tid", int64_t(R.Lane));
+      J.attribute("ph", "X");
+      J.attribute("ts", Microseconds(R.Start));
+      J.attribute("dur", Microseconds(R.End) - Microseconds(R.Start));
+      J.attribute("name", llvm::sys::path::filename(Cmd.getExecutable()));
+      J.attributeObject("args", [&] {
+        J.attribute("detail", Cmd.getSource().getClassName());
+        if (!Cmd.getOutputFilenames().empty())
+          J.attribute("output", Cmd.getOutputFilenames().front());
+      });
+    });
+  }
+  J.arrayEnd();
+  J.attributeEnd();
+  J.objectEnd();
+}
+
 void Compilation::initCompilationForDiagnostics() {
   ForDiagnostics = true;
 
@@ -97,6 +97,7 @@
 #include "llvm/Support/Process.h"
 #include "llvm/Support/Program.h"
 #include "llvm/Support/StringSaver.h"
+#include "llvm/Support/Threading.h"
 #include "llvm/Support/VirtualFileSystem.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/TargetParser/Host.h"
@@ -1140,7 +1141,8 @@ void Driver::CreateOffloadingDeviceToolChains(Compilation &C,
       C.getInputArgs().getLastArg(options::OPT_fsycl_device_code_split_EQ);
   checkSingleArgValidity(SYCLLink, {"early", "image"});
   checkSingleArgValidity(DeviceCodeSplit,
-                         {"per_kernel", "per_source", "auto", "off"});
+                         {"per_kernel", "per_source", "auto", "off",
+                          "balanced"});
 
   Arg *SYCLForceTarget =
       getArgRequiringSYCLRuntime(options::OPT_fsycl_force_target_EQ);
@@ -7845,6 +7847,39 @@ void Driver::BuildJobs(Compilation &C) const {
     for (auto &J : C.getJobs())
       J.InProcess = false;
 
+  // Run the device jobs of different SYCL targets concurrently.
+  if (Arg *A = C.getArgs().getLastArg(
+          options::OPT_fsycl_max_parallel_device_jobs_EQ)) {
+    unsigned MaxJobs = 0;
+    if (StringRef(A->getValue()).getAsInteger(10, MaxJobs))
+      Diag(diag::err_drv_invalid_int_value)
+          << A->getAsString(C.getArgs()) << A->getValue();
+    else {
+      if (!MaxJobs)
+        MaxJobs = llvm::hardware_concurrency().compute_thread_count();
+      C.setMaxParallelJobs(MaxJobs);
+    }
+
+    // Record when each job ran, next to the -ftime-trace output of the
+    // compilations.
+    if (Arg *TimeTrace = C.getArgs().getLastArgNoClaim(
+            options::OPT_ftime_trace, options::OPT_ftime_trace_EQ)) {
+      SmallString<128> Path;
+      StringRef Base = FinalOutput ? FinalOutput->getValue()
+                                   : StringRef(getDefaultImageName());
+      if (TimeTrace->getOption().matches(options::OPT_ftime_trace_EQ) &&
+          llvm::sys::fs::is_directory(TimeTrace->getValue()))
+        llvm::sys::path::append(Path, TimeTrace->getValue(),
+                                llvm::sys::path::filename(Base));
+      else
+        Path = Base;
+      Path += "-jobs.json";
+      const char *TraceFile = C.getArgs().MakeArgString(Path);
+      C.setJobsTimeTraceFile(TraceFile);
+      C.addResultFile(TraceFile, nullptr);
+    }
+  }
+
   if (CCPrintProcessStats) {
     C.setPostCallback([=](const Command &Cmd, int Res) {
       std::optional<llvm::sys::ProcessStatistics> ProcStat =
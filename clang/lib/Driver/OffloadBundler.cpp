@@ -40,6 +40,7 @@
 #include "llvm/Support/ErrorOr.h"
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Parallel.h"
 #include "llvm/Support/Path.h"
 #include "llvm/Support/Program.h"
 #include "llvm/Support/Signals.h"
@@ -56,6 +57,7 @@
 #include <cstdint>
 #include <forward_list>
 #include <memory>
+#include <optional>
 #include <set>
 #include <string>
 #include <system_error>
@@ -740,6 +742,16 @@ public:
   Error ReadBundleEnd(MemoryBuffer &Input) final { return Error::success(); }
 
   Error ReadBundle(raw_ostream &OS, MemoryBuffer &Input) final {
+    Expected<StringRef> ContentOrErr = ReadBundleContents(Input);
+    if (!ContentOrErr)
+      return ContentOrErr.takeError();
+    OS.write(ContentOrErr->data(), ContentOrErr->size());
+    return Error::success();
+  }
+
+  /// Return the contents of the current bundle without copying them. The
+  /// contents refer to the input buffer.
+  Expected<StringRef> ReadBundleContents(MemoryBuffer &Input) {
     Expected<StringRef> ContentOrErr = CurrentSection->getContents();
     if (!ContentOrErr)
       return ContentOrErr.takeError();
@@ -748,9 +760,7 @@ public:
     // Copy fat object contents to the output when extracting host bundle.
     if (Content.size() == 1u && Content.front() == 0)
       Content = StringRef(Input.getBufferStart(), Input.getBufferSize());
-
-    OS.write(Content.data(), Content.size());
-    return Error::success();
+    return Content;
   }
 
   Error WriteHeader(raw_fd_ostream &OS,
@@ -988,6 +998,16 @@ public:
 };
 } // namespace
 
+/// Combine the errors of work items which were run in parallel. The errors are
+/// joined in item order, so the diagnostics do not depend on the scheduling.
+static Error joinErrorsInOrder(MutableArrayRef<std::optional<Error>> Errors) {
+  Error Result = Error::success();
+  for (std::optional<Error> &Err : Errors)
+    if (Err)
+      Result = joinErrors(std::move(Result), std::move(*Err));
+  return Result;
+}
+
 /// Archive file handler. Only unbundling is supported so far.
 class ArchiveFileHandler final : public FileHandler {
   /// Archive we are dealing with.
@@ -1018,9 +1038,21 @@ class ArchiveFileHandler final : public FileHandler {
           .Case("a", OutputType::Archive)
           .Default(OutputType::Unknown);
 
-  // Set contains indexes of Children that should be skipped during
-  // unbundling.
-  std::unordered_set<size_t> ExcludedChildIndexes;
+  /// Bundles of an object in the archive. The names and contents refer to the
+  /// input buffer, so bundles are extracted without copying them.
+  struct ObjectBundles {
+    /// Name of the archive member.
+    StringRef MemberName;
+    /// Whether the object contains an excluded target and is skipped during
+    /// unbundling.
+    bool Excluded = false;
+    /// Bundle names (<kind>-<triple>) and contents in section order.
+    SmallVector<std::pair<StringRef, StringRef>, 4u> Bundles;
+  };
+
+  /// Objects of the archive in member order. Objects are only parsed once by
+  /// ReadHeader, rather than once per extracted bundle.
+  std::vector<ObjectBundles> Objects;
 
 public:
   ArchiveFileHandler(const OffloadBundlerConfig &BC) : BundlerConfig(BC) {}
@@ -1036,50 +1068,47 @@ public:
     Ar = std::move(*ArOrErr);
 
     // Read all children.
-    ssize_t ChildIndex = -1;
+    std::vector<Archive::Child> Children;
     Error Err = Error::success();
-    for (auto &C : Ar->children(Err)) {
-      ++ChildIndex;
-      auto BinOrErr = C.getAsBinary();
-      if (!BinOrErr) {
-        if (auto Err = isNotObjectErrorInvalidFileType(BinOrErr.takeError()))
-          return Err;
-        continue;
-      }
+    for (auto &C : Ar->children(Err))
+      Children.push_back(C);
+    if (Err)
+      return Err;
 
-      auto &Bin = BinOrErr.get();
-      if (!Bin->isObject())
-        continue;
+    // Load the contents of the children serially, as loading the members of
+    // a thin archive modifies the archive.
+    std::vector<MemoryBufferRef> Contents(Children.size());
+    std::vector<std::optional<Error>> Errors(Children.size());
+    for (size_t I = 0; I < Children.size(); ++I) {
+      Expected<MemoryBufferRef> BufOrErr = Children[I].getMemoryBufferRef();
+      if (BufOrErr)
+        Contents[I] = *BufOrErr;
+      else
+        Errors[I].emplace(
+            isNotObjectErrorInvalidFileType(BufOrErr.takeError()));
+    }
 
-      auto CheckOrErr = CheckIfObjectFileContainsExcludedTargets(C);
-      if (!CheckOrErr)
-        return CheckOrErr.takeError();
+    // Scan the objects in parallel. The results are merged in member order,
+    // so that the output does not depend on the scheduling.
+    std::vector<std::optional<ObjectBundles>> Scanned(Children.size());
+    parallelFor(0, Children.size(), [&](size_t I) {
+      if (!Errors[I])
+        Errors[I].emplace(ScanChild(Children[I], Contents[I], Scanned[I]));
+    });
+    if (Error Err = joinErrorsInOrder(Errors))
+      return Err;
 
-      if (*CheckOrErr) {
+    for (size_t ChildIndex = 0; ChildIndex < Scanned.size(); ++ChildIndex) {
+      if (!Scanned[ChildIndex])
+        continue;
+      ObjectBundles &Obj = *Scanned[ChildIndex];
+      if (Obj.Excluded)
         LLVM_DEBUG(outs() << "Add child to ban list. Index: " << ChildIndex
                           << "\n");
-        ExcludedChildIndexes.emplace(ChildIndex);
-      }
-
-      auto Obj = std::unique_ptr<ObjectFile>(cast<ObjectFile>(Bin.release()));
-      auto Buf = MemoryBuffer::getMemBuffer(Obj->getMemoryBufferRef(), false);
-
-      // Collect the list of bundles from the object.
-      ObjectFileHandler OFH(std::move(Obj), BundlerConfig);
-      if (Error Err = OFH.ReadHeader(*Buf))
-        return Err;
-      Expected<std::optional<StringRef>> NameOrErr = OFH.ReadBundleStart(*Buf);
-      if (!NameOrErr)
-        return NameOrErr.takeError();
-      while (*NameOrErr) {
-        ++Bundles[**NameOrErr];
-        NameOrErr = OFH.ReadBundleStart(*Buf);
-        if (!NameOrErr)
-          return NameOrErr.takeError();
-      }
+      for (auto &Bundle : Obj.Bundles)
+        ++Bundles[Bundle.first];
+      Objects.push_back(std::move(Obj));
     }
-    if (Err)
-      return Err;
 
     CurrBundle = Bundles.end();
     NextBundle = Bundles.begin();
@@ -1113,101 +1142,50 @@ public:
       return Error::success();
     }
 
-    // Extracted objects data for archive mode.
-    SmallVector<NewArchiveMember, 8u> ArMembers;
-
-    // Read all children.
-    Error Err = Error::success();
-    ssize_t ChildIndex = -1;
-    for (auto &C : Ar->children(Err)) {
-      ++ChildIndex;
-      if (ExcludedChildIndexes.count(ChildIndex)) {
-        LLVM_DEBUG(outs() << "Skip Child. Index: " << ChildIndex << "\n");
-        continue;
-      }
-
-      auto BinOrErr = C.getAsBinary();
-      if (!BinOrErr) {
-        if (auto Err = isNotObjectErrorInvalidFileType(BinOrErr.takeError()))
-          return Err;
+    // Collect the bundle from all the objects which are not excluded.
+    SmallVector<std::pair<const ObjectBundles *, StringRef>, 8u> Extracted;
+    for (const ObjectBundles &Obj : Objects) {
+      if (Obj.Excluded) {
+        LLVM_DEBUG(outs() << "Skip Child: " << Obj.MemberName << "\n");
         continue;
       }
+      for (auto &Bundle : Obj.Bundles)
+        if (Bundle.first == CurrBundle->first())
+          Extracted.emplace_back(&Obj, Bundle.second);
+    }
 
-      auto &Bin = BinOrErr.get();
-      if (!Bin->isObject())
-        continue;
-
-      auto Obj = std::unique_ptr<ObjectFile>(cast<ObjectFile>(Bin.release()));
-      auto Buf = MemoryBuffer::getMemBuffer(Obj->getMemoryBufferRef(), false);
-
-      auto ChildNameOrErr = C.getName();
-      if (!ChildNameOrErr)
-        return ChildNameOrErr.takeError();
-
-      ObjectFileHandler OFH(std::move(Obj), BundlerConfig);
-      if (Error Err = OFH.ReadHeader(*Buf))
+    if (Mode == OutputType::FileList) {
+      // Extract the device parts to temporary files in parallel, and add
+      // their names to the output file list in member order.
+      StringRef Ext("o");
+      if (BundlerConfig.FilesType == "aocr" ||
+          BundlerConfig.FilesType == "aocx")
+        Ext = BundlerConfig.FilesType;
+      std::vector<SmallString<128u>> ChildFileNames(Extracted.size());
+      std::vector<std::optional<Error>> Errors(Extracted.size());
+      parallelFor(0, Extracted.size(), [&](size_t I) {
+        Errors[I].emplace(WriteTempFile(Ext, Extracted[I].second,
+                                        ChildFileNames[I]));
+      });
+      if (Error Err = joinErrorsInOrder(Errors))
         return Err;
-      Expected<std::optional<StringRef>> NameOrErr = OFH.ReadBundleStart(*Buf);
-      if (!NameOrErr)
-        return NameOrErr.takeError();
-      while (*NameOrErr) {
-        auto TT = **NameOrErr;
-        if (TT == CurrBundle->first()) {
-          // This is the bundle we are looking for.
-          if (Mode == OutputType::FileList) {
-            // Create temporary file where the device part will be extracted to.
-            SmallString<128u> ChildFileName;
-            StringRef Ext("o");
-            if (BundlerConfig.FilesType == "aocr" ||
-                BundlerConfig.FilesType == "aocx")
-              Ext = BundlerConfig.FilesType;
-            auto EC = sys::fs::createTemporaryFile(TempFileNameBase, Ext,
-                                                   ChildFileName);
-            if (EC)
-              return createFileError(ChildFileName, EC);
-
-            raw_fd_ostream ChildOS(ChildFileName, EC);
-            if (EC)
-              return createFileError(ChildFileName, EC);
-
-            if (Error Err = OFH.ReadBundle(ChildOS, *Buf))
-              return Err;
-
-            if (ChildOS.has_error())
-              return createFileError(ChildFileName, ChildOS.error());
-
-            // Add temporary file name with the device part to the output file
-            // list.
-            OS << ChildFileName << "\n";
-          } else if (Mode == OutputType::Object) {
-            // Extract the bundle to the output file in single file mode.
-            if (Error Err = OFH.ReadBundle(OS, *Buf))
-              return Err;
-          } else if (Mode == OutputType::Archive) {
-            // Extract the bundle to a buffer.
-            SmallVector<char> Data;
-            raw_svector_ostream ChildOS{Data};
-            if (Error Err = OFH.ReadBundle(ChildOS, *Buf))
-              return Err;
-
-            // Add new archive member.
-            NewArchiveMember &Member = ArMembers.emplace_back();
-            std::string Name = (TT + "." + *ChildNameOrErr).str();
-            Member.Buf = MemoryBuffer::getMemBufferCopy(ChildOS.str(), Name);
-            Member.MemberName = Member.Buf->getBufferIdentifier();
-          }
-          if (Error Err = OFH.ReadBundleEnd(*Buf))
-            return Err;
-        }
-        NameOrErr = OFH.ReadBundleStart(*Buf);
-        if (!NameOrErr)
-          return NameOrErr.takeError();
+      for (const SmallString<128u> &ChildFileName : ChildFileNames)
+        OS << ChildFileName << "\n";
+    } else if (Mode == OutputType::Object) {
+      // Extract the bundle to the output file in single file mode.
+      for (auto &Bundle : Extracted)
+        OS << Bundle.second;
+    } else if (Mode == OutputType::Archive) {
+      // Make the archive members refer to the bundles in the input.
+      SmallVector<NewArchiveMember, 8u> ArMembers;
+      for (auto &[Obj, Contents] : Extracted) {
+        NewArchiveMember &Member = ArMembers.emplace_back();
+        std::string Name = (CurrBundle->first() + "." + Obj->MemberName).str();
+        Member.Buf = MemoryBuffer::getMemBuffer(
+            Contents, Name, /*RequiresNullTerminator=*/false);
+        Member.MemberName = Member.Buf->getBufferIdentifier();
       }
-    }
-    if (Err)
-      return Err;
 
-    if (Mode == OutputType::Archive) {
       // Determine archive kind for the offload target.
       auto ArKind =
           getTargetTriple(CurrBundle->first(), BundlerConfig).isOSDarwin()
@@ -1243,55 +1221,75 @@ public:
   }
 
 private:
-  // NOTE: mostly a copy-paste of ReadHeader method.
-  Expected<std::vector<std::string>>
-  ReadTargetsFromChild(const Archive::Child &C) {
-    Expected<std::unique_ptr<Binary>> BinOrErr = C.getAsBinary();
+  // Reads the bundles of the archive member C with the contents Buffer into
+  // Obj, leaving it empty if the member is not an object. This is run
+  // concurrently for all members, so it must not load the contents of C.
+  Error ScanChild(const Archive::Child &C, MemoryBufferRef Buffer,
+                  std::optional<ObjectBundles> &Obj) {
+    auto BinOrErr = createBinary(Buffer);
     if (!BinOrErr)
-      return BinOrErr.takeError();
+      return isNotObjectErrorInvalidFileType(BinOrErr.takeError());
+
+    auto &Bin = BinOrErr.get();
+    if (!Bin->isObject())
+      return Error::success();
+
+    auto ChildNameOrErr = C.getName();
+    if (!ChildNameOrErr)
+      return ChildNameOrErr.takeError();
+
+    auto ObjFile =
+        std::unique_ptr<ObjectFile>(cast<ObjectFile>(Bin.release()));
+    auto Buf =
+        MemoryBuffer::getMemBuffer(ObjFile->getMemoryBufferRef(), false);
 
-    std::unique_ptr<Binary> &Bin = BinOrErr.get();
-    auto Obj = std::unique_ptr<ObjectFile>(cast<ObjectFile>(Bin.release()));
-    std::unique_ptr<MemoryBuffer> Buf =
-        MemoryBuffer::getMemBuffer(Obj->getMemoryBufferRef(), false);
-    ObjectFileHandler OFH(std::move(Obj), BundlerConfig);
+    ObjectBundles Result;
+    Result.MemberName = *ChildNameOrErr;
+    ObjectFileHandler OFH(std::move(ObjFile), BundlerConfig);
     if (Error Err = OFH.ReadHeader(*Buf))
-      return {std::move(Err)};
+      return Err;
     Expected<std::optional<StringRef>> NameOrErr = OFH.ReadBundleStart(*Buf);
     if (!NameOrErr)
       return NameOrErr.takeError();
-
-    std::vector<std::string> Targets;
     while (*NameOrErr) {
-      if (*NameOrErr)
-        Targets.emplace_back((**NameOrErr).str());
+      Expected<StringRef> ContentsOrErr = OFH.ReadBundleContents(*Buf);
+      if (!ContentsOrErr)
+        return ContentsOrErr.takeError();
+      Result.Bundles.emplace_back(**NameOrErr, *ContentsOrErr);
       NameOrErr = OFH.ReadBundleStart(*Buf);
       if (!NameOrErr)
         return NameOrErr.takeError();
     }
 
-    return Targets;
-  }
+    // Check whether one of the targets of the object is in the excluded list.
+    const auto &ExcludedTargets = BundlerConfig.ExcludedTargetNames;
+    Result.Excluded =
+        llvm::any_of(Result.Bundles, [&ExcludedTargets](const auto &Bundle) {
+          return llvm::is_contained(ExcludedTargets, Bundle.first);
+        });
 
-  // Function reads targets from Child and checks whether one of Targets
-  // is in Excluded list.
-  Expected<bool>
-  CheckIfObjectFileContainsExcludedTargets(const Archive::Child &C) {
-    if (BundlerConfig.ExcludedTargetNames.empty())
-      return false;
+    Obj = std::move(Result);
+    return Error::success();
+  }
 
-    auto TargetNamesOrErr = ReadTargetsFromChild(C);
-    if (!TargetNamesOrErr)
-      return TargetNamesOrErr.takeError();
+  // Writes Contents to a new temporary file with the extension Ext, and
+  // returns its name in FileName.
+  Error WriteTempFile(StringRef Ext, StringRef Contents,
+                      SmallString<128u> &FileName) {
+    int FD = -1;
+    if (std::error_code EC =
+            sys::fs::createTemporaryFile(TempFileNameBase, Ext, FD, FileName))
+      return createFileError(FileName, EC);
 
-    auto TargetNames = TargetNamesOrErr.get();
-    const auto &ExcludedTargets = BundlerConfig.ExcludedTargetNames;
-    return std::any_of(TargetNames.begin(), TargetNames.end(),
-                       [&ExcludedTargets](const std::string &Target) {
-                         auto It = std::find(ExcludedTargets.begin(),
-                                             ExcludedTargets.end(), Target);
-                         return It != ExcludedTargets.end();
-                       });
+    raw_fd_ostream OS(FD, /*shouldClose=*/true);
+    OS << Contents;
+    OS.close();
+    if (OS.has_error()) {
+      std::error_code EC = OS.error();
+      OS.clear_error();
+      return createFileError(FileName, EC);
+    }
+    return Error::success();
   }
 };
 
@@ -1400,12 +1398,14 @@ Error OffloadBundler::BundleFiles() {
   if (EC)
     return createFileError(BundlerConfig.OutputFileNames.front(), EC);
 
-  // Open input files.
+  // Open input files. They do not need a null terminator, which allows large
+  // inputs to be memory mapped instead of read.
   SmallVector<std::unique_ptr<MemoryBuffer>, 8u> InputBuffers;
   InputBuffers.reserve(BundlerConfig.InputFileNames.size());
   for (auto &I : BundlerConfig.InputFileNames) {
     ErrorOr<std::unique_ptr<MemoryBuffer>> CodeOrErr =
-        MemoryBuffer::getFileOrSTDIN(I);
+        MemoryBuffer::getFileOrSTDIN(I, /*IsText=*/false,
+                                     /*RequiresNullTerminator=*/false);
     if (std::error_code EC = CodeOrErr.getError())
       return createFileError(I, EC);
     InputBuffers.emplace_back(std::move(*CodeOrErr));
@@ -1445,9 +1445,12 @@ Error OffloadBundler::BundleFiles() {
 
 // Unbundle the files. Return true if an error was found.
 Error OffloadBundler::UnbundleFiles() {
-  // Open Input file.
+  // Open Input file. Bundles are extracted directly from the memory mapped
+  // input, so it does not need a null terminator.
   ErrorOr<std::unique_ptr<MemoryBuffer>> CodeOrErr =
-      MemoryBuffer::getFileOrSTDIN(BundlerConfig.InputFileNames.front());
+      MemoryBuffer::getFileOrSTDIN(BundlerConfig.InputFileNames.front(),
+                                   /*IsText=*/false,
+                                   /*RequiresNullTerminator=*/false);
   if (std::error_code EC = CodeOrErr.getError())
     return createFileError(BundlerConfig.InputFileNames.front(), EC);
 
@@ -1276,6 +1276,7 @@ void Clang::AddPreprocessingOptions(Compilation &C, const JobAction &JA,
 
   if (JA.isOffloading(Action::OFK_SYCL)) {
     toolchains::SYCLToolChain::AddSYCLIncludeArgs(D, Args, CmdArgs);
+    toolchains::SYCLToolChain::AddSYCLPCHArgs(D, Args, CmdArgs);
     if (Inputs[0].getType() == types::TY_CUDA) {
       // Include __clang_cuda_runtime_wrapper.h in .cu SYCL compilation.
       getToolChain().AddCudaIncludeArgs(Args, CmdArgs);
@@ -9734,6 +9735,15 @@ void SPIRVTranslator::ConstructJob(Compilation &C, const JobAction &JA,
         TCArgs.MakeArgString("--out-file-list=" + OutputFileName));
     ForeachArgs.push_back(
         TCArgs.MakeArgString("--out-replace=" + OutputFileName));
+    // Translate the files in the llvm-foreach process rather than spawning
+    // llvm-spirv for each of them.
+    if (TCArgs.hasFlag(options::OPT_fsycl_in_process_device_tools,
+                       options::OPT_fno_sycl_in_process_device_tools, false))
+      ForeachArgs.push_back(TCArgs.MakeArgString("--in-process"));
+    // Reuse the SPIR-V modules of previous builds for unchanged device code.
+    if (Arg *A = TCArgs.getLastArg(options::OPT_fsycl_device_code_cache_EQ))
+      ForeachArgs.push_back(
+          TCArgs.MakeArgString(Twine("--cache-dir=") + A->getValue()));
     StringRef ParallelJobs =
         TCArgs.getLastArgValue(options::OPT_fsycl_max_parallel_jobs_EQ);
     if (!ParallelJobs.empty())
@@ -9852,7 +9862,13 @@ void SYCLPostLink::ConstructJob(Compilation &C, const JobAction &JA,
       addArgs(CmdArgs, TCArgs, {"-split=source"});
     else if (CodeSplitValue == "auto")
       addArgs(CmdArgs, TCArgs, {"-split=auto"});
-    else { // Device code split is off
+    else if (CodeSplitValue == "balanced") {
+      addArgs(CmdArgs, TCArgs, {"-split=balanced"});
+      if (Arg *SizeArg = TCArgs.getLastArg(
+              options::OPT_fsycl_device_code_split_target_size_EQ))
+        CmdArgs.push_back(TCArgs.MakeArgString(
+            Twine("-split-target-size=") + SizeArg->getValue()));
+    } else { // Device code split is off
     }
   } else if (getToolChain().getTriple().getArchName() != "spir64_fpga") {
     // for FPGA targets, off is the default split mode,
@@ -9892,6 +9908,13 @@ void SYCLPostLink::ConstructJob(Compilation &C, const JobAction &JA,
     if (SplitEsimd)
       addArgs(CmdArgs, TCArgs, {"-split-esimd"});
     addArgs(CmdArgs, TCArgs, {"-lower-esimd"});
+    // Accessor arguments are only packed for SPIR-V targets, FPGA kernels
+    // keep their interfaces.
+    if (getToolChain().getTriple().isSPIR() &&
+        getToolChain().getTriple().getArchName() != "spir64_fpga" &&
+        TCArgs.hasFlag(options::OPT_fsycl_pack_accessor_args,
+                       options::OPT_fno_sycl_pack_accessor_args, false))
+      addArgs(CmdArgs, TCArgs, {"-pack-accessor-args"});
   }
   addArgs(CmdArgs, TCArgs,
           {StringRef(getSYCLPostLinkOptimizationLevel(TCArgs))});
@@ -9904,11 +9927,27 @@ void SYCLPostLink::ConstructJob(Compilation &C, const JobAction &JA,
   // Process device-globals.
   addArgs(CmdArgs, TCArgs, {"-device-globals"});
 
+  // Embed the LLVM bitcode of the device images for the kernel fusion JIT
+  // compiler. For SPIR-V targets compiled at runtime, the bitcode is stored in
+  // the device image properties, so the JIT compiler does not have to translate
+  // the SPIR-V back to LLVM IR. NVPTX targets embed the bitcode as a separate
+  // device image instead.
+  if (TCArgs.hasArg(options::OPT_fsycl_embed_ir) &&
+      getToolChain().getTriple().isSPIR() &&
+      getToolChain().getTriple().getSubArch() == llvm::Triple::NoSubArch &&
+      SYCLPostLink->getTrueType() == types::TY_Tempfiletable)
+    addArgs(CmdArgs, TCArgs, {"-embed-fusion-bitcode"});
+
   // Make ESIMD accessors use stateless memory accesses.
   if (TCArgs.hasFlag(options::OPT_fsycl_esimd_force_stateless_mem,
                      options::OPT_fno_sycl_esimd_force_stateless_mem, false))
     addArgs(CmdArgs, TCArgs, {"-lower-esimd-force-stateless-mem"});
 
+  // Reuse the results of previous builds for unchanged device code.
+  if (Arg *A = TCArgs.getLastArg(options::OPT_fsycl_device_code_cache_EQ))
+    CmdArgs.push_back(
+        TCArgs.MakeArgString(Twine("-cache-dir=") + A->getValue()));
+
   // Add output file table file option
   assert(Output.isFilename() && "output must be a filename");
   addArgs(CmdArgs, TCArgs, {"-o", Output.getFilename()});
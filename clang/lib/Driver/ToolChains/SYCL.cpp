@@ -63,7 +63,8 @@ void SYCL::constructLLVMForeachCommand(Compilation &C, const JobAction &JA,
                                        const InputInfoList &InputFiles,
                                        const InputInfo &Output, const Tool *T,
                                        StringRef Increment, StringRef Ext,
-                                       StringRef ParallelJobs) {
+                                       StringRef ParallelJobs,
+                                       StringRef CacheDir) {
   // Construct llvm-foreach command.
   // The llvm-foreach command looks like this:
   // llvm-foreach --in-file-list=a.list --in-replace='{}' -- echo '{}'
@@ -87,6 +88,8 @@ void SYCL::constructLLVMForeachCommand(Compilation &C, const JobAction &JA,
         C.getArgs().MakeArgString("--out-increment=" + Increment));
   if (!ParallelJobs.empty())
     ForeachArgs.push_back(C.getArgs().MakeArgString("--jobs=" + ParallelJobs));
+  if (!CacheDir.empty())
+    ForeachArgs.push_back(C.getArgs().MakeArgString("--cache-dir=" + CacheDir));
 
   if (C.getDriver().isSaveTempsEnabled()) {
     SmallString<128> OutputDirName;
@@ -230,6 +233,9 @@ const char *SYCL::Linker::constructLLVMLinkCommand(
     // know it is an unbundled generated list.
     if (LinkSYCLDeviceLibs) {
       Opts.push_back("-only-needed");
+      // Device libraries which provide nothing the device code needs are
+      // skipped without parsing them.
+      Opts.push_back("-skip-unneeded-device-libs");
       // FIXME remove this when opaque pointers are supported for SPIR-V
       if (!this->getToolChain().getTriple().isSPIR()) {
         Opts.push_back("-opaque-pointers");
@@ -632,8 +638,11 @@ void SYCL::gen::BackendCompiler::ConstructJob(Compilation &C,
   if (!ForeachInputs.empty()) {
     StringRef ParallelJobs =
         Args.getLastArgValue(options::OPT_fsycl_max_parallel_jobs_EQ);
+    // Reuse the device images of previous builds for unchanged device code.
+    StringRef CacheDir =
+        Args.getLastArgValue(options::OPT_fsycl_device_code_cache_EQ);
     constructLLVMForeachCommand(C, JA, std::move(Cmd), ForeachInputs, Output,
-                                this, "", "out", ParallelJobs);
+                                this, "", "out", ParallelJobs, CacheDir);
   } else
     C.addCommand(std::move(Cmd));
 }
@@ -800,8 +809,11 @@ void SYCL::x86_64::BackendCompiler::ConstructJob(
   if (!ForeachInputs.empty()) {
     StringRef ParallelJobs =
         Args.getLastArgValue(options::OPT_fsycl_max_parallel_jobs_EQ);
+    // Reuse the device images of previous builds for unchanged device code.
+    StringRef CacheDir =
+        Args.getLastArgValue(options::OPT_fsycl_device_code_cache_EQ);
     constructLLVMForeachCommand(C, JA, std::move(Cmd), ForeachInputs, Output,
-                                this, "", "out", ParallelJobs);
+                                this, "", "out", ParallelJobs, CacheDir);
   } else
     C.addCommand(std::move(Cmd));
 }
@@ -1103,6 +1115,31 @@ void SYCLToolChain::AddSYCLIncludeArgs(const clang::driver::Driver &Driver,
   CC1Args.push_back(DriverArgs.MakeArgString(P));
 }
 
+void SYCLToolChain::AddSYCLPCHArgs(const clang::driver::Driver &Driver,
+                                   const ArgList &DriverArgs,
+                                   ArgStringList &CC1Args) {
+  if (!DriverArgs.hasFlag(options::OPT_fsycl_pch, options::OPT_fno_sycl_pch,
+                          false))
+    return;
+  // The front end looks up, or builds, a PCH of sycl/sycl.hpp matching the
+  // options of the compilation in the cache directory, and parses the header
+  // as usual if there is none.
+  SmallString<128> Header(Driver.getInstalledDir());
+  llvm::sys::path::append(Header, "..", "include", "sycl", "sycl.hpp");
+  SmallString<128> CachePath;
+  if (const Arg *A =
+          DriverArgs.getLastArg(options::OPT_fsycl_pch_cache_path_EQ))
+    CachePath = A->getValue();
+  else if (llvm::sys::path::cache_directory(CachePath))
+    llvm::sys::path::append(CachePath, "sycl-pch");
+  else
+    return;
+  CC1Args.push_back("-implicit-pch-header");
+  CC1Args.push_back(DriverArgs.MakeArgString(Header));
+  CC1Args.push_back("-implicit-pch-cache-path");
+  CC1Args.push_back(DriverArgs.MakeArgString(CachePath));
+}
+
 void SYCLToolChain::AddClangSystemIncludeArgs(const ArgList &DriverArgs,
                                               ArgStringList &CC1Args) const {
   HostTC.AddClangSystemIncludeArgs(DriverArgs, CC1Args);
@@ -37,7 +37,8 @@ void constructLLVMForeachCommand(Compilation &C, const JobAction &JA,
                                  const InputInfoList &InputFiles,
                                  const InputInfo &Output, const Tool *T,
                                  StringRef Increment, StringRef Ext = "out",
-                                 StringRef ParallelJobs = "");
+                                 StringRef ParallelJobs = "",
+                                 StringRef CacheDir = "");
 bool shouldDoPerObjectFileLinking(const Compilation &C);
 // Runs llvm-spirv to convert spirv to bc, llvm-link, which links multiple LLVM
 // bitcode. Converts generated bc back to spirv using llvm-spirv, wraps with
@@ -190,6 +191,9 @@ public:
   static void AddSYCLIncludeArgs(const clang::driver::Driver &Driver,
                                  const llvm::opt::ArgList &DriverArgs,
                                  llvm::opt::ArgStringList &CC1Args);
+  static void AddSYCLPCHArgs(const clang::driver::Driver &Driver,
+                             const llvm::opt::ArgList &DriverArgs,
+                             llvm::opt::ArgStringList &CC1Args);
   void AddClangSystemIncludeArgs(const llvm::opt::ArgList &DriverArgs,
                             llvm::opt::ArgStringList &CC1Args) const override;
   void AddClangCXXStdlibIncludeArgs(
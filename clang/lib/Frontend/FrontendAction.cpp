@@ -17,6 +17,7 @@
 #include "clang/Basic/Sarif.h"
 #include "clang/Frontend/ASTUnit.h"
 #include "clang/Frontend/CompilerInstance.h"
+#include "clang/Frontend/FrontendActions.h"
 #include "clang/Frontend/FrontendDiagnostic.h"
 #include "clang/Frontend/FrontendPluginRegistry.h"
 #include "clang/Frontend/LayoutOverrideSource.h"
@@ -24,6 +25,7 @@
 #include "clang/Frontend/SARIFDiagnosticPrinter.h"
 #include "clang/Frontend/Utils.h"
 #include "clang/Lex/HeaderSearch.h"
+#include "clang/Lex/Lexer.h"
 #include "clang/Lex/LiteralSupport.h"
 #include "clang/Lex/Preprocessor.h"
 #include "clang/Lex/PreprocessorOptions.h"
@@ -542,6 +544,138 @@ static Module *prepareToBuildModule(CompilerInstance &CI,
   return M;
 }
 
+/// Builds the precompiled version of the implicit PCH header into \p PCHFile
+/// with the options of \p CI. Returns true on success.
+static bool buildImplicitPCH(CompilerInstance &CI, InputKind Kind,
+                             StringRef PCHFile) {
+  auto Invocation = std::make_shared<CompilerInvocation>(CI.getInvocation());
+
+  // Only the header goes into the PCH; the integration headers and other
+  // command line includes belong to the translation unit.
+  PreprocessorOptions &PPOpts = Invocation->getPreprocessorOpts();
+  std::string Header = PPOpts.ImplicitPCHHeader;
+  PPOpts.resetNonModularOptions();
+  PPOpts.RetainRemappedFileBuffers = true;
+
+  LangOptions &LangOpts = *Invocation->getLangOpts();
+  LangOpts.IsHeaderFile = true;
+  LangOpts.SYCLIntHeader.clear();
+  LangOpts.SYCLIntFooter.clear();
+
+  FrontendOptions &FrontendOpts = Invocation->getFrontendOpts();
+  FrontendOpts.Inputs = {FrontendInputFile(Header, Kind.getHeader())};
+  FrontendOpts.OutputFile = PCHFile.str();
+  FrontendOpts.ProgramAction = frontend::GeneratePCH;
+  FrontendOpts.DisableFree = false;
+  FrontendOpts.ShowStats = false;
+  FrontendOpts.ShowTimers = false;
+  Invocation->getDependencyOutputOpts() = DependencyOutputOptions();
+  Invocation->getDiagnosticOpts().VerifyDiagnostics = 0;
+
+  // A failure to build the PCH is not an error of the compilation, which
+  // parses the header itself then.
+  CompilerInstance Instance(CI.getPCHContainerOperations(),
+                            &CI.getModuleCache());
+  Instance.setInvocation(std::move(Invocation));
+  Instance.createDiagnostics(new IgnoringDiagConsumer(),
+                             /*ShouldOwnClient=*/true);
+  Instance.createFileManager(&CI.getVirtualFileSystem());
+  GeneratePCHAction Action;
+  return Instance.ExecuteAction(Action) &&
+         !Instance.getDiagnostics().hasErrorOccurred();
+}
+
+/// Returns true if \p Input starts with an include of the implicit PCH header.
+/// Only then, the PCH is a through header for the translation unit: nothing
+/// the source file declares or defines can affect the header.
+static bool includesImplicitPCHHeaderFirst(CompilerInstance &CI,
+                                           const FrontendInputFile &Input) {
+  std::unique_ptr<llvm::MemoryBuffer> OwnedBuffer;
+  llvm::MemoryBufferRef Buffer;
+  if (Input.isBuffer()) {
+    Buffer = Input.getBuffer();
+  } else {
+    auto BufferOrErr = CI.getFileManager().getBufferForFile(Input.getFile());
+    if (!BufferOrErr)
+      return false;
+    OwnedBuffer = std::move(*BufferOrErr);
+    Buffer = *OwnedBuffer;
+  }
+
+  // Comments are skipped by the raw lexer, any other token has to be part of
+  // the #include directive.
+  Lexer RawLex(SourceLocation(), CI.getLangOpts(), Buffer.getBufferStart(),
+               Buffer.getBufferStart(), Buffer.getBufferEnd());
+  Token Tok;
+  RawLex.LexFromRawLexer(Tok);
+  if (Tok.isNot(tok::hash) || !Tok.isAtStartOfLine())
+    return false;
+  RawLex.setParsingPreprocessorDirective(true);
+  RawLex.LexFromRawLexer(Tok);
+  if (Tok.isNot(tok::raw_identifier) || Tok.getRawIdentifier() != "include")
+    return false;
+  RawLex.LexIncludeFilename(Tok);
+  if (Tok.isNot(tok::header_name) || Tok.getLength() < 2)
+    return false;
+
+  // The spelled name, e.g., sycl/sycl.hpp, has to match the last components
+  // of the path of the header.
+  StringRef Spelled(Tok.getLiteralData() + 1, Tok.getLength() - 2);
+  StringRef Header = CI.getPreprocessorOpts().ImplicitPCHHeader;
+  auto HeaderIt = llvm::sys::path::rbegin(Header);
+  auto HeaderEnd = llvm::sys::path::rend(Header);
+  for (auto It = llvm::sys::path::rbegin(Spelled),
+            End = llvm::sys::path::rend(Spelled);
+       It != End; ++It, ++HeaderIt) {
+    if (HeaderIt == HeaderEnd || *It != *HeaderIt)
+      return false;
+  }
+  return true;
+}
+
+/// Returns the precompiled version of the implicit PCH header which is
+/// compatible with the options of \p CI, building it if needed, or an empty
+/// string if there is none.
+static std::string getImplicitPCH(CompilerInstance &CI, InputKind Kind) {
+  const PreprocessorOptions &PPOpts = CI.getPreprocessorOpts();
+  // The name of the PCH reflects the options it was built with, so that the
+  // PCHs for different options can live side by side.
+  SmallString<256> PCHFile(PPOpts.ImplicitPCHCachePath);
+  llvm::sys::path::append(PCHFile,
+                          llvm::sys::path::stem(PPOpts.ImplicitPCHHeader) +
+                              "-" + CI.getInvocation().getModuleHash() +
+                              ".pch");
+
+  auto IsAcceptable = [&] {
+    return ASTReader::isAcceptableASTFile(
+        PCHFile, CI.getFileManager(), CI.getModuleCache(),
+        CI.getPCHContainerReader(), CI.getLangOpts(), CI.getTargetOpts(),
+        PPOpts, CI.getSpecificModuleCachePath(),
+        /*RequireStrictOptionMatches=*/true);
+  };
+  // Don't go through the file manager, which would remember that the file
+  // does not exist before it is built.
+  llvm::vfs::FileSystem &FS = CI.getVirtualFileSystem();
+  if (FS.exists(PCHFile) && IsAcceptable())
+    return std::string(PCHFile);
+
+  // Don't build the PCH if it can't be stored, or if building it failed
+  // before. Otherwise, every compilation would pay for building it again.
+  SmallString<256> FailedFile(PCHFile);
+  FailedFile += ".failed";
+  if (FS.exists(FailedFile) ||
+      llvm::sys::fs::create_directories(PPOpts.ImplicitPCHCachePath) ||
+      llvm::sys::fs::access(PPOpts.ImplicitPCHCachePath,
+                            llvm::sys::fs::AccessMode::Write))
+    return std::string();
+  if (!buildImplicitPCH(CI, Kind, PCHFile) || !IsAcceptable()) {
+    std::error_code EC;
+    llvm::raw_fd_ostream FailedMarker(FailedFile, EC);
+    return std::string();
+  }
+  return std::string(PCHFile);
+}
+
 /// Compute the input buffer that should be used to build the specified module.
 static std::unique_ptr<llvm::MemoryBuffer>
 getInputBufferForModule(CompilerInstance &CI, Module *M) {
@@ -762,6 +896,17 @@ bool FrontendAction::BeginSourceFile(CompilerInstance &CI,
     return true;
   }
 
+  // Look up the precompiled version of the implicit PCH header for source
+  // files which are compiled to the end and include the header first.
+  if (!CI.getPreprocessorOpts().ImplicitPCHHeader.empty() &&
+      CI.getPreprocessorOpts().ImplicitPCHInclude.empty() &&
+      Input.getKind().getFormat() == InputKind::Source &&
+      !Input.getKind().isHeader() && !Input.isPreprocessed() &&
+      !usesPreprocessorOnly() && getTranslationUnitKind() == TU_Complete &&
+      includesImplicitPCHHeaderFirst(CI, Input))
+    CI.getPreprocessorOpts().ImplicitPCHInclude =
+        getImplicitPCH(CI, Input.getKind());
+
   // If the implicit PCH include is actually a directory, rather than
   // a single file, search for a suitable PCH file in that directory.
   if (!CI.getPreprocessorOpts().ImplicitPCHInclude.empty()) {
@@ -402,6 +402,39 @@
 // CHECK-AR-TGT2-LIST: openmp-x86_64-pc-linux-gnu.{{.+}}.bundle3.o
 // CHECK-AR-TGT2-LIST: openmp-x86_64-pc-linux-gnu.{{.+}}.bundle4.o
 
+// Check that the members of regular and thin archives, which are scanned in
+// parallel, are unbundled in member order.
+// RUN: rm -rf %t.members && mkdir %t.members
+// RUN: echo 'Member 0' > %t.members/tgt0
+// RUN: echo 'Member 1' > %t.members/tgt1
+// RUN: echo 'Member 2' > %t.members/tgt2
+// RUN: echo 'Member 3' > %t.members/tgt3
+// RUN: clang-offload-bundler -type=o -targets=host-%itanium_abi_triple,openmp-powerpc64le-ibm-linux-gnu -input=%t.o -input=%t.members/tgt0 -output=%t.members/m0.o
+// RUN: clang-offload-bundler -type=o -targets=host-%itanium_abi_triple,openmp-powerpc64le-ibm-linux-gnu -input=%t.o -input=%t.members/tgt1 -output=%t.members/m1.o
+// RUN: clang-offload-bundler -type=o -targets=host-%itanium_abi_triple,openmp-powerpc64le-ibm-linux-gnu -input=%t.o -input=%t.members/tgt2 -output=%t.members/m2.o
+// RUN: clang-offload-bundler -type=o -targets=host-%itanium_abi_triple,openmp-powerpc64le-ibm-linux-gnu -input=%t.o -input=%t.members/tgt3 -output=%t.members/m3.o
+// RUN: cp %t.invalid.o %t.members/invalid.o
+// RUN: cd %t.members && llvm-ar rc fat.a m0.o m1.o m2.o m3.o invalid.o
+// RUN: cd %t.members && llvm-ar rcT thin.a m0.o m1.o m2.o m3.o invalid.o
+// RUN: cd %t.members && clang-offload-bundler -type=a -targets=openmp-powerpc64le-ibm-linux-gnu -output=fat.tgt.a -input=fat.a -unbundle
+// RUN: cd %t.members && clang-offload-bundler -type=a -targets=openmp-powerpc64le-ibm-linux-gnu -output=thin.tgt.a -input=thin.a -unbundle
+// RUN: cmp %t.members/fat.tgt.a %t.members/thin.tgt.a
+// RUN: llvm-ar t %t.members/thin.tgt.a | FileCheck %s --check-prefix=CHECK-AR-ORDER-LIST
+// RUN: llvm-ar p %t.members/thin.tgt.a | FileCheck %s --check-prefix=CHECK-AR-ORDER
+// RUN: cd %t.members && clang-offload-bundler -type=aoo -targets=openmp-powerpc64le-ibm-linux-gnu -output=fat.lst -input=fat.a -unbundle
+// RUN: cd %t.members && clang-offload-bundler -type=aoo -targets=openmp-powerpc64le-ibm-linux-gnu -output=thin.lst -input=thin.a -unbundle
+// RUN: cat `cat %t.members/fat.lst` | FileCheck %s --check-prefix=CHECK-AR-ORDER
+// RUN: cat `cat %t.members/thin.lst` | FileCheck %s --check-prefix=CHECK-AR-ORDER
+
+// CHECK-AR-ORDER-LIST: openmp-powerpc64le-ibm-linux-gnu.m0.o
+// CHECK-AR-ORDER-LIST-NEXT: openmp-powerpc64le-ibm-linux-gnu.m1.o
+// CHECK-AR-ORDER-LIST-NEXT: openmp-powerpc64le-ibm-linux-gnu.m2.o
+// CHECK-AR-ORDER-LIST-NEXT: openmp-powerpc64le-ibm-linux-gnu.m3.o
+// CHECK-AR-ORDER: Member 0
+// CHECK-AR-ORDER-NEXT: Member 1
+// CHECK-AR-ORDER-NEXT: Member 2
+// CHECK-AR-ORDER-NEXT: Member 3
+
 //
 // Check error due to missing bundles
 //
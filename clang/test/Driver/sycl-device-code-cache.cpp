@@ -0,0 +1,23 @@
+/// Verify that the device code cache directory is passed to sycl-post-link and
+/// to the llvm-foreach commands translating to SPIR-V.
+// RUN: %clang -### -fsycl -fsycl-device-code-cache=%t.cache %s 2>&1 \
+// RUN:   | FileCheck -check-prefix=CHECK-CACHE -DDIR=%t.cache %s
+// CHECK-CACHE: sycl-post-link{{.*}} "-cache-dir=[[DIR]]"
+// CHECK-CACHE: llvm-foreach{{.*}} "--cache-dir=[[DIR]]"{{.*}} "--" "{{.*}}llvm-spirv{{.*}}"
+
+/// Verify that it is also passed to the llvm-foreach commands compiling the
+/// device images ahead of time.
+// RUN: %clang -### -fsycl -fsycl-targets=spir64_gen \
+// RUN:   -fsycl-device-code-cache=%t.cache %s 2>&1 \
+// RUN:   | FileCheck -check-prefix=CHECK-CACHE-AOT -DDIR=%t.cache %s
+// RUN: %clang -### -fsycl -fsycl-targets=spir64_x86_64 \
+// RUN:   -fsycl-device-code-cache=%t.cache %s 2>&1 \
+// RUN:   | FileCheck -check-prefix=CHECK-CACHE-AOT -DDIR=%t.cache %s
+// CHECK-CACHE-AOT: sycl-post-link{{.*}} "-cache-dir=[[DIR]]"
+// CHECK-CACHE-AOT: llvm-foreach{{.*}} "--cache-dir=[[DIR]]"{{.*}} "--" "{{.*}}llvm-spirv{{.*}}"
+// CHECK-CACHE-AOT: llvm-foreach{{.*}} "--cache-dir=[[DIR]]"{{.*}} "--" "{{.*}}{{ocloc|opencl-aot}}{{.*}}"
+
+/// Verify that the cache is not used by default.
+// RUN: %clang -### -fsycl %s 2>&1 | FileCheck -check-prefix=CHECK-DEFAULT %s
+// CHECK-DEFAULT-NOT: "-cache-dir={{.*}}"
+// CHECK-DEFAULT-NOT: "--cache-dir={{.*}}"
@@ -0,0 +1,16 @@
+/// Verify that -fsycl-embed-ir makes sycl-post-link embed the bitcode of the
+/// SPIR-V device images compiled at runtime.
+// RUN: %clang -### -fsycl -fsycl-embed-ir %s 2>&1 \
+// RUN:   | FileCheck -check-prefix=CHECK-EMBED %s
+// RUN: %clang -### -fsycl -fsycl-targets=spir64 -fsycl-embed-ir %s 2>&1 \
+// RUN:   | FileCheck -check-prefix=CHECK-EMBED %s
+// CHECK-EMBED: sycl-post-link{{.*}} "-embed-fusion-bitcode"
+
+/// Verify that the bitcode is not embedded by default.
+// RUN: %clang -### -fsycl %s 2>&1 | FileCheck -check-prefix=CHECK-DEFAULT %s
+// CHECK-DEFAULT-NOT: sycl-post-link{{.*}} "-embed-fusion-bitcode"
+
+/// Verify that the bitcode is not embedded for AOT compiled device images.
+// RUN: %clang -### -fsycl -fsycl-targets=spir64_x86_64 -fsycl-embed-ir %s \
+// RUN:   2>&1 | FileCheck -check-prefix=CHECK-AOT %s
+// CHECK-AOT-NOT: sycl-post-link{{.*}} "-embed-fusion-bitcode"
@@ -0,0 +1,35 @@
+/// Check the handling of the limit of SYCL device jobs run concurrently.
+// REQUIRES: x86-registered-target
+
+// RUN: %clang -### -target x86_64-unknown-linux-gnu -fsycl \
+// RUN:   -fsycl-targets=spir64-unknown-unknown,spir64_x86_64-unknown-unknown \
+// RUN:   -fsycl-max-parallel-device-jobs=4 %s 2>&1 \
+// RUN:   | FileCheck %s -check-prefix=CHK-JOBS
+// RUN: %clang -### -target x86_64-unknown-linux-gnu -fsycl \
+// RUN:   -fsycl-targets=spir64-unknown-unknown,spir64_x86_64-unknown-unknown \
+// RUN:   -fsycl-max-parallel-device-jobs=0 %s 2>&1 \
+// RUN:   | FileCheck %s -check-prefix=CHK-JOBS
+// CHK-JOBS-NOT: error:
+// CHK-JOBS-NOT: warning: argument unused
+// CHK-JOBS: clang{{.*}} "-fsycl-is-device"
+
+// RUN: %clang -### -target x86_64-unknown-linux-gnu -fsycl \
+// RUN:   -fsycl-max-parallel-device-jobs=a %s 2>&1 \
+// RUN:   | FileCheck %s -check-prefix=CHK-INVALID
+// CHK-INVALID: error: invalid integral value 'a' in '-fsycl-max-parallel-device-jobs=a'
+
+/// Check that the jobs are run and recorded in the job time trace.
+// RUN: rm -rf %t && mkdir -p %t && cd %t
+// RUN: cp %s a.c && cp %s b.c
+// RUN: %clang -fsycl-device-only -c -ftime-trace \
+// RUN:   -fsycl-max-parallel-device-jobs=2 a.c b.c
+// RUN: ls a.bc b.bc
+// RUN: cat a.out-jobs.json \
+// RUN:   | %python -c 'import json, sys; json.dump(json.loads(sys.stdin.read()), sys.stdout, sort_keys=True, indent=2)' \
+// RUN:   | FileCheck %s -check-prefix=CHK-TRACE
+// CHK-TRACE: "traceEvents": [
+// CHK-TRACE-DAG: "output": "a.bc"
+// CHK-TRACE-DAG: "output": "b.bc"
+// CHK-TRACE-DAG: "name": "clang{{.*}}"
+// CHK-TRACE-DAG: "ph": "X"
+// CHK-TRACE-NOT: "output":
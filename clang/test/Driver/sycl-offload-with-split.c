@@ -235,6 +235,20 @@
 // CHK-PARALLEL-JOBS: llvm-foreach{{.*}} "--jobs=4" "--" "{{.*}}llvm-spirv{{.*}}"
 // CHK-PARALLEL-JOBS-AOT: llvm-foreach{{.*}} "--jobs=4" "--" "{{.*}}[[BE_COMPILER]]{{.*}}
 
+/// Check that the SPIR-V translation only runs in the llvm-foreach process on
+/// request
+// RUN: %clang -target x86_64-unknown-linux-gnu -fsycl -fsycl-in-process-device-tools -fsycl-targets=spir64-unknown-unknown %s -### 2>&1 \
+// RUN:  | FileCheck %s -check-prefixes=CHK-IN-PROCESS
+// RUN: %clang -target x86_64-unknown-linux-gnu -fsycl -fsycl-in-process-device-tools -fsycl-max-parallel-link-jobs=4 -fsycl-targets=spir64_gen-unknown-unknown %s -### 2>&1 \
+// RUN:  | FileCheck %s -check-prefixes=CHK-IN-PROCESS-JOBS
+// RUN: %clang -target x86_64-unknown-linux-gnu -fsycl -fsycl-targets=spir64-unknown-unknown %s -### 2>&1 \
+// RUN:  | FileCheck %s -check-prefixes=CHK-NO-IN-PROCESS
+// RUN: %clang -target x86_64-unknown-linux-gnu -fsycl -fsycl-in-process-device-tools -fno-sycl-in-process-device-tools -fsycl-targets=spir64-unknown-unknown %s -### 2>&1 \
+// RUN:  | FileCheck %s -check-prefixes=CHK-NO-IN-PROCESS
+// CHK-IN-PROCESS: llvm-foreach{{.*}} "--in-process" "--" "{{.*}}llvm-spirv{{.*}}"
+// CHK-IN-PROCESS-JOBS: llvm-foreach{{.*}} "--in-process" "--jobs=4" "--" "{{.*}}llvm-spirv{{.*}}"
+// CHK-NO-IN-PROCESS-NOT: "--in-process"
+
 /// ###########################################################################
 
 /// offload with multiple targets, including AOT
@@ -293,6 +307,18 @@
 // RUN:    | FileCheck %s -check-prefixes=CHK-PER-SOURCE
 // CHK-PER-SOURCE: sycl-post-link{{.*}} "-split=source"{{.*}} "-o"{{.*}}
 
+// Check -fsycl-device-code-split=balanced option passing.
+// RUN:   %clang -### -fsycl -fsycl-device-code-split=balanced %s 2>&1 \
+// RUN:    | FileCheck %s -check-prefixes=CHK-BALANCED,CHK-BALANCED-DEFAULT
+// RUN:   %clang_cl -### -fsycl -fsycl-device-code-split=balanced %s 2>&1 \
+// RUN:    | FileCheck %s -check-prefixes=CHK-BALANCED,CHK-BALANCED-DEFAULT
+// RUN:   %clang -### -fsycl -fsycl-device-code-split=balanced \
+// RUN:     -fsycl-device-code-split-target-size=500 %s 2>&1 \
+// RUN:    | FileCheck %s -check-prefixes=CHK-BALANCED,CHK-BALANCED-SIZE
+// CHK-BALANCED: sycl-post-link{{.*}} "-split=balanced"
+// CHK-BALANCED-DEFAULT-NOT: "-split-target-size={{.*}}"
+// CHK-BALANCED-SIZE-SAME: "-split-target-size=500"{{.*}} "-o"{{.*}}
+
 // Check -fsycl-device-code-split option passing.
 // RUN:   %clang -### -fsycl -fsycl-device-code-split %s 2>&1 \
 // RUN:    | FileCheck %s -check-prefixes=CHK-AUTO
@@ -0,0 +1,17 @@
+/// Check that -fsycl-pack-accessor-args is passed to sycl-post-link for
+/// SPIR-V targets only.
+// RUN: %clangxx -### -fsycl -fsycl-targets=spir64-unknown-unknown -fsycl-pack-accessor-args %s 2>&1 \
+// RUN:   | FileCheck %s --check-prefix=CHECK-PACK
+// RUN: %clangxx -### -fsycl -fsycl-targets=spir64_gen -fsycl-pack-accessor-args %s 2>&1 \
+// RUN:   | FileCheck %s --check-prefix=CHECK-PACK
+// CHECK-PACK: sycl-post-link{{.*}} "-pack-accessor-args"
+
+// RUN: %clangxx -### -fsycl -fsycl-targets=spir64-unknown-unknown %s 2>&1 \
+// RUN:   | FileCheck %s --check-prefix=CHECK-NO-PACK
+// RUN: %clangxx -### -fsycl -fsycl-targets=spir64-unknown-unknown -fsycl-pack-accessor-args -fno-sycl-pack-accessor-args %s 2>&1 \
+// RUN:   | FileCheck %s --check-prefix=CHECK-NO-PACK
+// RUN: %clangxx -### -fsycl -fsycl-targets=spir64_fpga -fsycl-pack-accessor-args %s 2>&1 \
+// RUN:   | FileCheck %s --check-prefix=CHECK-NO-PACK
+// RUN: %clangxx -### -fsycl -fsycl-targets=nvptx64-nvidia-cuda -fsycl-pack-accessor-args %s 2>&1 \
+// RUN:   | FileCheck %s --check-prefix=CHECK-NO-PACK
+// CHECK-NO-PACK-NOT: "-pack-accessor-args"
@@ -0,0 +1,17 @@
+/// Check that -fsycl-pch makes both the device and host compilations use the
+/// precompiled sycl/sycl.hpp header cache.
+// RUN: %clangxx -### -fsycl -fsycl-pch %s 2>&1 \
+// RUN:   | FileCheck %s --check-prefix=CHECK-PCH
+// CHECK-PCH: clang{{.*}} "-fsycl-is-device"{{.*}} "-implicit-pch-header" "{{.*}}include{{[/\\]+}}sycl{{[/\\]+}}sycl.hpp" "-implicit-pch-cache-path" "{{.*}}sycl-pch"
+// CHECK-PCH: clang{{.*}} "-fsycl-is-host"{{.*}} "-implicit-pch-header" "{{.*}}include{{[/\\]+}}sycl{{[/\\]+}}sycl.hpp" "-implicit-pch-cache-path" "{{.*}}sycl-pch"
+
+// RUN: %clangxx -### -fsycl -fsycl-pch -fsycl-pch-cache-path=%t-cache %s 2>&1 \
+// RUN:   | FileCheck %s -DCACHE=%t-cache --check-prefix=CHECK-CACHE
+// CHECK-CACHE: clang{{.*}} "-fsycl-is-device"{{.*}} "-implicit-pch-cache-path" "[[CACHE]]"
+// CHECK-CACHE: clang{{.*}} "-fsycl-is-host"{{.*}} "-implicit-pch-cache-path" "[[CACHE]]"
+
+// RUN: %clangxx -### -fsycl %s 2>&1 \
+// RUN:   | FileCheck %s --check-prefix=CHECK-NO-PCH
+// RUN: %clangxx -### -fsycl -fsycl-pch -fno-sycl-pch %s 2>&1 \
+// RUN:   | FileCheck %s --check-prefix=CHECK-NO-PCH
+// CHECK-NO-PCH-NOT: "-implicit-pch-header"
@@ -0,0 +1,50 @@
+// Check that the implicit PCH is only built and used for source files which
+// start with an include of the header.
+
+// RUN: rm -rf %t && split-file %s %t
+
+// RUN: %clang_cc1 -fsyntax-only -verify -I %t/include \
+// RUN:   -implicit-pch-header %t/include/sycl/sycl.hpp \
+// RUN:   -implicit-pch-cache-path %t/cache %t/first.cpp
+// RUN: ls %t/cache | FileCheck %s --check-prefix=BUILT
+// BUILT: sycl-{{.*}}.pch
+
+// The PCH is reused from the cache.
+// RUN: %clang_cc1 -fsyntax-only -verify -I %t/include \
+// RUN:   -implicit-pch-header %t/include/sycl/sycl.hpp \
+// RUN:   -implicit-pch-cache-path %t/cache %t/first.cpp
+
+// A macro defined before the include changes the meaning of the header.
+// RUN: %clang_cc1 -fsyntax-only -verify -I %t/include \
+// RUN:   -implicit-pch-header %t/include/sycl/sycl.hpp \
+// RUN:   -implicit-pch-cache-path %t/cache2 %t/macro-first.cpp
+// RUN: not ls %t/cache2
+
+// RUN: %clang_cc1 -fsyntax-only -verify -I %t/include \
+// RUN:   -implicit-pch-header %t/include/sycl/sycl.hpp \
+// RUN:   -implicit-pch-cache-path %t/cache2 %t/no-include.cpp
+// RUN: not ls %t/cache2
+
+//--- include/sycl/sycl.hpp
+#pragma once
+#ifdef SYCL_TEST_ALT
+int header_value() { return 2; }
+#else
+int header_value() { return 1; }
+#endif
+
+//--- first.cpp
+// expected-no-diagnostics
+/* Comments before the include are fine. */
+#include <sycl/sycl.hpp>
+static_assert(sizeof(header_value()) == sizeof(int), "");
+
+//--- macro-first.cpp
+// expected-no-diagnostics
+#define SYCL_TEST_ALT
+#include <sycl/sycl.hpp>
+int use() { return header_value(); }
+
+//--- no-include.cpp
+// expected-no-diagnostics
+int main() { return 0; }
@@ -43,6 +43,8 @@
 
 #include "LLVMSPIRVOpts.h"
 
+#include "llvm/Support/MemoryBufferRef.h"
+
 #include <iostream>
 #include <string>
 
@@ -106,6 +108,14 @@ std::unique_ptr<SPIRVModule> readSpirvModule(std::istream &IS,
                                              const SPIRV::TranslatorOpts &Opts,
                                              std::string &ErrMsg);
 
+/// \brief Load SPIR-V from a memory buffer as a SPIRVModule. The binary is
+/// decoded in place, without copying it to a stream first. Modules of the
+/// opposite endianness are byte-swapped at once before decoding.
+/// \returns null on failure.
+std::unique_ptr<SPIRVModule> readSpirvModule(llvm::MemoryBufferRef Buffer,
+                                             const SPIRV::TranslatorOpts &Opts,
+                                             std::string &ErrMsg);
+
 } // End namespace SPIRV
 
 namespace llvm {
@@ -129,6 +139,11 @@ bool writeSpirv(Module *M, const SPIRV::TranslatorOpts &Opts, std::ostream &OS,
 bool readSpirv(LLVMContext &C, const SPIRV::TranslatorOpts &Opts,
                std::istream &IS, Module *&M, std::string &ErrMsg);
 
+/// \brief Load SPIR-V from a memory buffer and translate to LLVM module.
+/// \returns true if succeeds.
+bool readSpirv(LLVMContext &C, const SPIRV::TranslatorOpts &Opts,
+               MemoryBufferRef Buffer, Module *&M, std::string &ErrMsg);
+
 /// \brief Partially load SPIR-V from the stream and decode only instructions
 /// needed to get information about specialization constants.
 /// \returns true if succeeds.
@@ -39,6 +39,7 @@
 #ifndef SPIRV_LLVMSPIRVOPTS_H
 #define SPIRV_LLVMSPIRVOPTS_H
 
+#include <llvm/ADT/ArrayRef.h>
 #include <llvm/ADT/SmallVector.h>
 #include <llvm/ADT/StringRef.h>
 
@@ -46,6 +47,7 @@
 #include <cstdint>
 #include <map>
 #include <optional>
+#include <string>
 #include <unordered_map>
 
 namespace llvm {
@@ -133,6 +135,10 @@ public:
 
   void setPreserveAuxData(bool ArgValue) { PreserveAuxData = ArgValue; }
 
+  // Preserves the auxiliary data in the translation to SPIR-V, which requires
+  // the SPV_KHR_non_semantic_info extension.
+  void enablePreserveAuxDataForSPIRV();
+
   void setGenKernelArgNameMDEnabled(bool ArgNameMD) {
     GenKernelArgNameMD = ArgNameMD;
   }
@@ -185,6 +191,10 @@ public:
 
   void setDebugInfoEIS(DebugInfoEIS EIS) { DebugInfoVersion = EIS; }
 
+  // Sets the debug info version emitted by the translation to SPIR-V along
+  // with the extension and DIExpressions the version requires.
+  void setDebugInfoEISForSPIRV(DebugInfoEIS EIS);
+
   bool shouldReplaceLLVMFmulAddWithOpenCLMad() const noexcept {
     return ReplaceLLVMFmulAddWithOpenCLMad;
   }
@@ -206,6 +216,10 @@ public:
   }
   BuiltinFormat getBuiltinFormat() const noexcept { return SPIRVBuiltinFormat; }
 
+  unsigned getReaderThreads() const noexcept { return ReaderThreads; }
+
+  void setReaderThreads(unsigned Threads) noexcept { ReaderThreads = Threads; }
+
 private:
   // Common translation options
   VersionNumber MaxVersion = VersionNumber::MaximumVersion;
@@ -250,8 +264,21 @@ private:
   bool PreserveAuxData = false;
 
   BuiltinFormat SPIRVBuiltinFormat = BuiltinFormat::Function;
+
+  // Number of threads translating function bodies from SPIR-V to LLVM IR.
+  unsigned ReaderThreads = 1;
 };
 
+/// Parses the values of llvm-spirv's --spirv-ext option into
+/// \p ExtensionsStatus. Each value is "+EXT_NAME" or "-EXT_NAME", where
+/// EXT_NAME is a known extension or "all"; the extensions which aren't
+/// mentioned get \p DefaultStatus. Returns false and sets \p ErrMsg if a value
+/// is malformed or names an unknown extension.
+bool parseSPIRVExtOption(llvm::ArrayRef<std::string> Values,
+                         std::optional<bool> DefaultStatus,
+                         TranslatorOpts::ExtensionsStatusMap &ExtensionsStatus,
+                         std::string &ErrMsg);
+
 } // namespace SPIRV
 
 #endif // SPIRV_LLVMSPIRVOPTS_H
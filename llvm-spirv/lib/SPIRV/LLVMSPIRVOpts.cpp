@@ -42,8 +42,11 @@
 
 #include <llvm/ADT/SmallVector.h>
 #include <llvm/ADT/StringRef.h>
+#include <llvm/ADT/Twine.h>
 #include <llvm/IR/IntrinsicInst.h>
 
+#include <map>
+
 using namespace llvm;
 using namespace SPIRV;
 
@@ -68,3 +71,60 @@ void TranslatorOpts::setSPIRVAllowUnknownIntrinsics(
     TranslatorOpts::ArgList IntrinsicPrefixList) noexcept {
   SPIRVAllowUnknownIntrinsics = IntrinsicPrefixList;
 }
+
+void TranslatorOpts::setDebugInfoEISForSPIRV(DebugInfoEIS EIS) {
+  setDebugInfoEIS(EIS);
+  if (EIS == DebugInfoEIS::NonSemantic_Shader_DebugInfo_200)
+    setAllowExtraDIExpressionsEnabled(true);
+  if (EIS == DebugInfoEIS::NonSemantic_Shader_DebugInfo_100 ||
+      EIS == DebugInfoEIS::NonSemantic_Shader_DebugInfo_200)
+    setAllowedToUseExtension(ExtensionID::SPV_KHR_non_semantic_info);
+}
+
+void TranslatorOpts::enablePreserveAuxDataForSPIRV() {
+  setPreserveAuxData(true);
+  setAllowedToUseExtension(ExtensionID::SPV_KHR_non_semantic_info);
+}
+
+bool SPIRV::parseSPIRVExtOption(
+    ArrayRef<std::string> Values, std::optional<bool> DefaultStatus,
+    TranslatorOpts::ExtensionsStatusMap &ExtensionsStatus,
+    std::string &ErrMsg) {
+  // Map name -> id for known extensions
+  std::map<StringRef, ExtensionID> ExtensionNamesMap;
+#define EXT(X) ExtensionNamesMap[#X] = ExtensionID::X;
+#include "LLVMSPIRVExtensions.inc"
+#undef EXT
+
+  for (const auto &It : ExtensionNamesMap)
+    ExtensionsStatus[It.second] = DefaultStatus;
+
+  for (StringRef ExtString : Values) {
+    if (ExtString.size() < 2 ||
+        ('+' != ExtString.front() && '-' != ExtString.front())) {
+      ErrMsg = "Invalid value of --spirv-ext, expected format is:\n"
+               "\t--spirv-ext=+EXT_NAME,-EXT_NAME";
+      return false;
+    }
+
+    StringRef ExtName = ExtString.drop_front();
+    bool ExtStatus = ('+' == ExtString.front());
+    if ("all" == ExtName) {
+      // Update status for all known extensions
+      for (const auto &It : ExtensionNamesMap)
+        ExtensionsStatus[It.second] = ExtStatus;
+      continue;
+    }
+
+    // Reject unknown extensions
+    auto It = ExtensionNamesMap.find(ExtName);
+    if (ExtensionNamesMap.end() == It) {
+      ErrMsg = ("Unknown extension '" + ExtName +
+                "' was specified via --spirv-ext option")
+                   .str();
+      return false;
+    }
+    ExtensionsStatus[It->second] = ExtStatus;
+  }
+  return true;
+}
@@ -47,6 +47,7 @@
 #include "SPIRVMDBuilder.h"
 #include "SPIRVMemAliasingINTEL.h"
 #include "SPIRVModule.h"
+#include "SPIRVStream.h"
 #include "SPIRVToLLVMDbgTran.h"
 #include "SPIRVToOCL.h"
 #include "SPIRVType.h"
@@ -58,6 +59,8 @@
 #include "llvm/ADT/SmallSet.h"
 #include "llvm/Analysis/LoopInfo.h"
 #include "llvm/BinaryFormat/Dwarf.h"
+#include "llvm/Bitcode/BitcodeReader.h"
+#include "llvm/Bitcode/BitcodeWriter.h"
 #include "llvm/IR/Constants.h"
 #include "llvm/IR/DerivedTypes.h"
 #include "llvm/IR/Dominators.h"
@@ -70,18 +73,23 @@
 #include "llvm/IR/Module.h"
 #include "llvm/IR/Type.h"
 #include "llvm/IR/TypedPointerType.h"
+#include "llvm/Linker/Linker.h"
 #include "llvm/Support/Casting.h"
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Debug.h"
+#include "llvm/Support/Endian.h"
 #include "llvm/Support/FileSystem.h"
+#include "llvm/Support/ThreadPool.h"
 
 #include <algorithm>
 #include <cstdlib>
+#include <cstring>
 #include <fstream>
 #include <functional>
 #include <iostream>
 #include <iterator>
 #include <map>
+#include <mutex>
 #include <set>
 #include <sstream>
 #include <string>
@@ -262,7 +270,9 @@ IntrinsicInst *SPIRVToLLVM::getLifetimeStartIntrinsic(Instruction *I) {
   return nullptr;
 }
 
-SPIRVErrorLog &SPIRVToLLVM::getErrorLog() { return BM->getErrorLog(); }
+SPIRVErrorLog &SPIRVToLLVM::getErrorLog() {
+  return Partition ? PartitionErrorLog : BM->getErrorLog();
+}
 
 void SPIRVToLLVM::setCallingConv(CallInst *Call) {
   Function *F = Call->getCalledFunction();
@@ -1534,8 +1544,14 @@ Value *SPIRVToLLVM::transValueWithoutDecoration(SPIRVValue *BV, Function *F,
   }
 
   case OpSpecConstantOp: {
-    auto BI =
-        createInstFromSpecConstantOp(static_cast<SPIRVSpecConstantOp *>(BV));
+    // The SPIR-V module takes ownership of the instruction, and may be read by
+    // several partitions translated in parallel.
+    static std::mutex SpecConstantOpMutex;
+    SPIRVInstruction *BI;
+    {
+      std::lock_guard<std::mutex> Lock(SpecConstantOpMutex);
+      BI = createInstFromSpecConstantOp(static_cast<SPIRVSpecConstantOp *>(BV));
+    }
     return mapValue(BV, transValue(BI, nullptr, nullptr, false));
   }
 
@@ -1543,7 +1559,9 @@ Value *SPIRVToLLVM::transValueWithoutDecoration(SPIRVValue *BV, Function *F,
     SPIRVConstantFunctionPointerINTEL *BC =
         static_cast<SPIRVConstantFunctionPointerINTEL *>(BV);
     SPIRVFunction *F = BC->getFunction();
-    BV->setName(F->getName());
+    // Partitions are named beforehand, see nameSharedValues().
+    if (!Partition)
+      BV->setName(F->getName());
     return mapValue(BV, transFunction(F));
   }
 
@@ -1585,10 +1603,22 @@ Value *SPIRVToLLVM::transValueWithoutDecoration(SPIRVValue *BV, Function *F,
     } else
       AddrSpace = SPIRSPIRVAddrSpaceMap::rmap(BS);
     // Force SPIRV BuiltIn variable's name to be __spirv_BuiltInXXXX.
-    // No matter what BV's linkage name is.
+    // No matter what BV's linkage name is. Partitions are named beforehand,
+    // see nameSharedValues().
     SPIRVBuiltinVariableKind BVKind;
-    if (BVar->isBuiltin(&BVKind))
+    if (!Partition && BVar->isBuiltin(&BVKind))
       BV->setName(prefixSPIRVName(SPIRVBuiltInNameMap::map(BVKind)));
+    // Module-scope variables are defined by the first partition only.
+    if (BS != StorageClassFunction && !ownsModuleLevelEntities()) {
+      if (LinkageTy == GlobalValue::AppendingLinkage)
+        return nullptr;
+      auto *LDecl = new GlobalVariable(
+          *M, Ty, IsConst, GlobalValue::ExternalLinkage,
+          /*Initializer=*/nullptr, BV->getName(), 0,
+          GlobalVariable::NotThreadLocal, AddrSpace);
+      promoteForLinking(LDecl, BV);
+      return mapValue(BV, LDecl);
+    }
     auto LVar = new GlobalVariable(*M, Ty, IsConst, LinkageTy,
                                    /*Initializer=*/nullptr, BV->getName(), 0,
                                    GlobalVariable::NotThreadLocal, AddrSpace);
@@ -1609,6 +1639,9 @@ Value *SPIRVToLLVM::transValueWithoutDecoration(SPIRVValue *BV, Function *F,
                              ? GlobalValue::UnnamedAddr::Global
                              : GlobalValue::UnnamedAddr::None);
     LVar->setInitializer(Initializer);
+    if (Partition && BS != StorageClassFunction &&
+        (Initializer || !LVar->hasName()))
+      promoteForLinking(LVar, BV);
 
     if (IsVectorCompute) {
       LVar->addAttribute(kVCMetadata::VCGlobalVariable);
@@ -2922,6 +2955,9 @@ Function *SPIRVToLLVM::transFunction(SPIRVFunction *BF) {
     return NewFn;
   }
 
+  if (Partition && BF->getNumBasicBlock())
+    promoteForLinking(F, BF);
+
   F->setCallingConv(IsKernel ? CallingConv::SPIR_KERNEL
                              : CallingConv::SPIR_FUNC);
   if (BF->hasDecorate(DecorationReferencedIndirectlyINTEL))
@@ -2967,6 +3003,10 @@ Function *SPIRVToLLVM::transFunction(SPIRVFunction *BF) {
     F->addRetAttr(SPIRSPIRVFuncParamAttrMap::rmap(Kind));
   });
 
+  // The body is translated by another partition.
+  if (!ownsFunctionBody(BF))
+    return F;
+
   // Creating all basic blocks before creating instructions.
   for (size_t I = 0, E = BF->getNumBasicBlock(); I != E; ++I) {
     transValue(BF->getBasicBlock(I), F, nullptr);
@@ -3175,6 +3215,37 @@ SPIRVToLLVM::SPIRVToLLVM(Module *LLVMModule, SPIRVModule *TheSPIRVModule)
   DbgTran.reset(new SPIRVToLLVMDbgTran(TheSPIRVModule, LLVMModule, this));
 }
 
+bool SPIRVToLLVM::ownsFunctionBody(SPIRVFunction *BF) const {
+  return !Partition || Partition->Functions.count(BF->getId());
+}
+
+// Gives external linkage and a name to a global value translated in parallel,
+// so that references from other partitions are resolved when linking them.
+void SPIRVToLLVM::promoteForLinking(GlobalValue *GV, SPIRVValue *BV) {
+  GlobalValue::LinkageTypes Linkage = GV->getLinkage();
+  if (Linkage == GlobalValue::AppendingLinkage)
+    return;
+  bool Unnamed = !GV->hasName();
+  if (Unnamed)
+    GV->setName("__spirv_reader_unnamed." + std::to_string(BV->getId()));
+  if (Linkage == GlobalValue::ExternalLinkage && !Unnamed)
+    return;
+  PromotedGlobals[GV->getName().str()] = {Linkage, Unnamed};
+  GV->setLinkage(GlobalValue::ExternalLinkage);
+  GV->setVisibility(GlobalValue::DefaultVisibility);
+}
+
+void SPIRVToLLVM::restorePromotedGlobals() {
+  for (const auto &It : PromotedGlobals) {
+    GlobalValue *GV = M->getNamedValue(It.first);
+    if (!GV || GV->isDeclaration())
+      continue;
+    GV->setLinkage(It.second.Linkage);
+    if (It.second.Unnamed)
+      GV->setName("");
+  }
+}
+
 std::string getSPIRVFuncSuffix(SPIRVInstruction *BI) {
   string Suffix = "";
   if (BI->getOpCode() == OpCreatePipeFromPipeStorage) {
@@ -3313,7 +3384,10 @@ bool SPIRVToLLVM::translate() {
       DbgTran->transDebugInst(EI);
   }
 
-  for (unsigned I = 0, E = BM->getNumVariables(); I != E; ++I) {
+  // The other partitions declare the global variables on demand, when their
+  // functions refer to them.
+  unsigned NumVariables = ownsModuleLevelEntities() ? BM->getNumVariables() : 0;
+  for (unsigned I = 0; I != NumVariables; ++I) {
     auto BV = BM->getVariable(I);
     if (BV->getStorageClass() != StorageClassFunction)
       transValue(BV, nullptr, nullptr);
@@ -3327,11 +3401,17 @@ bool SPIRVToLLVM::translate() {
   }
 
   for (unsigned I = 0, E = BM->getNumFunctions(); I != E; ++I) {
-    transFunction(BM->getFunction(I));
-    transUserSemantic(BM->getFunction(I));
+    SPIRVFunction *BF = BM->getFunction(I);
+    // Likewise, functions of other partitions are declared on demand.
+    if (!ownsModuleLevelEntities() && !ownsFunctionBody(BF))
+      continue;
+    transFunction(BF);
+    if (ownsModuleLevelEntities())
+      transUserSemantic(BF);
   }
 
-  transGlobalAnnotations();
+  if (ownsModuleLevelEntities())
+    transGlobalAnnotations();
 
   if (!transMetadata())
     return false;
@@ -3991,7 +4071,11 @@ bool SPIRVToLLVM::transMetadata() {
   for (unsigned I = 0, E = BM->getNumFunctions(); I != E; ++I) {
     SPIRVFunction *BF = BM->getFunction(I);
     Function *F = static_cast<Function *>(getTranslatedValue(BF));
-    assert(F && "Invalid translated function");
+    // Partitions only translate the functions they refer to.
+    if (!F) {
+      assert(!ownsModuleLevelEntities() && "Invalid translated function");
+      continue;
+    }
 
     transOCLMetadata(BF);
     transVectorComputeMetadata(BF);
@@ -4111,7 +4195,8 @@ bool SPIRVToLLVM::transMetadata() {
   MemoryModelMD->addOperand(
       getMDTwoInt(Context, static_cast<unsigned>(BM->getAddressingModel()),
                   static_cast<unsigned>(BM->getMemoryModel())));
-  createCXXStructor("llvm.global_ctors", CtorKernels);
+  if (ownsModuleLevelEntities())
+    createCXXStructor("llvm.global_ctors", CtorKernels);
   return true;
 }
 
@@ -4680,19 +4765,179 @@ std::unique_ptr<SPIRVModule> readSpirvModule(std::istream &IS,
   return readSpirvModule(IS, DefaultOpts, ErrMsg);
 }
 
+std::unique_ptr<SPIRVModule> readSpirvModule(llvm::MemoryBufferRef Buffer,
+                                             const SPIRV::TranslatorOpts &Opts,
+                                             std::string &ErrMsg) {
+  StringRef Binary = Buffer.getBuffer();
+  // The decoder reads words in host byte order, so a module of the opposite
+  // endianness is swapped as a whole instead of word by word.
+  std::vector<SPIRVWord> Swapped;
+  if (Binary.size() >= sizeof(SPIRVWord) &&
+      Binary.size() % sizeof(SPIRVWord) == 0 &&
+      support::endian::read32(Binary.data(), support::native) ==
+          sys::getSwappedBytes(static_cast<SPIRVWord>(MagicNumber))) {
+    Swapped.resize(Binary.size() / sizeof(SPIRVWord));
+    std::memcpy(Swapped.data(), Binary.data(), Binary.size());
+    for (SPIRVWord &W : Swapped)
+      sys::swapByteOrder(W);
+    Binary = StringRef(reinterpret_cast<const char *>(Swapped.data()),
+                       Binary.size());
+  }
+  SPIRVMemoryInputStream IS(Binary.data(), Binary.size());
+  return readSpirvModule(IS, Opts, ErrMsg);
+}
+
 } // namespace SPIRV
 
-std::unique_ptr<Module>
-llvm::convertSpirvToLLVM(LLVMContext &C, SPIRVModule &BM,
+// Debug information and auxiliary data are translated to module-level
+// metadata referring to the functions, so such modules are not split.
+static bool canTranslateInParallel(SPIRVModule &BM) {
+  return BM.getDebugInstVec().empty() && BM.getAuxDataInstVec().empty();
+}
+
+// Distributes the function definitions of BM over NumPartitions partitions of
+// similar size in instructions. Entry points are assigned to the first
+// partition, which translates the module-level metadata describing them.
+static std::vector<SPIRVToLLVMPartition>
+partitionFunctions(SPIRVModule &BM, unsigned NumPartitions) {
+  std::vector<SPIRVToLLVMPartition> Partitions(NumPartitions);
+  std::vector<uint64_t> Sizes(NumPartitions, 0);
+  std::vector<std::pair<uint64_t, SPIRVFunction *>> Functions;
+  for (unsigned I = 0, E = BM.getNumFunctions(); I != E; ++I) {
+    SPIRVFunction *BF = BM.getFunction(I);
+    uint64_t Size = 0;
+    for (size_t J = 0, NumBB = BF->getNumBasicBlock(); J != NumBB; ++J)
+      Size += BF->getBasicBlock(J)->getNumInst();
+    if (isKernel(BF)) {
+      Partitions[0].Functions.insert(BF->getId());
+      Sizes[0] += Size;
+    } else if (Size) {
+      Functions.emplace_back(Size, BF);
+    }
+  }
+  // Largest functions first, each to the least loaded partition.
+  std::stable_sort(
+      Functions.begin(), Functions.end(),
+      [](const auto &L, const auto &R) { return L.first > R.first; });
+  for (const auto &[Size, BF] : Functions) {
+    size_t Min = std::min_element(Sizes.begin(), Sizes.end()) - Sizes.begin();
+    Partitions[Min].Functions.insert(BF->getId());
+    Sizes[Min] += Size;
+  }
+  for (unsigned I = 0; I != NumPartitions; ++I)
+    Partitions[I].Index = I;
+  return Partitions;
+}
+
+// Gives their final names to the SPIR-V values which are renamed when they
+// are translated, as the partitions read the module concurrently.
+static void nameSharedValues(SPIRVModule &BM) {
+  for (unsigned I = 0, E = BM.getNumVariables(); I != E; ++I) {
+    SPIRVVariable *BVar = BM.getVariable(I);
+    SPIRVBuiltinVariableKind BVKind;
+    if (BVar->isBuiltin(&BVKind))
+      BVar->setName(prefixSPIRVName(SPIRVBuiltInNameMap::map(BVKind)));
+  }
+  for (unsigned I = 0, E = BM.getNumConstants(); I != E; ++I) {
+    SPIRVValue *BV = BM.getConstant(I);
+    if (BV->getOpCode() == OpConstantFunctionPointerINTEL)
+      BV->setName(static_cast<SPIRVConstantFunctionPointerINTEL *>(BV)
+                      ->getFunction()
+                      ->getName());
+  }
+}
+
+// Translates the function bodies of BM on several threads. The SPIR-V module
+// is decoded once and read by all partitions. LLVMContext is not thread-safe,
+// so every partition but the first one is translated in its own context and
+// only declares the functions and global variables it refers to. The partial
+// modules are passed back as bitcode and linked into the module of the first
+// partition in a fixed order.
+static std::unique_ptr<Module>
+translateSpirvInParallel(LLVMContext &C, SPIRVModule &BM,
                          const SPIRV::TranslatorOpts &Opts,
                          std::string &ErrMsg) {
+  std::vector<SPIRVToLLVMPartition> Partitions =
+      partitionFunctions(BM, Opts.getReaderThreads());
+  std::vector<SmallVector<char, 0>> Bitcode(Partitions.size());
+  std::vector<std::string> Errors(Partitions.size());
+  bool OpaquePointers = !C.supportsTypedPointers();
+  nameSharedValues(BM);
+
+  ThreadPool Pool(hardware_concurrency(Partitions.size() - 1));
+  for (size_t I = 1; I < Partitions.size(); ++I) {
+    Pool.async([&, I] {
+      LLVMContext PartC;
+      PartC.setOpaquePointers(OpaquePointers);
+      Module PartM("", PartC);
+      SPIRVToLLVM BTL(&PartM, &BM);
+      BTL.setPartition(&Partitions[I]);
+      if (!BTL.translate()) {
+        BTL.getErrorLog().getError(Errors[I]);
+        return;
+      }
+      // The module-level metadata comes from the first partition.
+      for (NamedMDNode &NMD : make_early_inc_range(PartM.named_metadata()))
+        PartM.eraseNamedMetadata(&NMD);
+      raw_svector_ostream OS(Bitcode[I]);
+      WriteBitcodeToFile(PartM, OS);
+    });
+  }
+
   std::unique_ptr<Module> M(new Module("", C));
   SPIRVToLLVM BTL(M.get(), &BM);
-
-  if (!BTL.translate()) {
-    BM.getError(ErrMsg);
+  BTL.setPartition(&Partitions[0]);
+  bool Translated = BTL.translate();
+  Pool.wait();
+  if (!Translated) {
+    BTL.getErrorLog().getError(ErrMsg);
     return nullptr;
   }
+  // A partition which failed has no bitcode.
+  for (size_t I = 1; I < Partitions.size(); ++I) {
+    if (Bitcode[I].empty()) {
+      ErrMsg = Errors[I];
+      return nullptr;
+    }
+  }
+
+  Linker L(*M);
+  for (size_t I = 1; I < Partitions.size(); ++I) {
+    Expected<std::unique_ptr<Module>> PartM = parseBitcodeFile(
+        MemoryBufferRef(StringRef(Bitcode[I].data(), Bitcode[I].size()), ""),
+        C);
+    if (!PartM) {
+      ErrMsg = toString(PartM.takeError());
+      return nullptr;
+    }
+    if (L.linkInModule(std::move(*PartM))) {
+      ErrMsg = "failed to link the functions translated in parallel";
+      return nullptr;
+    }
+  }
+  BTL.restorePromotedGlobals();
+  // Internal functions only became unused once they got their linkage back.
+  eraseUselessFunctions(M.get());
+  return M;
+}
+
+std::unique_ptr<Module>
+llvm::convertSpirvToLLVM(LLVMContext &C, SPIRVModule &BM,
+                         const SPIRV::TranslatorOpts &Opts,
+                         std::string &ErrMsg) {
+  std::unique_ptr<Module> M;
+  if (Opts.getReaderThreads() > 1 && canTranslateInParallel(BM)) {
+    M = translateSpirvInParallel(C, BM, Opts, ErrMsg);
+    if (!M)
+      return nullptr;
+  } else {
+    M.reset(new Module("", C));
+    SPIRVToLLVM BTL(M.get(), &BM);
+    if (!BTL.translate()) {
+      BM.getError(ErrMsg);
+      return nullptr;
+    }
+  }
 
   llvm::ModulePassManager PassMgr;
   addSPIRVBIsLoweringPass(PassMgr, Opts.getDesiredBIsRepresentation());
@@ -4736,6 +4981,24 @@ bool llvm::readSpirv(LLVMContext &C, const SPIRV::TranslatorOpts &Opts,
   return true;
 }
 
+bool llvm::readSpirv(LLVMContext &C, const SPIRV::TranslatorOpts &Opts,
+                     MemoryBufferRef Buffer, Module *&M, std::string &ErrMsg) {
+  std::unique_ptr<SPIRVModule> BM(readSpirvModule(Buffer, Opts, ErrMsg));
+
+  if (!BM)
+    return false;
+
+  M = convertSpirvToLLVM(C, *BM, Opts, ErrMsg).release();
+
+  if (!M)
+    return false;
+
+  if (DbgSaveTmpLLVM)
+    dumpLLVM(M, DbgTmpLLVMFileName);
+
+  return true;
+}
+
 bool llvm::getSpecConstInfo(std::istream &IS,
                             std::vector<SpecConstInfoTy> &SpecConstInfo) {
   std::unique_ptr<SPIRVModule> BM(SPIRVModule::createSPIRVModule());
@@ -49,6 +49,10 @@
 #include "llvm/ADT/StringSet.h"
 #include "llvm/IR/GlobalValue.h" // llvm::GlobalValue::LinkageTypes
 
+#include <map>
+#include <string>
+#include <unordered_set>
+
 namespace llvm {
 class Metadata;
 class Module;
@@ -75,10 +79,36 @@ class SPIRVConstantSampler;
 class SPIRVConstantPipeStorage;
 class SPIRVLoopMerge;
 class SPIRVToLLVMDbgTran;
+
+/// The share of a module translated by one thread of a parallel translation.
+/// All partitions read the same SPIR-V module. Every partition translates the
+/// bodies of its own functions and declares the global values they refer to.
+/// The partial modules are linked together afterwards.
+struct SPIRVToLLVMPartition {
+  /// Index of the partition. The first partition also declares all functions,
+  /// defines the global variables, translates the entry points and the
+  /// module-level metadata.
+  unsigned Index = 0;
+  /// Ids of the functions whose bodies are translated by this partition.
+  std::unordered_set<SPIRVId> Functions;
+};
+
 class SPIRVToLLVM : private BuiltinCallHelper {
 public:
   SPIRVToLLVM(Module *LLVMModule, SPIRVModule *TheSPIRVModule);
 
+  /// Translate only the share of the module described by \p P.
+  void setPartition(const SPIRVToLLVMPartition *P) { Partition = P; }
+
+  /// Restore the linkage and the names of the global values which were made
+  /// external to link the partitions, once they have been linked into the
+  /// module of the first partition.
+  void restorePromotedGlobals();
+
+  /// Partitions report errors to their own log, as the SPIR-V module and its
+  /// log are shared between the threads.
+  SPIRVErrorLog &getErrorLog();
+
   static const StringSet<> BuiltInConstFunc;
 
   /// Translate the SPIR-V type into an LLVM type. If UseTypedPointerTypes is
@@ -173,6 +203,15 @@ private:
   SPIRVBlockToLLVMStructMap BlockMap;
   SPIRVToLLVMPlaceholderMap PlaceholderMap;
   std::unique_ptr<SPIRVToLLVMDbgTran> DbgTran;
+  const SPIRVToLLVMPartition *Partition = nullptr;
+  SPIRVErrorLog PartitionErrorLog;
+  // Original linkage of the global values made external to link the
+  // partitions, indexed by name. Unnamed values are given a temporary name.
+  struct PromotedGlobal {
+    GlobalValue::LinkageTypes Linkage;
+    bool Unnamed;
+  };
+  std::map<std::string, PromotedGlobal> PromotedGlobals;
   // GlobalAnnotations collects array of annotation entries for global variables
   // and functions. They are used in translation of llvm.global.annotations
   // instruction.
@@ -216,7 +255,6 @@ private:
   Value *mapFunction(SPIRVFunction *BF, Function *F);
   Value *getTranslatedValue(SPIRVValue *BV);
   IntrinsicInst *getLifetimeStartIntrinsic(Instruction *I);
-  SPIRVErrorLog &getErrorLog();
   void setCallingConv(CallInst *Call);
   Type *transFPType(SPIRVType *T);
   Value *transShiftLogicalBitwiseInst(SPIRVValue *BV, BasicBlock *BB,
@@ -248,6 +286,12 @@ private:
   Instruction *transAllAny(SPIRVInstruction *BI, BasicBlock *BB);
   Instruction *transRelational(SPIRVInstruction *BI, BasicBlock *BB);
 
+  bool ownsFunctionBody(SPIRVFunction *BF) const;
+  bool ownsModuleLevelEntities() const {
+    return !Partition || Partition->Index == 0;
+  }
+  void promoteForLinking(GlobalValue *GV, SPIRVValue *BV);
+
   void transUserSemantic(SPIRV::SPIRVFunction *Fun);
   void transGlobalAnnotations();
   void transGlobalCtorDtors(SPIRVVariable *BV);
@@ -51,7 +51,9 @@
 #include "SPIRVValue.h"
 
 #include "llvm/ADT/APInt.h"
+#include "llvm/ADT/Hashing.h"
 
+#include <cstring>
 #include <set>
 #include <unordered_map>
 #include <unordered_set>
@@ -118,6 +120,7 @@ public:
   SPIRVVariable *getVariable(unsigned I) const override {
     return VariableVec[I];
   }
+  SPIRVValue *getConstant(unsigned I) const override { return ConstVec[I]; }
   SPIRVValue *getValue(SPIRVId TheId) const override;
   std::vector<SPIRVValue *>
   getValues(const std::vector<SPIRVId> &) const override;
@@ -144,6 +147,7 @@ public:
   }
   unsigned getNumFunctions() const override { return FuncVec.size(); }
   unsigned getNumVariables() const override { return VariableVec.size(); }
+  unsigned getNumConstants() const override { return ConstVec.size(); }
   SourceLanguage getSourceLanguage(SPIRVWord *Ver = nullptr) const override {
     if (Ver)
       *Ver = SrcLangVer;
@@ -484,7 +488,7 @@ private:
   SPIRVAddressingModelKind AddrModel;
   SPIRVMemoryModelKind MemoryModel;
 
-  typedef std::map<SPIRVId, SPIRVEntry *> SPIRVIdToEntryMap;
+  typedef std::unordered_map<SPIRVId, SPIRVEntry *> SPIRVIdToEntryMap;
   typedef std::set<SPIRVEntry *> SPIRVEntrySet;
   typedef std::set<SPIRVId> SPIRVIdSet;
   typedef std::vector<SPIRVId> SPIRVIdVec;
@@ -509,6 +513,17 @@ private:
       SPIRVUnknownStructFieldMap;
   typedef std::vector<SPIRVEntry *> SPIRVAliasInstMDVec;
   typedef std::unordered_map<llvm::MDNode *, SPIRVEntry *> SPIRVAliasInstMDMap;
+  // Types and constants which are uniquely identified by their opcode and
+  // operands are interned, the key being the opcode followed by the operand
+  // words of the instruction without the result id.
+  typedef std::vector<SPIRVWord> SPIRVInternKey;
+  struct SPIRVInternKeyHash {
+    size_t operator()(const SPIRVInternKey &Key) const {
+      return llvm::hash_combine_range(Key.begin(), Key.end());
+    }
+  };
+  typedef std::unordered_map<SPIRVInternKey, SPIRVEntry *, SPIRVInternKeyHash>
+      SPIRVInternMap;
 
   SPIRVForwardPointerVec ForwardPointerVec;
   SPIRVTypeVec TypeVec;
@@ -535,7 +550,7 @@ private:
   SPIRVCapMap CapMap;
   SPIRVUnknownStructFieldMap UnknownStructFieldMap;
   std::map<unsigned, SPIRVTypeInt *> IntTypeMap;
-  std::map<unsigned, SPIRVConstant *> LiteralMap;
+  SPIRVInternMap InternMap;
   std::vector<SPIRVExtInst *> DebugInstVec;
   std::vector<SPIRVExtInst *> AuxDataInstVec;
   std::vector<SPIRVModuleProcessed *> ModuleProcessedVec;
@@ -543,6 +558,11 @@ private:
   SPIRVAliasInstMDMap AliasInstMDMap;
 
   void layoutEntry(SPIRVEntry *Entry);
+  // Returns the entry interned under Key, creating it with Create if there is
+  // none yet.
+  template <class T, class CreateFn>
+  T *intern(SPIRVInternKey Key, CreateFn Create);
+  SPIRVConstant *addScalarConstant(SPIRVType *Ty, uint64_t Bits);
 };
 
 SPIRVModuleImpl::~SPIRVModuleImpl() {
@@ -632,15 +652,32 @@ void SPIRVModuleImpl::addCapabilityInternal(SPIRVCapabilityKind Cap) {
   }
 }
 
+template <class T, class CreateFn>
+T *SPIRVModuleImpl::intern(SPIRVInternKey Key, CreateFn Create) {
+  auto Loc = InternMap.find(Key);
+  if (Loc != InternMap.end())
+    return static_cast<T *>(Loc->second);
+  T *E = Create();
+  InternMap.emplace(std::move(Key), E);
+  return E;
+}
+
+SPIRVConstant *SPIRVModuleImpl::addScalarConstant(SPIRVType *Ty,
+                                                  uint64_t Bits) {
+  // Only the words used by the constant are part of the key, the unused high
+  // bits of narrow constants are ignored.
+  SPIRVInternKey Key = {OpConstant, Ty->getId(), static_cast<SPIRVWord>(Bits)};
+  if (Ty->getBitWidth() > 32)
+    Key.push_back(static_cast<SPIRVWord>(Bits >> 32));
+  return intern<SPIRVConstant>(std::move(Key), [&] {
+    auto *C = new SPIRVConstant(this, Ty, getId(), Bits);
+    addConstant(C);
+    return C;
+  });
+}
+
 SPIRVConstant *SPIRVModuleImpl::getLiteralAsConstant(unsigned Literal) {
-  auto Loc = LiteralMap.find(Literal);
-  if (Loc != LiteralMap.end())
-    return Loc->second;
-  auto Ty = addIntegerType(32);
-  auto V = new SPIRVConstant(this, Ty, getId(), static_cast<uint64_t>(Literal));
-  LiteralMap[Literal] = V;
-  addConstant(V);
-  return V;
+  return addScalarConstant(addIntegerType(32), Literal);
 }
 
 void SPIRVModuleImpl::layoutEntry(SPIRVEntry *E) {
@@ -862,7 +899,9 @@ template <class T> T *SPIRVModuleImpl::addType(T *Ty) {
 }
 
 SPIRVTypeVoid *SPIRVModuleImpl::addVoidType() {
-  return addType(new SPIRVTypeVoid(this, getId()));
+  return intern<SPIRVTypeVoid>({OpTypeVoid}, [&] {
+    return addType(new SPIRVTypeVoid(this, getId()));
+  });
 }
 
 SPIRVTypeArray *SPIRVModuleImpl::addArrayType(SPIRVType *ElementType,
@@ -871,7 +910,9 @@ SPIRVTypeArray *SPIRVModuleImpl::addArrayType(SPIRVType *ElementType,
 }
 
 SPIRVTypeBool *SPIRVModuleImpl::addBoolType() {
-  return addType(new SPIRVTypeBool(this, getId()));
+  return intern<SPIRVTypeBool>({OpTypeBool}, [&] {
+    return addType(new SPIRVTypeBool(this, getId()));
+  });
 }
 
 SPIRVTypeInt *SPIRVModuleImpl::addIntegerType(unsigned BitWidth) {
@@ -884,8 +925,9 @@ SPIRVTypeInt *SPIRVModuleImpl::addIntegerType(unsigned BitWidth) {
 }
 
 SPIRVTypeFloat *SPIRVModuleImpl::addFloatType(unsigned BitWidth) {
-  SPIRVTypeFloat *T = addType(new SPIRVTypeFloat(this, getId(), BitWidth));
-  return T;
+  return intern<SPIRVTypeFloat>({OpTypeFloat, BitWidth}, [&] {
+    return addType(new SPIRVTypeFloat(this, getId(), BitWidth));
+  });
 }
 
 SPIRVTypePointer *
@@ -897,8 +939,13 @@ SPIRVModuleImpl::addPointerType(SPIRVStorageClassKind StorageClass,
 
 SPIRVTypeFunction *SPIRVModuleImpl::addFunctionType(
     SPIRVType *ReturnType, const std::vector<SPIRVType *> &ParameterTypes) {
-  return addType(
-      new SPIRVTypeFunction(this, getId(), ReturnType, ParameterTypes));
+  SPIRVInternKey Key = {OpTypeFunction, ReturnType->getId()};
+  for (auto *T : ParameterTypes)
+    Key.push_back(T->getId());
+  return intern<SPIRVTypeFunction>(std::move(Key), [&] {
+    return addType(
+        new SPIRVTypeFunction(this, getId(), ReturnType, ParameterTypes));
+  });
 }
 
 SPIRVTypeOpaque *SPIRVModuleImpl::addOpaqueType(const std::string &Name) {
@@ -922,7 +969,11 @@ void SPIRVModuleImpl::closeStructType(SPIRVTypeStruct *T, bool Packed) {
 
 SPIRVTypeVector *SPIRVModuleImpl::addVectorType(SPIRVType *CompType,
                                                 SPIRVWord CompCount) {
-  return addType(new SPIRVTypeVector(this, getId(), CompType, CompCount));
+  return intern<SPIRVTypeVector>(
+      {OpTypeVector, CompType->getId(), CompCount}, [&] {
+        return addType(
+            new SPIRVTypeVector(this, getId(), CompType, CompCount));
+      });
 }
 
 SPIRVTypeJointMatrixINTEL *
@@ -1072,12 +1123,17 @@ SPIRVValue *SPIRVModuleImpl::addConstant(SPIRVValue *C) { return add(C); }
 SPIRVValue *SPIRVModuleImpl::addConstant(SPIRVType *Ty, uint64_t V) {
   if (Ty->isTypeBool()) {
     if (V)
-      return addConstant(new SPIRVConstantTrue(this, Ty, getId()));
-    else
+      return intern<SPIRVValue>({OpConstantTrue, Ty->getId()}, [&] {
+        return addConstant(new SPIRVConstantTrue(this, Ty, getId()));
+      });
+    return intern<SPIRVValue>({OpConstantFalse, Ty->getId()}, [&] {
       return addConstant(new SPIRVConstantFalse(this, Ty, getId()));
+    });
   }
   if (Ty->isTypeInt())
     return addIntegerConstant(static_cast<SPIRVTypeInt *>(Ty), V);
+  if (Ty->isTypeFloat())
+    return addScalarConstant(Ty, V);
   return addConstant(new SPIRVConstant(this, Ty, getId(), V));
 }
 
@@ -1086,20 +1142,21 @@ SPIRVValue *SPIRVModuleImpl::addConstant(SPIRVType *Ty, llvm::APInt V) {
 }
 
 SPIRVValue *SPIRVModuleImpl::addIntegerConstant(SPIRVTypeInt *Ty, uint64_t V) {
-  if (Ty->getBitWidth() == 32) {
-    unsigned I32 = static_cast<unsigned>(V);
-    assert(I32 == V && "Integer value truncated");
-    return getLiteralAsConstant(I32);
-  }
-  return addConstant(new SPIRVConstant(this, Ty, getId(), V));
+  assert((Ty->getBitWidth() != 32 || static_cast<uint32_t>(V) == V) &&
+         "Integer value truncated");
+  return addScalarConstant(Ty, V);
 }
 
 SPIRVValue *SPIRVModuleImpl::addFloatConstant(SPIRVTypeFloat *Ty, float V) {
-  return addConstant(new SPIRVConstant(this, Ty, getId(), V));
+  uint32_t Bits;
+  std::memcpy(&Bits, &V, sizeof(Bits));
+  return addScalarConstant(Ty, Bits);
 }
 
 SPIRVValue *SPIRVModuleImpl::addDoubleConstant(SPIRVTypeFloat *Ty, double V) {
-  return addConstant(new SPIRVConstant(this, Ty, getId(), V));
+  uint64_t Bits;
+  std::memcpy(&Bits, &V, sizeof(Bits));
+  return addScalarConstant(Ty, Bits);
 }
 
 SPIRVValue *SPIRVModuleImpl::addNullConstant(SPIRVType *Ty) {
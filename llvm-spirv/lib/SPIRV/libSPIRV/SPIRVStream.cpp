@@ -85,6 +85,23 @@ static void readQuotedString(std::istream &IS, std::string &Str) {
 bool SPIRVUseTextFormat = false;
 #endif
 
+SPIRVMemoryStreamBuf::pos_type
+SPIRVMemoryStreamBuf::seekoff(off_type Off, std::ios_base::seekdir Dir,
+                              std::ios_base::openmode Which) {
+  if (!(Which & std::ios_base::in))
+    return pos_type(off_type(-1));
+  off_type Base = 0;
+  if (Dir == std::ios_base::cur)
+    Base = gptr() - eback();
+  else if (Dir == std::ios_base::end)
+    Base = egptr() - eback();
+  off_type Pos = Base + Off;
+  if (Pos < 0 || Pos > egptr() - eback())
+    return pos_type(off_type(-1));
+  setg(eback(), eback() + Pos, egptr());
+  return pos_type(Pos);
+}
+
 SPIRVDecoder::SPIRVDecoder(std::istream &InputStream, SPIRVFunction &F)
     : IS(InputStream), M(*F.getModule()), WordCount(0), OpCode(OpNop),
       Scope(&F) {}
@@ -158,17 +175,29 @@ const SPIRVDecoder &operator>>(const SPIRVDecoder &I, std::string &Str) {
   }
 #endif
 
+  // Read the characters from the stream buffer directly, see readWord().
+  std::streambuf *Buf = I.IS.rdbuf();
+  using Traits = std::char_traits<char>;
   uint64_t Count = 0;
-  char Ch;
-  while (I.IS.get(Ch) && Ch != '\0') {
-    Str += Ch;
+  Traits::int_type Ch;
+  while (!Traits::eq_int_type(Ch = Buf->sbumpc(), Traits::eof()) &&
+         Traits::to_char_type(Ch) != '\0') {
+    Str += Traits::to_char_type(Ch);
     ++Count;
   }
+  if (Traits::eq_int_type(Ch, Traits::eof())) {
+    I.IS.setstate(std::ios::eofbit | std::ios::failbit);
+    return I;
+  }
   Count = (Count + 1) % 4;
   Count = Count ? 4 - Count : 0;
   for (; Count; --Count) {
-    I.IS >> Ch;
-    assert(Ch == '\0' && "Invalid string in SPIRV");
+    Ch = Buf->sbumpc();
+    if (Traits::eq_int_type(Ch, Traits::eof())) {
+      I.IS.setstate(std::ios::eofbit | std::ios::failbit);
+      break;
+    }
+    assert(Traits::to_char_type(Ch) == '\0' && "Invalid string in SPIRV");
   }
   SPIRVDBG(spvdbgs() << "Read string: \"" << Str << "\"\n");
   return I;
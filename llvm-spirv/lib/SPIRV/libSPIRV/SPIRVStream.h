@@ -45,7 +45,9 @@
 #include "SPIRVModule.h"
 #include <cctype>
 #include <cstdint>
+#include <cstring>
 #include <iostream>
+#include <streambuf>
 #include <string>
 #include <vector>
 
@@ -63,6 +65,35 @@ extern bool SPIRVUseTextFormat;
 class SPIRVFunction;
 class SPIRVBasicBlock;
 
+/// Read-only stream buffer over a SPIR-V module in memory. The get area refers
+/// to the memory directly, so the module is decoded without being copied.
+class SPIRVMemoryStreamBuf : public std::streambuf {
+public:
+  SPIRVMemoryStreamBuf(const char *Data, size_t Size) {
+    char *Begin = const_cast<char *>(Data);
+    setg(Begin, Begin, Begin + Size);
+  }
+
+protected:
+  pos_type seekoff(off_type Off, std::ios_base::seekdir Dir,
+                   std::ios_base::openmode Which) override;
+  pos_type seekpos(pos_type Pos, std::ios_base::openmode Which) override {
+    return seekoff(off_type(Pos), std::ios_base::beg, Which);
+  }
+};
+
+/// Input stream reading a SPIR-V module from memory, see SPIRVMemoryStreamBuf.
+class SPIRVMemoryInputStream : public std::istream {
+public:
+  SPIRVMemoryInputStream(const char *Data, size_t Size)
+      : std::istream(nullptr), Buf(Data, Size) {
+    rdbuf(&Buf);
+  }
+
+private:
+  SPIRVMemoryStreamBuf Buf;
+};
+
 class SPIRVDecoder {
 public:
   SPIRVDecoder(std::istream &InputStream, SPIRVModule &Module)
@@ -98,10 +129,47 @@ class SPIRVNL {
   friend spv_ostream &operator<<(spv_ostream &O, const SPIRVNL &E);
 };
 
+/// Read a word from the buffer of the stream. Unlike std::istream::read(),
+/// which constructs a sentry and calls the virtual xsgetn() for every word,
+/// words available in the get area of the buffer are read inline. This is
+/// always the case for SPIRVMemoryStreamBuf and std::stringbuf.
+inline void readWord(std::istream &IS, uint32_t &W) {
+  if (!IS.good()) {
+    W = 0;
+    IS.setstate(std::ios::failbit);
+    return;
+  }
+  std::streambuf *Buf = IS.rdbuf();
+  char Bytes[sizeof(W)];
+  if (Buf->in_avail() >= static_cast<std::streamsize>(sizeof(W))) {
+    for (char &B : Bytes)
+      B = std::char_traits<char>::to_char_type(Buf->sbumpc());
+  } else if (Buf->sgetn(Bytes, sizeof(W)) !=
+             static_cast<std::streamsize>(sizeof(W))) {
+    W = 0;
+    IS.setstate(std::ios::eofbit | std::ios::failbit);
+    return;
+  }
+  std::memcpy(&W, Bytes, sizeof(W));
+}
+
+/// Write a word to the buffer of the stream. Like readWord(), this bypasses
+/// the sentry of std::ostream::write(), which is constructed for every call
+/// and dominates the cost of emitting a module word by word.
+inline void writeWord(std::ostream &OS, uint32_t W) {
+  if (!OS.good())
+    return;
+  char Bytes[sizeof(W)];
+  std::memcpy(Bytes, &W, sizeof(W));
+  if (OS.rdbuf()->sputn(Bytes, sizeof(W)) !=
+      static_cast<std::streamsize>(sizeof(W)))
+    OS.setstate(std::ios::badbit);
+}
+
 template <typename T>
 const SPIRVDecoder &decodeBinary(const SPIRVDecoder &I, T &V) {
   uint32_t W;
-  I.IS.read(reinterpret_cast<char *>(&W), sizeof(W));
+  readWord(I.IS, W);
   V = static_cast<T>(W);
   SPIRVDBG(spvdbgs() << "Read word: W = " << W << " V = " << V << '\n');
   return I;
@@ -185,8 +253,7 @@ const SPIRVEncoder &operator<<(const SPIRVEncoder &O, T V) {
     return O;
   }
 #endif
-  uint32_t W = static_cast<uint32_t>(V);
-  O.OS.write(reinterpret_cast<char *>(&W), sizeof(W));
+  writeWord(O.OS, static_cast<uint32_t>(V));
   return O;
 }
 
@@ -0,0 +1,57 @@
+; Check that translating the function bodies on several threads produces the
+; same module as the sequential translation, including the linkage and the
+; names of the global values which are promoted to link the partitions.
+
+; RUN: llvm-as %s -o %t.bc
+; RUN: llvm-spirv %t.bc -o %t.spv
+; RUN: llvm-spirv -r %t.spv -o %t.rev.bc
+; RUN: llvm-dis < %t.rev.bc | FileCheck %s
+; RUN: llvm-spirv -r -spirv-reader-threads=4 %t.spv -o %t.rev.par.bc
+; RUN: llvm-dis < %t.rev.par.bc | FileCheck %s
+
+; CHECK-NOT: __spirv_reader_unnamed
+; CHECK-DAG: @Counter = internal addrspace(1) global i32 0
+; CHECK-DAG: @0 = internal {{.*}}addrspace(2) constant [4 x i8] c"abc\00"
+; CHECK-DAG: define internal spir_func i32 @inc(i32 %X)
+; CHECK-DAG: define internal spir_func i32 @twice(i32 %X)
+; CHECK-DAG: define spir_func i8 @first(i64 %I)
+; CHECK-DAG: define spir_kernel void @kernel(
+; CHECK-NOT: __spirv_reader_unnamed
+
+target datalayout = "e-i64:64-v16:16-v24:32-v32:32-v48:64-v96:128-v192:256-v256:256-v512:512-v1024:1024"
+target triple = "spir64-unknown-unknown"
+
+@Counter = internal addrspace(1) global i32 0, align 4
+@0 = private unnamed_addr addrspace(2) constant [4 x i8] c"abc\00", align 1
+
+define internal spir_func i32 @inc(i32 %X) {
+entry:
+  %Old = load i32, ptr addrspace(1) @Counter, align 4
+  %New = add i32 %Old, %X
+  store i32 %New, ptr addrspace(1) @Counter, align 4
+  ret i32 %New
+}
+
+define internal spir_func i32 @twice(i32 %X) {
+entry:
+  %A = call spir_func i32 @inc(i32 %X)
+  %B = call spir_func i32 @inc(i32 %A)
+  ret i32 %B
+}
+
+define spir_func i8 @first(i64 %I) {
+entry:
+  %P = getelementptr inbounds [4 x i8], ptr addrspace(2) @0, i64 0, i64 %I
+  %C = load i8, ptr addrspace(2) %P, align 1
+  ret i8 %C
+}
+
+define spir_kernel void @kernel(ptr addrspace(1) %Out) {
+entry:
+  %T = call spir_func i32 @twice(i32 1)
+  %C = call spir_func i8 @first(i64 0)
+  %Z = zext i8 %C to i32
+  %S = add i32 %T, %Z
+  store i32 %S, ptr addrspace(1) %Out, align 4
+  ret void
+}
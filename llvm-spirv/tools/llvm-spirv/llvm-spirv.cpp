@@ -77,6 +77,7 @@
 #include <set>
 #include <sstream>
 #include <string>
+#include <vector>
 
 #define DEBUG_TYPE "spirv"
 
@@ -133,6 +134,11 @@ static cl::opt<bool> SPIRVGenKernelArgNameMD(
     cl::desc("Enable generating OpenCL kernel argument name "
              "metadata"));
 
+static cl::opt<unsigned> SPIRVReaderThreads(
+    "spirv-reader-threads", cl::init(1),
+    cl::desc("Number of threads translating the function bodies of the SPIR-V "
+             "module in parallel in reverse translation"));
+
 static cl::opt<SPIRV::BIsRepresentation> BIsRepresentation(
     "spirv-target-env",
     cl::desc("Specify a representation of different SPIR-V Instructions which "
@@ -167,8 +173,6 @@ static cl::opt<bool>
                                 "for the translation from SPIR-V."),
                        cl::Hidden);
 
-using SPIRV::ExtensionID;
-
 #ifdef _SPIRV_SUPPORT_TEXT_FMT
 namespace SPIRV {
 // Use textual format for SPIRV.
@@ -368,7 +372,13 @@ static int convertLLVMToSPIRV(const SPIRV::TranslatorOpts &Opts) {
   std::string Err;
   bool Success = false;
   if (OutputFile != "-") {
-    std::ofstream OutFile(OutputFile, std::ios::binary);
+    // The module is written a word at a time, give the file a buffer large
+    // enough to turn that into a few big writes. The buffer has to be set
+    // before the file is opened.
+    std::vector<char> OutBuf(1 << 20);
+    std::ofstream OutFile;
+    OutFile.rdbuf()->pubsetbuf(OutBuf.data(), OutBuf.size());
+    OutFile.open(OutputFile, std::ios::binary);
     Success = writeSpirv(M.get(), Opts, OutFile, Err);
   } else {
     Success = writeSpirv(M.get(), Opts, std::cout, Err);
@@ -390,11 +400,19 @@ static int convertSPIRVToLLVM(const SPIRV::TranslatorOpts &Opts) {
   LLVMContext Context;
   Context.setOpaquePointers(EmitOpaquePointers);
 
-  std::ifstream IFS(InputFile, std::ios::binary);
+  // The module is decoded directly from the mapped file.
+  ErrorOr<std::unique_ptr<MemoryBuffer>> MBOrErr =
+      MemoryBuffer::getFile(InputFile, /*IsText=*/false,
+                            /*RequiresNullTerminator=*/false);
+  if (!MBOrErr) {
+    errs() << "Fails to load SPIR-V as LLVM Module: "
+           << MBOrErr.getError().message() << '\n';
+    return -1;
+  }
   Module *M;
   std::string Err;
 
-  if (!readSpirv(Context, Opts, IFS, M, Err)) {
+  if (!readSpirv(Context, Opts, (*MBOrErr)->getMemBufferRef(), M, Err)) {
     errs() << "Fails to load SPIR-V as LLVM Module: " << Err << '\n';
     return -1;
   }
@@ -505,16 +523,6 @@ static int regularizeLLVM(SPIRV::TranslatorOpts &Opts) {
 
 static int parseSPVExtOption(
     SPIRV::TranslatorOpts::ExtensionsStatusMap &ExtensionsStatus) {
-  // Map name -> id for known extensions
-  std::map<std::string, ExtensionID> ExtensionNamesMap;
-#define _STRINGIFY(X) #X
-#define STRINGIFY(X) _STRINGIFY(X)
-#define EXT(X) ExtensionNamesMap[STRINGIFY(X)] = ExtensionID::X;
-#include "LLVMSPIRVExtensions.inc"
-#undef EXT
-#undef STRINGIFY
-#undef _STRINGIFY
-
   // Set the initial state:
   //  - during SPIR-V consumption, assume that any known extension is allowed.
   //  - during SPIR-V generation, assume that any known extension is disallowed.
@@ -523,47 +531,13 @@ static int parseSPVExtOption(
   std::optional<bool> DefaultVal;
   if (IsReverse)
     DefaultVal = true;
-  for (const auto &It : ExtensionNamesMap)
-    ExtensionsStatus[It.second] = DefaultVal;
-
-  if (SPVExt.empty())
-    return 0; // Nothing to do
-
-  for (unsigned i = 0; i < SPVExt.size(); ++i) {
-    const std::string &ExtString = SPVExt[i];
-    if (ExtString.empty() ||
-        ('+' != ExtString.front() && '-' != ExtString.front())) {
-      errs() << "Invalid value of --spirv-ext, expected format is:\n"
-             << "\t--spirv-ext=+EXT_NAME,-EXT_NAME\n";
-      return -1;
-    }
 
-    auto ExtName = ExtString.substr(1);
-
-    if (ExtName.empty()) {
-      errs() << "Invalid value of --spirv-ext, expected format is:\n"
-             << "\t--spirv-ext=+EXT_NAME,-EXT_NAME\n";
-      return -1;
-    }
-
-    bool ExtStatus = ('+' == ExtString.front());
-    if ("all" == ExtName) {
-      // Update status for all known extensions
-      for (const auto &It : ExtensionNamesMap)
-        ExtensionsStatus[It.second] = ExtStatus;
-    } else {
-      // Reject unknown extensions
-      const auto &It = ExtensionNamesMap.find(ExtName);
-      if (ExtensionNamesMap.end() == It) {
-        errs() << "Unknown extension '" << ExtName << "' was specified via "
-               << "--spirv-ext option\n";
-        return -1;
-      }
-
-      ExtensionsStatus[It->second] = ExtStatus;
-    }
+  std::string ErrMsg;
+  if (!SPIRV::parseSPIRVExtOption(SPVExt, DefaultVal, ExtensionsStatus,
+                                  ErrMsg)) {
+    errs() << ErrMsg << "\n";
+    return -1;
   }
-
   return 0;
 }
 
@@ -738,17 +712,18 @@ int main(int Ac, char **Av) {
     Opts.setMemToRegEnabled(SPIRVMemToReg);
   if (SPIRVGenKernelArgNameMD)
     Opts.setGenKernelArgNameMDEnabled(SPIRVGenKernelArgNameMD);
+  if (IsReverse && SPIRVReaderThreads > 1)
+    Opts.setReaderThreads(SPIRVReaderThreads);
   if (IsReverse && !SpecConst.empty()) {
     if (parseSpecConstOpt(SpecConst, Opts))
       return -1;
   }
 
   if (SPIRVPreserveAuxData) {
-    Opts.setPreserveAuxData(
-        SPIRVPreserveAuxData);
-    if (!IsReverse)
-      Opts.setAllowedToUseExtension(
-          SPIRV::ExtensionID::SPV_KHR_non_semantic_info);
+    if (IsReverse)
+      Opts.setPreserveAuxData(SPIRVPreserveAuxData);
+    else
+      Opts.enablePreserveAuxDataForSPIRV();
   }
 
   if (SPIRVAllowUnknownIntrinsics.getNumOccurrences() != 0) {
@@ -780,16 +755,7 @@ int main(int Ac, char **Av) {
       errs() << "Note: --spirv-debug-info-version option ignored as it only "
                 "affects translation from LLVM IR to SPIR-V";
     } else {
-      Opts.setDebugInfoEIS(DebugEIS);
-      if (DebugEIS.getValue() ==
-          SPIRV::DebugInfoEIS::NonSemantic_Shader_DebugInfo_200)
-        Opts.setAllowExtraDIExpressionsEnabled(true);
-      if (DebugEIS.getValue() ==
-          SPIRV::DebugInfoEIS::NonSemantic_Shader_DebugInfo_100 ||
-          DebugEIS.getValue() ==
-          SPIRV::DebugInfoEIS::NonSemantic_Shader_DebugInfo_200)
-        Opts.setAllowedToUseExtension(
-            SPIRV::ExtensionID::SPV_KHR_non_semantic_info);
+      Opts.setDebugInfoEISForSPIRV(DebugEIS);
     }
   }
 
@@ -0,0 +1,49 @@
+//===- IRSymbolIndex.h - Symbols defined by a bitcode file ------*- C++ -*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// This file declares an index of the global values a bitcode file defines. It
+// is read from the symbol table of the bitcode file, without constructing the
+// module in memory, and tells whether linking the file with
+// Linker::LinkOnlyNeeded would add anything to a module.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_OBJECT_IRSYMBOLINDEX_H
+#define LLVM_OBJECT_IRSYMBOLINDEX_H
+
+#include "llvm/ADT/StringSet.h"
+#include "llvm/Support/Error.h"
+#include "llvm/Support/MemoryBufferRef.h"
+
+namespace llvm {
+
+class Module;
+
+namespace object {
+
+class IRSymbolIndex {
+public:
+  /// Reads the index from the symbol table of the bitcode file in \p Buffer.
+  static Expected<IRSymbolIndex> create(MemoryBufferRef Buffer);
+
+  /// Returns true if linking the bitcode file into \p M with
+  /// Linker::LinkOnlyNeeded could add a global value to \p M. This is the case
+  /// if the file defines a global value which \p M declares, or has module asm
+  /// or globals with appending linkage, which are linked in regardless of
+  /// uses.
+  bool isNeededBy(const Module &M) const;
+
+private:
+  StringSet<> Defined;
+  bool AlwaysNeeded = false;
+};
+
+} // end namespace object
+} // end namespace llvm
+
+#endif // LLVM_OBJECT_IRSYMBOLINDEX_H
@@ -0,0 +1,37 @@
+//===---- PackAccessorArgs.h - pack accessor kernel arguments -------------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// Packs the kernel arguments which hold the access ranges, memory ranges and
+// offsets of SYCL accessors into a single by-value kernel argument, so that
+// the SYCL runtime sets one argument per kernel launch instead of up to three
+// per accessor.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_SYCLLOWERIR_PACKACCESSORARGS_H
+#define LLVM_SYCLLOWERIR_PACKACCESSORARGS_H
+
+#include "llvm/IR/PassManager.h"
+
+namespace llvm {
+
+// Metadata attached to the kernels with packed arguments. Its operands are i32
+// constants: the index of the packed argument, the size of the packed argument
+// and a (argument index, offset, size) triple for each argument moved into the
+// packed one. Argument indices are the ones before packing.
+constexpr char SYCL_KERNEL_PACKED_ARGS_MD[] = "sycl_kernel_packed_args";
+
+class SYCLPackAccessorArgsPass
+    : public PassInfoMixin<SYCLPackAccessorArgsPass> {
+public:
+  PreservedAnalyses run(Module &M, ModuleAnalysisManager &);
+};
+
+} // namespace llvm
+
+#endif // LLVM_SYCLLOWERIR_PACKACCESSORARGS_H
@@ -0,0 +1,50 @@
+//===- IRSymbolIndex.cpp - Symbols defined by a bitcode file --------------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Object/IRSymbolIndex.h"
+#include "llvm/Bitcode/BitcodeReader.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Object/IRSymtab.h"
+
+using namespace llvm;
+using namespace llvm::object;
+
+Expected<IRSymbolIndex> IRSymbolIndex::create(MemoryBufferRef Buffer) {
+  Expected<BitcodeFileContents> BFC = getBitcodeFileContents(Buffer);
+  if (!BFC)
+    return BFC.takeError();
+  Expected<irsymtab::FileContents> FC = irsymtab::readBitcode(*BFC);
+  if (!FC)
+    return FC.takeError();
+
+  IRSymbolIndex Index;
+  for (const irsymtab::Reader::SymbolRef &Sym : FC->TheReader.symbols()) {
+    StringRef Name = Sym.getIRName();
+    // Module asm symbols have no IR name, and module asm is always linked in.
+    if (Name.empty()) {
+      Index.AlwaysNeeded = true;
+      continue;
+    }
+    if (Sym.isUndefined())
+      continue;
+    // So are globals with appending linkage, such as llvm.used.
+    if (Name.startswith("llvm."))
+      Index.AlwaysNeeded = true;
+    Index.Defined.insert(Name);
+  }
+  return std::move(Index);
+}
+
+bool IRSymbolIndex::isNeededBy(const Module &M) const {
+  if (AlwaysNeeded)
+    return true;
+  for (const GlobalValue &GV : M.global_values())
+    if (GV.isDeclaration() && Defined.contains(GV.getName()))
+      return true;
+  return false;
+}
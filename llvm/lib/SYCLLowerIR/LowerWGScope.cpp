@@ -65,9 +65,8 @@
 // (1) - materialization of a PFWI object
 // (2) - "fixup" of the private variable address.
 //
-// TODO: add support for the case when there are other functions between
-// parallel_for_work_group and parallel_for_work_item in the call stack.
-// For example:
+// There can be other functions between parallel_for_work_group and
+// parallel_for_work_item in the call stack. For example:
 //
 // void foo(sycl::group<1> group, ...) {
 //   group.parallel_for_work_item(range<1>(), [&](h_item<1> i) { ... });
@@ -78,10 +77,18 @@
 //       foo(g, ...);
 //     });
 //
-// TODO The approach employed by this pass generates lots of barriers and data
-// copying between private and local memory, which might not be efficient. There
-// are optimization opportunities listed below. Also other approaches can be
-// considered like
+// Such functions (foo above) are inlined into the PFWG lambda function before
+// the lowering, so that the PFWI calls they make become work item scope code of
+// the PFWG lambda.
+//
+// To reduce the overhead of the lowering, a local of kind 3 is materialized
+// only in the work item scope blocks which can read it, and barriers made
+// redundant by a preceding barrier in the same block are removed afterwards.
+//
+// TODO The approach employed by this pass still generates lots of barriers and
+// data copying between private and local memory, which might not be efficient.
+// There are optimization opportunities listed below. Also other approaches can
+// be considered like
 // "Efficient Fork-Join on GPUs through Warp Specialization" by Arpith C. Jacob
 // et. al.
 //===----------------------------------------------------------------------===//
@@ -90,14 +97,17 @@
 #include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/ADT/Statistic.h"
+#include "llvm/Analysis/ValueTracking.h"
 #include "llvm/TargetParser/Triple.h"
 #include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/InstIterator.h"
 #include "llvm/IR/Instructions.h"
 #include "llvm/IR/IntrinsicInst.h"
 #include "llvm/IR/Module.h"
 #include "llvm/InitializePasses.h"
 #include "llvm/Pass.h"
 #include "llvm/Support/CommandLine.h"
+#include "llvm/Transforms/Utils/Cloning.h"
 
 #ifndef NDEBUG
 #include "llvm/IR/CFG.h"
@@ -111,10 +121,13 @@ using namespace llvm;
 #define DEBUG_TYPE "lowerwgcode"
 
 STATISTIC(LocalMemUsed, "amount of additional local memory used for sharing");
+STATISTIC(NumFuncsInlined, "number of PFWI-calling functions inlined");
+STATISTIC(NumBarriersRemoved, "number of redundant barriers removed");
 
 static constexpr char WG_SCOPE_MD[] = "work_group_scope";
 static constexpr char WI_SCOPE_MD[] = "work_item_scope";
 static constexpr char PFWI_MD[] = "parallel_for_work_item";
+static constexpr char WG_BARRIER_NAME[] = "_Z22__spirv_ControlBarrierjjj";
 
 static cl::opt<int> Debug("sycl-lower-wg-debug", llvm::cl::Optional,
                           llvm::cl::Hidden,
@@ -213,6 +226,13 @@ static bool isPFWICall(const Instruction *I) {
   return isCallToAFuncMarkedWithMD(I, PFWI_MD);
 }
 
+// Checks if this is a work group barrier call.
+static bool isWGBarrier(const Instruction *I) {
+  const CallInst *Call = dyn_cast<CallInst>(I);
+  const Function *F = Call ? Call->getCalledFunction() : nullptr;
+  return F && F->getName() == WG_BARRIER_NAME;
+}
+
 // Checks if given instruction must be executed by all work items.
 static bool isWIScopeInst(const Instruction *I) {
   if (I->isTerminator())
@@ -493,10 +513,56 @@ static void materializeLocalsInWIScopeBlocksImpl(
   }
 }
 
-// Checks if there is a need to materialize value of given local in given work
-// item-scope basic block.
-static bool localMustBeMaterialized(const AllocaInst *L, const BasicBlock &BB) {
-  // TODO this is overly conservative - see speculations below.
+// Collects the work item scope basic blocks where the value of given local
+// can be read by worker WIs and thus must be materialized. Out of the work
+// group scope code, workers execute only work item scope calls, terminators
+// and the code generated by this pass, so only work item scope calls taking a
+// pointer derived from the local can read it. Returns false if the address of
+// the local escapes, in which case any work item scope block can read it.
+static bool collectWIScopeReaders(const AllocaInst *L,
+                                  SmallPtrSetImpl<BasicBlock *> &ReaderBBs) {
+  SmallVector<const Instruction *, 8> Ptrs{L};
+  SmallPtrSet<const Instruction *, 8> Visited;
+
+  while (!Ptrs.empty()) {
+    const Instruction *Ptr = Ptrs.pop_back_val();
+    if (!Visited.insert(Ptr).second)
+      continue;
+
+    for (const Use &U : Ptr->uses()) {
+      auto *UI = cast<Instruction>(U.getUser());
+
+      if (isa<GetElementPtrInst>(UI) || isa<BitCastInst>(UI) ||
+          isa<AddrSpaceCastInst>(UI)) {
+        Ptrs.push_back(UI);
+        continue;
+      }
+      if (isa<LoadInst>(UI))
+        continue;
+      if (isa<StoreInst>(UI)) {
+        // storing the pointer itself makes it escape
+        if (U.getOperandNo() != StoreInst::getPointerOperandIndex())
+          return false;
+        continue;
+      }
+      auto *Call = dyn_cast<CallInst>(UI);
+
+      if (!Call)
+        return false;
+      if (isWIScopeInst(Call)) {
+        ReaderBBs.insert(Call->getParent());
+        continue;
+      }
+      // other calls are executed by the leader only
+      if (isa<MemIntrinsic>(Call) || isa<DbgInfoIntrinsic>(Call) ||
+          Call->isLifetimeStartOrEnd())
+        continue;
+      if (Call->isArgOperand(&U) &&
+          Call->doesNotCapture(Call->getArgOperandNo(&U)))
+        continue;
+      return false;
+    }
+  }
   return true;
 }
 
@@ -536,13 +602,11 @@ static bool localMustBeMaterialized(const AllocaInst *L, const BasicBlock &BB) {
 // basic_block10: // WI scope
 //   use2(p1);
 //
-// TODO. This implementation is quite ineffective. Currently it materializes
-// all locals in all WI scope basic blocks.
-// Will be improved incrementally:
-// - For each alloca: determine all derived (via GEPs) pointers and make sure
-//   they don't escape. Then check if there are reads in current WI scope BB
-//   through either of those. If none of them escape and there are no reads then
-//   materialization of this alloca in this BB is not needed.
+// A local is materialized only in the WI scope basic blocks where work item
+// scope calls take pointers derived from it, unless its address escapes (see
+// collectWIScopeReaders).
+//
+// TODO. This implementation can be improved further:
 // - Materialization is not needed if there is dominating BB with materialized
 //   value, and there are no WG scope writes to this alloca on any path from
 //   that BB to current.
@@ -565,8 +629,11 @@ void materializeLocalsInWIScopeBlocks(SmallPtrSetImpl<AllocaInst *> &Locals,
 
   // Fill the local-to-shadow and basic block-to-locals maps:
   for (auto L : Locals) {
+    SmallPtrSet<BasicBlock *, 4> ReaderBBs;
+    bool Escapes = !collectWIScopeReaders(L, ReaderBBs);
+
     for (auto *BB : WIScopeBBs) {
-      if (!localMustBeMaterialized(L, *BB))
+      if (!Escapes && !ReaderBBs.contains(BB))
         continue;
       if (Local2Shadow.find(L) == Local2Shadow.end()) {
         // lazily create a "shadow" for current local:
@@ -749,12 +816,150 @@ static void shareByValParams(Function &F, const Triple &TT) {
   spirv::genWGBarrier(MergeBB->front(), TT);
 }
 
+// Checks if given function calls parallel_for_work_item directly or through
+// other functions defined in the module.
+static bool callsPFWI(const Function &F,
+                      DenseMap<const Function *, bool> &Visited) {
+  auto It = Visited.find(&F);
+  if (It != Visited.end())
+    return It->second;
+  // SYCL device code can't be recursive, but don't loop forever on bad input
+  Visited[&F] = false;
+  bool Res = false;
+
+  for (const Instruction &I : instructions(F)) {
+    const auto *Call = dyn_cast<CallInst>(&I);
+    const Function *Callee = Call ? Call->getCalledFunction() : nullptr;
+
+    if (Callee && (Callee->getMetadata(PFWI_MD) ||
+                   (!Callee->isDeclaration() && callsPFWI(*Callee, Visited)))) {
+      Res = true;
+      break;
+    }
+  }
+  Visited[&F] = Res;
+  return Res;
+}
+
+// Inlines the functions called from the PFWG lambda function F which call
+// parallel_for_work_item, so that the PFWI calls are lowered as part of F.
+static bool inlinePFWICallers(Function &F) {
+  DenseMap<const Function *, bool> Visited;
+  bool Changed = false;
+
+  while (true) {
+    SmallVector<CallInst *, 4> Calls;
+
+    for (Instruction &I : instructions(F)) {
+      auto *Call = dyn_cast<CallInst>(&I);
+      Function *Callee = Call ? Call->getCalledFunction() : nullptr;
+
+      if (!Callee || Callee == &F || Callee->isDeclaration() ||
+          Callee->getMetadata(PFWI_MD) || Callee->getMetadata(WI_SCOPE_MD))
+        continue;
+      if (callsPFWI(*Callee, Visited))
+        Calls.push_back(Call);
+    }
+    bool Inlined = false;
+
+    for (CallInst *Call : Calls) {
+      InlineFunctionInfo IFI;
+      // No lifetime markers - the lowering makes workers access the allocas
+      // of inlined functions outside of the leader's code.
+      if (InlineFunction(*Call, IFI, /*MergeAttributes=*/false,
+                         /*CalleeAAR=*/nullptr, /*InsertLifetime=*/false)
+              .isSuccess()) {
+        ++NumFuncsInlined;
+        Inlined = true;
+      }
+    }
+    // inlined bodies may call other PFWI-calling functions
+    if (!Inlined)
+      break;
+    Changed = true;
+  }
+  return Changed;
+}
+
+// Checks if given instruction is an access to private memory of current WI or
+// a read of a work group local created by this pass or of a constant. Workers
+// only read the locals created by this pass, while the leader writes them
+// under the "is leader" guard, which always starts with a barrier.
+static bool isPrivateOrShadowAccess(
+    const Instruction &I, const SmallPtrSetImpl<GlobalVariable *> &OldGlobals) {
+  auto IsPrivate = [](const Value *Ptr) {
+    const Value *Obj = getUnderlyingObject(Ptr);
+    const auto *Arg = dyn_cast<Argument>(Obj);
+    return isa<AllocaInst>(Obj) || (Arg && Arg->hasByValAttr());
+  };
+  auto IsPrivateOrShadow = [&](const Value *Ptr) {
+    auto *G = dyn_cast<GlobalVariable>(getUnderlyingObject(Ptr));
+    return IsPrivate(Ptr) ||
+           (G && (G->isConstant() || !OldGlobals.contains(G)));
+  };
+
+  if (!I.mayReadOrWriteMemory() || I.isDebugOrPseudoInst())
+    return true;
+  if (const auto *LI = dyn_cast<LoadInst>(&I))
+    return LI->isSimple() && IsPrivateOrShadow(LI->getPointerOperand());
+  if (const auto *SI = dyn_cast<StoreInst>(&I))
+    return SI->isSimple() && IsPrivate(SI->getPointerOperand());
+  if (const auto *MT = dyn_cast<MemTransferInst>(&I))
+    return !MT->isVolatile() && IsPrivate(MT->getRawDest()) &&
+           IsPrivateOrShadow(MT->getRawSource());
+  return false;
+}
+
+// Removes barriers created by this pass which are preceded by another barrier
+// created by this pass in the same basic block, if all the instructions in
+// between are private or shadow accesses (see isPrivateOrShadowAccess). This
+// typically happens when a WI scope block gets both a materialization barrier
+// and a barrier for the values shared by a preceding range.
+static bool
+removeRedundantBarriers(Function &F,
+                        const SmallPtrSetImpl<Instruction *> &OldBarriers,
+                        const SmallPtrSetImpl<GlobalVariable *> &OldGlobals) {
+  SmallVector<Instruction *, 8> Redundant;
+
+  for (auto &BB : F) {
+    // whether there is a barrier covering current instruction
+    bool Covered = false;
+
+    for (auto &I : BB) {
+      if (isWGBarrier(&I) && !OldBarriers.contains(&I)) {
+        if (Covered)
+          Redundant.push_back(&I);
+        Covered = true;
+        continue;
+      }
+      if (Covered && !isPrivateOrShadowAccess(I, OldGlobals))
+        Covered = false;
+    }
+  }
+  for (auto *I : Redundant)
+    I->eraseFromParent();
+  NumBarriersRemoved += Redundant.size();
+  return !Redundant.empty();
+}
+
 PreservedAnalyses SYCLLowerWGScopePass::run(Function &F,
                                             FunctionAnalysisManager &FAM) {
   if (!F.getMetadata(WG_SCOPE_MD))
     return PreservedAnalyses::all();
   LLVM_DEBUG(llvm::dbgs() << "Function name: " << F.getName() << "\n");
   const auto &TT = llvm::Triple(F.getParent()->getTargetTriple());
+  bool Inlined = inlinePFWICallers(F);
+
+  // Remember the barriers and globals which exist before the transformation to
+  // tell them from the ones created by this pass.
+  SmallPtrSet<Instruction *, 4> OldBarriers;
+  SmallPtrSet<GlobalVariable *, 16> OldGlobals;
+
+  for (auto &I : instructions(F))
+    if (isWGBarrier(&I))
+      OldBarriers.insert(&I);
+  for (auto &G : F.getParent()->globals())
+    OldGlobals.insert(&G);
   // Ranges of "side effect" instructions
   SmallVector<InstrRange, 16> Ranges;
   SmallPtrSet<AllocaInst *, 16> Allocas;
@@ -821,7 +1026,8 @@ PreservedAnalyses SYCLLowerWGScopePass::run(Function &F,
       NByval++;
   }
 
-  bool HaveChanges = (Ranges.size() > 0) || (Allocas.size() > 0) || NByval > 0;
+  bool HaveChanges =
+      Inlined || (Ranges.size() > 0) || (Allocas.size() > 0) || NByval > 0;
 
 #ifndef NDEBUG
   if (HaveChanges && Debug > 1) {
@@ -854,9 +1060,12 @@ PreservedAnalyses SYCLLowerWGScopePass::run(Function &F,
   for (auto *PFWICall : PFWICalls)
     fixupPrivateMemoryPFWILambdaCaptures(PFWICall);
 
-  // Finally, create shadows for and replace usages of byval pointer params.
+  // Create shadows for and replace usages of byval pointer params.
   shareByValParams(F, TT);
 
+  // Finally, clean up the barriers made redundant by the transformations above.
+  removeRedundantBarriers(F, OldBarriers, OldGlobals);
+
 #ifndef NDEBUG
   if (HaveChanges && Debug > 0)
     verifyModule(*F.getParent(), &llvm::errs());
@@ -959,7 +1168,7 @@ Value *spirv::genPseudoLocalID(Instruction &Before, const Triple &TT) {
 //  uint32_t Semantics) noexcept;
 Instruction *spirv::genWGBarrier(Instruction &Before, const Triple &TT) {
   Module &M = *Before.getModule();
-  StringRef Name = "_Z22__spirv_ControlBarrierjjj";
+  StringRef Name = WG_BARRIER_NAME;
   LLVMContext &Ctx = Before.getContext();
   Type *ScopeTy = Type::getInt32Ty(Ctx);
   Type *SemanticsTy = Type::getInt32Ty(Ctx);
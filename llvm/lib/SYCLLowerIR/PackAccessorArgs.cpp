@@ -0,0 +1,225 @@
+//===---- PackAccessorArgs.cpp - pack accessor kernel arguments -----------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+// Each SYCL accessor is passed to a kernel as a pointer followed by its access
+// range, memory range and offset. The runtime sets every kernel argument
+// separately on each launch, so kernels with many accessors pay for lots of
+// small argument setting calls. This pass moves the range and offset
+// arguments which survived dead argument elimination into a single by-value
+// struct argument appended to the kernel, and records the layout of the struct
+// in metadata, from which sycl-post-link emits a device image property telling
+// the runtime how to pack the argument values.
+//===----------------------------------------------------------------------===//
+
+#include "llvm/SYCLLowerIR/PackAccessorArgs.h"
+
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/Statistic.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/DataLayout.h"
+#include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/Metadata.h"
+#include "llvm/IR/Module.h"
+
+#include <optional>
+
+#define DEBUG_TYPE "sycl-pack-accessor-args"
+
+using namespace llvm;
+
+STATISTIC(NumArgsPacked, "number of kernel arguments packed");
+
+namespace {
+
+// Number of kernel arguments following the pointer of an accessor, which hold
+// its access range, memory range and offset.
+constexpr unsigned NumAccessorFields = 3;
+
+// Kernel metadata with an operand per kernel argument.
+constexpr const char *PerArgMDNames[] = {
+    "kernel_arg_addr_space",      "kernel_arg_access_qual",
+    "kernel_arg_type",            "kernel_arg_base_type",
+    "kernel_arg_type_qual",       "kernel_arg_name",
+    "kernel_arg_buffer_location", "kernel_arg_runtime_aligned",
+    "kernel_arg_exclusive_ptr",   "kernel_arg_accessor_ptr"};
+
+bool isTrue(const MDOperand &Op) {
+  auto *C = mdconst::dyn_extract<ConstantInt>(Op);
+  return C && !C->isZero();
+}
+
+// Returns the indices of the kernel arguments holding accessor fields which
+// can be packed. Accessor pointers are marked by "kernel_arg_runtime_aligned"
+// metadata, which refers to the arguments emitted by the front end, some of
+// which may have been removed by dead argument elimination.
+SmallVector<unsigned, 16> getPackableArgs(const Function &F) {
+  SmallVector<unsigned, 16> Res;
+  const MDNode *AccPtrs = F.getMetadata("kernel_arg_runtime_aligned");
+  if (!AccPtrs)
+    return Res;
+  unsigned NumFEArgs = AccPtrs->getNumOperands();
+  const MDNode *Omitted = F.getMetadata("sycl_kernel_omit_args");
+  if (Omitted && Omitted->getNumOperands() != NumFEArgs)
+    return Res;
+
+  // Maps front end argument indices to the current ones, -1 for removed
+  // arguments.
+  SmallVector<int, 16> ArgIdx(NumFEArgs, -1);
+  unsigned NumArgs = 0;
+  for (unsigned I = 0; I < NumFEArgs; ++I)
+    if (!Omitted || !isTrue(Omitted->getOperand(I)))
+      ArgIdx[I] = NumArgs++;
+  if (NumArgs != F.arg_size())
+    return Res;
+
+  std::optional<unsigned> AddrSpace;
+  for (unsigned I = 0; I < NumFEArgs; ++I) {
+    if (!isTrue(AccPtrs->getOperand(I)))
+      continue;
+    for (unsigned J = I + 1; J <= I + NumAccessorFields && J < NumFEArgs;
+         ++J) {
+      if (isTrue(AccPtrs->getOperand(J)))
+        break; // next accessor
+      if (ArgIdx[J] < 0)
+        continue;
+      const Argument *Arg = F.getArg(ArgIdx[J]);
+      Type *T = Arg->getParamByValType();
+      if (!T || !T->isSized())
+        continue;
+      // All the packed arguments are addressed through the same pointer
+      unsigned AS = Arg->getType()->getPointerAddressSpace();
+      if (AddrSpace && *AddrSpace != AS)
+        continue;
+      AddrSpace = AS;
+      Res.push_back(ArgIdx[J]);
+    }
+  }
+  return Res;
+}
+
+bool packAccessorArgs(Function &F) {
+  // Kernels are not expected to be called, but don't bother updating callers
+  if (!F.use_empty())
+    return false;
+  SmallVector<unsigned, 16> Packed = getPackableArgs(F);
+  // Packing a single argument does not save anything
+  if (Packed.size() < 2)
+    return false;
+
+  LLVMContext &Ctx = F.getContext();
+  const DataLayout &DL = F.getParent()->getDataLayout();
+  SmallVector<Type *, 16> FieldTys;
+  SmallVector<bool, 16> IsPacked(F.arg_size(), false);
+
+  for (unsigned I : Packed) {
+    FieldTys.push_back(F.getArg(I)->getParamByValType());
+    IsPacked[I] = true;
+  }
+  StructType *PackedTy = StructType::get(Ctx, FieldTys);
+  const StructLayout *SL = DL.getStructLayout(PackedTy);
+
+  // Create the new function with the packed argument appended
+  const AttributeList &PAL = F.getAttributes();
+  SmallVector<Type *, 16> Params;
+  SmallVector<AttributeSet, 16> ArgAttrs;
+
+  for (const Argument &Arg : F.args()) {
+    if (IsPacked[Arg.getArgNo()])
+      continue;
+    Params.push_back(Arg.getType());
+    ArgAttrs.push_back(PAL.getParamAttrs(Arg.getArgNo()));
+  }
+  Params.push_back(PointerType::get(
+      PackedTy, F.getArg(Packed.front())->getType()->getPointerAddressSpace()));
+  AttrBuilder PackedAttrs(Ctx);
+  PackedAttrs.addByValAttr(PackedTy);
+  PackedAttrs.addAlignmentAttr(SL->getAlignment());
+  ArgAttrs.push_back(AttributeSet::get(Ctx, PackedAttrs));
+
+  FunctionType *NFTy =
+      FunctionType::get(F.getReturnType(), Params, F.isVarArg());
+  Function *NF = Function::Create(NFTy, F.getLinkage(), F.getAddressSpace());
+  NF->copyAttributesFrom(&F);
+  NF->setComdat(F.getComdat());
+  NF->setAttributes(AttributeList::get(Ctx, PAL.getFnAttrs(),
+                                       PAL.getRetAttrs(), ArgAttrs));
+  F.getParent()->getFunctionList().insert(F.getIterator(), NF);
+  NF->takeName(&F);
+  NF->splice(NF->begin(), &F);
+
+  // Redirect the uses of the packed arguments to the fields of the packed one,
+  // which is passed by value as well.
+  Argument *PackedArg = NF->getArg(NF->arg_size() - 1);
+  PackedArg->setName("_arg__packed_accessor_fields");
+  IRBuilder<> Builder(&*NF->getEntryBlock().getFirstInsertionPt());
+  SmallVector<Metadata *, 16> PackedMD;
+  auto AddToMD = [&](uint64_t Val) {
+    PackedMD.push_back(ConstantAsMetadata::get(Builder.getInt32(Val)));
+  };
+  AddToMD(PackedArg->getArgNo());
+  AddToMD(SL->getSizeInBytes());
+  unsigned NewArgNo = 0;
+  unsigned FieldNo = 0;
+
+  for (Argument &Arg : F.args()) {
+    if (!IsPacked[Arg.getArgNo()]) {
+      Argument *NewArg = NF->getArg(NewArgNo++);
+      Arg.replaceAllUsesWith(NewArg);
+      NewArg->takeName(&Arg);
+      continue;
+    }
+    Value *Field =
+        Builder.CreateStructGEP(PackedTy, PackedArg, FieldNo, Arg.getName());
+    Arg.replaceAllUsesWith(Field);
+    AddToMD(Arg.getArgNo());
+    AddToMD(SL->getElementOffset(FieldNo));
+    AddToMD(DL.getTypeAllocSize(FieldTys[FieldNo]));
+    ++FieldNo;
+  }
+  NumArgsPacked += Packed.size();
+
+  SmallVector<std::pair<unsigned, MDNode *>, 8> MDs;
+  F.getAllMetadata(MDs);
+  for (auto [KindID, Node] : MDs)
+    NF->addMetadata(KindID, *Node);
+
+  // Keep the per-argument metadata in sync with the arguments. The packed
+  // argument inherits the entry of the first argument packed into it.
+  for (const char *Name : PerArgMDNames) {
+    MDNode *Node = NF->getMetadata(Name);
+    if (!Node || Node->getNumOperands() != F.arg_size())
+      continue;
+    SmallVector<Metadata *, 16> Ops;
+    for (unsigned I = 0; I < F.arg_size(); ++I)
+      if (!IsPacked[I])
+        Ops.push_back(Node->getOperand(I));
+    Ops.push_back(Node->getOperand(Packed.front()));
+    NF->setMetadata(Name, MDNode::get(Ctx, Ops));
+  }
+  NF->setMetadata(SYCL_KERNEL_PACKED_ARGS_MD, MDNode::get(Ctx, PackedMD));
+  F.eraseFromParent();
+  return true;
+}
+
+} // namespace
+
+PreservedAnalyses SYCLPackAccessorArgsPass::run(Module &M,
+                                                ModuleAnalysisManager &) {
+  SmallVector<Function *, 16> Kernels;
+
+  // DAE is not supported for ESIMD kernels, and neither are accessor ranges
+  // and offsets, so they are skipped here as well.
+  for (Function &F : M)
+    if (!F.isDeclaration() && F.getCallingConv() == CallingConv::SPIR_KERNEL &&
+        !F.getMetadata("sycl_explicit_simd"))
+      Kernels.push_back(&F);
+
+  bool Changed = false;
+  for (Function *F : Kernels)
+    Changed |= packAccessorArgs(*F);
+  return Changed ? PreservedAnalyses::none() : PreservedAnalyses::all();
+}
@@ -0,0 +1,6 @@
+define void @conflict() {
+  ret void
+}
+
+!llvm.module.flags = !{!0}
+!0 = !{i32 1, !"flag", i32 2}
@@ -0,0 +1,6 @@
+define void @transitive() {
+  ret void
+}
+
+!llvm.ident = !{!0}
+!0 = !{!"transitive"}
@@ -0,0 +1,6 @@
+define void @unused() {
+  ret void
+}
+
+!llvm.ident = !{!0}
+!0 = !{!"unused"}
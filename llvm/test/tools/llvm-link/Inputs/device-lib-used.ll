@@ -0,0 +1,9 @@
+define void @used() {
+  call void @transitive()
+  ret void
+}
+
+declare void @transitive()
+
+!llvm.ident = !{!0}
+!0 = !{!"used"}
@@ -0,0 +1,51 @@
+; RUN: llvm-as %s -o %t.main.bc
+; RUN: llvm-as %p/Inputs/device-lib-used.ll -o %t.used.bc
+; RUN: llvm-as %p/Inputs/device-lib-transitive.ll -o %t.transitive.bc
+; RUN: llvm-as %p/Inputs/device-lib-unused.ll -o %t.unused.bc
+; RUN: llvm-as %p/Inputs/device-lib-conflict.ll -o %t.conflict.bc
+
+; By default, -only-needed links the named metadata of all libraries, even if
+; nothing else is needed from them.
+; RUN: llvm-link -only-needed %t.main.bc %t.unused.bc %t.used.bc \
+; RUN:   %t.transitive.bc -S -o - | FileCheck %s --check-prefixes=CHECK,NOSKIP
+
+; With -skip-unneeded-device-libs, libraries which define nothing the linked
+; module needs are skipped, including their named metadata. A library becomes
+; needed by a library linked before it.
+; RUN: llvm-link -only-needed -skip-unneeded-device-libs -v %t.main.bc \
+; RUN:   %t.unused.bc %t.used.bc %t.transitive.bc -S -o %t.skip.ll 2>&1 \
+; RUN:   | FileCheck %s --check-prefix=VERBOSE
+; RUN: FileCheck %s --implicit-check-not=unused < %t.skip.ll
+
+; Conflicting module flags of unneeded libraries are only diagnosed if the
+; libraries are not skipped.
+; RUN: not llvm-link -only-needed %t.main.bc %t.conflict.bc -S -o - 2>&1 \
+; RUN:   | FileCheck %s --check-prefix=CONFLICT
+; RUN: llvm-link -only-needed -skip-unneeded-device-libs %t.main.bc \
+; RUN:   %t.conflict.bc -S -o - | FileCheck %s --check-prefix=NO-CONFLICT
+
+; VERBOSE: Linking in '{{.*}}main.bc'
+; VERBOSE: Skipping '{{.*}}unused.bc', no symbols needed
+; VERBOSE: Linking in '{{.*}}used.bc'
+; VERBOSE: Linking in '{{.*}}transitive.bc'
+
+; CHECK-DAG: define void @main()
+; CHECK-DAG: define void @used()
+; CHECK-DAG: define void @transitive()
+; CHECK-DAG: !{!"used"}
+; CHECK-DAG: !{!"transitive"}
+; NOSKIP-DAG: !{!"unused"}
+
+; CONFLICT: linking module flags 'flag': IDs have conflicting values
+
+; NO-CONFLICT: !{i32 1, !"flag", i32 1}
+
+define void @main() {
+  call void @used()
+  ret void
+}
+
+declare void @used()
+
+!llvm.module.flags = !{!0}
+!0 = !{i32 1, !"flag", i32 1}
@@ -0,0 +1,91 @@
+; This test checks that the outputs of sycl-post-link are cached by the input
+; module and the options. A hit recreates the output files and the table from
+; the cache entry, a miss or a corrupted entry processes the module.
+
+; RUN: rm -rf %t.cache %t.other-cache %t.dir && mkdir %t.dir
+; RUN: sed -e 's/Kernel/Other/g' %s > %t.dir/other.ll
+
+;; A miss stores a single entry, along with the timestamp of the pruning.
+; RUN: sycl-post-link -split=kernel -symbols -cache-dir=%t.cache \
+; RUN:   -o %t.dir/miss.table %s
+; RUN: ls %t.cache | count 2
+; RUN: FileCheck %s -input-file=%t.dir/miss.table -check-prefix=TABLE \
+; RUN:   -DSTEM=miss
+; RUN: cat %t.dir/miss_0.sym %t.dir/miss_1.sym \
+; RUN:   | FileCheck %s -check-prefix=SYMS
+
+;; A hit recreates the same files under the new output names.
+; RUN: sycl-post-link -split=kernel -symbols -cache-dir=%t.cache -j 2 \
+; RUN:   -o %t.dir/hit.table %s
+; RUN: ls %t.cache | count 2
+; RUN: FileCheck %s -input-file=%t.dir/hit.table -check-prefix=TABLE \
+; RUN:   -DSTEM=hit
+; RUN: cmp %t.dir/miss_0.bc %t.dir/hit_0.bc
+; RUN: cmp %t.dir/miss_0.prop %t.dir/hit_0.prop
+; RUN: cmp %t.dir/miss_0.sym %t.dir/hit_0.sym
+; RUN: cmp %t.dir/miss_1.bc %t.dir/hit_1.bc
+; RUN: cmp %t.dir/miss_1.prop %t.dir/hit_1.prop
+; RUN: cmp %t.dir/miss_1.sym %t.dir/hit_1.sym
+
+;; The module is not processed on a hit: replacing the entry by the one of
+;; another module makes the outputs of that module appear.
+; RUN: sycl-post-link -split=kernel -symbols -cache-dir=%t.other-cache \
+; RUN:   -o %t.dir/other.table %t.dir/other.ll
+; RUN: cp %t.other-cache/llvmcache-* %t.cache/llvmcache-*
+; RUN: sycl-post-link -split=kernel -symbols -cache-dir=%t.cache \
+; RUN:   -o %t.dir/swapped.table %s
+; RUN: cat %t.dir/swapped_0.sym %t.dir/swapped_1.sym \
+; RUN:   | FileCheck %s -check-prefix=OTHER-SYMS
+
+;; A corrupted entry is a miss, the entry is stored again.
+; RUN: echo garbage > %t.dir/garbage
+; RUN: cp %t.dir/garbage %t.cache/llvmcache-*
+; RUN: sycl-post-link -split=kernel -symbols -cache-dir=%t.cache \
+; RUN:   -o %t.dir/corrupted.table %s
+; RUN: ls %t.cache | count 2
+; RUN: FileCheck %s -input-file=%t.dir/corrupted.table -check-prefix=TABLE \
+; RUN:   -DSTEM=corrupted
+; RUN: cat %t.dir/corrupted_0.sym %t.dir/corrupted_1.sym \
+; RUN:   | FileCheck %s -check-prefix=SYMS
+; RUN: not cmp %t.dir/garbage %t.cache/llvmcache-*
+; RUN: sycl-post-link -split=kernel -symbols -cache-dir=%t.cache \
+; RUN:   -o %t.dir/rehit.table %s
+; RUN: cmp %t.dir/miss_0.bc %t.dir/rehit_0.bc
+; RUN: cmp %t.dir/miss_1.bc %t.dir/rehit_1.bc
+
+;; Different options miss.
+; RUN: sycl-post-link -split=kernel -cache-dir=%t.cache \
+; RUN:   -o %t.dir/nosym.table %s
+; RUN: ls %t.cache | count 3
+; RUN: FileCheck %s -input-file=%t.dir/nosym.table -check-prefix=TABLE-NOSYM
+
+; TABLE: [Code|Properties|Symbols]
+; TABLE-NEXT: {{.*}}[[STEM]]_0.bc|{{.*}}[[STEM]]_0.prop|{{.*}}[[STEM]]_0.sym
+; TABLE-NEXT: {{.*}}[[STEM]]_1.bc|{{.*}}[[STEM]]_1.prop|{{.*}}[[STEM]]_1.sym
+; TABLE-EMPTY:
+
+; TABLE-NOSYM: [Code|Properties]
+; TABLE-NOSYM-NEXT: {{.*}}nosym_0.bc|{{.*}}nosym_0.prop
+; TABLE-NOSYM-NEXT: {{.*}}nosym_1.bc|{{.*}}nosym_1.prop
+; TABLE-NOSYM-EMPTY:
+
+; SYMS-DAG: {{^}}KernelA{{$}}
+; SYMS-DAG: {{^}}KernelB{{$}}
+
+; OTHER-SYMS-DAG: {{^}}OtherA{{$}}
+; OTHER-SYMS-DAG: {{^}}OtherB{{$}}
+
+target datalayout = "e-i64:64-v16:16-v24:32-v32:32-v48:64-v96:128-v192:256-v256:256-v512:512-v1024:1024-n8:16:32:64"
+target triple = "spir64-unknown-unknown"
+
+define spir_kernel void @KernelA() #0 {
+entry:
+  ret void
+}
+
+define spir_kernel void @KernelB() #0 {
+entry:
+  ret void
+}
+
+attributes #0 = { "sycl-module-id"="device-code-cache.cpp" }
@@ -0,0 +1,125 @@
+; This test checks the balanced device code split. Kernels sharing code are
+; grouped into modules of about -split-target-size LLVM IR instructions,
+; regardless of the translation unit they come from, and the size of each
+; module is recorded in its properties.
+
+; The closures of KernelA and KernelB take 14 instructions each and share the
+; 11 instructions of @helper, KernelC takes 10 and KernelD takes 1.
+; - KernelA starts the first module (14).
+; - KernelB joins it, as it only adds 3 instructions (17).
+; - KernelC would exceed the target size of 20 there, so it starts the second
+;   module (10).
+; - KernelD fits in both and shares no code with either, so it joins the
+;   fullest one (18).
+; RUN: sycl-post-link -split=balanced -split-target-size=20 -symbols \
+; RUN:   -o %t.table %s
+; RUN: FileCheck %s -input-file=%t.table -check-prefix=TABLE2
+; RUN: FileCheck %s -input-file=%t_0.sym -check-prefix=SYM0
+; RUN: FileCheck %s -input-file=%t_1.sym -check-prefix=SYM1
+; RUN: FileCheck %s -input-file=%t_0.prop -check-prefix=PROP0
+; RUN: FileCheck %s -input-file=%t_1.prop -check-prefix=PROP1
+
+; TABLE2: [Code|Properties|Symbols]
+; TABLE2-NEXT: {{.*}}_0.bc|{{.*}}_0.prop|{{.*}}_0.sym
+; TABLE2-NEXT: {{.*}}_1.bc|{{.*}}_1.prop|{{.*}}_1.sym
+; TABLE2-EMPTY:
+
+; SYM0: KernelA
+; SYM0-NEXT: KernelB
+; SYM0-NEXT: KernelD
+; SYM0-EMPTY:
+
+; SYM1: KernelC
+; SYM1-EMPTY:
+
+; PROP0: [SYCL/misc properties]
+; PROP0: irInstructionCount=1|18
+; PROP1: [SYCL/misc properties]
+; PROP1: irInstructionCount=1|10
+
+; With a target size smaller than any kernel, each kernel gets its own module.
+; RUN: sycl-post-link -split=balanced -split-target-size=1 -symbols \
+; RUN:   -o %t.small.table %s
+; RUN: FileCheck %s -input-file=%t.small.table -check-prefix=TABLE4
+; RUN: FileCheck %s -input-file=%t.small_0.prop -check-prefix=PROP-A
+; RUN: FileCheck %s -input-file=%t.small_3.prop -check-prefix=PROP-D
+
+; TABLE4: [Code|Properties|Symbols]
+; TABLE4-NEXT: {{.*}}_0.bc|{{.*}}_0.prop|{{.*}}_0.sym
+; TABLE4-NEXT: {{.*}}_1.bc|{{.*}}_1.prop|{{.*}}_1.sym
+; TABLE4-NEXT: {{.*}}_2.bc|{{.*}}_2.prop|{{.*}}_2.sym
+; TABLE4-NEXT: {{.*}}_3.bc|{{.*}}_3.prop|{{.*}}_3.sym
+; TABLE4-EMPTY:
+
+; PROP-A: irInstructionCount=1|14
+; PROP-D: irInstructionCount=1|1
+
+; With the default target size, all the kernels go into a single module.
+; RUN: sycl-post-link -split=balanced -symbols -o %t.default.table %s
+; RUN: FileCheck %s -input-file=%t.default.table -check-prefix=TABLE1
+; RUN: FileCheck %s -input-file=%t.default_0.prop -check-prefix=PROP-ALL
+
+; TABLE1: [Code|Properties|Symbols]
+; TABLE1-NEXT: {{.*}}_0.bc|{{.*}}_0.prop|{{.*}}_0.sym
+; TABLE1-EMPTY:
+
+; PROP-ALL: irInstructionCount=1|28
+
+; Other split modes do not record the size.
+; RUN: sycl-post-link -split=source -symbols -o %t.source.table %s
+; RUN: FileCheck %s -input-file=%t.source_0.prop -check-prefix=NO-SIZE
+; NO-SIZE-NOT: irInstructionCount
+
+target datalayout = "e-i64:64-v16:16-v24:32-v32:32-v48:64-v96:128-v192:256-v256:256-v512:512-v1024:1024-n8:16:32:64"
+target triple = "spir64-unknown-unknown"
+
+define spir_kernel void @KernelA(i32 %X, ptr addrspace(1) %P) #0 {
+entry:
+  %R = call i32 @helper(i32 %X)
+  store i32 %R, ptr addrspace(1) %P
+  ret void
+}
+
+define spir_kernel void @KernelB(i32 %X, ptr addrspace(1) %P) #0 {
+entry:
+  %R = call i32 @helper(i32 %X)
+  store i32 %R, ptr addrspace(1) %P
+  ret void
+}
+
+define spir_kernel void @KernelC(i32 %X, ptr addrspace(1) %P) #1 {
+entry:
+  %A1 = add i32 %X, 1
+  %A2 = add i32 %A1, 2
+  %A3 = add i32 %A2, 3
+  %A4 = add i32 %A3, 4
+  %A5 = add i32 %A4, 5
+  %A6 = add i32 %A5, 6
+  %A7 = add i32 %A6, 7
+  %A8 = add i32 %A7, 8
+  store i32 %A8, ptr addrspace(1) %P
+  ret void
+}
+
+define spir_kernel void @KernelD() #1 {
+entry:
+  ret void
+}
+
+define internal i32 @helper(i32 %X) {
+entry:
+  %A1 = add i32 %X, 1
+  %A2 = add i32 %A1, 2
+  %A3 = add i32 %A2, 3
+  %A4 = add i32 %A3, 4
+  %A5 = add i32 %A4, 5
+  %A6 = add i32 %A5, 6
+  %A7 = add i32 %A6, 7
+  %A8 = add i32 %A7, 8
+  %A9 = add i32 %A8, 9
+  %A10 = add i32 %A9, 10
+  ret i32 %A10
+}
+
+attributes #0 = { "sycl-module-id"="a.cpp" }
+attributes #1 = { "sycl-module-id"="b.cpp" }
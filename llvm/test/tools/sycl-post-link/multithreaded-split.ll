@@ -0,0 +1,75 @@
+; This test checks that processing the device code splits concurrently
+; produces the same file table and files as processing them serially, and that
+; errors of the workers are reported by the main thread in split order.
+
+; RUN: rm -rf %t.j1 %t.j4 %t.budget && mkdir %t.j1 %t.j4 %t.budget
+; RUN: cd %t.j1 && sycl-post-link -split=kernel -symbols -emit-param-info \
+; RUN:   -j 1 -o out.table %s
+; RUN: cd %t.j4 && sycl-post-link -split=kernel -symbols -emit-param-info \
+; RUN:   -j 4 -o out.table %s
+; RUN: cd %t.budget && sycl-post-link -split=kernel -symbols -emit-param-info \
+; RUN:   -j 4 -split-memory-budget=1 -o out.table %s
+; RUN: FileCheck %s -input-file=%t.j1/out.table
+; RUN: cmp %t.j1/out.table %t.j4/out.table
+; RUN: cmp %t.j1/out.table %t.budget/out.table
+; RUN: cmp %t.j1/out_0.bc %t.j4/out_0.bc
+; RUN: cmp %t.j1/out_0.prop %t.j4/out_0.prop
+; RUN: cmp %t.j1/out_0.sym %t.j4/out_0.sym
+; RUN: cmp %t.j1/out_1.bc %t.j4/out_1.bc
+; RUN: cmp %t.j1/out_1.prop %t.j4/out_1.prop
+; RUN: cmp %t.j1/out_1.sym %t.j4/out_1.sym
+; RUN: cmp %t.j1/out_2.bc %t.j4/out_2.bc
+; RUN: cmp %t.j1/out_2.prop %t.j4/out_2.prop
+; RUN: cmp %t.j1/out_2.sym %t.j4/out_2.sym
+; RUN: cmp %t.j1/out_3.bc %t.j4/out_3.bc
+; RUN: cmp %t.j1/out_3.prop %t.j4/out_3.prop
+; RUN: cmp %t.j1/out_3.sym %t.j4/out_3.sym
+; RUN: cmp %t.j1/out_3.bc %t.budget/out_3.bc
+; RUN: cmp %t.j1/out_3.prop %t.budget/out_3.prop
+; RUN: cmp %t.j1/out_3.sym %t.budget/out_3.sym
+
+; RUN: not sycl-post-link -split=kernel -symbols -j 4 \
+; RUN:   -o %t.missing/out.table %s 2>&1 | FileCheck %s -check-prefix=ERROR
+
+; CHECK: [Code|Properties|Symbols]
+; CHECK-NEXT: out_0.bc|out_0.prop|out_0.sym
+; CHECK-NEXT: out_1.bc|out_1.prop|out_1.sym
+; CHECK-NEXT: out_2.bc|out_2.prop|out_2.sym
+; CHECK-NEXT: out_3.bc|out_3.prop|out_3.sym
+; CHECK-EMPTY:
+
+; ERROR: sycl-post-link: error opening the file '{{.*}}out_0.bc'
+; ERROR-NOT: sycl-post-link:
+
+target datalayout = "e-i64:64-v16:16-v24:32-v32:32-v48:64-v96:128-v192:256-v256:256-v512:512-v1024:1024-n8:16:32:64"
+target triple = "spir64-unknown-unknown"
+
+define spir_kernel void @Kernel0(i32 %Used, i32 %Unused) #0 {
+entry:
+  call void @helper(i32 %Used)
+  ret void
+}
+
+define spir_kernel void @Kernel1(i32 %Used) #0 {
+entry:
+  call void @helper(i32 %Used)
+  ret void
+}
+
+define spir_kernel void @Kernel2() #0 {
+entry:
+  ret void
+}
+
+define spir_kernel void @Kernel3(ptr addrspace(1) %Ptr) #0 {
+entry:
+  store i32 0, ptr addrspace(1) %Ptr
+  ret void
+}
+
+define internal void @helper(i32 %Value) {
+entry:
+  ret void
+}
+
+attributes #0 = { "sycl-module-id"="multithreaded-split.cpp" }
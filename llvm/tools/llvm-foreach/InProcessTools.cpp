@@ -0,0 +1,494 @@
+//===- InProcessTools.cpp - Tools run inside llvm-foreach -----------------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#include "InProcessTools.h"
+
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/StringSwitch.h"
+#include "llvm/BinaryFormat/Magic.h"
+#include "llvm/Bitcode/BitcodeReader.h"
+#include "llvm/Bitcode/BitcodeWriter.h"
+#include "llvm/IR/AutoUpgrade.h"
+#include "llvm/IR/DiagnosticInfo.h"
+#include "llvm/IR/DiagnosticPrinter.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
+#include "llvm/IR/Verifier.h"
+#include "llvm/IRReader/IRReader.h"
+#include "llvm/Linker/Linker.h"
+#include "llvm/Object/IRSymbolIndex.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/SourceMgr.h"
+#include "llvm/Support/ToolOutputFile.h"
+#include "llvm/Support/raw_ostream.h"
+
+#ifdef LLVM_FOREACH_HAS_SPIRV
+#include "LLVMSPIRVLib.h"
+#include "LLVMSPIRVOpts.h"
+
+#include <fstream>
+#endif // LLVM_FOREACH_HAS_SPIRV
+
+#include <mutex>
+#include <string>
+#include <vector>
+
+using namespace llvm;
+using namespace llvm::foreach;
+
+namespace {
+
+// Serializes the diagnostics of tools running concurrently.
+void reportError(StringRef Tool, const Twine &Msg) {
+  static std::mutex ErrorMutex;
+  std::lock_guard<std::mutex> Lock{ErrorMutex};
+  errs() << Tool << ": " << Msg << '\n';
+}
+
+// An option of a command line in the form "-name", "--name" or "-name=value".
+struct ParsedOption {
+  StringRef Name;
+  std::optional<StringRef> Value;
+};
+
+std::optional<ParsedOption> parseOption(StringRef Arg) {
+  if (!Arg.consume_front("-") || Arg.empty())
+    return std::nullopt;
+  Arg.consume_front("-");
+  auto [Name, Value] = Arg.split('=');
+  if (Name.size() == Arg.size())
+    return ParsedOption{Name, std::nullopt};
+  return ParsedOption{Name, Value};
+}
+
+// Location of a file name in a command line.
+struct FileArg {
+  size_t Index = 0;
+  // Length of the option name preceding the file name in the argument, e.g.
+  // for "-o=file".
+  size_t PrefixLength = 0;
+
+  StringRef get(ArrayRef<StringRef> Args) const {
+    return Args[Index].drop_front(PrefixLength);
+  }
+};
+
+// Handles the output file option "-o". Returns false if the command line is
+// malformed.
+bool parseOutputOption(ArrayRef<StringRef> Args, size_t &I,
+                       const ParsedOption &Opt, std::optional<FileArg> &Out) {
+  if (Out)
+    return false;
+  if (Opt.Value) {
+    Out = FileArg{I, Args[I].size() - Opt.Value->size()};
+    return true;
+  }
+  if (++I == Args.size())
+    return false;
+  Out = FileArg{I, 0};
+  return true;
+}
+
+// Returns true if the file is LLVM bitcode.
+bool isBitcodeFile(StringRef Path) {
+  file_magic Magic;
+  return !identify_magic(Path, Magic) && Magic == file_magic::bitcode;
+}
+
+// Records whether errors were diagnosed instead of exiting the process, which
+// is what the default diagnostic handler does.
+struct ErrorRecordingHandler : public DiagnosticHandler {
+  StringRef Tool;
+  bool SuppressWarnings;
+  bool HasErrors = false;
+
+  ErrorRecordingHandler(StringRef Tool, bool SuppressWarnings)
+      : Tool(Tool), SuppressWarnings(SuppressWarnings) {}
+
+  bool handleDiagnostics(const DiagnosticInfo &DI) override {
+    if (DI.getSeverity() == DS_Error)
+      HasErrors = true;
+    else if (DI.getSeverity() != DS_Warning || SuppressWarnings)
+      return true;
+    std::string Msg;
+    raw_string_ostream OS{Msg};
+    DiagnosticPrinterRawOStream DP{OS};
+    OS << LLVMContext::getDiagnosticMessagePrefix(DI.getSeverity()) << ": ";
+    DI.print(DP);
+    reportError(Tool, OS.str());
+    return true;
+  }
+};
+
+//===----------------------------------------------------------------------===//
+// llvm-link
+//===----------------------------------------------------------------------===//
+
+// A bitcode library linked with -only-needed. The links run by llvm-foreach
+// mostly link the same device libraries, so they are read and indexed once
+// per process.
+struct LibraryIndex {
+  std::unique_ptr<MemoryBuffer> Buffer;
+  object::IRSymbolIndex Symbols;
+
+  // Builds the index from the symbol table bitcode writers emit, without
+  // parsing the module.
+  static std::unique_ptr<LibraryIndex> create(StringRef Path) {
+    ErrorOr<std::unique_ptr<MemoryBuffer>> Buffer =
+        MemoryBuffer::getFile(Path, /*IsText=*/false,
+                              /*RequiresNullTerminator=*/false);
+    if (!Buffer)
+      return nullptr;
+    Expected<object::IRSymbolIndex> Symbols =
+        object::IRSymbolIndex::create((*Buffer)->getMemBufferRef());
+    if (!Symbols) {
+      consumeError(Symbols.takeError());
+      return nullptr;
+    }
+    return std::make_unique<LibraryIndex>(
+        LibraryIndex{std::move(*Buffer), std::move(*Symbols)});
+  }
+
+  // Returns the index of the library at Path, or nullptr if it can't be
+  // indexed.
+  static const LibraryIndex *get(StringRef Path) {
+    static std::mutex CacheMutex;
+    static StringMap<std::unique_ptr<LibraryIndex>> Cache;
+    std::lock_guard<std::mutex> Lock{CacheMutex};
+    auto [It, Inserted] = Cache.try_emplace(Path);
+    if (Inserted)
+      It->second = create(Path);
+    return It->second.get();
+  }
+};
+
+// Links IR files into a single bitcode file, like "llvm-link -o out in...".
+class LinkTool : public InProcessTool {
+  std::vector<size_t> Inputs;
+  FileArg Output;
+  unsigned LinkFlags = Linker::Flags::None;
+  bool SkipUnneededDeviceLibs = false;
+  bool SuppressWarnings = false;
+
+public:
+  static std::unique_ptr<LinkTool> create(ArrayRef<StringRef> Args) {
+    auto Tool = std::make_unique<LinkTool>();
+    std::optional<FileArg> Output;
+    for (size_t I = 1; I < Args.size(); ++I) {
+      std::optional<ParsedOption> Opt = parseOption(Args[I]);
+      if (!Opt) {
+        Tool->Inputs.push_back(I);
+        continue;
+      }
+      if (Opt->Name == "o") {
+        if (!parseOutputOption(Args, I, *Opt, Output))
+          return nullptr;
+        continue;
+      }
+      if (Opt->Value)
+        return nullptr;
+      if (Opt->Name == "only-needed")
+        Tool->LinkFlags |= Linker::Flags::LinkOnlyNeeded;
+      else if (Opt->Name == "skip-unneeded-device-libs")
+        Tool->SkipUnneededDeviceLibs = true;
+      else if (Opt->Name == "suppress-warnings")
+        Tool->SuppressWarnings = true;
+      else if (Opt->Name != "f")
+        return nullptr;
+    }
+    if (!Output || Tool->Inputs.empty())
+      return nullptr;
+    Tool->Output = *Output;
+    return Tool;
+  }
+
+  std::optional<int> run(ArrayRef<StringRef> Args) const override {
+    // Archives and other inputs are left to llvm-link.
+    for (size_t I : Inputs) {
+      file_magic Magic;
+      if (identify_magic(Args[I], Magic) ||
+          (Magic != file_magic::bitcode && Magic != file_magic::unknown))
+        return std::nullopt;
+    }
+
+    LLVMContext Ctx;
+    auto Handler =
+        std::make_unique<ErrorRecordingHandler>("llvm-link", SuppressWarnings);
+    const bool &HasErrors = Handler->HasErrors;
+    Ctx.setDiagnosticHandler(std::move(Handler), /*RespectFilters=*/true);
+    auto Composite = std::make_unique<Module>("llvm-link", Ctx);
+    Linker L{*Composite};
+    for (size_t I : Inputs) {
+      // Like in llvm-link, only OverrideFromSrc applies to the first file.
+      const bool IsFirst = I == Inputs.front();
+      const bool OnlyNeeded =
+          !IsFirst && (LinkFlags & Linker::Flags::LinkOnlyNeeded);
+      const LibraryIndex *Lib =
+          OnlyNeeded ? LibraryIndex::get(Args[I]) : nullptr;
+      if (Lib && SkipUnneededDeviceLibs &&
+          !Lib->Symbols.isNeededBy(*Composite))
+        continue;
+
+      SMDiagnostic Err;
+      std::unique_ptr<Module> M;
+      if (Lib) {
+        // Only the needed functions are materialized by the linker.
+        M = getLazyIRModule(
+            MemoryBuffer::getMemBuffer(Lib->Buffer->getMemBufferRef(),
+                                       /*RequiresNullTerminator=*/false),
+            Err, Ctx);
+        if (M) {
+          if (Error E = M->materializeMetadata()) {
+            reportError("llvm-link", toString(std::move(E)));
+            return 1;
+          }
+          UpgradeDebugInfo(*M);
+        }
+      } else {
+        M = parseIRFile(Args[I], Err, Ctx);
+      }
+      if (!M) {
+        std::string Msg;
+        raw_string_ostream OS{Msg};
+        Err.print("llvm-link", OS);
+        reportError("llvm-link", OS.str());
+        return 1;
+      }
+      unsigned Flags =
+          IsFirst ? LinkFlags & Linker::Flags::OverrideFromSrc : LinkFlags;
+      if (L.linkInModule(std::move(M), Flags) || HasErrors)
+        return 1;
+    }
+    // Buffer the verifier output, so that it is not interleaved with the
+    // diagnostics of other jobs.
+    std::string VerifierMsg;
+    raw_string_ostream VerifierOS{VerifierMsg};
+    if (verifyModule(*Composite, &VerifierOS)) {
+      reportError("llvm-link", VerifierOS.str() + "linked module is broken!");
+      return 1;
+    }
+
+    std::error_code EC;
+    ToolOutputFile Out{Output.get(Args), EC, sys::fs::OF_None};
+    if (EC) {
+      reportError("llvm-link", EC.message());
+      return 1;
+    }
+    WriteBitcodeToFile(*Composite, Out.os());
+    Out.keep();
+    return 0;
+  }
+};
+
+//===----------------------------------------------------------------------===//
+// llvm-spirv
+//===----------------------------------------------------------------------===//
+
+#ifdef LLVM_FOREACH_HAS_SPIRV
+// Translates an LLVM bitcode file to SPIR-V, like "llvm-spirv -o out in".
+// Only the options used for device code compilation are supported, any other
+// option makes llvm-foreach spawn llvm-spirv.
+class SPIRVTranslatorTool : public InProcessTool {
+  FileArg Input;
+  FileArg Output;
+  SPIRV::TranslatorOpts Opts;
+  // Storage of the prefixes referenced by Opts.
+  std::vector<std::string> UnknownIntrinsicPrefixes;
+
+public:
+  static std::unique_ptr<SPIRVTranslatorTool>
+  create(ArrayRef<StringRef> Args) {
+    using namespace SPIRV;
+    auto Tool = std::make_unique<SPIRVTranslatorTool>();
+    std::optional<FileArg> Input;
+    std::optional<FileArg> Output;
+    VersionNumber MaxVersion = VersionNumber::MaximumVersion;
+    std::vector<std::string> ExtOptions;
+    std::optional<DebugInfoEIS> DebugEIS;
+    FPContractMode FPCMode = FPContractMode::On;
+    std::optional<bool> ReplaceFmulAdd;
+    bool AllowUnknownIntrinsics = false;
+    bool AllowExtraDIExpressions = false;
+    bool PreserveAuxData = false;
+    bool PreserveKernelArgTypeMD = false;
+
+    for (size_t I = 1; I < Args.size(); ++I) {
+      std::optional<ParsedOption> Opt = parseOption(Args[I]);
+      if (!Opt) {
+        if (Input)
+          return nullptr;
+        Input = FileArg{I, 0};
+        continue;
+      }
+      StringRef Name = Opt->Name;
+      StringRef Value = Opt->Value.value_or("");
+      if (Name == "o") {
+        if (!parseOutputOption(Args, I, *Opt, Output))
+          return nullptr;
+      } else if (Name == "spirv-max-version") {
+        std::optional<VersionNumber> V =
+            StringSwitch<std::optional<VersionNumber>>(Value)
+                .Case("1.0", VersionNumber::SPIRV_1_0)
+                .Case("1.1", VersionNumber::SPIRV_1_1)
+                .Case("1.2", VersionNumber::SPIRV_1_2)
+                .Case("1.3", VersionNumber::SPIRV_1_3)
+                .Case("1.4", VersionNumber::SPIRV_1_4)
+                .Default(std::nullopt);
+        if (!V)
+          return nullptr;
+        MaxVersion = *V;
+      } else if (Name == "spirv-ext" && Opt->Value) {
+        SmallVector<StringRef, 16> Exts;
+        Value.split(Exts, ',');
+        for (StringRef Ext : Exts)
+          ExtOptions.push_back(Ext.str());
+      } else if (Name == "spirv-debug-info-version") {
+        DebugEIS = StringSwitch<std::optional<DebugInfoEIS>>(Value)
+                       .Case("legacy", DebugInfoEIS::SPIRV_Debug)
+                       .Case("ocl-100", DebugInfoEIS::OpenCL_DebugInfo_100)
+                       .Case("nonsemantic-shader-100",
+                             DebugInfoEIS::NonSemantic_Shader_DebugInfo_100)
+                       .Case("nonsemantic-shader-200",
+                             DebugInfoEIS::NonSemantic_Shader_DebugInfo_200)
+                       .Default(std::nullopt);
+        if (!DebugEIS)
+          return nullptr;
+      } else if (Name == "spirv-fp-contract") {
+        std::optional<FPContractMode> Mode =
+            StringSwitch<std::optional<FPContractMode>>(Value)
+                .Case("on", FPContractMode::On)
+                .Case("off", FPContractMode::Off)
+                .Case("fast", FPContractMode::Fast)
+                .Default(std::nullopt);
+        if (!Mode)
+          return nullptr;
+        FPCMode = *Mode;
+      } else if (Name == "spirv-allow-unknown-intrinsics") {
+        AllowUnknownIntrinsics = true;
+        // Without a value, all unknown intrinsics are allowed, which is
+        // expressed by an empty prefix.
+        SmallVector<StringRef, 4> Prefixes;
+        Value.split(Prefixes, ',');
+        for (StringRef Prefix : Prefixes)
+          Tool->UnknownIntrinsicPrefixes.push_back(Prefix.str());
+      } else if (Name == "spirv-replace-fmuladd-with-ocl-mad") {
+        if (Value.empty() || Value == "true" || Value == "1")
+          ReplaceFmulAdd = true;
+        else if (Value == "false" || Value == "0")
+          ReplaceFmulAdd = false;
+        else
+          return nullptr;
+      } else if (Opt->Value) {
+        return nullptr;
+      } else if (Name == "spirv-allow-extra-diexpressions") {
+        AllowExtraDIExpressions = true;
+      } else if (Name == "spirv-preserve-auxdata") {
+        PreserveAuxData = true;
+      } else if (Name ==
+                 "spirv-preserve-ocl-kernel-arg-type-metadata-through-string") {
+        PreserveKernelArgTypeMD = true;
+      } else {
+        return nullptr;
+      }
+    }
+    if (!Input || !Output || Output->get(Args) == "-")
+      return nullptr;
+    Tool->Input = *Input;
+    Tool->Output = *Output;
+
+    // The options are applied by the same library functions as in llvm-spirv.
+    // Invalid values make llvm-foreach spawn llvm-spirv, which diagnoses them.
+    // Known extensions are disallowed by default in the translation to SPIR-V.
+    TranslatorOpts::ExtensionsStatusMap ExtensionsStatus;
+    std::string ErrMsg;
+    if (!parseSPIRVExtOption(ExtOptions, /*DefaultStatus=*/std::nullopt,
+                             ExtensionsStatus, ErrMsg))
+      return nullptr;
+
+    TranslatorOpts &Opts = Tool->Opts;
+    Opts = TranslatorOpts{MaxVersion, ExtensionsStatus};
+    Opts.setFPContractMode(FPCMode);
+    if (PreserveAuxData)
+      Opts.enablePreserveAuxDataForSPIRV();
+    if (AllowUnknownIntrinsics) {
+      TranslatorOpts::ArgList PrefixList;
+      for (const std::string &Prefix : Tool->UnknownIntrinsicPrefixes)
+        PrefixList.push_back(Prefix);
+      Opts.setSPIRVAllowUnknownIntrinsics(PrefixList);
+    }
+    if (ReplaceFmulAdd)
+      Opts.setReplaceLLVMFmulAddWithOpenCLMad(*ReplaceFmulAdd);
+    if (AllowExtraDIExpressions)
+      Opts.setAllowExtraDIExpressionsEnabled(true);
+    if (DebugEIS)
+      Opts.setDebugInfoEISForSPIRV(*DebugEIS);
+    if (PreserveKernelArgTypeMD)
+      Opts.setPreserveOCLKernelArgTypeMetadataThroughString(true);
+    return Tool;
+  }
+
+  std::optional<int> run(ArrayRef<StringRef> Args) const override {
+    // Empty files and other unexpected inputs are diagnosed by llvm-spirv.
+    StringRef InputFile = Input.get(Args);
+    if (!isBitcodeFile(InputFile))
+      return std::nullopt;
+
+    LLVMContext Ctx;
+    Ctx.setDiagnosticHandler(
+        std::make_unique<ErrorRecordingHandler>("llvm-spirv",
+                                                /*SuppressWarnings=*/false),
+        /*RespectFilters=*/true);
+    ErrorOr<std::unique_ptr<MemoryBuffer>> MBOrErr =
+        MemoryBuffer::getFile(InputFile);
+    if (!MBOrErr) {
+      reportError("llvm-spirv",
+                  InputFile + ": " + MBOrErr.getError().message());
+      return 1;
+    }
+    Expected<std::unique_ptr<Module>> MOrErr =
+        getOwningLazyBitcodeModule(std::move(*MBOrErr), Ctx,
+                                   /*ShouldLazyLoadMetadata=*/true);
+    Error E = MOrErr ? (*MOrErr)->materializeAll() : MOrErr.takeError();
+    if (E) {
+      reportError("llvm-spirv", toString(std::move(E)));
+      return 1;
+    }
+
+    std::string Err;
+    // Buffer the word-by-word output of the writer in large chunks.
+    std::vector<char> OutBuf(1 << 20);
+    std::ofstream OutFile;
+    OutFile.rdbuf()->pubsetbuf(OutBuf.data(), OutBuf.size());
+    OutFile.open(Output.get(Args).str(), std::ios::binary);
+    if (!writeSpirv(MOrErr->get(), Opts, OutFile, Err)) {
+      reportError("llvm-spirv", "Fails to save LLVM as SPIR-V: " + Err);
+      return 1;
+    }
+    return 0;
+  }
+};
+#endif // LLVM_FOREACH_HAS_SPIRV
+
+} // namespace
+
+std::unique_ptr<InProcessTool>
+llvm::foreach::createInProcessTool(ArrayRef<StringRef> Args) {
+  if (Args.empty())
+    return nullptr;
+  StringRef Name = sys::path::stem(Args[0]);
+  if (Name == "llvm-link")
+    return LinkTool::create(Args);
+#ifdef LLVM_FOREACH_HAS_SPIRV
+  if (Name == "llvm-spirv")
+    return SPIRVTranslatorTool::create(Args);
+#endif // LLVM_FOREACH_HAS_SPIRV
+  return nullptr;
+}
@@ -0,0 +1,49 @@
+//===- InProcessTools.h - Tools run inside llvm-foreach ---------*- C++ -*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// Implementations of LLVM-based tools which llvm-foreach can run in its own
+// process instead of spawning a process per command. A tool is only run
+// in-process if all the options of the command are understood, otherwise
+// llvm-foreach falls back to spawning the program.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_TOOLS_LLVM_FOREACH_INPROCESSTOOLS_H
+#define LLVM_TOOLS_LLVM_FOREACH_INPROCESSTOOLS_H
+
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/StringRef.h"
+
+#include <memory>
+#include <optional>
+
+namespace llvm {
+namespace foreach {
+
+class InProcessTool {
+public:
+  virtual ~InProcessTool() = default;
+
+  /// Runs the tool with the arguments \p Args, which start with the program
+  /// name. The arguments only differ from the ones the tool was created with
+  /// in the input and output file names. Returns the exit code of the tool,
+  /// or std::nullopt if the inputs are not supported and the program has to be
+  /// spawned instead. This may be called concurrently from multiple threads.
+  virtual std::optional<int> run(ArrayRef<StringRef> Args) const = 0;
+};
+
+/// Returns an in-process implementation of the program invoked by the command
+/// \p Args, or nullptr if the program is not supported or the command uses
+/// options the implementation does not understand. The options are parsed
+/// once here and shared by all the runs of the tool.
+std::unique_ptr<InProcessTool> createInProcessTool(ArrayRef<StringRef> Args);
+
+} // namespace foreach
+} // namespace llvm
+
+#endif // LLVM_TOOLS_LLVM_FOREACH_INPROCESSTOOLS_H
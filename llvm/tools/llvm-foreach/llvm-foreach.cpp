@@ -11,16 +11,24 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include "InProcessTools.h"
+
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/Support/Caching.h"
 #include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Endian.h"
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/LineIterator.h"
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/Path.h"
 #include "llvm/Support/Program.h"
+#include "llvm/Support/SHA1.h"
 #include "llvm/Support/SystemUtils.h"
+#include "llvm/Support/ThreadPool.h"
 #include "llvm/Support/Threading.h"
 
 #include <list>
+#include <mutex>
 #include <vector>
 
 using namespace llvm;
@@ -82,6 +90,21 @@ static cl::opt<unsigned int> JobsInParallel{
 static cl::alias JobsInParallelShort{"j", cl::desc("Alias for --jobs"),
                                      cl::aliasopt(JobsInParallel)};
 
+static cl::opt<bool> InProcess{
+    "in-process", cl::Optional, cl::init(false),
+    cl::desc("Run the command inside llvm-foreach on a thread pool instead of "
+             "spawning a process per input if the command is known "
+             "(llvm-link, llvm-spirv). Unknown commands and options fall back "
+             "to spawning processes.")};
+
+static cl::opt<std::string> CacheDir{
+    "cache-dir", cl::Optional, cl::init(""),
+    cl::desc("Directory of a cache of the command outputs. The output for an "
+             "input is reused if the command and the contents of the input "
+             "files are unchanged, so the command must not read other files. "
+             "Not supported with --out-increment."),
+    cl::value_desc("dir")};
+
 static void error(const Twine &Msg) {
   errs() << "llvm-foreach: " << Msg << '\n';
   exit(1);
@@ -92,15 +115,99 @@ static void error(std::error_code EC, const Twine &Prefix) {
     error(Prefix + ": " + EC.message());
 }
 
+static void addToHash(SHA1 &Hasher, StringRef Str) {
+  uint8_t Size[sizeof(uint64_t)];
+  support::endian::write64le(Size, Str.size());
+  Hasher.update(ArrayRef<uint8_t>{Size, sizeof(Size)});
+  Hasher.update(Str);
+}
+
+// Computes the part of the cache keys common to all the inputs, from the
+// program and the command template. The input and output file names replacing
+// the placeholders differ between builds, so the placeholders are hashed.
+static std::string computeCommandCacheKey(StringRef Prog) {
+  SHA1 Hasher;
+  // Outputs of different versions of the program must not be mixed.
+  sys::fs::file_status Status;
+  if (std::error_code EC = sys::fs::status(Prog, Status))
+    error("Could not stat '" + Prog + "': " + EC.message());
+  addToHash(Hasher, Prog);
+  addToHash(Hasher, std::to_string(Status.getSize()));
+  addToHash(Hasher,
+            std::to_string(
+                Status.getLastModificationTime().time_since_epoch().count()));
+  for (size_t I = 1; I < InputCommandArgs.size(); ++I) {
+    std::string Arg = InputCommandArgs[I];
+    auto ReplaceAll = [&](StringRef From, StringRef To) {
+      for (size_t Pos = Arg.find(From); Pos != std::string::npos;
+           Pos = Arg.find(From, Pos + To.size()))
+        Arg.replace(Pos, From.size(), To.str());
+    };
+    for (size_t R = 0; R < Replaces.size(); ++R)
+      ReplaceAll(Replaces[R], "{in" + std::to_string(R) + "}");
+    if (!OutReplace.empty())
+      ReplaceAll(OutReplace, "{out}");
+    addToHash(Hasher, Arg);
+  }
+  return toHex(Hasher.final(), /*LowerCase*/ true);
+}
+
+// Computes the cache key of the command run for the given input files.
+// Returns std::nullopt if an input file can't be read, the command reports it.
+static std::optional<std::string>
+computeCacheKey(StringRef CommandKey, ArrayRef<StringRef> InputFiles) {
+  SHA1 Hasher;
+  addToHash(Hasher, CommandKey);
+  for (StringRef InputFile : InputFiles) {
+    ErrorOr<std::unique_ptr<MemoryBuffer>> MBOrErr =
+        MemoryBuffer::getFile(InputFile, /*IsText=*/false,
+                              /*RequiresNullTerminator=*/false);
+    if (!MBOrErr)
+      return std::nullopt;
+    addToHash(Hasher, (*MBOrErr)->getBuffer());
+  }
+  return toHex(Hasher.final(), /*LowerCase*/ true);
+}
+
+// Stores the output file of a successful command in the cache. Failures to
+// store are not fatal, the command is run again by the next build.
+static void storeCachedOutput(const AddStreamFn &AddStream, unsigned Task,
+                              StringRef OutputPath) {
+  ErrorOr<std::unique_ptr<MemoryBuffer>> MBOrErr =
+      MemoryBuffer::getFile(OutputPath, /*IsText=*/false,
+                            /*RequiresNullTerminator=*/false);
+  if (!MBOrErr)
+    return;
+  // No module name, the output file already has the contents.
+  Expected<std::unique_ptr<CachedFileStream>> StreamOrErr =
+      AddStream(Task, "");
+  if (!StreamOrErr) {
+    consumeError(StreamOrErr.takeError());
+    return;
+  }
+  // The entry is committed to the cache when the stream is destroyed.
+  *(*StreamOrErr)->OS << (*MBOrErr)->getBuffer();
+}
+
+// A spawned command, along with what is needed to store its output in the
+// cache once it succeeded.
+struct Job {
+  sys::ProcessInfo Process;
+  AddStreamFn AddStream;
+  unsigned Task;
+  std::string OutputPath;
+};
+
 // With BlockingWait=false this function just goes through the all
 // submitted jobs to check if some of them have finished.
-int checkIfJobsAreFinished(std::list<sys::ProcessInfo> &JobsSubmitted,
+int checkIfJobsAreFinished(std::list<Job> &JobsSubmitted,
                            bool BlockingWait = true) {
   std::string ErrMsg;
   auto It = JobsSubmitted.begin();
   while (It != JobsSubmitted.end()) {
     sys::ProcessInfo WaitResult = sys::Wait(
-        *It, /*SecondsToWait*/ BlockingWait ? std::nullopt : std::optional(0),
+        It->Process,
+        /*SecondsToWait*/ BlockingWait ? std::nullopt : std::optional(0),
         &ErrMsg);
 
     // Check if the job has finished (PID will be 0 if it's not).
@@ -109,12 +216,16 @@ int checkIfJobsAreFinished(std::list<sys::ProcessInfo> &JobsSubmitted,
       continue;
     }
     assert(BlockingWait || WaitResult.Pid);
+    Job Finished = std::move(*It);
     It = JobsSubmitted.erase(It);
 
     if (WaitResult.ReturnCode != 0) {
       errs() << "llvm-foreach: " << ErrMsg << '\n';
       return WaitResult.ReturnCode;
     }
+    if (Finished.AddStream)
+      storeCachedOutput(Finished.AddStream, Finished.Task,
+                        Finished.OutputPath);
   }
   return 0;
 }
@@ -215,12 +326,43 @@ int main(int argc, char **argv) {
   if (!OutputFileList.empty())
     error(EC, "error opening the file '" + OutputFileList + "'");
 
+  // Commands run in-process share the parsed options and a thread pool. Jobs
+  // keep their own copies of the arguments, as they outlive the iteration.
+  std::unique_ptr<foreach::InProcessTool> Tool;
+  if (InProcess)
+    Tool = foreach::createInProcessTool(Args);
+  std::optional<ThreadPool> Pool;
+  if (Tool)
+    Pool.emplace(hardware_concurrency(JobsInParallel));
+  std::mutex ResMutex;
+
+  // Outputs are looked up in the cache by the command and the contents of the
+  // inputs. On a hit, the cached output is written to the output file, which
+  // is passed as the module name. Incremented outputs are not cached, as they
+  // are not named by the output file list.
+  std::optional<FileCache> Cache;
+  std::string CommandKey;
+  if (!CacheDir.empty() && !OutReplace.empty() && OutIncrement.empty()) {
+    Cache = ExitOnErr(localCache(
+        "llvm-foreach", "Foreach", CacheDir,
+        [](unsigned Task, const Twine &OutputPath,
+           std::unique_ptr<MemoryBuffer> MB) {
+          if (OutputPath.isTriviallyEmpty())
+            return;
+          std::error_code EC;
+          raw_fd_ostream OS{OutputPath.str(), EC, sys::fs::OF_None};
+          error(EC, "Could not write '" + OutputPath + "'");
+          OS << MB->getBuffer();
+        }));
+    CommandKey = computeCommandCacheKey(Prog);
+  }
+
   int Res = 0;
   std::string ResOutArg;
   std::string IncOutArg;
   std::vector<std::string> ResInArgs(InReplaceArgs.size());
   std::string ResFileList = "";
-  std::list<sys::ProcessInfo> JobsSubmitted;
+  std::list<Job> JobsSubmitted;
   for (size_t j = 0; j != FileLists[0].size(); ++j) {
     for (size_t i = 0; i < InReplaceArgs.size(); ++i) {
       ArgumentReplace CurReplace = InReplaceArgs[i];
@@ -272,6 +414,44 @@ int main(int argc, char **argv) {
       Args[OutIncrementArg.ArgNum] = IncOutArg;
     }
 
+    AddStreamFn AddStream;
+    if (Cache) {
+      SmallVector<StringRef, 4> InputFiles;
+      for (const std::vector<std::string> &FileList : FileLists)
+        InputFiles.push_back(FileList[j]);
+      if (std::optional<std::string> Key =
+              computeCacheKey(CommandKey, InputFiles)) {
+        AddStream = ExitOnErr((*Cache)(j, *Key, Path));
+        // The output file has been written from the cache.
+        if (!AddStream)
+          continue;
+      }
+    }
+
+    if (Tool) {
+      std::vector<std::string> JobArgs(Args.begin(), Args.end());
+      Pool->async([&, JobArgs = std::move(JobArgs), AddStream,
+                   OutputPath = std::string(Path), Task = j] {
+        SmallVector<StringRef, 8> Argv(JobArgs.begin(), JobArgs.end());
+        std::optional<int> Result = Tool->run(Argv);
+        std::string ErrMsg;
+        if (!Result)
+          Result = sys::ExecuteAndWait(Prog, Argv, /*Env=*/std::nullopt,
+                                       /*Redirects=*/std::nullopt,
+                                       /*SecondsToWait=*/0, /*MemoryLimit=*/0,
+                                       &ErrMsg);
+        if (*Result != 0) {
+          std::lock_guard<std::mutex> Lock{ResMutex};
+          if (!ErrMsg.empty())
+            errs() << "llvm-foreach: " << ErrMsg << '\n';
+          Res = *Result;
+        } else if (AddStream) {
+          storeCachedOutput(AddStream, Task, OutputPath);
+        }
+      });
+      continue;
+    }
+
     // Do not start execution of a new job until previous one(s) are finished,
     // if the maximum number of parallel workers is reached.
     while (JobsSubmitted.size() == JobsInParallel)
@@ -279,12 +459,16 @@ int main(int argc, char **argv) {
               checkIfJobsAreFinished(JobsSubmitted, /*BlockingWait*/ false))
         Res = Result;
 
-    JobsSubmitted.emplace_back(
-        sys::ExecuteNoWait(Prog, Args, /*Env=*/std::nullopt,
-                           /*Redirects=*/std::nullopt, /*MemoryLimit=*/0));
+    JobsSubmitted.push_back(
+        Job{sys::ExecuteNoWait(Prog, Args, /*Env=*/std::nullopt,
+                               /*Redirects=*/std::nullopt, /*MemoryLimit=*/0),
+            std::move(AddStream), static_cast<unsigned>(j),
+            std::string(Path)});
   }
 
   // Wait for all commands to be executed.
+  if (Pool)
+    Pool->wait();
   while (!JobsSubmitted.empty())
     if (int Result =
             checkIfJobsAreFinished(JobsSubmitted, /*BlockingWait*/ true))
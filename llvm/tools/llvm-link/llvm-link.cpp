@@ -25,6 +25,7 @@
 #include "llvm/IRReader/IRReader.h"
 #include "llvm/Linker/Linker.h"
 #include "llvm/Object/Archive.h"
+#include "llvm/Object/IRSymbolIndex.h"
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/InitLLVM.h"
@@ -88,6 +89,14 @@ static cl::opt<bool> OnlyNeeded("only-needed",
                                 cl::desc("Link only needed symbols"),
                                 cl::cat(LinkCategory));
 
+static cl::opt<bool> SkipUnneededDeviceLibs(
+    "skip-unneeded-device-libs",
+    cl::desc("With -only-needed, skip bitcode files which define no symbol "
+             "the linked module needs, without parsing them. Their named "
+             "metadata and module flags are not linked. Used for SYCL device "
+             "libraries"),
+    cl::cat(LinkCategory));
+
 static cl::opt<bool> Force("f", cl::desc("Enable binary output on terminals"),
                            cl::cat(LinkCategory));
 
@@ -373,7 +382,21 @@ static bool importFunctions(const char *argv0, Module &DestModule) {
   return true;
 }
 
+/// Returns false if linking the bitcode file in \p Buffer into \p Composite
+/// with -only-needed would not add anything to it. This is decided from the
+/// symbol table bitcode writers emit, so that libraries which are not needed
+/// at all are not parsed.
+static bool isNeededFile(const Module &Composite, MemoryBufferRef Buffer) {
+  Expected<object::IRSymbolIndex> Index = object::IRSymbolIndex::create(Buffer);
+  if (!Index) {
+    consumeError(Index.takeError());
+    return true;
+  }
+  return Index->isNeededBy(Composite);
+}
+
 static bool linkFiles(const char *argv0, LLVMContext &Context, Linker &L,
+                      const Module &Composite,
                       const cl::list<std::string> &Files, unsigned Flags) {
   // Filter out flags that don't apply to the first file we load.
   unsigned ApplicableFlags = Flags & Linker::Flags::OverrideFromSrc;
@@ -383,6 +406,18 @@ static bool linkFiles(const char *argv0, LLVMContext &Context, Linker &L,
     std::unique_ptr<MemoryBuffer> Buffer =
         ExitOnErr(errorOrToExpected(MemoryBuffer::getFileOrSTDIN(File)));
 
+    if (SkipUnneededDeviceLibs &&
+        (ApplicableFlags & Linker::Flags::LinkOnlyNeeded) &&
+        !DisableLazyLoad && SummaryIndex.empty() &&
+        identify_magic(Buffer->getBuffer()) == file_magic::bitcode &&
+        !isNeededFile(Composite, *Buffer)) {
+      if (Verbose)
+        errs() << "Skipping '" << File << "', no symbols needed\n";
+      InternalizeLinkedSymbols = Internalize;
+      ApplicableFlags = Flags;
+      continue;
+    }
+
     std::unique_ptr<Module> M =
         identify_magic(Buffer->getBuffer()) == file_magic::archive
             ? loadArFile(argv0, std::move(Buffer), Context)
@@ -474,11 +509,11 @@ int main(int argc, char **argv) {
     Flags |= Linker::Flags::LinkOnlyNeeded;
 
   // First add all the regular input files
-  if (!linkFiles(argv[0], Context, L, InputFilenames, Flags))
+  if (!linkFiles(argv[0], Context, L, *Composite, InputFilenames, Flags))
     return 1;
 
   // Next the -override ones.
-  if (!linkFiles(argv[0], Context, L, OverridingInputs,
+  if (!linkFiles(argv[0], Context, L, *Composite, OverridingInputs,
                  Flags | Linker::Flags::OverrideFromSrc))
     return 1;
 
@@ -26,9 +26,11 @@
 #include "llvm/Transforms/IPO/StripDeadPrototypes.h"
 #include "llvm/Transforms/IPO/StripSymbols.h"
 #include "llvm/Transforms/Utils/Cloning.h"
+#include "llvm/Transforms/Utils/ValueMapper.h"
 
 #include <algorithm>
 #include <map>
+#include <numeric>
 #include <utility>
 #include <variant>
 
@@ -75,6 +77,7 @@ EntryPointsGroupScope selectDeviceCodeGroupScope(const Module &M,
                                                  bool AutoSplitIsGlobalScope) {
   switch (Mode) {
   case SPLIT_PER_TU:
+  case SPLIT_BALANCED:
     return Scope_PerModule;
 
   case SPLIT_PER_KERNEL:
@@ -199,16 +202,48 @@ groupEntryPointsByKernelType(ModuleDesc &MD,
   return EntryPointGroups;
 }
 
+// Collects the global values used by the constant C (directly or through
+// other constants) into Refs. Constants in Visited are skipped.
+void collectReferencedGlobals(const Constant *C,
+                              SmallPtrSetImpl<const Constant *> &Visited,
+                              SmallPtrSetImpl<const GlobalValue *> &Refs) {
+  SmallVector<const Constant *, 8> Worklist;
+  if (Visited.insert(C).second)
+    Worklist.push_back(C);
+  while (!Worklist.empty()) {
+    const Constant *Cur = Worklist.pop_back_val();
+    if (const auto *GV = dyn_cast<GlobalValue>(Cur)) {
+      Refs.insert(GV);
+      continue;
+    }
+    for (const Use &Op : Cur->operands())
+      if (const auto *OpC = dyn_cast<Constant>(Op.get()))
+        if (Visited.insert(OpC).second)
+          Worklist.push_back(OpC);
+  }
+}
+
 // Represents a call graph between functions in a module. Nodes are functions,
-// edges are "calls" relation.
+// edges are "calls" relation. In addition, the global values referenced by
+// each function body and global variable initializer are recorded, so that
+// split modules can be built without cloning the whole input module.
 class CallGraph {
 public:
   using FunctionSet = SmallPtrSet<const Function *, 16>;
+  using GlobalSet = SmallPtrSet<const GlobalValue *, 16>;
 
 private:
   std::unordered_map<const Function *, FunctionSet> Graph;
   SmallPtrSet<const Function *, 1> EmptySet;
   FunctionSet AddrTakenFunctions;
+  std::unordered_map<const GlobalValue *, GlobalSet> References;
+  SmallPtrSet<const GlobalValue *, 1> EmptyGlobalSet;
+
+  void addReferences(const GlobalValue &GV, ArrayRef<const Constant *> Cs) {
+    SmallPtrSet<const Constant *, 32> Visited;
+    for (const Constant *C : Cs)
+      collectReferencedGlobals(C, Visited, References[&GV]);
+  }
 
 public:
   CallGraph(const Module &M) {
@@ -224,6 +259,40 @@ public:
       if (F.hasAddressTaken()) {
         AddrTakenFunctions.insert(&F);
       }
+      if (F.isDeclaration())
+        continue;
+      SmallVector<const Constant *, 16> Cs;
+      if (F.hasPersonalityFn())
+        Cs.push_back(F.getPersonalityFn());
+      if (F.hasPrefixData())
+        Cs.push_back(F.getPrefixData());
+      if (F.hasPrologueData())
+        Cs.push_back(F.getPrologueData());
+      for (const auto &I : instructions(F))
+        for (const Use &Op : I.operands())
+          if (const auto *C = dyn_cast<Constant>(Op.get()))
+            Cs.push_back(C);
+      addReferences(F, Cs);
+    }
+    for (const auto &G : M.globals())
+      if (G.hasInitializer())
+        addReferences(G, G.getInitializer());
+
+    // GlobalDCE keeps all members of a comdat alive if one of them is alive,
+    // so global variables are also referenced by the members of their comdat.
+    std::map<const Comdat *, SmallVector<const GlobalVariable *, 1>> ComdatVars;
+    for (const auto &G : M.globals())
+      if (const Comdat *C = G.getComdat())
+        ComdatVars[C].push_back(&G);
+    if (ComdatVars.empty())
+      return;
+    for (const GlobalObject &GO : M.global_objects()) {
+      auto It = ComdatVars.find(GO.getComdat());
+      if (It == ComdatVars.end())
+        continue;
+      for (const GlobalVariable *G : It->second)
+        if (G != &GO)
+          References[&GO].insert(G);
     }
   }
 
@@ -238,6 +307,14 @@ public:
   iterator_range<FunctionSet::const_iterator> addrTakenFunctions() const {
     return make_range(AddrTakenFunctions.begin(), AddrTakenFunctions.end());
   }
+
+  iterator_range<GlobalSet::const_iterator>
+  references(const GlobalValue *GV) const {
+    auto It = References.find(GV);
+    return (It == References.end())
+               ? make_range(EmptyGlobalSet.begin(), EmptyGlobalSet.end())
+               : make_range(It->second.begin(), It->second.end());
+  }
 };
 
 void collectFunctionsToExtract(SetVector<const GlobalValue *> &GVs,
@@ -273,29 +350,195 @@ void collectFunctionsToExtract(SetVector<const GlobalValue *> &GVs,
 }
 
 void collectGlobalVarsToExtract(SetVector<const GlobalValue *> &GVs,
-                                const Module &M) {
-  // It's not easy to trace global variable's uses inside needed functions
-  // because global variable can be used inside a combination of operators, so
-  // mark all global variables as needed and remove dead ones after cloning.
-  // Notice. For device global variables with the 'device_image_scope' property,
-  // removing dead ones is a must, the 'checkImageScopedDeviceGlobals' function
-  // checks that there are no usages of a single device global variable with the
-  // 'device_image_scope' property from multiple modules and the splitter must
-  // not add such usages after the check.
+                                SetVector<const GlobalValue *> &Decls,
+                                const Module &M, const CallGraph &Deps) {
+  // Global variables which are not discardable are never removed by GlobalDCE,
+  // so they are extracted to every split module.
   for (const auto &G : M.globals())
-    GVs.insert(&G);
+    if (!G.isDeclaration() && !G.isDiscardableIfUnused())
+      GVs.insert(&G);
+
+  // Other global variables are only extracted if they are transitively
+  // referenced by the extracted functions and variables. This gives the same
+  // result as cloning all global variables and removing dead ones afterwards,
+  // without paying for the cloning. Notice. For device global variables with
+  // the 'device_image_scope' property, removing dead ones is a must, the
+  // 'checkImageScopedDeviceGlobals' function checks that there are no usages
+  // of a single device global variable with the 'device_image_scope' property
+  // from multiple modules and the splitter must not add such usages after the
+  // check.
+  // Referenced functions which are not extracted, aliases and ifuncs are only
+  // declared in the split module.
+  decltype(GVs.size()) Idx = 0;
+  while (Idx < GVs.size()) {
+    const GlobalValue *GV = GVs[Idx++];
+    for (const GlobalValue *Ref : Deps.references(GV)) {
+      if (isa<GlobalVariable>(Ref) && !Ref->isDeclaration())
+        GVs.insert(Ref);
+      else if (!GVs.count(Ref))
+        Decls.insert(Ref);
+    }
+  }
+}
+
+// Creates a declaration of GV in module SubM, the same way CloneModule does
+// for global values it does not clone definitions of.
+GlobalValue *createDeclaration(const GlobalValue &GV, Module &SubM) {
+  GlobalValue *Decl = nullptr;
+  if (auto *FTy = dyn_cast<FunctionType>(GV.getValueType())) {
+    auto *F = Function::Create(FTy, GlobalValue::ExternalLinkage,
+                               GV.getAddressSpace(), GV.getName(), &SubM);
+    if (isa<Function>(GV))
+      F->copyAttributesFrom(cast<Function>(&GV));
+    // Personality function is not valid on a declaration.
+    F->setPersonalityFn(nullptr);
+    Decl = F;
+  } else {
+    auto *G = new GlobalVariable(
+        SubM, GV.getValueType(), /*isConstant*/ false,
+        GlobalValue::ExternalLinkage, nullptr, GV.getName(), nullptr,
+        GV.getThreadLocalMode(), GV.getAddressSpace());
+    if (const auto *SrcG = dyn_cast<GlobalVariable>(&GV))
+      G->copyAttributesFrom(SrcG);
+    Decl = G;
+  }
+  Decl->setLinkage(GlobalValue::ExternalLinkage);
+  return Decl;
 }
 
+// Creates declarations in the split module for global values which are only
+// referenced from metadata. Such declarations have no uses and are removed by
+// ModuleDesc::cleanup.
+class DeclarationMaterializer final : public ValueMaterializer {
+  Module &SubM;
+
+public:
+  DeclarationMaterializer(Module &SubM) : SubM(SubM) {}
+
+  Value *materialize(Value *V) override {
+    if (const auto *GV = dyn_cast<GlobalValue>(V))
+      return createDeclaration(*GV, SubM);
+    return nullptr;
+  }
+};
+
+// Builds a module with definitions of the global values in GVs and
+// declarations of the global values in Decls. Unlike CloneModule, which clones
+// the whole input module and then deletes what is not needed, only the bodies
+// and initializers of the global values in GVs are cloned. The lists of global
+// values of the input module are still scanned to look them up in the sets, and
+// all named metadata is copied, as CloneModule would do.
 ModuleDesc extractSubModule(const ModuleDesc &MD,
-                            const SetVector<const GlobalValue *> GVs,
+                            const SetVector<const GlobalValue *> &GVs,
+                            const SetVector<const GlobalValue *> &Decls,
                             EntryPointGroup &&ModuleEntryPoints) {
   const Module &M = MD.getModule();
-  // For each group of entry points collect all dependencies.
+  auto SubM =
+      std::make_unique<Module>(M.getModuleIdentifier(), M.getContext());
+  SubM->setSourceFileName(M.getSourceFileName());
+  SubM->setDataLayout(M.getDataLayout());
+  SubM->setTargetTriple(M.getTargetTriple());
+  SubM->setModuleInlineAsm(M.getModuleInlineAsm());
+
+  // Create all global values first, so that definitions can refer to them.
+  // Iterating over the input module rather than the sets keeps the order of
+  // global values in the split module the same as with CloneModule.
   ValueToValueMapTy VMap;
-  // Clone definitions only for needed globals. Others will be added as
-  // declarations and removed later.
-  std::unique_ptr<Module> SubM = CloneModule(
-      M, VMap, [&](const GlobalValue *GV) { return GVs.count(GV); });
+  for (const auto &G : M.globals()) {
+    if (!GVs.count(&G)) {
+      if (Decls.count(&G))
+        VMap[&G] = createDeclaration(G, *SubM);
+      continue;
+    }
+    auto *NewG = new GlobalVariable(
+        *SubM, G.getValueType(), G.isConstant(), G.getLinkage(), nullptr,
+        G.getName(), nullptr, G.getThreadLocalMode(), G.getAddressSpace());
+    NewG->copyAttributesFrom(&G);
+    VMap[&G] = NewG;
+  }
+  for (const auto &F : M) {
+    if (!GVs.count(&F)) {
+      if (Decls.count(&F))
+        VMap[&F] = createDeclaration(F, *SubM);
+      continue;
+    }
+    Function *NewF =
+        Function::Create(F.getFunctionType(), F.getLinkage(),
+                         F.getAddressSpace(), F.getName(), SubM.get());
+    NewF->copyAttributesFrom(&F);
+    VMap[&F] = NewF;
+  }
+  for (const auto &A : M.aliases())
+    if (Decls.count(&A))
+      VMap[&A] = createDeclaration(A, *SubM);
+  for (const auto &I : M.ifuncs())
+    if (Decls.count(&I))
+      VMap[&I] = createDeclaration(I, *SubM);
+
+  DeclarationMaterializer Materializer{*SubM};
+  auto CopyComdat = [&](GlobalObject &Dst, const GlobalObject &Src) {
+    if (const Comdat *SC = Src.getComdat()) {
+      Comdat *DC = SubM->getOrInsertComdat(SC->getName());
+      DC->setSelectionKind(SC->getSelectionKind());
+      Dst.setComdat(DC);
+    }
+  };
+
+  auto CopyMetadata = [&](GlobalObject &Dst, const GlobalObject &Src) {
+    SmallVector<std::pair<unsigned, MDNode *>, 1> MDs;
+    Src.getAllMetadata(MDs);
+    for (auto [Kind, Node] : MDs)
+      Dst.addMetadata(
+          Kind, *MapMetadata(Node, VMap, RF_None, nullptr, &Materializer));
+  };
+
+  for (const auto &G : M.globals()) {
+    auto It = VMap.find(&G);
+    if (It == VMap.end())
+      continue;
+    auto *NewG = cast<GlobalVariable>(It->second);
+    CopyMetadata(*NewG, G);
+    if (!GVs.count(&G) || G.isDeclaration())
+      continue;
+    NewG->setInitializer(MapValue(G.getInitializer(), VMap, RF_None, nullptr,
+                                  &Materializer));
+    CopyComdat(*NewG, G);
+  }
+
+  for (const auto &F : M) {
+    auto It = VMap.find(&F);
+    if (It == VMap.end())
+      continue;
+    auto *NewF = cast<Function>(It->second);
+    if (F.isDeclaration()) {
+      // Copy over metadata for declarations since we're not doing it below in
+      // CloneFunctionInto().
+      CopyMetadata(*NewF, F);
+      continue;
+    }
+    if (!GVs.count(&F))
+      continue;
+    Function::arg_iterator DestI = NewF->arg_begin();
+    for (const Argument &J : F.args()) {
+      DestI->setName(J.getName());
+      VMap[&J] = &*DestI++;
+    }
+    SmallVector<ReturnInst *, 8> Returns; // Ignore returns cloned.
+    CloneFunctionInto(NewF, &F, VMap, CloneFunctionChangeType::ClonedModule,
+                      Returns, "", nullptr, nullptr, &Materializer);
+    if (F.hasPersonalityFn())
+      NewF->setPersonalityFn(MapValue(F.getPersonalityFn(), VMap, RF_None,
+                                      nullptr, &Materializer));
+    CopyComdat(*NewF, F);
+  }
+
+  for (const auto &NMD : M.named_metadata()) {
+    NamedMDNode *NewNMD = SubM->getOrInsertNamedMetadata(NMD.getName());
+    for (const MDNode *Op : NMD.operands())
+      NewNMD->addOperand(
+          MapMetadata(Op, VMap, RF_None, nullptr, &Materializer));
+  }
+
   // Replace entry points with cloned ones.
   EntryPointSet NewEPs;
   const EntryPointSet &EPs = ModuleEntryPoints.Functions;
@@ -312,10 +555,12 @@ ModuleDesc extractCallGraph(const ModuleDesc &MD,
                             EntryPointGroup &&ModuleEntryPoints,
                             const CallGraph &CG) {
   SetVector<const GlobalValue *> GVs;
+  SetVector<const GlobalValue *> Decls;
   collectFunctionsToExtract(GVs, ModuleEntryPoints, CG);
-  collectGlobalVarsToExtract(GVs, MD.getModule());
+  collectGlobalVarsToExtract(GVs, Decls, MD.getModule(), CG);
 
-  ModuleDesc SplitM = extractSubModule(MD, GVs, std::move(ModuleEntryPoints));
+  ModuleDesc SplitM =
+      extractSubModule(MD, GVs, Decls, std::move(ModuleEntryPoints));
   SplitM.cleanup();
 
   return SplitM;
@@ -344,6 +589,105 @@ private:
   CallGraph CG;
 };
 
+// Splits a set of entry points into clusters for the balanced device code
+// split. Entry points which share code are put into the same cluster, as long
+// as the total size of the code reachable from the cluster's entry points does
+// not exceed TargetSize. Sizes are measured in LLVM IR instructions, which
+// approximates the cost of JIT-compiling the cluster at runtime. Entry points
+// that are larger than TargetSize on their own form a separate cluster.
+std::vector<EntryPointSet> clusterEntryPointsBySize(const EntryPointSet &EPs,
+                                                    const CallGraph &CG,
+                                                    uint64_t TargetSize) {
+  using FunctionSet = SmallPtrSet<const Function *, 32>;
+  struct Cluster {
+    FunctionSet Functions;
+    uint64_t Size = 0;
+    SmallVector<unsigned, 8> Members;
+  };
+
+  // Collect the functions reachable from each entry point.
+  std::vector<FunctionSet> Closures(EPs.size());
+  std::vector<uint64_t> Sizes(EPs.size(), 0);
+  for (unsigned I = 0; I < EPs.size(); ++I) {
+    SmallVector<const Function *, 32> Worklist{EPs[I]};
+    Closures[I].insert(EPs[I]);
+    while (!Worklist.empty()) {
+      const Function *F = Worklist.pop_back_val();
+      Sizes[I] += F->getInstructionCount();
+      for (const Function *Callee : CG.successors(F))
+        if (!Callee->isDeclaration() && Closures[I].insert(Callee).second)
+          Worklist.push_back(Callee);
+    }
+  }
+
+  // Place big entry points first, so that small ones fill the gaps left in
+  // the clusters. stable_sort keeps the result independent of the sort
+  // implementation.
+  SmallVector<unsigned, 32> Order(EPs.size());
+  std::iota(Order.begin(), Order.end(), 0);
+  std::stable_sort(Order.begin(), Order.end(), [&](unsigned A, unsigned B) {
+    return Sizes[A] > Sizes[B];
+  });
+
+  std::vector<Cluster> Clusters;
+  for (unsigned I : Order) {
+    // Prefer the cluster sharing the most code with the entry point. Among
+    // clusters sharing the same amount of code, prefer the fullest one to
+    // keep the number of device images low.
+    Cluster *Best = nullptr;
+    uint64_t BestShared = 0;
+    for (Cluster &C : Clusters) {
+      uint64_t Shared = 0;
+      for (const Function *F : Closures[I])
+        if (C.Functions.contains(F))
+          Shared += F->getInstructionCount();
+      if (C.Size + Sizes[I] - Shared > TargetSize)
+        continue;
+      if (!Best || Shared > BestShared ||
+          (Shared == BestShared && C.Size > Best->Size)) {
+        Best = &C;
+        BestShared = Shared;
+      }
+    }
+    if (!Best)
+      Best = &Clusters.emplace_back();
+    Best->Size += Sizes[I] - BestShared;
+    Best->Functions.insert(Closures[I].begin(), Closures[I].end());
+    Best->Members.push_back(I);
+  }
+
+  // List the entry points of each cluster in their original order to keep the
+  // output stable.
+  std::vector<EntryPointSet> Result;
+  Result.reserve(Clusters.size());
+  for (Cluster &C : Clusters) {
+    llvm::sort(C.Members);
+    EntryPointSet &Set = Result.emplace_back();
+    for (unsigned I : C.Members)
+      Set.insert(EPs[I]);
+  }
+  return Result;
+}
+
+// Replaces each of the entry point groups produced by the categorizer for the
+// balanced device code split by the clusters computed by
+// clusterEntryPointsBySize.
+EntryPointGroupVec
+clusterEntryPointGroups(const Module &M,
+                        std::map<std::string, EntryPointSet> &EntryPointsMap,
+                        const EntryPointGroup::Properties &Props,
+                        uint64_t TargetSize) {
+  CallGraph CG{M};
+  EntryPointGroupVec Groups;
+  for (auto &[Key, EntryPoints] : EntryPointsMap) {
+    std::vector<EntryPointSet> Clusters =
+        clusterEntryPointsBySize(EntryPoints, CG, TargetSize);
+    for (unsigned I = 0; I < Clusters.size(); ++I)
+      Groups.emplace_back(Key + std::to_string(I), std::move(Clusters[I]),
+                          Props);
+  }
+  return Groups;
+}
 } // namespace
 
 namespace llvm {
@@ -819,7 +1163,8 @@ std::string FunctionsCategorizer::computeCategoryFor(Function *F) const {
 
 std::unique_ptr<ModuleSplitterBase>
 getDeviceCodeSplitter(ModuleDesc &&MD, IRSplitMode Mode, bool IROutputOnly,
-                      bool EmitOnlyKernelsAsEntryPoints) {
+                      bool EmitOnlyKernelsAsEntryPoints,
+                      unsigned BalancedSplitTargetSize) {
   FunctionsCategorizer Categorizer;
 
   EntryPointsGroupScope Scope =
@@ -841,9 +1186,14 @@ getDeviceCodeSplitter(ModuleDesc &&MD, IRSplitMode Mode, bool IROutputOnly,
     // The most complex case, because we should account for many other features
     // like aspects used in a kernel, large-grf mode, reqd-work-group-size, etc.
 
-    // This is core of per-source device code split
-    Categorizer.registerSimpleStringAttributeRule(
-        sycl::utils::ATTR_SYCL_MODULE_ID);
+    // This is core of per-source device code split. Balanced split ignores
+    // translation unit boundaries, but must not mix SYCL and ESIMD kernels.
+    if (Mode == SPLIT_BALANCED)
+      Categorizer.registerSimpleFlagMetadataRule(ESIMD_MARKER_MD, "esimd",
+                                                 "sycl");
+    else
+      Categorizer.registerSimpleStringAttributeRule(
+          sycl::utils::ATTR_SYCL_MODULE_ID);
 
     // Optional features
     // Note: Add more rules at the end of the list to avoid chaning orders of
@@ -878,8 +1228,15 @@ getDeviceCodeSplitter(ModuleDesc &&MD, IRSplitMode Mode, bool IROutputOnly,
     Groups.reserve(EntryPointsMap.size());
     // Start with properties of a source module
     EntryPointGroup::Properties MDProps = MD.getEntryPointGroup().Props;
-    for (auto &[Key, EntryPoints] : EntryPointsMap)
-      Groups.emplace_back(Key, std::move(EntryPoints), MDProps);
+    if (Mode == SPLIT_BALANCED && Scope == Scope_PerModule) {
+      // Kernels with the same optional features are further clustered by the
+      // code they share.
+      Groups = clusterEntryPointGroups(MD.getModule(), EntryPointsMap, MDProps,
+                                       BalancedSplitTargetSize);
+    } else {
+      for (auto &[Key, EntryPoints] : EntryPointsMap)
+        Groups.emplace_back(Key, std::move(EntryPoints), MDProps);
+    }
   }
 
   bool DoSplit = (Mode != SPLIT_NONE &&
@@ -31,6 +31,7 @@ enum IRSplitMode {
   SPLIT_PER_TU,     // one module per translation unit
   SPLIT_PER_KERNEL, // one module per kernel
   SPLIT_AUTO,       // automatically select split mode
+  SPLIT_BALANCED,   // kernels sharing code are grouped up to a target size
   SPLIT_NONE        // no splitting
 };
 
@@ -240,7 +241,8 @@ public:
 
 std::unique_ptr<ModuleSplitterBase>
 getDeviceCodeSplitter(ModuleDesc &&MD, IRSplitMode Mode, bool IROutputOnly,
-                      bool EmitOnlyKernelsAsEntryPoints);
+                      bool EmitOnlyKernelsAsEntryPoints,
+                      unsigned BalancedSplitTargetSize = 0);
 
 std::unique_ptr<ModuleSplitterBase>
 getSplitterByKernelType(ModuleDesc &&MD, bool EmitOnlyKernelsAsEntryPoints);
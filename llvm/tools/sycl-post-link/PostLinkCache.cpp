@@ -0,0 +1,194 @@
+//===---- PostLinkCache.cpp - cache of the outputs of sycl-post-link -----===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#include "PostLinkCache.h"
+
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/Config/llvm-config.h"
+#include "llvm/Support/Endian.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/raw_ostream.h"
+
+using namespace llvm;
+
+// Bump this whenever the layout of the cache entries or the hashed key
+// components change.
+static constexpr char CacheMagic[] = "SYCLPOSTLINKCACHE2";
+static constexpr size_t CacheMagicSize = sizeof(CacheMagic) - 1;
+
+PostLinkCacheKey::PostLinkCacheKey() {
+  add(StringRef{CacheMagic, CacheMagicSize});
+  // Outputs of different tool versions must not be mixed.
+  add(StringRef{LLVM_VERSION_STRING});
+}
+
+void PostLinkCacheKey::add(uint64_t Value) {
+  uint8_t Bytes[sizeof(uint64_t)];
+  support::endian::write64le(Bytes, Value);
+  Hasher.update(ArrayRef<uint8_t>{Bytes, sizeof(Bytes)});
+}
+
+void PostLinkCacheKey::add(StringRef Str) {
+  add(static_cast<uint64_t>(Str.size()));
+  Hasher.update(Str);
+}
+
+std::string PostLinkCacheKey::result() {
+  return toHex(Hasher.final(), /*LowerCase*/ true);
+}
+
+static SmallString<128> getEntryPath(StringRef CacheDir, StringRef Key) {
+  // This choice of file name allows the cache to be pruned (see pruneCache()
+  // in include/llvm/Support/CachePruning.h).
+  SmallString<128> EntryPath;
+  sys::path::append(EntryPath, CacheDir, "llvmcache-" + Key);
+  return EntryPath;
+}
+
+namespace {
+// Reads the length-prefixed fields of a cache entry.
+class EntryReader {
+  StringRef Data;
+  bool Failed = false;
+
+public:
+  EntryReader(StringRef Data) : Data(Data) {}
+
+  uint64_t readInt() {
+    if (Data.size() < sizeof(uint64_t)) {
+      Failed = true;
+      return 0;
+    }
+    uint64_t Value = support::endian::read64le(Data.data());
+    Data = Data.drop_front(sizeof(uint64_t));
+    return Value;
+  }
+
+  // Reads the number of elements of a sequence, each taking at least MinSize
+  // bytes, so that a corrupted count never exceeds the size of the entry.
+  uint64_t readCount(uint64_t MinSize) {
+    uint64_t Count = readInt();
+    if (Failed || Count > Data.size() / MinSize) {
+      Failed = true;
+      return 0;
+    }
+    return Count;
+  }
+
+  std::string readString() {
+    uint64_t Size = readInt();
+    if (Failed || Data.size() < Size) {
+      Failed = true;
+      return {};
+    }
+    std::string Str = Data.take_front(Size).str();
+    Data = Data.drop_front(Size);
+    return Str;
+  }
+
+  bool failed() const { return Failed; }
+  bool atEnd() const { return Data.empty(); }
+};
+
+void writeInt(raw_ostream &OS, uint64_t Value) {
+  uint8_t Bytes[sizeof(uint64_t)];
+  support::endian::write64le(Bytes, Value);
+  OS.write(reinterpret_cast<const char *>(Bytes), sizeof(Bytes));
+}
+
+void writeString(raw_ostream &OS, StringRef Str) {
+  writeInt(OS, Str.size());
+  OS << Str;
+}
+} // namespace
+
+std::optional<std::vector<CachedTableRow>>
+llvm::lookupCachedTable(StringRef CacheDir, StringRef Key) {
+  SmallString<128> EntryPath = getEntryPath(CacheDir, Key);
+  // Update the access time on hits, so that eviction is least-recently-used.
+  Expected<sys::fs::file_t> FDOrErr =
+      sys::fs::openNativeFileForRead(EntryPath, sys::fs::OF_UpdateAtime);
+  if (!FDOrErr) {
+    consumeError(FDOrErr.takeError());
+    return std::nullopt;
+  }
+  ErrorOr<std::unique_ptr<MemoryBuffer>> MBOrErr =
+      MemoryBuffer::getOpenFile(*FDOrErr, EntryPath, /*FileSize=*/-1,
+                                /*RequiresNullTerminator=*/false);
+  sys::fs::closeFile(*FDOrErr);
+  if (!MBOrErr)
+    return std::nullopt;
+
+  // Layout: magic, number of rows, and for each row the number of files
+  // followed by the suffix, ID, extension and contents of each file. Integers
+  // are 64-bit little-endian, strings are prefixed by their size.
+  StringRef Contents = (*MBOrErr)->getBuffer();
+  if (!Contents.consume_front(StringRef{CacheMagic, CacheMagicSize}))
+    return std::nullopt;
+  EntryReader Reader{Contents};
+  // A row takes at least its number of files, a file at least its ID and the
+  // sizes of its three strings.
+  constexpr uint64_t MinRowSize = sizeof(uint64_t);
+  constexpr uint64_t MinFileSize = 4 * sizeof(uint64_t);
+  std::vector<CachedTableRow> Rows(Reader.readCount(MinRowSize));
+  for (CachedTableRow &Row : Rows) {
+    Row.resize(Reader.readCount(MinFileSize));
+    for (CachedOutputFile &File : Row) {
+      File.Suffix = Reader.readString();
+      File.ID = Reader.readInt();
+      File.Ext = Reader.readString();
+      File.Contents = Reader.readString();
+    }
+    if (Reader.failed())
+      return std::nullopt;
+  }
+  if (Reader.failed() || !Reader.atEnd())
+    return std::nullopt;
+  return Rows;
+}
+
+Error llvm::storeCachedTable(StringRef CacheDir, StringRef Key,
+                             ArrayRef<CachedTableRow> Rows) {
+  if (std::error_code EC = sys::fs::create_directories(CacheDir))
+    return createStringError(EC, "failed to create cache directory '" +
+                                     CacheDir + "'");
+
+  SmallString<128> TempModel;
+  sys::path::append(TempModel, CacheDir, "PostLink-%%%%%%.tmp");
+  Expected<sys::fs::TempFile> TempOrErr = sys::fs::TempFile::create(TempModel);
+  if (!TempOrErr)
+    return TempOrErr.takeError();
+  sys::fs::TempFile &Temp = *TempOrErr;
+  {
+    raw_fd_ostream OS{Temp.FD, /*shouldClose*/ false};
+    OS.write(CacheMagic, CacheMagicSize);
+    writeInt(OS, Rows.size());
+    for (const CachedTableRow &Row : Rows) {
+      writeInt(OS, Row.size());
+      for (const CachedOutputFile &File : Row) {
+        writeString(OS, File.Suffix);
+        writeInt(OS, File.ID);
+        writeString(OS, File.Ext);
+        writeString(OS, File.Contents);
+      }
+    }
+    OS.flush();
+    if (OS.has_error()) {
+      std::error_code EC = OS.error();
+      OS.clear_error();
+      consumeError(Temp.discard());
+      return createStringError(EC, "failed to write cache entry");
+    }
+  }
+  // Another process might have stored the same entry concurrently. As entries
+  // for the same key are identical, it does not matter which one wins.
+  return Temp.keep(getEntryPath(CacheDir, Key));
+}
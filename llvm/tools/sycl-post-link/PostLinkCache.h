@@ -0,0 +1,68 @@
+//===----- PostLinkCache.h - cache of the outputs of sycl-post-link -------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// A content-addressed on-disk cache of the output files produced for an input
+// module. Each entry is keyed by a hash of the input module and of the options
+// influencing the outputs, so unchanged device code does not have to be
+// parsed, split and processed again by subsequent builds.
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/Error.h"
+#include "llvm/Support/SHA1.h"
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace llvm {
+
+// An output file. Output file names are made of the output file stem, a
+// suffix, the ID of the split the file was produced for and an extension.
+// Only the suffix, the ID and the extension are stored, as the stem differs
+// between builds.
+struct CachedOutputFile {
+  std::string Suffix;
+  uint64_t ID;
+  std::string Ext;
+  std::string Contents;
+};
+
+// The files of one row of the output file table.
+using CachedTableRow = std::vector<CachedOutputFile>;
+
+// Feeds the components of a cache key into a SHA1 hasher in an unambiguous
+// encoding.
+class PostLinkCacheKey {
+public:
+  PostLinkCacheKey();
+
+  void add(uint64_t Value);
+  void add(StringRef Str);
+
+  std::string result();
+
+private:
+  SHA1 Hasher;
+};
+
+// Loads the entry for Key from CacheDir. File system errors and corrupted
+// entries are treated as cache misses.
+std::optional<std::vector<CachedTableRow>>
+lookupCachedTable(StringRef CacheDir, StringRef Key);
+
+// Stores Rows under Key in CacheDir. The entry is written to a temporary file
+// first and renamed, so concurrent builds never read partial entries.
+Error storeCachedTable(StringRef CacheDir, StringRef Key,
+                       ArrayRef<CachedTableRow> Rows);
+
+} // namespace llvm
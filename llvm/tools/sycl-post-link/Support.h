@@ -37,8 +37,8 @@ inline void error(const Twine &Msg) {
   exit(1);
 }
 
-inline void warning(const Twine &Msg) {
-  errs() << "sycl-post-link WARNING: " << Msg << '\n';
+inline void warning(const Twine &Msg, raw_ostream &OS = errs()) {
+  OS << "sycl-post-link WARNING: " << Msg << '\n';
 }
 
 inline void checkError(std::error_code EC, const Twine &Prefix) {
@@ -46,4 +46,18 @@ inline void checkError(std::error_code EC, const Twine &Prefix) {
     error(Prefix + ": " + EC.message());
 }
 
+// Returns the error checkError() reports, so that it can be reported later,
+// e.g., by the main thread for worker threads.
+inline Error makeError(std::error_code EC, const Twine &Prefix) {
+  if (!EC)
+    return Error::success();
+  return createStringError(EC, Prefix + ": " + EC.message());
+}
+
+// Reports E like error() does.
+inline void exitOnError(Error E) {
+  if (E)
+    error(toString(std::move(E)));
+}
+
 } // namespace llvm
@@ -14,6 +14,7 @@
 //===----------------------------------------------------------------------===//
 
 #include "ModuleSplitter.h"
+#include "PostLinkCache.h"
 #include "SYCLDeviceLibReqMask.h"
 #include "SYCLDeviceRequirements.h"
 #include "SYCLKernelParamOptInfo.h"
@@ -25,6 +26,8 @@
 #include "llvm/Analysis/ProfileSummaryInfo.h"
 #include "llvm/Analysis/TargetLibraryInfo.h"
 #include "llvm/Analysis/TargetTransformInfo.h"
+#include "llvm/Bitcode/BitcodeReader.h"
+#include "llvm/Bitcode/BitcodeWriter.h"
 #include "llvm/Bitcode/BitcodeWriterPass.h"
 #include "llvm/GenXIntrinsics/GenXSPIRVWriterAdaptor.h"
 #include "llvm/IR/Dominators.h"
@@ -41,15 +44,20 @@
 #include "llvm/SYCLLowerIR/ESIMD/LowerESIMD.h"
 #include "llvm/SYCLLowerIR/HostPipes.h"
 #include "llvm/SYCLLowerIR/LowerInvokeSimd.h"
+#include "llvm/SYCLLowerIR/PackAccessorArgs.h"
 #include "llvm/SYCLLowerIR/SYCLUtils.h"
+#include "llvm/Support/CachePruning.h"
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/InitLLVM.h"
+#include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/Path.h"
 #include "llvm/Support/PropertySetIO.h"
 #include "llvm/Support/SimpleTable.h"
 #include "llvm/Support/SourceMgr.h"
 #include "llvm/Support/SystemUtils.h"
+#include "llvm/Support/ThreadPool.h"
+#include "llvm/Support/Threading.h"
 #include "llvm/Support/WithColor.h"
 #include "llvm/Transforms/IPO/AlwaysInliner.h"
 #include "llvm/Transforms/InstCombine/InstCombine.h"
@@ -60,8 +68,10 @@
 #include "llvm/Transforms/Utils/GlobalStatus.h"
 
 #include <algorithm>
+#include <condition_variable>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <queue>
 #include <string>
 #include <unordered_set>
@@ -168,9 +178,18 @@ cl::opt<module_split::IRSplitMode> SplitMode(
                clEnumValN(module_split::SPLIT_PER_KERNEL, "kernel",
                           "1 output module per kernel"),
                clEnumValN(module_split::SPLIT_AUTO, "auto",
-                          "Choose split mode automatically")),
+                          "Choose split mode automatically"),
+               clEnumValN(module_split::SPLIT_BALANCED, "balanced",
+                          "Group kernels sharing code into modules of "
+                          "about -split-target-size")),
     cl::cat(PostLinkCat));
 
+cl::opt<unsigned> SplitTargetSize{
+    "split-target-size",
+    cl::desc("Target size in LLVM IR instructions of the modules produced by "
+             "-split=balanced. Kernels larger than that get their own module"),
+    cl::init(20000), cl::cat(PostLinkCat)};
+
 cl::opt<bool> DoSymGen{"symbols", cl::desc("generate exported symbol files"),
                        cl::cat(PostLinkCat)};
 
@@ -191,6 +210,12 @@ cl::opt<bool> EmitKernelParamInfo{
     "emit-param-info", cl::desc("emit kernel parameter optimization info"),
     cl::cat(PostLinkCat)};
 
+cl::opt<bool> PackAccessorArgs{
+    "pack-accessor-args",
+    cl::desc("Pack the kernel arguments holding accessor ranges and offsets "
+             "into a single argument"),
+    cl::cat(PostLinkCat)};
+
 cl::opt<bool> EmitProgramMetadata{"emit-program-metadata",
                                   cl::desc("emit SYCL program metadata"),
                                   cl::cat(PostLinkCat)};
@@ -210,11 +235,45 @@ cl::opt<bool> DeviceGlobals{
     cl::desc("Lower and generate information about device global variables"),
     cl::cat(PostLinkCat)};
 
+cl::opt<bool> EmbedFusionBitcode{
+    "embed-fusion-bitcode",
+    cl::desc("Embed the LLVM bitcode of each device image into its properties "
+             "for use by the kernel fusion JIT compiler"),
+    cl::cat(PostLinkCat)};
+
+cl::opt<unsigned> NumThreads{
+    "num-threads",
+    cl::desc("Number of threads used to process device code splits "
+             "concurrently. 0 uses all available hardware threads"),
+    cl::init(1), cl::cat(PostLinkCat)};
+
+cl::alias NumThreadsA{"j", cl::desc("Alias for --num-threads"),
+                      cl::aliasopt(NumThreads)};
+
+cl::opt<unsigned> SplitMemoryBudget{
+    "split-memory-budget",
+    cl::desc("Upper bound in MiB of the serialized size of the device code "
+             "splits processed concurrently. 0 means no bound"),
+    cl::init(0), cl::cat(PostLinkCat)};
+
+cl::opt<std::string> CacheDir{
+    "cache-dir",
+    cl::desc("Directory of a cache of the outputs produced for input "
+             "modules. Modules found in the cache are not processed again"),
+    cl::value_desc("dir"), cl::cat(PostLinkCat)};
+
+cl::opt<std::string> CachePolicy{
+    "cache-policy",
+    cl::desc("Pruning policy of the -cache-dir cache, in the format described "
+             "in llvm/Support/CachePruning.h"),
+    cl::value_desc("policy"), cl::cat(PostLinkCat)};
+
 struct GlobalBinImageProps {
   bool EmitKernelParamInfo;
   bool EmitProgramMetadata;
   bool EmitExportedSymbols;
   bool EmitDeviceGlobalPropSet;
+  bool EmbedFusionBitcode;
 };
 
 struct IrPropSymFilenameTriple {
@@ -223,12 +282,14 @@ struct IrPropSymFilenameTriple {
   std::string Sym;
 };
 
-void writeToFile(const std::string &Filename, const std::string &Content) {
+Error writeToFile(const std::string &Filename, const std::string &Content) {
   std::error_code EC;
   raw_fd_ostream OS{Filename, EC, sys::fs::OpenFlags::OF_None};
-  checkError(EC, "error opening the file '" + Filename + "'");
+  if (EC)
+    return makeError(EC, "error opening the file '" + Filename + "'");
   OS.write(Content.data(), Content.size());
   OS.close();
+  return Error::success();
 }
 
 // This function traverses over reversed call graph by BFS algorithm.
@@ -331,10 +392,11 @@ std::string makeResultFileName(Twine Ext, int I, StringRef Suffix) {
          std::to_string(I) + Ext.str();
 }
 
-void saveModuleIR(Module &M, StringRef OutFilename) {
+Error saveModuleIR(Module &M, StringRef OutFilename) {
   std::error_code EC;
   raw_fd_ostream Out{OutFilename, EC, sys::fs::OF_None};
-  checkError(EC, "error opening the file '" + OutFilename + "'");
+  if (EC)
+    return makeError(EC, "error opening the file '" + OutFilename + "'");
 
   // TODO: Use the new PassManager instead?
   legacy::PassManager PrintModule;
@@ -344,19 +406,22 @@ void saveModuleIR(Module &M, StringRef OutFilename) {
   else if (Force || !CheckBitcodeOutputToConsole(Out))
     PrintModule.add(createBitcodeWriterPass(Out));
   PrintModule.run(M);
+  return Error::success();
 }
 
-std::string saveModuleIR(Module &M, int I, StringRef Suff) {
+Expected<std::string> saveModuleIR(Module &M, int I, StringRef Suff) {
   DUMP_ENTRY_POINTS(M, EmitOnlyKernelsAsEntryPoints, "saving IR");
   StringRef FileExt = (OutputAssembly) ? ".ll" : ".bc";
   std::string OutFilename = makeResultFileName(FileExt, I, Suff);
-  saveModuleIR(M, OutFilename);
+  if (Error E = saveModuleIR(M, OutFilename))
+    return std::move(E);
   return OutFilename;
 }
 
-std::string saveModuleProperties(module_split::ModuleDesc &MD,
-                                 const GlobalBinImageProps &GlobProps, int I,
-                                 StringRef Suff) {
+Expected<std::string>
+saveModuleProperties(module_split::ModuleDesc &MD,
+                     const GlobalBinImageProps &GlobProps, int I,
+                     StringRef Suff) {
   using PropSetRegTy = llvm::util::PropertySetRegistry;
   PropSetRegTy PropSet;
   Module &M = MD.getModule();
@@ -383,6 +448,20 @@ std::string saveModuleProperties(module_split::ModuleDesc &MD,
     PropSet.add(PropSetRegTy::SYCL_SPEC_CONSTANTS_DEFAULT_VALUES, "all",
                 DefaultValues);
   }
+  {
+    // Record the layouts of the kernel arguments packed by SYCLPackAccessorArgs
+    std::map<StringRef, std::vector<uint32_t>> ArgPacking;
+    for (const Function &F : M) {
+      const MDNode *Node = F.getMetadata(SYCL_KERNEL_PACKED_ARGS_MD);
+      if (!Node)
+        continue;
+      std::vector<uint32_t> &Layout = ArgPacking[F.getName()];
+      for (const MDOperand &Op : Node->operands())
+        Layout.push_back(mdconst::extract<ConstantInt>(Op)->getZExtValue());
+    }
+    if (!ArgPacking.empty())
+      PropSet.add(PropSetRegTy::SYCL_KERNEL_ARG_PACKING, ArgPacking);
+  }
   if (GlobProps.EmitKernelParamInfo) {
     // extract kernel parameter optimization info per module
     ModuleAnalysisManager MAM;
@@ -454,6 +533,14 @@ std::string saveModuleProperties(module_split::ModuleDesc &MD,
   if (MD.isESIMD()) {
     PropSet[PropSetRegTy::SYCL_MISC_PROP].insert({"isEsimdImage", true});
   }
+  if (SplitMode == module_split::SPLIT_BALANCED) {
+    // Report the size of each cluster to allow tuning -split-target-size.
+    uint32_t InstCount = 0;
+    for (const Function &F : M)
+      InstCount += F.getInstructionCount();
+    PropSet[PropSetRegTy::SYCL_MISC_PROP].insert(
+        {"irInstructionCount", InstCount});
+  }
 
   {
     StringRef RegAllocModeAttr = "sycl-register-alloc-mode";
@@ -523,18 +610,32 @@ std::string saveModuleProperties(module_split::ModuleDesc &MD,
     PropSet.add(PropSetRegTy::SYCL_HOST_PIPES, HostPipePropertyMap);
   }
 
+  // ESIMD kernels cannot be fused, so only embed bitcode for SYCL images. The
+  // kernel fusion JIT compiler loads the bitcode instead of translating the
+  // SPIR-V of the device image back to LLVM IR.
+  if (GlobProps.EmbedFusionBitcode && !MD.isESIMD()) {
+    std::string Bitcode;
+    raw_string_ostream BitcodeOut{Bitcode};
+    WriteBitcodeToFile(M, BitcodeOut);
+    BitcodeOut.flush();
+    PropSet.add(PropSetRegTy::SYCL_FUSION_BITCODE, "bitcode",
+                StringRef{Bitcode});
+  }
+
   std::error_code EC;
   std::string SCFile = makeResultFileName(".prop", I, Suff);
   raw_fd_ostream SCOut(SCFile, EC);
-  checkError(EC, "error opening file '" + SCFile + "'");
+  if (EC)
+    return makeError(EC, "error opening file '" + SCFile + "'");
   PropSet.write(SCOut);
 
   return SCFile;
 }
 
 // Saves specified collection of symbols to a file.
-std::string saveModuleSymbolTable(const module_split::EntryPointSet &Es, int I,
-                                  StringRef Suffix) {
+Expected<std::string>
+saveModuleSymbolTable(const module_split::EntryPointSet &Es, int I,
+                      StringRef Suffix) {
 #ifndef NDEBUG
   if (DebugPostLink > 0) {
     llvm::errs() << "ENTRY POINTS saving Sym table {\n";
@@ -552,7 +653,8 @@ std::string saveModuleSymbolTable(const module_split::EntryPointSet &Es, int I,
   }
   // Save to file.
   std::string OutFileName = makeResultFileName(".sym", I, Suffix);
-  writeToFile(OutFileName, SymT);
+  if (Error E = writeToFile(OutFileName, SymT))
+    return std::move(E);
   return OutFileName;
 }
 
@@ -633,8 +735,9 @@ StringRef getModuleSuffix(const module_split::ModuleDesc &MD) {
 //   the result.
 // @return a triple of files where IR, Property and Symbols components of the
 //   Module descriptor are written respectively.
-IrPropSymFilenameTriple saveModule(module_split::ModuleDesc &MD, int I,
-                                   StringRef IRFilename = "") {
+Expected<IrPropSymFilenameTriple> saveModule(module_split::ModuleDesc &MD,
+                                             int I,
+                                             StringRef IRFilename = "") {
   IrPropSymFilenameTriple Res;
   StringRef Suffix = getModuleSuffix(MD);
 
@@ -642,21 +745,33 @@ IrPropSymFilenameTriple saveModule(module_split::ModuleDesc &MD, int I,
     // don't save IR, just record the filename
     Res.Ir = IRFilename.str();
   } else {
-    Res.Ir = saveModuleIR(MD.getModule(), I, Suffix);
+    Expected<std::string> IrOrErr = saveModuleIR(MD.getModule(), I, Suffix);
+    if (!IrOrErr)
+      return IrOrErr.takeError();
+    Res.Ir = std::move(*IrOrErr);
   }
   GlobalBinImageProps Props = {EmitKernelParamInfo, EmitProgramMetadata,
-                               EmitExportedSymbols, DeviceGlobals};
-  Res.Prop = saveModuleProperties(MD, Props, I, Suffix);
+                               EmitExportedSymbols, DeviceGlobals,
+                               EmbedFusionBitcode};
+  Expected<std::string> PropOrErr =
+      saveModuleProperties(MD, Props, I, Suffix);
+  if (!PropOrErr)
+    return PropOrErr.takeError();
+  Res.Prop = std::move(*PropOrErr);
 
   if (DoSymGen) {
     // save the names of the entry points - the symbol table
-    Res.Sym = saveModuleSymbolTable(MD.entries(), I, Suffix);
+    Expected<std::string> SymOrErr =
+        saveModuleSymbolTable(MD.entries(), I, Suffix);
+    if (!SymOrErr)
+      return SymOrErr.takeError();
+    Res.Sym = std::move(*SymOrErr);
   }
   return Res;
 }
 
-module_split::ModuleDesc link(module_split::ModuleDesc &&MD1,
-                              module_split::ModuleDesc &&MD2) {
+Expected<module_split::ModuleDesc> link(module_split::ModuleDesc &&MD1,
+                                        module_split::ModuleDesc &&MD2) {
   std::vector<std::string> Names;
   MD1.saveEntryPointNames(Names);
   MD2.saveEntryPointNames(Names);
@@ -664,7 +779,8 @@ module_split::ModuleDesc link(module_split::ModuleDesc &&MD1,
       MD1.getModule(), std::move(MD2.releaseModulePtr()));
 
   if (link_error) {
-    error(" error when linking SYCL and ESIMD modules");
+    return createStringError(inconvertibleErrorCode(),
+                             " error when linking SYCL and ESIMD modules");
   }
   module_split::ModuleDesc Res(MD1.releaseModulePtr(), std::move(Names));
   Res.assignMergedProperties(MD1, MD2);
@@ -751,9 +867,129 @@ static bool removeSYCLKernelsConstRefArray(Module &M) {
   return true;
 }
 
-std::unique_ptr<util::SimpleTable>
-processInputModule(std::unique_ptr<Module> M) {
-  // Construct the resulting table which will accumulate all the outputs.
+// State of the input module processing shared by all the splits.
+struct SplitProcessingState {
+  // Whether the input module was modified before splitting.
+  bool Modified;
+  // Whether the input module was split into more than one module.
+  bool SplitOccurred;
+};
+
+// Outputs of processing a single split.
+struct SplitResult {
+  std::vector<IrPropSymFilenameTriple> Rows;
+  // Warnings and notes, reported by the main thread in split order.
+  std::string Diagnostics;
+};
+
+// Runs the SYCL/ESIMD split and the per-module transformations on a split of
+// the input module and saves the results. Splits are processed independently,
+// so this may run concurrently for splits living in different contexts.
+// Errors and diagnostics are returned rather than reported, as this may run on
+// a worker thread.
+Expected<SplitResult> processSplit(module_split::ModuleDesc MDesc, int ID,
+                                   const SplitProcessingState &State) {
+  SplitResult Res;
+  raw_string_ostream Diags{Res.Diagnostics};
+  DUMP_ENTRY_POINTS(MDesc.entries(), MDesc.Name.c_str(), 1);
+  bool Modified = State.Modified;
+  bool SplitOccurred = State.SplitOccurred;
+
+  MDesc.fixupLinkageOfDirectInvokeSimdTargets();
+
+  // Do SYCL/ESIMD splitting. It happens always, as ESIMD and SYCL must
+  // undergo different set of LLVMIR passes. After this they are linked back
+  // together to form single module with disjoint SYCL and ESIMD call graphs
+  // unless -split-esimd option is specified. The graphs become disjoint
+  // when linked back because functions shared between graphs are cloned and
+  // renamed.
+  std::unique_ptr<module_split::ModuleSplitterBase> ESIMDSplitter =
+      module_split::getSplitterByKernelType(std::move(MDesc),
+                                            EmitOnlyKernelsAsEntryPoints);
+  bool ESIMDSplitOccurred = ESIMDSplitter->remainingSplits() > 1;
+
+  if (ESIMDSplitOccurred && SplitOccurred &&
+      (SplitMode == module_split::SPLIT_PER_KERNEL) && !SplitEsimd) {
+    // Controversial state reached - SYCL and ESIMD entry points resulting
+    // from SYCL/ESIMD split (which is done always) are linked back, since
+    // -split-esimd is not specified, but per-kernel split is requested.
+    warning("SYCL and ESIMD entry points detected and split mode is "
+            "per-kernel, so " +
+                SplitEsimd.ValueStr + " must also be specified",
+            Diags);
+  }
+  SmallVector<module_split::ModuleDesc, 2> MMs;
+  SplitOccurred |= ESIMDSplitOccurred;
+  Modified |= SplitOccurred;
+
+  while (ESIMDSplitter->hasMoreSplits()) {
+    module_split::ModuleDesc MDesc2 = ESIMDSplitter->nextSplit();
+    DUMP_ENTRY_POINTS(MDesc2.entries(), MDesc2.Name.c_str(), 3);
+    Modified |= processSpecConstants(MDesc2);
+
+    if (!MDesc2.isSYCL() && LowerEsimd) {
+      assert(MDesc2.isESIMD() && "NYI");
+      Modified |= lowerEsimdConstructs(MDesc2);
+    }
+    MMs.emplace_back(std::move(MDesc2));
+  }
+  if (!SplitEsimd && (MMs.size() > 1)) {
+    // SYCL/ESIMD splitting is not requested, link back into single module.
+    assert(MMs.size() == 2);
+    assert((MMs[0].isESIMD() && MMs[1].isSYCL()) ||
+           (MMs[1].isESIMD() && MMs[0].isSYCL()));
+    int ESIMDInd = MMs[0].isESIMD() ? 0 : 1;
+    int SYCLInd = MMs[0].isESIMD() ? 1 : 0;
+    // ... but before that, make sure no link conflicts will occur.
+    MMs[ESIMDInd].renameDuplicatesOf(MMs[SYCLInd].getModule(), ".esimd");
+    Expected<module_split::ModuleDesc> M2OrErr =
+        link(std::move(MMs[0]), std::move(MMs[1]));
+    if (!M2OrErr)
+      return M2OrErr.takeError();
+    module_split::ModuleDesc M2 = std::move(*M2OrErr);
+    M2.restoreLinkageOfDirectInvokeSimdTargets();
+    string_vector Names;
+    M2.saveEntryPointNames(Names);
+    M2.cleanup(); // may remove some entry points, need to save/rebuild
+    M2.rebuildEntryPoints(Names);
+    MMs.clear();
+    MMs.emplace_back(std::move(M2));
+    DUMP_ENTRY_POINTS(MMs.back().entries(), MMs.back().Name.c_str(), 3);
+    Modified = true;
+  }
+
+  if (IROutputOnly) {
+    if (SplitOccurred) {
+      return createStringError(inconvertibleErrorCode(),
+                               "some modules had to be split, '-" +
+                                   IROutputOnly.ArgStr + "' can't be used");
+    }
+    if (Error E = saveModuleIR(MMs.front().getModule(), OutputFilename))
+      return std::move(E);
+    return Res;
+  }
+  // Empty IR file name directs saveModule to generate one and save IR to
+  // it:
+  std::string OutIRFileName = "";
+
+  if (!Modified && (OutputFilename.getNumOccurrences() == 0)) {
+    assert(!SplitOccurred);
+    OutIRFileName = InputFilename; // ... non-empty means "skip IR writing"
+    Diags << "sycl-post-link NOTE: no modifications to the input LLVM IR "
+             "have been made\n";
+  }
+  for (module_split::ModuleDesc &IrMD : MMs) {
+    Expected<IrPropSymFilenameTriple> RowOrErr =
+        saveModule(IrMD, ID, OutIRFileName);
+    if (!RowOrErr)
+      return RowOrErr.takeError();
+    Res.Rows.push_back(std::move(*RowOrErr));
+  }
+  return Res;
+}
+
+// Creates the output file table, without rows.
+std::unique_ptr<util::SimpleTable> createOutputTable() {
   SmallVector<StringRef, MAX_COLUMNS_IN_FILE_TABLE> ColumnTitles{
       StringRef(COL_CODE), StringRef(COL_PROPS)};
 
@@ -763,7 +999,105 @@ processInputModule(std::unique_ptr<Module> M) {
   Expected<std::unique_ptr<util::SimpleTable>> TableE =
       util::SimpleTable::create(ColumnTitles);
   CHECK_AND_EXIT(TableE.takeError());
-  std::unique_ptr<util::SimpleTable> Table = std::move(TableE.get());
+  return std::move(TableE.get());
+}
+
+// Computes the key of the input module in the cache from its contents and the
+// command line. Options which do not influence the contents of the output
+// files, like the input and output file names or the number of threads, are
+// skipped, so that the cache is shared between builds of different files.
+std::string computeCacheKey(StringRef Input, int argc, char **argv) {
+  // Options which take a value. The value may also be passed as a separate
+  // argument.
+  static constexpr StringRef IgnoredOptions[] = {
+      "o", "out-dir", "cache-dir", "cache-policy", "num-threads", "j",
+      "split-memory-budget"};
+  PostLinkCacheKey Key;
+  for (int I = 1; I < argc; ++I) {
+    StringRef Arg{argv[I]};
+    if (Arg == InputFilename)
+      continue;
+    StringRef Name = Arg.ltrim('-');
+    if (Arg.startswith("-") &&
+        llvm::any_of(IgnoredOptions, [&](StringRef Ignored) {
+          if (Name == Ignored) {
+            ++I; // Skip the separate value.
+            return true;
+          }
+          return Name.startswith((Ignored + "=").str());
+        }))
+      continue;
+    Key.add(Arg);
+  }
+  Key.add(Input);
+  return Key.result();
+}
+
+// Recreates the output files and the output file table from the cache.
+// Returns nullptr if the input module is not in the cache.
+std::unique_ptr<util::SimpleTable> loadCachedOutputs(StringRef Key) {
+  std::optional<std::vector<CachedTableRow>> Rows =
+      lookupCachedTable(CacheDir, Key);
+  if (!Rows)
+    return nullptr;
+  std::unique_ptr<util::SimpleTable> Table = createOutputTable();
+  const size_t NumColumns = Table->getNumColumns();
+  // Entries are checked before any file is written, so that a corrupted entry
+  // does not leave stray files behind.
+  if (llvm::any_of(*Rows, [&](const CachedTableRow &Row) {
+        return Row.size() != NumColumns;
+      }))
+    return nullptr;
+  for (const CachedTableRow &Row : *Rows) {
+    SmallVector<std::string, MAX_COLUMNS_IN_FILE_TABLE> Files;
+    for (const CachedOutputFile &File : Row) {
+      Files.push_back(makeResultFileName(File.Ext, File.ID, File.Suffix));
+      exitOnError(writeToFile(Files.back(), File.Contents));
+    }
+    Table->addRow(SmallVector<StringRef, MAX_COLUMNS_IN_FILE_TABLE>(
+        Files.begin(), Files.end()));
+  }
+  return Table;
+}
+
+// Stores the output files listed in Table in the cache. Failures to store are
+// not fatal, the input module is processed again by the next build.
+void storeCachedOutputs(StringRef Key, const util::SimpleTable &Table) {
+  const StringRef OutputStem = sys::path::stem(OutputFilename);
+  std::vector<CachedTableRow> Rows;
+  for (const util::SimpleTable::Row &TableRow : Table.rows()) {
+    CachedTableRow &Row = Rows.emplace_back();
+    for (StringRef Column : {COL_CODE, COL_PROPS, COL_SYM}) {
+      StringRef FileName = TableRow.getCell(Column, "");
+      if (FileName.empty())
+        continue;
+      // Output file names are built by makeResultFileName. The input file,
+      // listed when the module is not modified, is not an output.
+      StringRef Stem = sys::path::stem(FileName);
+      auto [Suffix, IDStr] = Stem.rsplit('_');
+      uint64_t ID;
+      if (FileName == InputFilename || !Suffix.consume_front(OutputStem) ||
+          IDStr.getAsInteger(10, ID))
+        return;
+      ErrorOr<std::unique_ptr<MemoryBuffer>> MBOrErr =
+          MemoryBuffer::getFile(FileName, /*IsText=*/false,
+                                /*RequiresNullTerminator=*/false);
+      if (!MBOrErr)
+        return;
+      Row.push_back(CachedOutputFile{Suffix.str(), ID,
+                                     sys::path::extension(FileName).str(),
+                                     (*MBOrErr)->getBuffer().str()});
+    }
+  }
+  if (Error E = llvm::storeCachedTable(CacheDir, Key, Rows))
+    warning("failed to store the outputs in the cache: " +
+            toString(std::move(E)));
+}
+
+std::unique_ptr<util::SimpleTable>
+processInputModule(std::unique_ptr<Module> M) {
+  // Construct the resulting table which will accumulate all the outputs.
+  std::unique_ptr<util::SimpleTable> Table = createOutputTable();
 
   // Used in output filenames generation.
   int ID = 0;
@@ -785,6 +1119,10 @@ processInputModule(std::unique_ptr<Module> M) {
   // actions.
   Modified |= removeSYCLKernelsConstRefArray(*M.get());
 
+  // Pack accessor arguments before splitting, so that the pass runs once.
+  if (PackAccessorArgs)
+    Modified |= runModulePass<SYCLPackAccessorArgsPass>(*M);
+
   // Do invoke_simd processing before splitting because this:
   // - saves processing time (the pass is run once, even though on larger IR)
   // - doing it before SYCL/ESIMD splitting is required for correctness
@@ -806,10 +1144,12 @@ processInputModule(std::unique_ptr<Module> M) {
           (SplitMode == module_split::SPLIT_AUTO)) &&
          "invalid split mode for IR-only output");
 
+  // Worker contexts must use the same kind of pointers as the input module.
+  const bool TypedPointers = M->getContext().supportsTypedPointers();
   std::unique_ptr<module_split::ModuleSplitterBase> Splitter =
       module_split::getDeviceCodeSplitter(
           module_split::ModuleDesc{std::move(M)}, SplitMode, IROutputOnly,
-          EmitOnlyKernelsAsEntryPoints);
+          EmitOnlyKernelsAsEntryPoints, SplitTargetSize);
   bool SplitOccurred = Splitter->remainingSplits() > 1;
   Modified |= SplitOccurred;
 
@@ -817,95 +1157,114 @@ processInputModule(std::unique_ptr<Module> M) {
   if (DeviceGlobals)
     Splitter->verifyNoCrossModuleDeviceGlobalUsage();
 
-  // It is important that we *DO NOT* preserve all the splits in memory at the
-  // same time, because it leads to a huge RAM consumption by the tool on bigger
-  // inputs.
-  while (Splitter->hasMoreSplits()) {
-    module_split::ModuleDesc MDesc = Splitter->nextSplit();
-    DUMP_ENTRY_POINTS(MDesc.entries(), MDesc.Name.c_str(), 1);
-
-    MDesc.fixupLinkageOfDirectInvokeSimdTargets();
-
-    // Do SYCL/ESIMD splitting. It happens always, as ESIMD and SYCL must
-    // undergo different set of LLVMIR passes. After this they are linked back
-    // together to form single module with disjoint SYCL and ESIMD call graphs
-    // unless -split-esimd option is specified. The graphs become disjoint
-    // when linked back because functions shared between graphs are cloned and
-    // renamed.
-    std::unique_ptr<module_split::ModuleSplitterBase> ESIMDSplitter =
-        module_split::getSplitterByKernelType(std::move(MDesc),
-                                              EmitOnlyKernelsAsEntryPoints);
-    bool ESIMDSplitOccurred = ESIMDSplitter->remainingSplits() > 1;
-
-    if (ESIMDSplitOccurred && SplitOccurred &&
-        (SplitMode == module_split::SPLIT_PER_KERNEL) && !SplitEsimd) {
-      // Controversial state reached - SYCL and ESIMD entry points resulting
-      // from SYCL/ESIMD split (which is done always) are linked back, since
-      // -split-esimd is not specified, but per-kernel split is requested.
-      warning("SYCL and ESIMD entry points detected and split mode is "
-              "per-kernel, so " +
-              SplitEsimd.ValueStr + " must also be specified");
-    }
-    SmallVector<module_split::ModuleDesc, 2> MMs;
-    SplitOccurred |= ESIMDSplitOccurred;
-    Modified |= SplitOccurred;
-
-    while (ESIMDSplitter->hasMoreSplits()) {
-      module_split::ModuleDesc MDesc2 = ESIMDSplitter->nextSplit();
-      DUMP_ENTRY_POINTS(MDesc2.entries(), MDesc2.Name.c_str(), 3);
-      Modified |= processSpecConstants(MDesc2);
-
-      if (!MDesc2.isSYCL() && LowerEsimd) {
-        assert(MDesc2.isESIMD() && "NYI");
-        Modified |= lowerEsimdConstructs(MDesc2);
-      }
-      MMs.emplace_back(std::move(MDesc2));
-    }
-    if (!SplitEsimd && (MMs.size() > 1)) {
-      // SYCL/ESIMD splitting is not requested, link back into single module.
-      assert(MMs.size() == 2);
-      assert((MMs[0].isESIMD() && MMs[1].isSYCL()) ||
-             (MMs[1].isESIMD() && MMs[0].isSYCL()));
-      int ESIMDInd = MMs[0].isESIMD() ? 0 : 1;
-      int SYCLInd = MMs[0].isESIMD() ? 1 : 0;
-      // ... but before that, make sure no link conflicts will occur.
-      MMs[ESIMDInd].renameDuplicatesOf(MMs[SYCLInd].getModule(), ".esimd");
-      module_split::ModuleDesc M2 = link(std::move(MMs[0]), std::move(MMs[1]));
-      M2.restoreLinkageOfDirectInvokeSimdTargets();
-      string_vector Names;
-      M2.saveEntryPointNames(Names);
-      M2.cleanup(); // may remove some entry points, need to save/rebuild
-      M2.rebuildEntryPoints(Names);
-      MMs.clear();
-      MMs.emplace_back(std::move(M2));
-      DUMP_ENTRY_POINTS(MMs.back().entries(), MMs.back().Name.c_str(), 3);
-      Modified = true;
+  const unsigned Threads = IROutputOnly ? 1u
+                                        : hardware_concurrency(NumThreads)
+                                              .compute_thread_count();
+  SplitProcessingState State{Modified, SplitOccurred};
+
+  if (Threads <= 1) {
+    // It is important that we *DO NOT* preserve all the splits in memory at
+    // the same time, because it leads to a huge RAM consumption by the tool on
+    // bigger inputs.
+    while (Splitter->hasMoreSplits()) {
+      module_split::ModuleDesc MDesc = Splitter->nextSplit();
+      Expected<SplitResult> ResOrErr =
+          processSplit(std::move(MDesc), ID++, State);
+      exitOnError(ResOrErr.takeError());
+      errs() << ResOrErr->Diagnostics;
+      if (IROutputOnly)
+        return Table;
+      for (const IrPropSymFilenameTriple &T : ResOrErr->Rows)
+        addTableRow(*Table, T);
     }
+    return Table;
+  }
 
-    if (IROutputOnly) {
-      if (SplitOccurred) {
-        error("some modules had to be split, '-" + IROutputOnly.ArgStr +
-              "' can't be used");
-      }
-      saveModuleIR(MMs.front().getModule(), OutputFilename);
-      return Table;
+  // Process the splits concurrently. The splitter works on the input module's
+  // context, so each split is handed to a worker as bitcode and loaded into a
+  // separate context there. The number of splits in flight is bounded by the
+  // thread count and the memory budget, so that we still do not keep all the
+  // splits in memory at the same time. Split IDs are assigned in splitter
+  // order. Workers do not report anything, the rows are added to the table and
+  // the diagnostics and errors are reported by the main thread in ID order, so
+  // the output does not depend on the scheduling of the workers.
+  const uint64_t Budget = static_cast<uint64_t>(SplitMemoryBudget) << 20;
+  const size_t MaxInFlight = 2 * static_cast<size_t>(Threads);
+  std::vector<std::optional<Expected<SplitResult>>> Results(
+      Splitter->remainingSplits());
+  std::mutex InFlightMutex;
+  std::condition_variable InFlightCV;
+  uint64_t BytesInFlight = 0;
+  size_t SplitsInFlight = 0;
+
+  ThreadPool Pool(hardware_concurrency(Threads));
+  while (Splitter->hasMoreSplits()) {
+    auto Bitcode = std::make_shared<SmallVector<char, 0>>();
+    std::vector<std::string> EntryNames;
+    std::string GroupId;
+    module_split::EntryPointGroup::Properties GroupProps;
+    module_split::ModuleDesc::Properties Props;
+    {
+      // The split is freed in the input context before waiting for a slot.
+      module_split::ModuleDesc MDesc = Splitter->nextSplit();
+      raw_svector_ostream OS{*Bitcode};
+      WriteBitcodeToFile(MDesc.getModule(), OS);
+      MDesc.saveEntryPointNames(EntryNames);
+      GroupId = MDesc.getEntryPointGroup().GroupId;
+      GroupProps = MDesc.getEntryPointGroup().Props;
+      Props = MDesc.Props;
     }
-    // Empty IR file name directs saveModule to generate one and save IR to
-    // it:
-    std::string OutIRFileName = "";
-
-    if (!Modified && (OutputFilename.getNumOccurrences() == 0)) {
-      assert(!SplitOccurred);
-      OutIRFileName = InputFilename; // ... non-empty means "skip IR writing"
-      errs() << "sycl-post-link NOTE: no modifications to the input LLVM IR "
-                "have been made\n";
-    }
-    for (module_split::ModuleDesc &IrMD : MMs) {
-      IrPropSymFilenameTriple T = saveModule(IrMD, ID, OutIRFileName);
-      addTableRow(*Table, T);
+    const uint64_t Size = Bitcode->size();
+
+    {
+      // Always admit a split if nothing is in flight, even if it exceeds the
+      // budget on its own.
+      std::unique_lock<std::mutex> Lock{InFlightMutex};
+      InFlightCV.wait(Lock, [&] {
+        return SplitsInFlight == 0 ||
+               (SplitsInFlight < MaxInFlight &&
+                (Budget == 0 || BytesInFlight + Size <= Budget));
+      });
+      ++SplitsInFlight;
+      BytesInFlight += Size;
     }
 
-    ++ID;
+    const int SplitID = ID++;
+    Pool.async([&, Bitcode, EntryNames = std::move(EntryNames),
+                GroupId = std::move(GroupId), GroupProps, Props, Size,
+                SplitID]() mutable {
+      auto Release = [&] {
+        std::lock_guard<std::mutex> Lock{InFlightMutex};
+        --SplitsInFlight;
+        BytesInFlight -= Size;
+        InFlightCV.notify_all();
+      };
+      Results[SplitID].emplace([&]() -> Expected<SplitResult> {
+        LLVMContext Ctx;
+        Ctx.setOpaquePointers(!TypedPointers);
+        Expected<std::unique_ptr<Module>> MOrErr = parseBitcodeFile(
+            MemoryBufferRef{StringRef{Bitcode->data(), Bitcode->size()},
+                            "split"},
+            Ctx);
+        if (!MOrErr)
+          return MOrErr.takeError();
+        Bitcode.reset();
+        module_split::ModuleDesc Split{
+            std::move(*MOrErr),
+            module_split::EntryPointGroup{GroupId, {}, GroupProps}, Props};
+        Split.rebuildEntryPoints(EntryNames);
+        return processSplit(std::move(Split), SplitID, State);
+      }());
+      Release();
+    });
+  }
+  Pool.wait();
+
+  for (std::optional<Expected<SplitResult>> &ResOrErr : Results) {
+    exitOnError(ResOrErr->takeError());
+    errs() << (*ResOrErr)->Diagnostics;
+    for (const IrPropSymFilenameTriple &T : (*ResOrErr)->Rows)
+      addTableRow(*Table, T);
   }
   return Table;
 }
@@ -935,11 +1294,20 @@ int main(int argc, char **argv) {
       "  one module per kernel will be emitted.\n"
       "  '-split=auto' mode automatically selects the best way of splitting\n"
       "  kernels into modules based on some heuristic.\n"
+      "  '-split=balanced' mode ignores 'sycl-module-id' and groups kernels\n"
+      "  sharing code into modules of about '-split-target-size' LLVM IR\n"
+      "  instructions. The size of each module is recorded in its properties.\n"
       "  The '-split' option is compatible with '-split-esimd'. In this case,\n"
       "  first input module will be split according to the '-split' option\n"
       "  processing algorithm, not distinguishing between SYCL and ESIMD\n"
       "  kernels. Then each resulting module is further split into SYCL and\n"
       "  ESIMD parts if the module has both kinds of entry points.\n"
+      "  The resulting modules can be processed concurrently using\n"
+      "  '-j <N>'. '-split-memory-budget' bounds the size of the modules\n"
+      "  processed at the same time. The output does not depend on '-j'.\n"
+      "- With '-cache-dir', the output files are stored in a cache keyed by\n"
+      "  the input module and the options, and reused when the same input is\n"
+      "  met again. '-cache-policy' controls the pruning.\n"
       "- If -symbols options is also specified, then for each produced module\n"
       "  a text file containing names of all spir kernels in it is generated.\n"
       "- Specialization constant intrinsic transformer. Replaces symbolic\n"
@@ -1002,6 +1370,11 @@ int main(int argc, char **argv) {
            << " -" << IROutputOnly.ArgStr << "\n";
     return 1;
   }
+  if (IROutputOnly && PackAccessorArgs) {
+    errs() << "error: -" << PackAccessorArgs.ArgStr << " can't be used with"
+           << " -" << IROutputOnly.ArgStr << "\n";
+    return 1;
+  }
   if (IROutputOnly && DoProgMetadata) {
     errs() << "error: -" << EmitProgramMetadata.ArgStr << " can't be used with"
            << " -" << IROutputOnly.ArgStr << "\n";
@@ -1013,28 +1386,56 @@ int main(int argc, char **argv) {
     return 1;
   }
 
-  SMDiagnostic Err;
-  std::unique_ptr<Module> M = parseIRFile(InputFilename, Err, Context);
-  // It is OK to use raw pointer here as we control that it does not outlive M
-  // or objects it is moved to
-  Module *MPtr = M.get();
-
-  if (!MPtr) {
-    Err.print(argv[0], errs());
-    return 1;
-  }
-
   if (OutputFilename.getNumOccurrences() == 0) {
     std::string S =
         IROutputOnly ? (OutputAssembly ? ".out.ll" : "out.bc") : ".files";
     OutputFilename = (Twine(sys::path::stem(InputFilename)) + S).str();
   }
 
-  std::unique_ptr<util::SimpleTable> Table = processInputModule(std::move(M));
+  ErrorOr<std::unique_ptr<MemoryBuffer>> InputOrErr =
+      MemoryBuffer::getFileOrSTDIN(InputFilename);
+  if (std::error_code EC = InputOrErr.getError()) {
+    errs() << argv[0] << ": could not open input file '" << InputFilename
+           << "': " << EC.message() << "\n";
+    return 1;
+  }
+
+  // The outputs of an input module only depend on its contents and on the
+  // options, so on a cache hit the module is not even parsed. The cache is
+  // not used for single IR file output.
+  const bool UseCache = !CacheDir.empty() && !IROutputOnly;
+  std::string CacheKey;
+  std::unique_ptr<util::SimpleTable> Table;
+  if (UseCache) {
+    CacheKey = computeCacheKey((*InputOrErr)->getBuffer(), argc, argv);
+    Table = loadCachedOutputs(CacheKey);
+  }
+
+  if (!Table) {
+    SMDiagnostic Err;
+    std::unique_ptr<Module> M =
+        parseIR((*InputOrErr)->getMemBufferRef(), Err, Context);
+    if (!M) {
+      Err.print(argv[0], errs());
+      return 1;
+    }
 
-  // Input module was processed and a single output file was requested.
-  if (IROutputOnly)
-    return 0;
+    Table = processInputModule(std::move(M));
+
+    // Input module was processed and a single output file was requested.
+    if (IROutputOnly)
+      return 0;
+
+    if (UseCache)
+      storeCachedOutputs(CacheKey, *Table);
+  }
+
+  if (!CacheDir.empty()) {
+    Expected<CachePruningPolicy> PolicyOrErr =
+        parseCachePruningPolicy(CachePolicy);
+    CHECK_AND_EXIT(PolicyOrErr.takeError());
+    pruneCache(CacheDir, *PolicyOrErr);
+  }
 
   // Emit the resulting table
   std::error_code EC;
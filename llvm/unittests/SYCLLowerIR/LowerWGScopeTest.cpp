@@ -0,0 +1,133 @@
+//===- LowerWGScopeTest.cpp - Unit tests for work group scope lowering ----===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/SYCLLowerIR/LowerWGScope.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/AsmParser/Parser.h"
+#include "llvm/IR/InstIterator.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/SourceMgr.h"
+#include "gtest/gtest.h"
+
+using namespace llvm;
+
+static std::unique_ptr<Module> parseIR(LLVMContext &C, const char *IR) {
+  SMDiagnostic Err;
+  std::unique_ptr<Module> Mod = parseAssemblyString(IR, Err, C);
+  if (!Mod)
+    Err.print("LowerWGScopeTest", errs());
+  return Mod;
+}
+
+static bool isCallTo(const Instruction &I, StringRef Name) {
+  const auto *Call = dyn_cast<CallInst>(&I);
+  const Function *Callee = Call ? Call->getCalledFunction() : nullptr;
+  return Callee && Callee->getName() == Name;
+}
+
+static bool isBarrier(const Instruction &I) {
+  return isCallTo(I, "_Z22__spirv_ControlBarrierjjj");
+}
+
+static const CallInst *findCallTo(Function &F, StringRef Name) {
+  for (const Instruction &I : instructions(F))
+    if (isCallTo(I, Name))
+      return cast<CallInst>(&I);
+  return nullptr;
+}
+
+static void runLowerWGScope(Function &F) {
+  FunctionAnalysisManager FAM;
+  SYCLLowerWGScopePass().run(F, FAM);
+}
+
+TEST(LowerWGScope, PFWICallThroughHelper) {
+  LLVMContext C;
+  std::unique_ptr<Module> M = parseIR(C, R"(
+    target triple = "spir64-unknown-unknown"
+
+    @G = addrspace(1) global i32 0
+
+    define internal void @pfwi(ptr addrspace(1) %Arg)
+        !parallel_for_work_item !0 {
+      ret void
+    }
+
+    define internal void @helper() {
+      store i32 1, ptr addrspace(1) @G
+      call void @pfwi(ptr addrspace(1) @G)
+      ret void
+    }
+
+    define void @wg() !work_group_scope !0 {
+    entry:
+      call void @helper()
+      ret void
+    }
+
+    !0 = !{}
+  )");
+  ASSERT_TRUE(M);
+  Function *F = M->getFunction("wg");
+  runLowerWGScope(*F);
+
+  // The helper is inlined, so the PFWI call is executed by all work items,
+  // while the store preceding it is executed by the leader only.
+  EXPECT_EQ(findCallTo(*F, "helper"), nullptr);
+  const CallInst *PFWICall = findCallTo(*F, "pfwi");
+  ASSERT_NE(PFWICall, nullptr);
+  const StoreInst *Store = nullptr;
+  for (const Instruction &I : instructions(F))
+    if ((Store = dyn_cast<StoreInst>(&I)))
+      break;
+  ASSERT_NE(Store, nullptr);
+  EXPECT_NE(Store->getParent(), PFWICall->getParent());
+  // Workers wait for the leader before the PFWI call.
+  EXPECT_TRUE(isBarrier(PFWICall->getParent()->front()));
+}
+
+TEST(LowerWGScope, RemoveRedundantBarriers) {
+  LLVMContext C;
+  std::unique_ptr<Module> M = parseIR(C, R"(
+    target triple = "spir64-unknown-unknown"
+
+    @G = addrspace(1) global i32 0
+
+    define internal void @pfwi(ptr %Arg) !parallel_for_work_item !0 {
+      ret void
+    }
+
+    define void @wg() !work_group_scope !0 {
+    entry:
+      %Local = alloca i32
+      store i32 1, ptr addrspace(1) @G
+      call void @pfwi(ptr %Local)
+      ret void
+    }
+
+    !0 = !{}
+  )");
+  ASSERT_TRUE(M);
+  Function *F = M->getFunction("wg");
+  runLowerWGScope(*F);
+
+  // The block of the PFWI call starts with the barrier of the materialization
+  // of the local, followed by the materialization copies and the barrier for
+  // the store of the leader. The latter is removed, as only private and shadow
+  // accesses separate it from the former.
+  const CallInst *PFWICall = findCallTo(*F, "pfwi");
+  ASSERT_NE(PFWICall, nullptr);
+  const BasicBlock *PFWIBlock = PFWICall->getParent();
+  EXPECT_TRUE(isBarrier(PFWIBlock->front()));
+  EXPECT_EQ(llvm::count_if(*PFWIBlock, isBarrier), 1);
+  // The other barriers precede the leader tests guarding the store and the
+  // materialization, in other blocks.
+  EXPECT_EQ(llvm::count_if(instructions(F), isBarrier), 3);
+}
@@ -9,6 +9,9 @@
 #ifndef SYCL_FUSION_JIT_COMPILER_JITCONTEXT_H
 #define SYCL_FUSION_JIT_COMPILER_JITCONTEXT_H
 
+#include <atomic>
+#include <cstdint>
+#include <list>
 #include <memory>
 #include <mutex>
 #include <shared_mutex>
@@ -53,6 +56,21 @@ private:
   BinaryFormat Format;
 };
 
+///
+/// Statistics of the in-memory cache of fused kernels.
+struct CacheStatistics {
+  uint64_t Hits = 0;
+
+  uint64_t Misses = 0;
+
+  uint64_t Evictions = 0;
+
+  size_t NumEntries = 0;
+
+  /// Accumulated size of the binaries of all cached kernels in bytes.
+  size_t SizeInBytes = 0;
+};
+
 ///
 /// Context to persistenly store information across invocations of the JIT
 /// compiler and manage lifetimes of binaries.
@@ -66,13 +84,41 @@ public:
   llvm::LLVMContext *getLLVMContext();
 
   template <typename... Ts> KernelBinary &emplaceKernelBinary(Ts &&...Args) {
+    auto Binary = std::make_shared<KernelBinary>(std::forward<Ts>(Args)...);
     WriteLockT WriteLock{BinariesMutex};
-    return Binaries.emplace_back(std::forward<Ts>(Args)...);
+    return *Binaries.emplace(Binary->address(), std::move(Binary))
+                .first->second;
   }
 
+  ///
+  /// Get shared ownership of the binary at Address, so it stays alive even if
+  /// the context drops it, e.g., because its cache entry is evicted.
+  std::shared_ptr<KernelBinary> getKernelBinary(BinaryAddress Address) const;
+
+  ///
+  /// Remove the binary at Address from the context and hand its ownership to
+  /// the caller.
+  std::shared_ptr<KernelBinary> releaseKernelBinary(BinaryAddress Address);
+
+  ///
+  /// Look up a fused kernel. Lookups only share the cache with each other and
+  /// are never blocked by a compilation, only by the short insertion of its
+  /// result. The binary of the returned kernel is only guaranteed to stay
+  /// alive while the entry is cached.
   std::optional<SYCLKernelInfo> getCacheEntry(CacheKeyT &Identifier) const;
 
-  void addCacheEntry(CacheKeyT &Identifier, SYCLKernelInfo &Kernel);
+  ///
+  /// Add a fused kernel to the cache. If the accumulated size of the cached
+  /// binaries exceeds MaxCacheSize bytes afterwards, the least-recently used
+  /// entries are evicted and the context releases their binaries. Binaries
+  /// the caller holds on to, e.g., because it registered them with the
+  /// runtime, stay alive until the caller drops them. A MaxCacheSize of zero
+  /// disables eviction. If the kernel is already cached, e.g., because it was
+  /// compiled concurrently, the binary of the new kernel is released.
+  void addCacheEntry(CacheKeyT &Identifier, SYCLKernelInfo &Kernel,
+                     size_t MaxCacheSize = 0);
+
+  CacheStatistics getCacheStatistics() const;
 
 private:
   // FIXME: Change this to std::shared_mutex after switching to C++17.
@@ -82,15 +128,48 @@ private:
 
   using WriteLockT = std::unique_lock<MutexT>;
 
+  /// Keys of the cached kernels, most-recently used first. The keys are owned
+  /// by the cache map, which never moves its elements.
+  using LRUListT = std::list<const CacheKeyT *>;
+
+  struct CacheEntry {
+    CacheEntry(const SYCLKernelInfo &Info,
+               std::shared_ptr<KernelBinary> Binary);
+
+    SYCLKernelInfo Info;
+
+    std::shared_ptr<KernelBinary> Binary;
+
+    /// Position of the entry in the LRU list.
+    LRUListT::iterator LRUPosition;
+  };
+
+  using CacheMapT = std::unordered_map<CacheKeyT, CacheEntry>;
+
   std::unique_ptr<llvm::LLVMContext> LLVMCtx;
 
-  MutexT BinariesMutex;
+  mutable MutexT BinariesMutex;
 
-  std::vector<KernelBinary> Binaries;
+  std::unordered_map<BinaryAddress, std::shared_ptr<KernelBinary>> Binaries;
 
   mutable MutexT CacheMutex;
 
-  std::unordered_map<CacheKeyT, SYCLKernelInfo> Cache;
+  CacheMapT Cache;
+
+  /// Accumulated size of the cached binaries, guarded by CacheMutex.
+  size_t CacheSize = 0;
+
+  /// Lookups only hold CacheMutex for reading, so reordering the LRU list on a
+  /// hit is guarded by this mutex in addition.
+  mutable std::mutex LRUMutex;
+
+  mutable LRUListT LRUList;
+
+  mutable std::atomic<uint64_t> CacheHits{0};
+
+  mutable std::atomic<uint64_t> CacheMisses{0};
+
+  std::atomic<uint64_t> CacheEvictions{0};
 };
 } // namespace jit_compiler
 
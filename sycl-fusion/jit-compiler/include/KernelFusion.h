@@ -14,6 +14,7 @@
 #include "Options.h"
 #include "Parameter.h"
 #include <cassert>
+#include <memory>
 #include <string>
 #include <variant>
 #include <vector>
@@ -25,9 +26,11 @@ public:
   explicit FusionResult(std::string &&ErrorMessage)
       : Type{FusionResultType::FAILED}, Value{std::move(ErrorMessage)} {}
 
-  explicit FusionResult(SYCLKernelInfo KernelInfo, bool Cached = false)
+  explicit FusionResult(SYCLKernelInfo KernelInfo, bool Cached = false,
+                        std::shared_ptr<const KernelBinary> Binary = nullptr)
       : Type{(Cached) ? FusionResultType::CACHED : FusionResultType::NEW},
-        Value{std::forward<SYCLKernelInfo>(KernelInfo)} {}
+        Value{std::forward<SYCLKernelInfo>(KernelInfo)},
+        Binary{std::move(Binary)} {}
 
   bool failed() const { return Type == FusionResultType::FAILED; }
 
@@ -45,11 +48,20 @@ public:
     return std::get<SYCLKernelInfo>(Value);
   }
 
+  /// Shared ownership of the binary of a new kernel, nullptr for cached ones.
+  const std::shared_ptr<const KernelBinary> &getBinary() const {
+    return Binary;
+  }
+
 private:
   enum class FusionResultType { FAILED, CACHED, NEW };
   FusionResultType Type;
 
   std::variant<std::string, SYCLKernelInfo> Value;
+
+  // Keeps the binary of a new kernel alive while the result is in use, even if
+  // it is evicted from the cache concurrently.
+  std::shared_ptr<const KernelBinary> Binary;
 };
 
 class KernelFusion {
@@ -64,6 +76,18 @@ public:
               const std::vector<jit_compiler::ParameterInternalization>
                   &Internalization,
               const std::vector<jit_compiler::JITConstant> &JITConstants);
+
+  ///
+  /// Specialize a single kernel on the values of some of its scalar arguments.
+  /// The constants are propagated into the kernel by the same machinery used
+  /// for fused kernels, so the specialized kernel is cached like a fusion of
+  /// only this kernel. Arguments replaced by constants are marked as unused in
+  /// the specialized kernel's argument usage mask.
+  static FusionResult
+  specializeKernel(JITContext &JITCtx, Config &&JITConfig,
+                   const SYCLKernelInfo &KernelInformation,
+                   const std::string &SpecializedKernelName,
+                   const std::vector<jit_compiler::JITConstant> &JITConstants);
 };
 
 } // namespace jit_compiler
@@ -11,12 +11,22 @@
 
 #include "Kernel.h"
 
+#include <cstddef>
 #include <memory>
+#include <string>
 #include <unordered_map>
 
 namespace jit_compiler {
 
-enum OptionID { VerboseOutput, EnableCaching, TargetFormat };
+enum OptionID {
+  VerboseOutput,
+  EnableCaching,
+  TargetFormat,
+  PersistentCacheDir,
+  PersistentCachePolicy,
+  CacheLookupOnly,
+  CacheMaxSize
+};
 
 class OptionPtrBase {};
 
@@ -83,6 +93,32 @@ struct JITEnableCaching : public OptionBase<OptionID::EnableCaching, bool> {};
 struct JITTargetFormat
     : public OptionBase<OptionID::TargetFormat, BinaryFormat> {};
 
+///
+/// Directory used to persist fused kernels across processes. An empty string
+/// disables the persistent cache.
+struct JITPersistentCacheDir
+    : public OptionBase<OptionID::PersistentCacheDir, std::string> {};
+
+///
+/// Pruning policy for the persistent cache in the syntax accepted by
+/// llvm::parseCachePruningPolicy. An empty string disables eviction.
+struct JITPersistentCachePolicy
+    : public OptionBase<OptionID::PersistentCachePolicy, std::string> {};
+
+///
+/// Only consult the caches and fail instead of compiling a new fused kernel if
+/// no cached kernel is available. Such invocations do not use the LLVM context
+/// of the JIT context, so they can run concurrently with a compilation.
+struct JITCacheLookupOnly
+    : public OptionBase<OptionID::CacheLookupOnly, bool> {};
+
+///
+/// Maximum accumulated size in bytes of the binaries held by the in-memory
+/// cache. Least-recently used entries are evicted beyond that. Zero disables
+/// eviction.
+struct JITCacheMaxSize
+    : public OptionBase<OptionID::CacheMaxSize, std::size_t> {};
+
 } // namespace option
 } // namespace jit_compiler
 
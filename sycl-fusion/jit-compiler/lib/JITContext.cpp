@@ -23,23 +23,104 @@ size_t KernelBinary::size() const { return Blob.size(); }
 
 BinaryFormat KernelBinary::format() const { return Format; }
 
-JITContext::JITContext() : LLVMCtx{new llvm::LLVMContext}, Binaries{} {}
+JITContext::CacheEntry::CacheEntry(const SYCLKernelInfo &Info,
+                                   std::shared_ptr<KernelBinary> Binary)
+    : Info{Info}, Binary{std::move(Binary)}, LRUPosition{} {}
+
+JITContext::JITContext()
+    : LLVMCtx{new llvm::LLVMContext}, Binaries{}, Cache{} {}
 
 JITContext::~JITContext() = default;
 
 llvm::LLVMContext *JITContext::getLLVMContext() { return LLVMCtx.get(); }
 
+std::shared_ptr<KernelBinary>
+JITContext::getKernelBinary(BinaryAddress Address) const {
+  ReadLockT ReadLock{BinariesMutex};
+  auto Binary = Binaries.find(Address);
+  if (Binary != Binaries.end()) {
+    return Binary->second;
+  }
+  return nullptr;
+}
+
+std::shared_ptr<KernelBinary>
+JITContext::releaseKernelBinary(BinaryAddress Address) {
+  WriteLockT WriteLock{BinariesMutex};
+  auto Binary = Binaries.find(Address);
+  if (Binary == Binaries.end()) {
+    return nullptr;
+  }
+  auto Released = std::move(Binary->second);
+  Binaries.erase(Binary);
+  return Released;
+}
+
 std::optional<SYCLKernelInfo>
 JITContext::getCacheEntry(CacheKeyT &Identifier) const {
   ReadLockT ReadLock{CacheMutex};
   auto Entry = Cache.find(Identifier);
-  if (Entry != Cache.end()) {
-    return Entry->second;
+  if (Entry == Cache.end()) {
+    CacheMisses.fetch_add(1, std::memory_order_relaxed);
+    return {};
   }
-  return {};
+  CacheHits.fetch_add(1, std::memory_order_relaxed);
+  {
+    std::lock_guard<std::mutex> LRULock{LRUMutex};
+    LRUList.splice(LRUList.begin(), LRUList, Entry->second.LRUPosition);
+  }
+  return Entry->second.Info;
 }
 
-void JITContext::addCacheEntry(CacheKeyT &Identifier, SYCLKernelInfo &Kernel) {
-  WriteLockT WriteLock{CacheMutex};
-  Cache.emplace(Identifier, Kernel);
+void JITContext::addCacheEntry(CacheKeyT &Identifier, SYCLKernelInfo &Kernel,
+                               size_t MaxCacheSize) {
+  // Cache entries share the ownership of their binary with the context, so
+  // evicting an entry frees the binary once the context releases it as well.
+  std::shared_ptr<KernelBinary> Binary =
+      getKernelBinary(Kernel.BinaryInfo.BinaryStart);
+
+  // Binaries evicted from the cache, released after dropping the lock.
+  std::vector<BinaryAddress> Released;
+  {
+    WriteLockT WriteLock{CacheMutex};
+    auto [NewEntry, Inserted] = Cache.try_emplace(Identifier, Kernel, Binary);
+    if (!Inserted) {
+      // Another thread compiled the same fusion concurrently. Keep the cached
+      // kernel, which callers might already use.
+      if (Binary && NewEntry->second.Binary != Binary) {
+        Released.push_back(Binary->address());
+      }
+    } else {
+      // Lookups only modify the list under the read lock, so holding the
+      // write lock is sufficient here.
+      NewEntry->second.LRUPosition =
+          LRUList.insert(LRUList.begin(), &NewEntry->first);
+      CacheSize += Kernel.BinaryInfo.BinarySize;
+      // Evict the least-recently used entries, but never the new one.
+      while (MaxCacheSize && CacheSize > MaxCacheSize && LRUList.size() > 1) {
+        auto Victim = Cache.find(*LRUList.back());
+        LRUList.pop_back();
+        CacheSize -= Victim->second.Info.BinaryInfo.BinarySize;
+        if (Victim->second.Binary) {
+          Released.push_back(Victim->second.Binary->address());
+        }
+        Cache.erase(Victim);
+        CacheEvictions.fetch_add(1, std::memory_order_relaxed);
+      }
+    }
+  }
+  for (BinaryAddress Address : Released) {
+    releaseKernelBinary(Address);
+  }
+}
+
+CacheStatistics JITContext::getCacheStatistics() const {
+  CacheStatistics Stats;
+  Stats.Hits = CacheHits.load(std::memory_order_relaxed);
+  Stats.Misses = CacheMisses.load(std::memory_order_relaxed);
+  Stats.Evictions = CacheEvictions.load(std::memory_order_relaxed);
+  ReadLockT ReadLock{CacheMutex};
+  Stats.NumEntries = Cache.size();
+  Stats.SizeInBytes = CacheSize;
+  return Stats;
 }
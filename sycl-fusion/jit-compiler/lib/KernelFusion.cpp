@@ -11,6 +11,7 @@
 #include "KernelIO.h"
 #include "NDRangesHelper.h"
 #include "Options.h"
+#include "cache/PersistentCache.h"
 #include "fusion/FusionHelper.h"
 #include "fusion/FusionPipeline.h"
 #include "helper/ConfigHelper.h"
@@ -18,6 +19,7 @@
 #include "translation/KernelTranslation.h"
 #include "translation/SPIRVLLVMTranslation.h"
 #include <llvm/Support/Error.h>
+#include <chrono>
 #include <sstream>
 
 using namespace jit_compiler;
@@ -68,7 +70,7 @@ FusionResult KernelFusion::fuseKernels(
     JITContext &JITCtx, Config &&JITConfig,
     const std::vector<SYCLKernelInfo> &KernelInformation,
     const std::vector<std::string> &KernelsToFuse,
-    const std::string &FusedKernelName, ParamIdentList &Identities,
+    const std::string &FusedKernelNameHint, ParamIdentList &Identities,
     int BarriersFlags,
     const std::vector<jit_compiler::ParameterInternalization> &Internalization,
     const std::vector<jit_compiler::JITConstant> &Constants) {
@@ -93,17 +95,13 @@ FusionResult KernelFusion::fuseKernels(
         "Fusion output target format not supported by this build");
   }
 
-  if (TargetFormat == BinaryFormat::PTX && IsHeterogeneousList) {
-    return FusionResult{"Heterogeneous ND ranges not supported for CUDA"};
-  }
-
   bool CachingEnabled = ConfigHelper::get<option::JITEnableCaching>();
   CacheKeyT CacheKey{KernelsToFuse,
                      Identities,
                      BarriersFlags,
                      Internalization,
                      Constants,
-                     jit_compiler::isHeterogeneousList(NDRanges)
+                     IsHeterogeneousList
                          ? std::optional<std::vector<NDRange>>{NDRanges}
                          : std::optional<std::vector<NDRange>>{std::nullopt}};
   if (CachingEnabled) {
@@ -116,6 +114,43 @@ FusionResult KernelFusion::fuseKernels(
         "Compiling new kernel, no suitable cached kernel found");
   }
 
+  // The persistent cache is a second level behind the in-memory cache.
+  std::string PersistentCacheDir =
+      CachingEnabled ? ConfigHelper::get<option::JITPersistentCacheDir>()
+                     : std::string{};
+  std::string PersistentKey;
+  std::string FusedKernelName = FusedKernelNameHint;
+  bool LookupOnly = ConfigHelper::get<option::JITCacheLookupOnly>();
+  if (CachingEnabled && (!PersistentCacheDir.empty() || !LookupOnly)) {
+    PersistentKey = cache::PersistentCache::computeKey(CacheKey, TargetFormat,
+                                                       KernelInformation);
+    // Derive the name from the key, so that a kernel loaded from the persistent
+    // cache or compiled again after its eviction from the in-memory cache gets
+    // the same name, and the runtime can reuse its registration. This also
+    // avoids clashes with the names handed out by the runtime in this process.
+    FusedKernelName = "fused_" + PersistentKey;
+  }
+  if (!PersistentCacheDir.empty()) {
+    std::optional<SYCLKernelInfo> PersistedKernel =
+        cache::PersistentCache::lookup(PersistentCacheDir, PersistentKey,
+                                       JITCtx);
+    if (PersistedKernel) {
+      helper::printDebugMessage("Re-using JIT kernel from persistent cache");
+      PersistedKernel->NDR = combineNDRanges(NDRanges);
+      auto Binary =
+          JITCtx.getKernelBinary(PersistedKernel->BinaryInfo.BinaryStart);
+      JITCtx.addCacheEntry(CacheKey, *PersistedKernel,
+                           ConfigHelper::get<option::JITCacheMaxSize>());
+      // The binary is new to this process, so report it as a new kernel.
+      return FusionResult{*PersistedKernel, /*Cached*/ false,
+                          std::move(Binary)};
+    }
+  }
+
+  if (LookupOnly) {
+    return FusionResult{"No cached kernel available"};
+  }
+
   SYCLModuleInfo ModuleInfo;
   // Copy the kernel information for the input kernels to the module
   // information. We could remove the copy, if we removed the const from the
@@ -124,14 +159,23 @@ FusionResult KernelFusion::fuseKernels(
   ModuleInfo.kernels().insert(ModuleInfo.kernels().end(),
                               KernelInformation.begin(),
                               KernelInformation.end());
-  // Load all input kernels from their respective SPIR-V modules into a single
-  // LLVM IR module.
+  // Load all input kernels from their respective SPIR-V or LLVM bitcode
+  // modules into a single LLVM IR module.
+  auto LoadStart = std::chrono::steady_clock::now();
   llvm::Expected<std::unique_ptr<llvm::Module>> ModOrError =
       translation::KernelTranslator::loadKernels(*JITCtx.getLLVMContext(),
                                                  ModuleInfo.kernels());
   if (auto Error = ModOrError.takeError()) {
     return errorToFusionResult(std::move(Error), "SPIR-V translation failed");
   }
+  // Report the loading time, as it depends heavily on the input format. This
+  // allows comparing input images with and without embedded LLVM bitcode.
+  helper::printDebugMessage(
+      "Loading input kernels took " +
+      std::to_string(std::chrono::duration_cast<std::chrono::microseconds>(
+                         std::chrono::steady_clock::now() - LoadStart)
+                         .count()) +
+      "us");
   std::unique_ptr<llvm::Module> LLVMMod = std::move(*ModOrError);
 
   // Add information about the kernel that should be fused as metadata into the
@@ -174,9 +218,44 @@ FusionResult KernelFusion::fuseKernels(
 
   FusedKernelInfo.NDR = FusedKernel.FusedNDRange;
 
+  // Without caching, nothing refers to the binary after the caller has
+  // consumed the result, so hand its ownership to the result.
+  std::shared_ptr<const KernelBinary> Binary =
+      CachingEnabled
+          ? JITCtx.getKernelBinary(FusedKernelInfo.BinaryInfo.BinaryStart)
+          : JITCtx.releaseKernelBinary(FusedKernelInfo.BinaryInfo.BinaryStart);
   if (CachingEnabled) {
-    JITCtx.addCacheEntry(CacheKey, FusedKernelInfo);
+    JITCtx.addCacheEntry(CacheKey, FusedKernelInfo,
+                         ConfigHelper::get<option::JITCacheMaxSize>());
   }
 
-  return FusionResult{FusedKernelInfo};
+  if (!PersistentCacheDir.empty()) {
+    if (auto Err = cache::PersistentCache::store(
+            PersistentCacheDir, PersistentKey, FusedKernelInfo)) {
+      helper::printDebugMessage("Failed to store kernel in persistent cache: " +
+                                llvm::toString(std::move(Err)));
+    }
+    if (auto Err = cache::PersistentCache::prune(
+            PersistentCacheDir,
+            ConfigHelper::get<option::JITPersistentCachePolicy>())) {
+      helper::printDebugMessage("Failed to prune persistent cache: " +
+                                llvm::toString(std::move(Err)));
+    }
+  }
+
+  return FusionResult{FusedKernelInfo, /*Cached*/ false, std::move(Binary)};
+}
+
+FusionResult KernelFusion::specializeKernel(
+    JITContext &JITCtx, Config &&JITConfig,
+    const SYCLKernelInfo &KernelInformation,
+    const std::string &SpecializedKernelName,
+    const std::vector<jit_compiler::JITConstant> &Constants) {
+  // A specialization is a fusion of a single kernel without barriers,
+  // identities or internalization.
+  ParamIdentList NoIdentities;
+  return fuseKernels(JITCtx, std::move(JITConfig), {KernelInformation},
+                     {KernelInformation.Name}, SpecializedKernelName,
+                     NoIdentities, /*BarriersFlags*/ -1,
+                     /*Internalization*/ {}, Constants);
 }
@@ -0,0 +1,260 @@
+//==------------------------- PersistentCache.cpp --------------------------==//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#include "PersistentCache.h"
+
+#include "KernelIO.h"
+#include "llvm/ADT/DenseSet.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/Config/llvm-config.h"
+#include "llvm/Support/CachePruning.h"
+#include "llvm/Support/Endian.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/SHA1.h"
+#include "llvm/Support/raw_ostream.h"
+
+using namespace jit_compiler;
+using namespace jit_compiler::cache;
+using namespace llvm;
+
+// Bump this whenever the layout of the cache files or the hashed key
+// components change.
+static constexpr char CacheMagic[] = "SYCLFUSIONCACHE1";
+static constexpr size_t CacheMagicSize = sizeof(CacheMagic) - 1;
+
+namespace {
+///
+/// Helper feeding the components of a fusion cache key into a SHA1 hasher in
+/// an unambiguous, platform-independent encoding.
+class KeyHasher {
+public:
+  void add(uint64_t Value) {
+    uint8_t Bytes[sizeof(uint64_t)];
+    support::endian::write64le(Bytes, Value);
+    Hasher.update(ArrayRef<uint8_t>{Bytes, sizeof(Bytes)});
+  }
+
+  void add(StringRef Str) {
+    add(static_cast<uint64_t>(Str.size()));
+    Hasher.update(Str);
+  }
+
+  void add(const Parameter &P) {
+    add(static_cast<uint64_t>(P.KernelIdx));
+    add(static_cast<uint64_t>(P.ParamIdx));
+  }
+
+  void add(const Indices &I) {
+    for (auto Idx : I) {
+      add(static_cast<uint64_t>(Idx));
+    }
+  }
+
+  void add(const NDRange &ND) {
+    add(static_cast<uint64_t>(ND.getDimensions()));
+    add(ND.getGlobalSize());
+    add(ND.getLocalSize());
+    add(ND.getOffset());
+  }
+
+  std::string result() { return toHex(Hasher.final(), /*LowerCase*/ true); }
+
+private:
+  SHA1 Hasher;
+};
+} // namespace
+
+std::string PersistentCache::computeKey(const CacheKeyT &Key,
+                                        BinaryFormat TargetFormat,
+                                        ArrayRef<SYCLKernelInfo> Kernels) {
+  KeyHasher Hasher;
+  Hasher.add(StringRef{CacheMagic, CacheMagicSize});
+  // Results of different compiler versions must not be mixed.
+  Hasher.add(StringRef{LLVM_VERSION_STRING});
+  Hasher.add(static_cast<uint64_t>(TargetFormat));
+
+  const auto &[Names, Identities, BarriersFlags, Internalization, Constants,
+               NDRanges] = Key;
+  Hasher.add(static_cast<uint64_t>(Names.size()));
+  for (const auto &Name : Names) {
+    Hasher.add(Name);
+  }
+  Hasher.add(static_cast<uint64_t>(Identities.size()));
+  for (const auto &Ident : Identities) {
+    Hasher.add(Ident.LHS);
+    Hasher.add(Ident.RHS);
+  }
+  Hasher.add(static_cast<uint64_t>(BarriersFlags));
+  Hasher.add(static_cast<uint64_t>(Internalization.size()));
+  for (const auto &Intern : Internalization) {
+    Hasher.add(Intern.Param);
+    Hasher.add(static_cast<uint64_t>(Intern.Intern));
+    Hasher.add(static_cast<uint64_t>(Intern.LocalSize));
+  }
+  Hasher.add(static_cast<uint64_t>(Constants.size()));
+  for (const auto &Const : Constants) {
+    Hasher.add(Const.Param);
+    Hasher.add(Const.Value);
+  }
+  Hasher.add(static_cast<uint64_t>(NDRanges.has_value()));
+  if (NDRanges) {
+    Hasher.add(static_cast<uint64_t>(NDRanges->size()));
+    for (const auto &ND : *NDRanges) {
+      Hasher.add(ND);
+    }
+  }
+
+  // The argument information influences the fused kernel's signature and the
+  // binary contents determine the kernels' code. Multiple kernels can share the
+  // same binary, so only hash each binary once.
+  DenseSet<std::pair<BinaryAddress, uint64_t>> HashedBinaries;
+  Hasher.add(static_cast<uint64_t>(Kernels.size()));
+  for (const auto &Kernel : Kernels) {
+    Hasher.add(Kernel.Name);
+    Hasher.add(static_cast<uint64_t>(Kernel.Args.Kinds.size()));
+    for (auto Kind : Kernel.Args.Kinds) {
+      Hasher.add(static_cast<uint64_t>(Kind));
+    }
+    Hasher.add(static_cast<uint64_t>(Kernel.Args.UsageMask.size()));
+    for (auto Usage : Kernel.Args.UsageMask) {
+      Hasher.add(static_cast<uint64_t>(Usage));
+    }
+    const auto &BinInfo = Kernel.BinaryInfo;
+    Hasher.add(static_cast<uint64_t>(BinInfo.Format));
+    if (HashedBinaries.insert({BinInfo.BinaryStart, BinInfo.BinarySize})
+            .second) {
+      Hasher.add(
+          StringRef{reinterpret_cast<const char *>(BinInfo.BinaryStart),
+                    static_cast<size_t>(BinInfo.BinarySize)});
+    } else {
+      Hasher.add(StringRef{});
+    }
+  }
+  return Hasher.result();
+}
+
+static SmallString<128> getEntryPath(StringRef CacheDir, StringRef Key) {
+  // This choice of file name allows the cache to be pruned (see pruneCache()
+  // in include/llvm/Support/CachePruning.h).
+  SmallString<128> EntryPath;
+  sys::path::append(EntryPath, CacheDir, "llvmcache-" + Key);
+  return EntryPath;
+}
+
+std::optional<SYCLKernelInfo> PersistentCache::lookup(StringRef CacheDir,
+                                                      StringRef Key,
+                                                      JITContext &JITCtx) {
+  SmallString<128> EntryPath = getEntryPath(CacheDir, Key);
+  // Update the access time on hits, so that eviction is least-recently-used.
+  Expected<sys::fs::file_t> FDOrErr =
+      sys::fs::openNativeFileForRead(EntryPath, sys::fs::OF_UpdateAtime);
+  if (!FDOrErr) {
+    consumeError(FDOrErr.takeError());
+    return {};
+  }
+  ErrorOr<std::unique_ptr<MemoryBuffer>> MBOrErr =
+      MemoryBuffer::getOpenFile(*FDOrErr, EntryPath, /*FileSize=*/-1,
+                                /*RequiresNullTerminator=*/false);
+  sys::fs::closeFile(*FDOrErr);
+  if (!MBOrErr) {
+    return {};
+  }
+
+  // Layout: magic, 64-bit little-endian size of the YAML kernel info, kernel
+  // info, fused kernel binary.
+  StringRef Contents = (*MBOrErr)->getBuffer();
+  if (Contents.size() < CacheMagicSize + sizeof(uint64_t) ||
+      !Contents.startswith(StringRef{CacheMagic, CacheMagicSize})) {
+    return {};
+  }
+  Contents = Contents.drop_front(CacheMagicSize);
+  uint64_t InfoSize = support::endian::read64le(Contents.data());
+  Contents = Contents.drop_front(sizeof(uint64_t));
+  if (Contents.size() < InfoSize) {
+    return {};
+  }
+
+  SYCLKernelInfo Info;
+  yaml::Input YamlIn{Contents.take_front(InfoSize)};
+  YamlIn >> Info;
+  if (YamlIn.error()) {
+    return {};
+  }
+  StringRef Binary = Contents.drop_front(InfoSize);
+  if (Binary.size() != Info.BinaryInfo.BinarySize) {
+    return {};
+  }
+
+  KernelBinary &KernelBin =
+      JITCtx.emplaceKernelBinary(Binary.str(), Info.BinaryInfo.Format);
+  Info.BinaryInfo.BinaryStart = KernelBin.address();
+  Info.BinaryInfo.BinarySize = KernelBin.size();
+  return Info;
+}
+
+Error PersistentCache::store(StringRef CacheDir, StringRef Key,
+                             const SYCLKernelInfo &Kernel) {
+  if (auto EC = sys::fs::create_directories(CacheDir)) {
+    return createStringError(EC, "Failed to create cache directory %s",
+                             CacheDir.str().c_str());
+  }
+
+  std::string SerializedInfo;
+  {
+    raw_string_ostream InfoStream{SerializedInfo};
+    yaml::Output YamlOut{InfoStream};
+    // The YAML I/O interface requires a mutable reference.
+    SYCLKernelInfo InfoCopy{Kernel};
+    YamlOut << InfoCopy;
+  }
+
+  // Write to a temporary file and atomically rename it afterwards, so other
+  // processes never read incomplete entries.
+  SmallString<128> TempModel;
+  sys::path::append(TempModel, CacheDir, "Fusion-%%%%%%.tmp");
+  Expected<sys::fs::TempFile> TempOrErr = sys::fs::TempFile::create(TempModel);
+  if (!TempOrErr) {
+    return TempOrErr.takeError();
+  }
+  sys::fs::TempFile &Temp = *TempOrErr;
+  {
+    raw_fd_ostream OS{Temp.FD, /*shouldClose*/ false};
+    OS.write(CacheMagic, CacheMagicSize);
+    uint8_t SizeBytes[sizeof(uint64_t)];
+    support::endian::write64le(SizeBytes, SerializedInfo.size());
+    OS.write(reinterpret_cast<const char *>(SizeBytes), sizeof(SizeBytes));
+    OS << SerializedInfo;
+    OS.write(reinterpret_cast<const char *>(Kernel.BinaryInfo.BinaryStart),
+             Kernel.BinaryInfo.BinarySize);
+    OS.flush();
+    if (OS.has_error()) {
+      std::error_code EC = OS.error();
+      OS.clear_error();
+      consumeError(Temp.discard());
+      return createStringError(EC, "Failed to write cache entry");
+    }
+  }
+  // Another process might have stored the same entry concurrently. As entries
+  // for the same key are identical, it does not matter which one wins.
+  return Temp.keep(getEntryPath(CacheDir, Key));
+}
+
+Error PersistentCache::prune(StringRef CacheDir, StringRef PolicyStr) {
+  if (PolicyStr.empty()) {
+    return Error::success();
+  }
+  Expected<CachePruningPolicy> PolicyOrErr = parseCachePruningPolicy(PolicyStr);
+  if (!PolicyOrErr) {
+    return PolicyOrErr.takeError();
+  }
+  pruneCache(CacheDir, *PolicyOrErr);
+  return Error::success();
+}
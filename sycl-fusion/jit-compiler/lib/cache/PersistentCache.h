@@ -0,0 +1,60 @@
+//==-------- PersistentCache.h - On-disk cache for fused JIT kernels -------==//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef SYCL_FUSION_JIT_COMPILER_CACHE_PERSISTENTCACHE_H
+#define SYCL_FUSION_JIT_COMPILER_CACHE_PERSISTENTCACHE_H
+
+#include "JITContext.h"
+#include "Kernel.h"
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/Error.h"
+
+#include <optional>
+#include <string>
+
+namespace jit_compiler {
+namespace cache {
+
+///
+/// Cache for fused kernels that persists across processes.
+///
+/// Each entry is stored in a single file named "llvmcache-<key>" in the cache
+/// directory, so that the directory can be managed by llvm::pruneCache. The
+/// file contains the YAML-serialized SYCLKernelInfo of the fused kernel
+/// followed by the fused kernel binary. Entries are written to a temporary file
+/// first and atomically renamed, so concurrent processes never observe partial
+/// entries. All file system errors are treated as cache misses.
+class PersistentCache {
+public:
+  ///
+  /// Compute the key of a fusion from the in-memory cache key, the output
+  /// format and the input kernels, including the contents of their binaries.
+  static std::string computeKey(const CacheKeyT &Key, BinaryFormat TargetFormat,
+                                llvm::ArrayRef<SYCLKernelInfo> Kernels);
+
+  ///
+  /// Load the entry for Key from CacheDir. The binary is stored in the
+  /// JITContext and the returned kernel information refers to it.
+  static std::optional<SYCLKernelInfo>
+  lookup(llvm::StringRef CacheDir, llvm::StringRef Key, JITContext &JITCtx);
+
+  ///
+  /// Store the fused kernel described by Kernel under Key in CacheDir.
+  static llvm::Error store(llvm::StringRef CacheDir, llvm::StringRef Key,
+                           const SYCLKernelInfo &Kernel);
+
+  ///
+  /// Evict entries from CacheDir according to the pruning policy PolicyStr.
+  static llvm::Error prune(llvm::StringRef CacheDir, llvm::StringRef PolicyStr);
+};
+
+} // namespace cache
+} // namespace jit_compiler
+
+#endif // SYCL_FUSION_JIT_COMPILER_CACHE_PERSISTENTCACHE_H
@@ -8,6 +8,7 @@
 
 #include "FusionPipeline.h"
 
+#include "barriers/BarrierElimination.h"
 #include "debug/PassDebug.h"
 #include "helper/ConfigHelper.h"
 #include "internalization/Internalization.h"
@@ -110,6 +111,10 @@ FusionPipeline::runFusionPasses(Module &Mod, SYCLModuleInfo &InputInfo,
   // Run dataflow internalization and runtime constant propagation.
   MPM.addPass(SYCLInternalizer{});
   MPM.addPass(SYCLCP{});
+  // Remove or narrow barriers between the fused kernels that do not order any
+  // accesses to memory shared between work-items. This profits from accesses
+  // turned private by internalization and from constant strides.
+  MPM.addPass(SYCLBarrierElimination{});
   // Run additional optimization passes after completing fusion.
   {
     FunctionPassManager FPM;
@@ -117,6 +122,10 @@ FusionPipeline::runFusionPasses(Module &Mod, SYCLModuleInfo &InputInfo,
     FPM.addPass(SCCPPass{});
     FPM.addPass(InstCombinePass{});
     FPM.addPass(SimplifyCFGPass{});
+    // Loops bounded by propagated scalar arguments, e.g., in specialized
+    // kernels, now have constant trip counts and can be unrolled.
+    FPM.addPass(createFunctionToLoopPassAdaptor(IndVarSimplifyPass{}));
+    FPM.addPass(LoopUnrollPass{LoopUnrollOptions{}});
     FPM.addPass(SROAPass{SROAOptions::ModifyCFG});
     FPM.addPass(InstCombinePass{});
     FPM.addPass(SimplifyCFGPass{});
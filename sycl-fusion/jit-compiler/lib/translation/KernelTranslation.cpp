@@ -9,15 +9,20 @@
 #include "KernelTranslation.h"
 
 #include "SPIRVLLVMTranslation.h"
+#include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/Bitcode/BitcodeReader.h"
 #include "llvm/IR/Constants.h"
+#include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/InstIterator.h"
 #include "llvm/IR/LegacyPassManager.h"
+#include "llvm/IR/ReplaceConstant.h"
 #include "llvm/Linker/Linker.h"
 #include "llvm/MC/TargetRegistry.h"
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/TargetSelect.h"
 #include "llvm/Target/TargetMachine.h"
 #include "llvm/Target/TargetOptions.h"
+#include "llvm/TargetParser/Triple.h"
 
 using namespace jit_compiler;
 using namespace jit_compiler::translation;
@@ -66,6 +71,17 @@ KernelTranslator::loadKernels(llvm::LLVMContext &LLVMCtx,
   std::unique_ptr<Module> Result{nullptr};
   bool First = true;
   DenseSet<BinaryBlob> ParsedBinaries;
+  // Names of the kernels stored in each LLVM bitcode module. Only these
+  // kernels and the functions they transitively reference need to be
+  // materialized from a lazily loaded bitcode module.
+  DenseMap<BinaryBlob, SmallVector<StringRef>> KernelsPerBinary;
+  for (const auto &Kernel : Kernels) {
+    const SYCLKernelBinaryInfo &BinInfo = Kernel.BinaryInfo;
+    if (BinInfo.Format == BinaryFormat::LLVM) {
+      KernelsPerBinary[{BinInfo.BinaryStart, BinInfo.BinarySize}].push_back(
+          Kernel.Name);
+    }
+  }
   size_t AddressBits = 0;
   for (auto &Kernel : Kernels) {
     // FIXME: Currently, we use the front of the list.
@@ -88,7 +104,8 @@ KernelTranslator::loadKernels(llvm::LLVMContext &LLVMCtx,
 
       switch (BinInfo.Format) {
       case BinaryFormat::LLVM: {
-        auto ModOrError = loadLLVMKernel(LLVMCtx, Kernel);
+        auto ModOrError =
+            loadLLVMKernel(LLVMCtx, Kernel, KernelsPerBinary[BinBlob]);
         if (auto Err = ModOrError.takeError()) {
           return std::move(Err);
         }
@@ -147,17 +164,248 @@ KernelTranslator::loadKernels(llvm::LLVMContext &LLVMCtx,
   return std::move(Result);
 }
 
+///
+/// Collect the functions referenced by the constant C, looking through
+/// constant expressions, aggregates and global variable initializers.
+static void collectReferencedFunctions(const Constant *C,
+                                       SmallPtrSetImpl<const Value *> &Visited,
+                                       SmallVectorImpl<Function *> &Worklist) {
+  if (!Visited.insert(C).second) {
+    return;
+  }
+  if (auto *F = dyn_cast<Function>(C)) {
+    Worklist.push_back(const_cast<Function *>(F));
+    return;
+  }
+  if (auto *GV = dyn_cast<GlobalVariable>(C)) {
+    if (GV->hasInitializer()) {
+      collectReferencedFunctions(GV->getInitializer(), Visited, Worklist);
+    }
+    return;
+  }
+  if (auto *GA = dyn_cast<GlobalAlias>(C)) {
+    collectReferencedFunctions(GA->getAliasee(), Visited, Worklist);
+    return;
+  }
+  for (const auto &Op : C->operands()) {
+    if (auto *OpC = dyn_cast<Constant>(Op)) {
+      collectReferencedFunctions(OpC, Visited, Worklist);
+    }
+  }
+}
+
+///
+/// Materialize the bodies of the functions in the lazily loaded module Mod
+/// that are transitively reachable from the kernels named in Roots or from
+/// the initializers of non-intrinsic global variables. The bodies of all other
+/// functions are never read from the bitcode and the unused declarations are
+/// removed.
+static llvm::Error materializeReachable(Module &Mod,
+                                        ArrayRef<StringRef> Roots) {
+  SmallPtrSet<const Value *, 32> Visited;
+  SmallVector<Function *> Worklist;
+  for (auto Name : Roots) {
+    if (auto *F = Mod.getFunction(Name)) {
+      collectReferencedFunctions(F, Visited, Worklist);
+    }
+  }
+  for (const auto &GV : Mod.globals()) {
+    // Intrinsic globals such as llvm.used can reference all functions in the
+    // module and would defeat lazy loading.
+    if (!GV.getName().startswith("llvm.")) {
+      collectReferencedFunctions(&GV, Visited, Worklist);
+    }
+  }
+  while (!Worklist.empty()) {
+    Function *F = Worklist.pop_back_val();
+    if (auto Err = F->materialize()) {
+      return Err;
+    }
+    for (const auto &I : instructions(F)) {
+      for (const auto &Op : I.operands()) {
+        if (auto *C = dyn_cast<Constant>(Op)) {
+          collectReferencedFunctions(C, Visited, Worklist);
+        }
+      }
+    }
+  }
+
+  SmallVector<Function *> Unreachable;
+  for (auto &F : Mod) {
+    if (F.isMaterializable()) {
+      // Dropping the body also marks the function as not materializable, so
+      // materializeAll() below will not read it.
+      F.deleteBody();
+      Unreachable.push_back(&F);
+    }
+  }
+  // Finish loading, e.g., module-level metadata and auto-upgrades.
+  if (auto Err = Mod.materializeAll()) {
+    return Err;
+  }
+  for (auto *F : Unreachable) {
+    if (F->use_empty()) {
+      F->eraseFromParent();
+    }
+  }
+  return Error::success();
+}
+
+static llvm::Error unsupportedBuiltinUse(const GlobalVariable &GV) {
+  return createStringError(inconvertibleErrorCode(),
+                           "Unsupported use of SPIR-V builtin variable %s",
+                           GV.getName().str().c_str());
+}
+
+///
+/// Replace the loads from the SPIR-V builtin variable GV, e.g.,
+/// __spirv_BuiltInGlobalInvocationId, with calls to the corresponding builtin
+/// functions, e.g., __spirv_BuiltInGlobalInvocationId(int). This is the
+/// representation produced when translating SPIR-V to LLVM IR, which the
+/// fusion passes expect.
+static llvm::Error lowerBuiltinVariableToCalls(GlobalVariable &GV) {
+  Module &Mod = *GV.getParent();
+  const DataLayout &DL = Mod.getDataLayout();
+  auto *VecTy = dyn_cast<FixedVectorType>(GV.getValueType());
+  Type *ElemTy = VecTy ? VecTy->getElementType() : GV.getValueType();
+  if (!ElemTy->isIntegerTy()) {
+    return unsupportedBuiltinUse(GV);
+  }
+  const unsigned NumElems = VecTy ? VecTy->getNumElements() : 1;
+  const uint64_t ElemSize = DL.getTypeStoreSize(ElemTy);
+
+  // Vector builtins take the dimension as argument.
+  auto Name = GV.getName();
+  std::string MangledName = ("_Z" + Twine{Name.size()} + Name).str();
+  MangledName += VecTy ? "i" : "v";
+  auto *FTy = VecTy ? FunctionType::get(ElemTy, {Type::getInt32Ty(
+                                                     Mod.getContext())},
+                                        /*isVarArg*/ false)
+                    : FunctionType::get(ElemTy, /*isVarArg*/ false);
+  FunctionCallee Callee = Mod.getOrInsertFunction(MangledName, FTy);
+  if (auto *F = dyn_cast<Function>(Callee.getCallee())) {
+    F->setCallingConv(CallingConv::SPIR_FUNC);
+    F->setDoesNotAccessMemory();
+    F->setDoesNotThrow();
+  }
+
+  convertUsersOfConstantsToInstructions({&GV});
+  // Walk the uses of the variable, tracking the byte offset into the variable
+  // introduced by address computations.
+  SmallVector<std::pair<Value *, uint64_t>> Worklist{{&GV, 0}};
+  SmallVector<Instruction *> ToErase;
+  while (!Worklist.empty()) {
+    auto [Ptr, Offset] = Worklist.pop_back_val();
+    for (auto *U : Ptr->users()) {
+      auto *I = dyn_cast<Instruction>(U);
+      if (!I) {
+        return unsupportedBuiltinUse(GV);
+      }
+      if (isa<AddrSpaceCastInst, BitCastInst>(I)) {
+        Worklist.emplace_back(I, Offset);
+        ToErase.push_back(I);
+        continue;
+      }
+      if (auto *GEP = dyn_cast<GetElementPtrInst>(I)) {
+        APInt GEPOffset{DL.getIndexTypeSizeInBits(GEP->getType()), 0};
+        if (!GEP->accumulateConstantOffset(DL, GEPOffset)) {
+          return unsupportedBuiltinUse(GV);
+        }
+        Worklist.emplace_back(GEP, Offset + GEPOffset.getZExtValue());
+        ToErase.push_back(GEP);
+        continue;
+      }
+      auto *Load = dyn_cast<LoadInst>(I);
+      if (!Load || Offset % ElemSize != 0) {
+        return unsupportedBuiltinUse(GV);
+      }
+      IRBuilder<> Builder{Load};
+      const uint64_t FirstElem = Offset / ElemSize;
+      auto CreateCall = [&](uint64_t Elem) -> Value * {
+        if (Elem >= NumElems) {
+          // Clang loads three-element vectors as four-element vectors.
+          return PoisonValue::get(ElemTy);
+        }
+        auto *Call = VecTy
+                         ? Builder.CreateCall(Callee, {Builder.getInt32(Elem)})
+                         : Builder.CreateCall(Callee);
+        Call->setCallingConv(CallingConv::SPIR_FUNC);
+        return Call;
+      };
+      Value *Replacement = nullptr;
+      if (Load->getType() == ElemTy) {
+        Replacement = CreateCall(FirstElem);
+      } else if (auto *LoadTy = dyn_cast<FixedVectorType>(Load->getType());
+                 LoadTy && LoadTy->getElementType() == ElemTy) {
+        Replacement = PoisonValue::get(LoadTy);
+        for (unsigned Idx = 0; Idx < LoadTy->getNumElements(); ++Idx) {
+          Replacement = Builder.CreateInsertElement(
+              Replacement, CreateCall(FirstElem + Idx), Idx);
+        }
+      } else {
+        return unsupportedBuiltinUse(GV);
+      }
+      Load->replaceAllUsesWith(Replacement);
+      ToErase.push_back(Load);
+    }
+  }
+  // Users were recorded after the values they use, so erase in reverse order.
+  for (auto *I : llvm::reverse(ToErase)) {
+    I->eraseFromParent();
+  }
+  if (GV.use_empty()) {
+    GV.eraseFromParent();
+  }
+  return Error::success();
+}
+
+///
+/// Lower all SPIR-V builtin variables in Mod to calls, see
+/// lowerBuiltinVariableToCalls.
+static llvm::Error lowerBuiltinVariablesToCalls(Module &Mod) {
+  SmallVector<GlobalVariable *> BuiltinVars;
+  for (auto &GV : Mod.globals()) {
+    if (GV.isDeclaration() && GV.getName().startswith("__spirv_BuiltIn")) {
+      BuiltinVars.push_back(&GV);
+    }
+  }
+  for (auto *GV : BuiltinVars) {
+    if (auto Err = lowerBuiltinVariableToCalls(*GV)) {
+      return Err;
+    }
+  }
+  return Error::success();
+}
+
 llvm::Expected<std::unique_ptr<llvm::Module>>
 KernelTranslator::loadLLVMKernel(llvm::LLVMContext &LLVMCtx,
-                                 SYCLKernelInfo &Kernel) {
+                                 SYCLKernelInfo &Kernel,
+                                 llvm::ArrayRef<llvm::StringRef> KernelNames) {
   auto &BinInfo = Kernel.BinaryInfo;
   llvm::StringRef RawData(reinterpret_cast<const char *>(BinInfo.BinaryStart),
                           BinInfo.BinarySize);
-  return llvm::parseBitcodeFile(
-      MemoryBuffer::getMemBuffer(RawData, Kernel.Name,
-                                 /* RequiresNullTermnator*/ false)
-          ->getMemBufferRef(),
-      LLVMCtx);
+  // The input binary can contain many more kernels than the ones being fused,
+  // so only read the functions required by the fused kernels from the bitcode.
+  // The memory of the input binary outlives the module, so it can be
+  // referenced by the lazy loader directly.
+  auto ModOrError = llvm::getLazyBitcodeModule(
+      MemoryBufferRef{RawData, Kernel.Name}, LLVMCtx,
+      /*ShouldLazyLoadMetadata*/ true);
+  if (auto Err = ModOrError.takeError()) {
+    return std::move(Err);
+  }
+  std::unique_ptr<llvm::Module> Mod = std::move(*ModOrError);
+  if (auto Err = materializeReachable(*Mod, KernelNames)) {
+    return std::move(Err);
+  }
+  // In contrast to modules translated from SPIR-V, device code compiled for
+  // SPIR targets accesses the SPIR-V builtins through global variables.
+  if (Triple{Mod->getTargetTriple()}.isSPIR()) {
+    if (auto Err = lowerBuiltinVariablesToCalls(*Mod)) {
+      return std::move(Err);
+    }
+  }
+  return std::move(Mod);
 }
 
 llvm::Expected<std::unique_ptr<llvm::Module>>
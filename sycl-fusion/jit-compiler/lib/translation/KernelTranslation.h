@@ -10,6 +10,8 @@
 
 #include "JITContext.h"
 #include "Kernel.h"
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/StringRef.h"
 #include "llvm/IR/LLVMContext.h"
 #include "llvm/IR/Module.h"
 #include "llvm/Support/Error.h"
@@ -32,8 +34,12 @@ private:
   /// Pair of address and size to represent a binary blob.
   using BinaryBlob = std::pair<BinaryAddress, size_t>;
 
+  ///
+  /// Lazily load the LLVM bitcode module of Kernel, materializing only the
+  /// code reachable from the kernels named in KernelNames.
   static llvm::Expected<std::unique_ptr<llvm::Module>>
-  loadLLVMKernel(llvm::LLVMContext &LLVMCtx, SYCLKernelInfo &Kernel);
+  loadLLVMKernel(llvm::LLVMContext &LLVMCtx, SYCLKernelInfo &Kernel,
+                 llvm::ArrayRef<llvm::StringRef> KernelNames);
 
   static llvm::Expected<std::unique_ptr<llvm::Module>>
   loadSPIRVKernel(llvm::LLVMContext &LLVMCtx, SYCLKernelInfo &Kernel);
@@ -61,17 +61,17 @@ SPIRVLLVMTranslator::loadSPIRVKernel(llvm::LLVMContext &LLVMCtx,
   assert(BinInfo.Format == BinaryFormat::SPIRV &&
          "Only SPIR-V supported as input");
 
-  // Create an input stream for the SPIR-V binary.
-  std::stringstream SPIRStream(
-      std::string(reinterpret_cast<const char *>(BinInfo.BinaryStart),
-                  BinInfo.BinarySize),
-      std::ios_base::in | std::ios_base::binary);
+  // The SPIR-V binary is decoded in place, without copying it.
+  MemoryBufferRef SPIRVBuffer{
+      StringRef{reinterpret_cast<const char *>(BinInfo.BinaryStart),
+                BinInfo.BinarySize},
+      Kernel.Name};
   std::string ErrMsg;
   // Create a raw pointer. readSpirv accepts a reference to a pointer,
   // so it will reset the pointer to point to an actual LLVM module.
   Module *LLVMMod;
   auto Success =
-      llvm::readSpirv(LLVMCtx, translatorOpts(), SPIRStream, LLVMMod, ErrMsg);
+      llvm::readSpirv(LLVMCtx, translatorOpts(), SPIRVBuffer, LLVMMod, ErrMsg);
   if (!Success) {
     return createStringError(
         inconvertibleErrorCode(),
@@ -9,6 +9,7 @@
 #include "llvm/Passes/PassBuilder.h"
 #include "llvm/Passes/PassPlugin.h"
 
+#include "barriers/BarrierElimination.h"
 #include "internalization/Internalization.h"
 #include "kernel-fusion/SYCLKernelFusion.h"
 #include "kernel-info/SYCLKernelInfo.h"
@@ -33,6 +34,10 @@ llvm::PassPluginLibraryInfo getSYCLKernelFusionPluginInfo() {
                 MPM.addPass(SYCLKernelFusion(BarrierFlag));
                 return true;
               }
+              if (Name == "sycl-barrier-elimination") {
+                MPM.addPass(SYCLBarrierElimination());
+                return true;
+              }
               if (Name == "sycl-internalization") {
                 MPM.addPass(SYCLInternalizer());
                 return true;
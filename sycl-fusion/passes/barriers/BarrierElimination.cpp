@@ -0,0 +1,532 @@
+//==------------------------ BarrierElimination.cpp ------------------------==//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#include "BarrierElimination.h"
+
+#include "debug/PassDebug.h"
+#include "target/TargetFusionInfo.h"
+
+#include "llvm/Analysis/AliasAnalysis.h"
+#include "llvm/Analysis/CFG.h"
+#include "llvm/Analysis/MemoryLocation.h"
+#include "llvm/Analysis/PostDominators.h"
+#include "llvm/Analysis/ScalarEvolution.h"
+#include "llvm/Analysis/ScalarEvolutionExpressions.h"
+#include "llvm/Analysis/ValueTracking.h"
+#include "llvm/IR/Dominators.h"
+#include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/InstIterator.h"
+#include "llvm/IR/IntrinsicInst.h"
+#include "llvm/Support/MathExtras.h"
+
+#define DEBUG_TYPE "sycl-fusion"
+
+using namespace llvm;
+
+constexpr StringLiteral SYCLBarrierElimination::Key;
+
+namespace {
+
+///
+/// Synchronization required between two stages of a fused kernel, ordered by
+/// strength.
+enum class BarrierScope { None, SubGroup, WorkGroup };
+
+///
+/// Byte offset of an address from its base pointer, expressed as a linear
+/// combination of the IDs of the accessing work-item plus a part that is
+/// uniform across the work-group.
+struct AccessForm {
+  const SCEV *Base{nullptr};
+  /// Symbolic work-group uniform part of the offset, nullptr if there is none.
+  const SCEV *Uniform{nullptr};
+  int64_t Constant{0};
+  std::array<int64_t, 3> LocalID{};
+  /// Kept apart from the local ID, as the work-group uniform difference
+  /// between both, e.g., the global offset, is not part of Uniform.
+  std::array<int64_t, 3> GlobalID{};
+  int64_t SubGroupID{0};
+  int64_t SubGroupLocalID{0};
+
+  bool usesLocalID() const {
+    auto IsNonZero = [](int64_t C) { return C != 0; };
+    return llvm::any_of(LocalID, IsNonZero) ||
+           llvm::any_of(GlobalID, IsNonZero);
+  }
+
+  bool operator==(const AccessForm &Other) const {
+    return Base == Other.Base && Uniform == Other.Uniform &&
+           Constant == Other.Constant && LocalID == Other.LocalID &&
+           GlobalID == Other.GlobalID && SubGroupID == Other.SubGroupID &&
+           SubGroupLocalID == Other.SubGroupLocalID;
+  }
+};
+
+///
+/// A memory access of a stage. Accesses to unknown memory, e.g., through
+/// calls, have no underlying object.
+struct MemAccess {
+  const Value *Object;
+  std::optional<AccessForm> Form;
+  uint64_t Size;
+  bool IsWrite;
+};
+
+using StageAccesses = SmallVector<MemAccess>;
+
+///
+/// Beyond this number of access pairs, barriers are conservatively kept to
+/// bound compile time.
+constexpr size_t MaxAccessPairs{1 << 16};
+
+class BarrierEliminationImpl {
+public:
+  BarrierEliminationImpl(Function &F, FunctionAnalysisManager &FAM,
+                         const TargetFusionInfo &TFI, unsigned Dims,
+                         uint64_t Extent)
+      : F{F}, SE{FAM.getResult<ScalarEvolutionAnalysis>(F)},
+        AA{FAM.getResult<AAManager>(F)},
+        DT{FAM.getResult<DominatorTreeAnalysis>(F)},
+        PDT{FAM.getResult<PostDominatorTreeAnalysis>(F)}, TFI{TFI},
+        Dims{Dims}, Extent{Extent},
+        MaxSubGroupSize{TFI.getMaxSubGroupSize(F)} {}
+
+  bool run();
+
+private:
+  bool collectBarriers(SmallVectorImpl<CallInst *> &Barriers) const;
+
+  void collectAccesses(ArrayRef<CallInst *> Barriers,
+                       MutableArrayRef<StageAccesses> Stages);
+
+  std::optional<IndexSpaceQuery> getQuery(const Value *V) const;
+
+  bool isUniform(const SCEV *S) const;
+
+  bool decompose(const SCEV *S, int64_t Scale, AccessForm &Form,
+                 SmallVectorImpl<const SCEV *> &UniformTerms) const;
+
+  std::optional<AccessForm> getForm(Value *Ptr) const;
+
+  bool isInjective(const AccessForm &Form, uint64_t Size) const;
+
+  bool isSubGroupLocal(const AccessForm &A, const AccessForm &B,
+                       uint64_t Size) const;
+
+  BarrierScope classify(const MemAccess &A, const MemAccess &B) const;
+
+  BarrierScope classify(ArrayRef<MemAccess> Before,
+                     ArrayRef<MemAccess> After) const;
+
+  Function &F;
+  ScalarEvolution &SE;
+  AAResults &AA;
+  DominatorTree &DT;
+  PostDominatorTree &PDT;
+  const TargetFusionInfo &TFI;
+  unsigned Dims;
+  uint64_t Extent;
+  uint64_t MaxSubGroupSize;
+};
+} // namespace
+
+bool BarrierEliminationImpl::collectBarriers(
+    SmallVectorImpl<CallInst *> &Barriers) const {
+  for (auto &I : instructions(F)) {
+    if (I.hasMetadata(SYCLBarrierElimination::Key)) {
+      Barriers.push_back(cast<CallInst>(&I));
+    }
+  }
+  // The barriers are inserted at the top level of the fused kernel, so they
+  // are totally ordered by dominance.
+  llvm::sort(Barriers, [&](CallInst *LHS, CallInst *RHS) {
+    return LHS != RHS && DT.dominates(LHS, RHS);
+  });
+  for (auto [Prev, Barrier] : llvm::zip(Barriers, drop_begin(Barriers))) {
+    if (!DT.dominates(Prev, Barrier)) {
+      return false;
+    }
+  }
+  // Stages are only well-defined if every execution of the kernel passes
+  // each barrier exactly once.
+  return llvm::all_of(Barriers, [&](CallInst *Barrier) {
+    auto *BB = Barrier->getParent();
+    SmallVector<BasicBlock *> Succs{successors(BB)};
+    return PDT.dominates(BB, &F.getEntryBlock()) &&
+           !isPotentiallyReachableFromMany(Succs, BB, nullptr, &DT);
+  });
+}
+
+void BarrierEliminationImpl::collectAccesses(
+    ArrayRef<CallInst *> Barriers, MutableArrayRef<StageAccesses> Stages) {
+  const auto &DL = F.getParent()->getDataLayout();
+  for (auto &I : instructions(F)) {
+    if (I.hasMetadata(SYCLBarrierElimination::Key) ||
+        !I.mayReadOrWriteMemory()) {
+      continue;
+    }
+    // The stage of an instruction is the number of barriers executed before
+    // it.
+    auto &Stage = Stages[llvm::count_if(
+        Barriers, [&](CallInst *B) { return DT.dominates(B, &I); })];
+    if (auto *Call = dyn_cast<CallBase>(&I)) {
+      if (getQuery(Call) || isa<DbgInfoIntrinsic>(Call) ||
+          Call->isLifetimeStartOrEnd() ||
+          Call->getIntrinsicID() == Intrinsic::assume) {
+        continue;
+      }
+    }
+    Value *Ptr = getLoadStorePointerOperand(&I);
+    if (!Ptr || I.isAtomic() || I.isVolatile()) {
+      // Calls, atomics and volatile accesses might touch any memory.
+      Stage.push_back(MemAccess{nullptr, std::nullopt, 0, true});
+      continue;
+    }
+    const Value *Object = getUnderlyingObject(Ptr);
+    if (isa<AllocaInst>(Object)) {
+      // Private memory.
+      continue;
+    }
+    const bool IsWrite = isa<StoreInst>(&I);
+    if (auto *GV = dyn_cast<GlobalVariable>(Object);
+        GV && GV->isConstant() && !IsWrite) {
+      continue;
+    }
+    Type *AccessTy = getLoadStoreType(&I);
+    Stage.push_back(MemAccess{Object, getForm(Ptr),
+                              DL.getTypeStoreSize(AccessTy).getFixedValue(),
+                              IsWrite});
+  }
+}
+
+std::optional<IndexSpaceQuery>
+BarrierEliminationImpl::getQuery(const Value *V) const {
+  if (const auto *Call = dyn_cast<CallBase>(V)) {
+    return TFI.getIndexSpaceQuery(Call);
+  }
+  return {};
+}
+
+bool BarrierEliminationImpl::isUniform(const SCEV *S) const {
+  // Kernel arguments, constants and work-group uniform queries are uniform.
+  // Loop recurrences might depend on the work-item.
+  return !SCEVExprContains(S, [&](const SCEV *Expr) {
+    if (isa<SCEVAddRecExpr>(Expr)) {
+      return true;
+    }
+    if (const auto *U = dyn_cast<SCEVUnknown>(Expr)) {
+      const Value *V = U->getValue();
+      if (isa<Argument>(V) || isa<Constant>(V)) {
+        return false;
+      }
+      auto Query = getQuery(V);
+      return !Query || Query->K != IndexSpaceQuery::WorkGroupUniform;
+    }
+    return false;
+  });
+}
+
+bool BarrierEliminationImpl::decompose(
+    const SCEV *S, int64_t Scale, AccessForm &Form,
+    SmallVectorImpl<const SCEV *> &UniformTerms) const {
+  if (const auto *C = dyn_cast<SCEVConstant>(S)) {
+    const APInt &Val = C->getAPInt();
+    int64_t Term;
+    return Val.getSignificantBits() <= 64 &&
+           !MulOverflow(Val.getSExtValue(), Scale, Term) &&
+           !AddOverflow(Form.Constant, Term, Form.Constant);
+  }
+  if (isUniform(S)) {
+    UniformTerms.push_back(
+        SE.getMulExpr(S, SE.getConstant(S->getType(), Scale, true)));
+    return true;
+  }
+  if (const auto *Add = dyn_cast<SCEVAddExpr>(S)) {
+    return llvm::all_of(Add->operands(), [&](const SCEV *Op) {
+      return decompose(Op, Scale, Form, UniformTerms);
+    });
+  }
+  if (const auto *Mul = dyn_cast<SCEVMulExpr>(S)) {
+    // Constants are always the first operand of a canonical multiplication.
+    const auto *C = dyn_cast<SCEVConstant>(Mul->getOperand(0));
+    int64_t NewScale;
+    if (Mul->getNumOperands() != 2 || !C ||
+        C->getAPInt().getSignificantBits() > 64 ||
+        MulOverflow(C->getAPInt().getSExtValue(), Scale, NewScale)) {
+      return false;
+    }
+    return decompose(Mul->getOperand(1), NewScale, Form, UniformTerms);
+  }
+  // Index space queries are small non-negative integers, so extending or
+  // truncating them does not change their value.
+  if (const auto *Cast = dyn_cast<SCEVCastExpr>(S)) {
+    S = Cast->getOperand(0);
+  }
+  const auto *U = dyn_cast<SCEVUnknown>(S);
+  if (!U) {
+    return false;
+  }
+  auto Query = getQuery(U->getValue());
+  if (!Query) {
+    return false;
+  }
+  int64_t *Coeff = nullptr;
+  switch (Query->K) {
+  case IndexSpaceQuery::LocalID:
+    Coeff = &Form.LocalID[Query->Dim];
+    break;
+  case IndexSpaceQuery::GlobalID:
+    Coeff = &Form.GlobalID[Query->Dim];
+    break;
+  case IndexSpaceQuery::SubGroupID:
+    Coeff = &Form.SubGroupID;
+    break;
+  case IndexSpaceQuery::SubGroupLocalID:
+    Coeff = &Form.SubGroupLocalID;
+    break;
+  case IndexSpaceQuery::WorkGroupUniform:
+    // Casts of uniform values are handled above.
+    return false;
+  }
+  return !AddOverflow(*Coeff, Scale, *Coeff);
+}
+
+std::optional<AccessForm> BarrierEliminationImpl::getForm(Value *Ptr) const {
+  const SCEV *Addr = SE.getSCEV(Ptr);
+  const SCEV *Base = SE.getPointerBase(Addr);
+  if (!isa<SCEVUnknown>(Base)) {
+    return {};
+  }
+  const SCEV *Offset = SE.getMinusSCEV(Addr, Base);
+  if (isa<SCEVCouldNotCompute>(Offset)) {
+    return {};
+  }
+  AccessForm Form;
+  Form.Base = Base;
+  SmallVector<const SCEV *> UniformTerms;
+  if (!decompose(Offset, 1, Form, UniformTerms)) {
+    return {};
+  }
+  if (!UniformTerms.empty()) {
+    Form.Uniform = SE.getAddExpr(UniformTerms);
+  }
+  return Form;
+}
+
+bool BarrierEliminationImpl::isInjective(const AccessForm &Form,
+                                         uint64_t Size) const {
+  // The address is injective in the work-item if the coefficients form a
+  // mixed radix number system, i.e., each coefficient exceeds the largest
+  // offset reachable through the smaller ones.
+  SmallVector<uint64_t, 3> Coeffs;
+  uint64_t DigitExtent;
+  if (Form.usesLocalID()) {
+    if (Form.SubGroupID || Form.SubGroupLocalID) {
+      return false;
+    }
+    for (unsigned Dim = 0; Dim < 3; ++Dim) {
+      // Within a work-group, the global ID is the local ID plus a uniform
+      // value, so both contribute to the same digit.
+      int64_t C;
+      if (AddOverflow(Form.LocalID[Dim], Form.GlobalID[Dim], C)) {
+        return false;
+      }
+      if (C == 0) {
+        continue;
+      }
+      if (Dim >= Dims) {
+        return false;
+      }
+      Coeffs.push_back(std::abs(C));
+    }
+    // Work-items differing only in a dimension not contributing to the
+    // address would access the same address.
+    if (Coeffs.size() != Dims) {
+      return false;
+    }
+    llvm::sort(Coeffs);
+    DigitExtent = Extent;
+  } else {
+    if (!Form.SubGroupID || !Form.SubGroupLocalID) {
+      return false;
+    }
+    // The sub-group local ID has to be the least significant digit, as the
+    // number of sub-groups is unknown.
+    Coeffs = {static_cast<uint64_t>(std::abs(Form.SubGroupLocalID)),
+              static_cast<uint64_t>(std::abs(Form.SubGroupID))};
+    DigitExtent = MaxSubGroupSize;
+  }
+  uint64_t Span = Size;
+  for (uint64_t C : Coeffs) {
+    if (C < Span) {
+      return false;
+    }
+    // Saturates on overflow, which only matters for more significant digits.
+    Span = SaturatingMultiplyAdd(C, DigitExtent - 1, Span);
+  }
+  return true;
+}
+
+bool BarrierEliminationImpl::isSubGroupLocal(const AccessForm &A,
+                                             const AccessForm &B,
+                                             uint64_t Size) const {
+  // Both accesses must address a window starting at the same multiple of the
+  // sub-group ID, with the windows of different sub-groups not overlapping.
+  if (A.usesLocalID() || B.usesLocalID() || A.Base != B.Base ||
+      A.Uniform != B.Uniform || A.SubGroupID != B.SubGroupID ||
+      A.SubGroupID == 0) {
+    return false;
+  }
+  const int64_t MaxLocalID = MaxSubGroupSize - 1;
+  int64_t Lo = std::numeric_limits<int64_t>::max();
+  int64_t Hi = std::numeric_limits<int64_t>::min();
+  for (const AccessForm *Form : {&A, &B}) {
+    int64_t Reach;
+    int64_t Lower;
+    int64_t Upper;
+    if (MulOverflow(Form->SubGroupLocalID, MaxLocalID, Reach) ||
+        AddOverflow(Form->Constant, std::min<int64_t>(Reach, 0), Lower) ||
+        AddOverflow(Form->Constant, std::max<int64_t>(Reach, 0), Upper) ||
+        AddOverflow(Upper, static_cast<int64_t>(Size), Upper)) {
+      return false;
+    }
+    Lo = std::min(Lo, Lower);
+    Hi = std::max(Hi, Upper);
+  }
+  int64_t Span;
+  return !SubOverflow(Hi, Lo, Span) && std::abs(A.SubGroupID) >= Span;
+}
+
+BarrierScope BarrierEliminationImpl::classify(const MemAccess &A,
+                                           const MemAccess &B) const {
+  if (!A.IsWrite && !B.IsWrite) {
+    return BarrierScope::None;
+  }
+  if (!A.Object || !B.Object) {
+    return BarrierScope::WorkGroup;
+  }
+  if (A.Object != B.Object &&
+      AA.isNoAlias(MemoryLocation::getBeforeOrAfter(A.Object),
+                   MemoryLocation::getBeforeOrAfter(B.Object))) {
+    return BarrierScope::None;
+  }
+  if (!A.Form || !B.Form || A.Form->Base != B.Form->Base) {
+    return BarrierScope::WorkGroup;
+  }
+  const uint64_t Size = std::max(A.Size, B.Size);
+  if (*A.Form == *B.Form && isInjective(*A.Form, Size)) {
+    return BarrierScope::None;
+  }
+  if (isSubGroupLocal(*A.Form, *B.Form, Size)) {
+    return BarrierScope::SubGroup;
+  }
+  return BarrierScope::WorkGroup;
+}
+
+BarrierScope BarrierEliminationImpl::classify(ArrayRef<MemAccess> Before,
+                                           ArrayRef<MemAccess> After) const {
+  if (Before.size() * After.size() > MaxAccessPairs) {
+    return BarrierScope::WorkGroup;
+  }
+  BarrierScope Res = BarrierScope::None;
+  for (const auto &A : Before) {
+    for (const auto &B : After) {
+      Res = std::max(Res, classify(A, B));
+      if (Res == BarrierScope::WorkGroup) {
+        return Res;
+      }
+    }
+  }
+  return Res;
+}
+
+bool BarrierEliminationImpl::run() {
+  SmallVector<CallInst *> Barriers;
+  if (!collectBarriers(Barriers)) {
+    FUSION_DEBUG(llvm::dbgs() << "Unexpected placement of barriers in "
+                              << F.getName() << ", keeping all barriers\n");
+    return false;
+  }
+  SmallVector<StageAccesses> Stages(Barriers.size() + 1);
+  collectAccesses(Barriers, Stages);
+
+  // Accesses since the last barrier and accesses since the last work-group
+  // barrier that are already ordered by a sub-group barrier.
+  StageAccesses Recent = std::move(Stages.front());
+  StageAccesses SubGroupOrdered;
+  bool Changed = false;
+  for (auto [Barrier, Next] : llvm::zip(Barriers, drop_begin(Stages))) {
+    BarrierScope Scope = classify(Recent, Next);
+    if (classify(SubGroupOrdered, Next) == BarrierScope::WorkGroup) {
+      Scope = BarrierScope::WorkGroup;
+    }
+    switch (Scope) {
+    case BarrierScope::WorkGroup:
+      SubGroupOrdered.clear();
+      Recent = std::move(Next);
+      break;
+    case BarrierScope::SubGroup: {
+      FUSION_DEBUG(llvm::dbgs() << "Narrowing barrier in " << F.getName()
+                                << " to sub-group scope\n");
+      const auto Flags =
+          mdconst::extract<ConstantInt>(
+              Barrier->getMetadata(SYCLBarrierElimination::Key)->getOperand(0))
+              ->getSExtValue();
+      IRBuilder<> Builder{Barrier};
+      TFI.createSubGroupBarrierCall(Builder, Flags);
+      Barrier->eraseFromParent();
+      SubGroupOrdered.append(Recent.begin(), Recent.end());
+      Recent = std::move(Next);
+      Changed = true;
+      break;
+    }
+    case BarrierScope::None:
+      FUSION_DEBUG(llvm::dbgs()
+                   << "Removing barrier in " << F.getName() << "\n");
+      Barrier->eraseFromParent();
+      Recent.append(Next.begin(), Next.end());
+      Changed = true;
+      break;
+    }
+  }
+  return Changed;
+}
+
+PreservedAnalyses SYCLBarrierElimination::run(Module &M,
+                                              ModuleAnalysisManager &AM) {
+  auto &FAM = AM.getResult<FunctionAnalysisManagerModuleProxy>(M).getManager();
+  std::optional<TargetFusionInfo> TFI;
+  bool Changed = false;
+  for (Function &F : M) {
+    auto Barriers = llvm::make_filter_range(instructions(F), [](auto &I) {
+      return I.hasMetadata(Key);
+    });
+    if (Barriers.begin() == Barriers.end()) {
+      continue;
+    }
+    if (!TFI) {
+      TFI.emplace(&M);
+    }
+    auto *MD = Barriers.begin()->getMetadata(Key);
+    const auto Dims =
+        mdconst::extract<ConstantInt>(MD->getOperand(1))->getZExtValue();
+    const auto Extent =
+        mdconst::extract<ConstantInt>(MD->getOperand(2))->getZExtValue();
+    if (BarrierEliminationImpl{F, FAM, *TFI, static_cast<unsigned>(Dims),
+                               Extent}
+            .run()) {
+      FAM.invalidate(F, PreservedAnalyses::none());
+    }
+    // The metadata is only needed by this pass.
+    for (auto &I : instructions(F)) {
+      I.setMetadata(Key, nullptr);
+    }
+    Changed = true;
+  }
+  return Changed ? PreservedAnalyses::none() : PreservedAnalyses::all();
+}
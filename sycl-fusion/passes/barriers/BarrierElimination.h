@@ -0,0 +1,38 @@
+//==-- BarrierElimination.h - Remove barriers between fused kernel stages --==//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef SYCL_FUSION_PASSES_BARRIERELIMINATION_H
+#define SYCL_FUSION_PASSES_BARRIERELIMINATION_H
+
+#include <llvm/IR/PassManager.h>
+
+namespace llvm {
+///
+/// Pass to remove or narrow the work-group barriers inserted between the
+/// stages of a fused kernel.
+///
+/// The memory accesses of the stages are analyzed with ScalarEvolution. If no
+/// address written on one side of a barrier is accessed by another work-item on
+/// the other side, the barrier is removed. If data is only shared among the
+/// work-items of a sub-group, the barrier is replaced by a sub-group barrier.
+///
+/// Kernel fusion does not order memory accesses across work-groups, so the
+/// analysis only needs to consider the work-items of a single work-group.
+class SYCLBarrierElimination : public PassInfoMixin<SYCLBarrierElimination> {
+public:
+  ///
+  /// Metadata attached to barriers inserted by kernel fusion. The operands are
+  /// the barrier flags, the number of dimensions of the fused kernel and an
+  /// upper bound of the work-group extent in any dimension.
+  constexpr static StringLiteral Key{"sycl.kernel.fusion.barrier"};
+
+  PreservedAnalyses run(Module &M, ModuleAnalysisManager &AM);
+};
+} // namespace llvm
+
+#endif // SYCL_FUSION_PASSES_BARRIERELIMINATION_H
@@ -82,15 +82,17 @@ struct SYCLInternalizerImpl {
   /// Check that an value can be promoted.
   /// For GEP and Call instructions, delegate to the specific implementations.
   /// For address-space casts, pointer-to-int conversions and unknown users,
-  /// return an error.
-  Error canPromoteValue(Value *Val, size_t LocalSize) const;
+  /// return an error. ElemTy is the element type of the promoted pointer, if
+  /// known.
+  Error canPromoteValue(Value *Val, size_t LocalSize, Type *ElemTy) const;
 
   ///
   /// Check that the operand of a GEP can be promoted.
-  /// If the GEP uses more than one index, return an error.
+  /// If the GEP uses more than one index, or indexes into elements of a size
+  /// different from the promoted pointer's element type, return an error.
   /// Otherwise, check if the GEP itself can be promoted in its users.
   Error canPromoteGEP(GetElementPtrInst *GEPI, const Value *Val,
-                      size_t LocalSize) const;
+                      size_t LocalSize, Type *ElemTy) const;
 
   ///
   /// Check if operand to a function call can be promoted.
@@ -103,6 +105,8 @@ struct SYCLInternalizerImpl {
                             SmallVectorImpl<size_t> &PromoteArgSizes) const;
 };
 
+static Type *getElementTypeFromUses(Value *PtrVal);
+
 constexpr StringLiteral SYCLInternalizer::Key;
 constexpr StringLiteral SYCLInternalizer::LocalSizeKey;
 
@@ -232,13 +236,23 @@ Error SYCLInternalizerImpl::canPromoteCall(CallBase *C, const Value *Val,
 }
 
 Error SYCLInternalizerImpl::canPromoteGEP(GetElementPtrInst *GEPI,
-                                          const Value *Val,
-                                          size_t LocalSize) const {
+                                          const Value *Val, size_t LocalSize,
+                                          Type *ElemTy) const {
   if (cast<PointerType>(GEPI->getType())->getAddressSpace() == AS) {
     // If the GEPI is already using the correct address-space, no change is
     // required.
     return Error::success();
   }
+  // Indices are remapped in units of the promoted element type, so indexing
+  // with a different element size, e.g., byte offsets computed on a USM
+  // pointer, cannot be remapped.
+  const DataLayout &DL = GEPI->getModule()->getDataLayout();
+  if (ElemTy && DL.getTypeAllocSize(GEPI->getSourceElementType()) !=
+                    DL.getTypeAllocSize(ElemTy)) {
+    return createStringError(inconvertibleErrorCode(),
+                             "Element size of GEP instruction does not match "
+                             "the element size of the promoted pointer");
+  }
   if (GEPI->getNumIndices() != 1 &&
       std::any_of(GEPI->user_begin(), GEPI->user_end(), [](const auto *User) {
         return isa<GetElementPtrInst>(User);
@@ -248,11 +262,11 @@ Error SYCLInternalizerImpl::canPromoteGEP(GetElementPtrInst *GEPI,
                              "promotable GEP instruction pointer argument");
   }
   // Recurse to check all users of the GEP.
-  return canPromoteValue(GEPI, LocalSize);
+  return canPromoteValue(GEPI, LocalSize, ElemTy);
 }
 
-Error SYCLInternalizerImpl::canPromoteValue(Value *Val,
-                                            size_t LocalSize) const {
+Error SYCLInternalizerImpl::canPromoteValue(Value *Val, size_t LocalSize,
+                                            Type *ElemTy) const {
   for (auto *U : Val->users()) {
     auto *I = dyn_cast<Instruction>(U);
     if (!I) {
@@ -277,8 +291,8 @@ Error SYCLInternalizerImpl::canPromoteValue(Value *Val,
       }
       break;
     case Instruction::GetElementPtr:
-      if (auto Err =
-              canPromoteGEP(cast<GetElementPtrInst>(I), Val, LocalSize)) {
+      if (auto Err = canPromoteGEP(cast<GetElementPtrInst>(I), Val,
+                                   LocalSize, ElemTy)) {
         return Err;
       }
       break;
@@ -316,7 +330,8 @@ Error SYCLInternalizerImpl::checkArgsPromotable(
       PromoteArgSizes[Index] = 0;
       continue;
     }
-    if (auto Err = canPromoteValue(Arg, LocalSize)) {
+    if (auto Err = canPromoteValue(Arg, LocalSize,
+                                   getElementTypeFromUses(Arg))) {
       // Set the local size to 0 to indicate that this argument should not be
       // promoted.
       PromoteArgSizes[Index] = 0;
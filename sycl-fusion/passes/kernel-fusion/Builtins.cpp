@@ -1,6 +1,7 @@
 #include "Builtins.h"
 
 #include "NDRangesHelper.h"
+#include "target/TargetFusionInfo.h"
 
 #include "llvm/IR/IRBuilder.h"
 #include "llvm/IR/InstIterator.h"
@@ -10,19 +11,8 @@
 using namespace llvm;
 using namespace jit_compiler;
 
-enum class BuiltinKind : uint8_t {
-  GlobalSizeRemapper,
-  LocalSizeRemapper,
-  NumWorkGroupsRemapper,
-  GlobalOffsetRemapper,
-  GlobalIDRemapper,
-  LocalIDRemapper,
-  GroupIDRemapper,
-};
-
 static constexpr StringLiteral RemapperCommonName{"__remapper"};
 static constexpr size_t NumBuiltins{11};
-static constexpr size_t NumBuiltinsToRemap{7};
 
 template <typename ForwardIt, typename KeyTy>
 static ForwardIt mapArrayLookup(ForwardIt Begin, ForwardIt End,
@@ -40,19 +30,6 @@ static auto mapArrayLookupValue(ForwardIt Begin, ForwardIt End,
   return Iter->second;
 }
 
-static BuiltinKind getBuiltinKind(Function *F) {
-  constexpr std::array<std::pair<StringLiteral, BuiltinKind>,
-                       NumBuiltinsToRemap>
-      Map{{{GetGlobalSizeName, BuiltinKind::GlobalSizeRemapper},
-           {GetGroupIDName, BuiltinKind::GroupIDRemapper},
-           {GetGlobalOffsetName, BuiltinKind::GlobalOffsetRemapper},
-           {GetNumWorkGroupsName, BuiltinKind::NumWorkGroupsRemapper},
-           {GetLocalSizeName, BuiltinKind::LocalSizeRemapper},
-           {GetLocalIDName, BuiltinKind::LocalIDRemapper},
-           {GetGlobalIDName, BuiltinKind::GlobalIDRemapper}}};
-  return mapArrayLookupValue(Map.begin(), Map.end(), F->getName());
-}
-
 /// 0 for IDs/offset and 1 for sizes.
 static uint64_t getDefaultValue(BuiltinKind K) {
   switch (K) {
@@ -80,7 +57,8 @@ static raw_ostream &operator<<(raw_ostream &Os, const NDRange &ND) {
 
 /// Will generate a unique function name so that it can be reused in further
 /// stages.
-static std::string getFunctionName(BuiltinKind K, const NDRange &SrcNDRange,
+static std::string getFunctionName(BuiltinKind K, StringRef BuiltinName,
+                                   const NDRange &SrcNDRange,
                                    const NDRange &FusedNDRange) {
   std::string Res;
   raw_string_ostream S{Res};
@@ -105,6 +83,8 @@ static std::string getFunctionName(BuiltinKind K, const NDRange &SrcNDRange,
         llvm_unreachable("Unhandled kind");
       }()
     << "_remapper_" << SrcNDRange << "_" << FusedNDRange;
+  // Some targets provide a separate builtin per dimension.
+  S << "_" << BuiltinName;
   return S.str();
 }
 
@@ -204,9 +184,10 @@ static Value *generateNumWorkGroupsCase(IRBuilderBase &Builder,
                           SrcNDRange.getLocalSize()[Index]);
 }
 static Value *remapGetGlobalID(IRBuilderBase &Builder,
+                               const TargetFusionInfo &TargetInfo,
                                const NDRange &SrcNDRange,
                                const NDRange &FusedNDRange, uint32_t Index) {
-  auto *GlobalLinearID = getGlobalLinearID(Builder, FusedNDRange);
+  auto *GlobalLinearID = getGlobalLinearID(Builder, TargetInfo, FusedNDRange);
   const auto getGS = [&Indices = SrcNDRange.getGlobalSize(),
                       Dimensions = SrcNDRange.getDimensions()](auto I) {
     return Indices[mirror(Dimensions, I)];
@@ -230,18 +211,22 @@ static Value *remapGetGlobalID(IRBuilderBase &Builder,
 /// global_id(1) = (global_linear_id(x) / global_size(2)) % global_size(1)
 /// global_id(2) = global_linear_id(x) % global_size(2)
 static Value *generateGetGlobalIDCase(IRBuilderBase &Builder,
+                                      const TargetFusionInfo &TargetInfo,
                                       const NDRange &SrcNDRange,
                                       const NDRange &FusedNDRange,
                                       uint32_t Index) {
-  return remapGetGlobalID(Builder, SrcNDRange, FusedNDRange, Index);
+  return remapGetGlobalID(Builder, TargetInfo, SrcNDRange, FusedNDRange,
+                          Index);
 }
 
 /// local_id(x) = global_id(x) % local_size(x)
 static Value *generateGetLocalIDCase(IRBuilderBase &Builder,
+                                     const TargetFusionInfo &TargetInfo,
                                      const NDRange &SrcNDRange,
                                      const NDRange &FusedNDRange,
                                      uint32_t Index) {
-  auto *GlobalID = remapGetGlobalID(Builder, SrcNDRange, FusedNDRange, Index);
+  auto *GlobalID =
+      remapGetGlobalID(Builder, TargetInfo, SrcNDRange, FusedNDRange, Index);
   return Builder.CreateURem(GlobalID,
                             Builder.getInt64(SrcNDRange.getLocalSize()[mirror(
                                 SrcNDRange.getDimensions(), Index)]));
@@ -249,16 +234,19 @@ static Value *generateGetLocalIDCase(IRBuilderBase &Builder,
 
 /// group_id(x) = global_id(x) / local_size(x)
 static Value *generateGetGroupIDCase(IRBuilderBase &Builder,
+                                     const TargetFusionInfo &TargetInfo,
                                      const NDRange &SrcNDRange,
                                      const NDRange &FusedNDRange,
                                      uint32_t Index) {
-  auto *GlobalID = remapGetGlobalID(Builder, SrcNDRange, FusedNDRange, Index);
+  auto *GlobalID =
+      remapGetGlobalID(Builder, TargetInfo, SrcNDRange, FusedNDRange, Index);
   return Builder.CreateUDiv(GlobalID,
                             Builder.getInt64(SrcNDRange.getLocalSize()[mirror(
                                 SrcNDRange.getDimensions(), Index)]));
 }
 
 static Value *generateCase(BuiltinKind K, IRBuilderBase &Builder,
+                           const TargetFusionInfo &TargetInfo,
                            const NDRange &SrcNDRange,
                            const NDRange &FusedNDRange, uint32_t Index) {
   switch (K) {
@@ -269,11 +257,14 @@ static Value *generateCase(BuiltinKind K, IRBuilderBase &Builder,
   case BuiltinKind::NumWorkGroupsRemapper:
     return generateNumWorkGroupsCase(Builder, SrcNDRange, FusedNDRange, Index);
   case BuiltinKind::GlobalIDRemapper:
-    return generateGetGlobalIDCase(Builder, SrcNDRange, FusedNDRange, Index);
+    return generateGetGlobalIDCase(Builder, TargetInfo, SrcNDRange,
+                                   FusedNDRange, Index);
   case BuiltinKind::LocalIDRemapper:
-    return generateGetLocalIDCase(Builder, SrcNDRange, FusedNDRange, Index);
+    return generateGetLocalIDCase(Builder, TargetInfo, SrcNDRange,
+                                  FusedNDRange, Index);
   case BuiltinKind::GroupIDRemapper:
-    return generateGetGroupIDCase(Builder, SrcNDRange, FusedNDRange, Index);
+    return generateGetGroupIDCase(Builder, TargetInfo, SrcNDRange,
+                                  FusedNDRange, Index);
   case BuiltinKind::GlobalOffsetRemapper:
     return generateGetGlobalOffsetCase(Builder, SrcNDRange, FusedNDRange,
                                        Index);
@@ -374,14 +365,15 @@ static FunctionType *getFunctionType(IRBuilderBase &Builder,
                              FunctionName)(Builder);
 }
 
-static Function *initFunction(Function *OldF, const NDRange &SrcNDRange,
-                              const NDRange &FusedNDRange) {
-  const auto K = getBuiltinKind(OldF);
+Function *jit_compiler::Remapper::initFunction(BuiltinKind K, Function *OldF,
+                                              const NDRange &SrcNDRange,
+                                              const NDRange &FusedNDRange) {
   if (!shouldRemap(K, SrcNDRange, FusedNDRange)) {
     // If the builtin should not be remapped, return the original function.
     return OldF;
   }
-  const auto Name = getFunctionName(K, SrcNDRange, FusedNDRange);
+  const auto Name =
+      getFunctionName(K, OldF->getName(), SrcNDRange, FusedNDRange);
   auto *M = OldF->getParent();
   auto *F = M->getFunction(Name);
   assert(!F && "Function name should be unique");
@@ -389,29 +381,42 @@ static Function *initFunction(Function *OldF, const NDRange &SrcNDRange,
   auto &Ctx = M->getContext();
   IRBuilder<> Builder{Ctx};
 
-  F = Function::Create(getFunctionType(Builder, RemapperCommonName),
+  // The remapper has the same signature as the builtin it replaces.
+  F = Function::Create(OldF->getFunctionType(),
                        Function::LinkageTypes::InternalLinkage, Name, *M);
 
   auto *EntryBlock = BasicBlock::Create(Ctx, "entry", F);
   Builder.SetInsertPoint(EntryBlock);
 
-  constexpr unsigned SYCLDimensions{3};
-  // Vector holding all the possible values
-  auto *Vec = cast<Value>(
-      ConstantVector::getSplat(ElementCount::getFixed(SYCLDimensions),
-                               Builder.getInt64(getDefaultValue(K))));
-
   const auto NumDimensions = static_cast<uint32_t>(SrcNDRange.getDimensions());
-  for (uint32_t I = 0; I < NumDimensions; ++I) {
-    // Initialize vector
-    Vec = Builder.CreateInsertElement(
-        Vec, generateCase(K, Builder, SrcNDRange, FusedNDRange, I),
-        Builder.getInt32(I));
+  if (auto Dim = TargetInfo.getBuiltinDimension(OldF)) {
+    // The builtin queries a fixed dimension.
+    Builder.CreateRet(
+        *Dim < NumDimensions
+            ? generateCase(K, Builder, TargetInfo, SrcNDRange, FusedNDRange,
+                           *Dim)
+            : Builder.getInt64(getDefaultValue(K)));
+  } else {
+    // The builtin receives the queried dimension as its argument.
+    constexpr unsigned SYCLDimensions{3};
+    // Vector holding all the possible values
+    auto *Vec = cast<Value>(
+        ConstantVector::getSplat(ElementCount::getFixed(SYCLDimensions),
+                                 Builder.getInt64(getDefaultValue(K))));
+
+    for (uint32_t I = 0; I < NumDimensions; ++I) {
+      // Initialize vector
+      Vec = Builder.CreateInsertElement(
+          Vec,
+          generateCase(K, Builder, TargetInfo, SrcNDRange, FusedNDRange, I),
+          Builder.getInt32(I));
+    }
+    // Get queried value
+    Builder.CreateRet(Builder.CreateExtractElement(Vec, F->getArg(0)));
   }
-  // Get queried value
-  Builder.CreateRet(Builder.CreateExtractElement(Vec, F->getArg(0)));
 
-  setFunctionMetadata(F, RemapperCommonName, Ctx);
+  F->setAttributes(getAttributes(RemapperCommonName, Ctx));
+  F->setCallingConv(OldF->getCallingConv());
 
   return F;
 }
@@ -425,7 +430,8 @@ getGetGlobalLinearIDFunctionName(const NDRange &FusedNDRange) {
 }
 
 static Function *
-getOrCreateGetGlobalLinearIDFunction(Module *M, const NDRange &FusedNDRange) {
+getOrCreateGetGlobalLinearIDFunction(Module *M, const TargetFusionInfo &TFI,
+                                     const NDRange &FusedNDRange) {
   const auto Name = getGetGlobalLinearIDFunctionName(FusedNDRange);
 
   auto *F = M->getFunction(Name);
@@ -444,14 +450,13 @@ getOrCreateGetGlobalLinearIDFunction(Module *M, const NDRange &FusedNDRange) {
 
   // See:
   // https://registry.khronos.org/SYCL/specs/sycl-2020/html/sycl-2020.html#sec:multi-dim-linearization
-  auto *Res = [&Builder, &FusedNDRange] {
+  auto *Res = [&Builder, &TFI, &FusedNDRange] {
     const auto Dimensions = FusedNDRange.getDimensions();
     const auto GetGS = [&FusedNDRange](std::size_t I) {
       return FusedNDRange.getGlobalSize()[I];
     };
-    const auto GetID = [&Builder, Dimensions](uint32_t I) {
-      return createSPIRVCall(Builder, GetGlobalIDName,
-                             Builder.getInt32(mirror(Dimensions, I)));
+    const auto GetID = [&Builder, &TFI, Dimensions](uint32_t I) {
+      return TFI.getGlobalIDWithoutOffset(Builder, mirror(Dimensions, I));
     };
     switch (Dimensions) {
     case 1:
@@ -478,63 +483,24 @@ getOrCreateGetGlobalLinearIDFunction(Module *M, const NDRange &FusedNDRange) {
 
   Builder.CreateRet(Res);
 
-  setFunctionMetadata(F, RemapperCommonName, Context);
+  F->setAttributes(getAttributes(RemapperCommonName, Context));
+  TFI.setMetadataForGeneratedFunction(F);
 
   return F;
 }
 
 Value *jit_compiler::getGlobalLinearID(IRBuilderBase &Builder,
+                                       const TargetFusionInfo &TargetInfo,
                                        const NDRange &FusedNDRange) {
   auto *F = getOrCreateGetGlobalLinearIDFunction(
-      Builder.GetInsertBlock()->getParent()->getParent(), FusedNDRange);
+      Builder.GetInsertBlock()->getParent()->getParent(), TargetInfo,
+      FusedNDRange);
   auto *C = Builder.CreateCall(F);
   C->setAttributes(F->getAttributes());
   C->setCallingConv(F->getCallingConv());
   return C;
 }
 
-static bool isIndexSpaceGetterBuiltin(Function *F) {
-  constexpr std::array<StringLiteral, NumBuiltinsToRemap> BuiltinNames{
-      GetGlobalSizeName,    GetGroupIDName,   GetGlobalOffsetName,
-      GetNumWorkGroupsName, GetLocalSizeName, GetLocalIDName,
-      GetGlobalIDName};
-  const auto Name = F->getName();
-  const auto *Iter = llvm::lower_bound(BuiltinNames, Name);
-  return Iter != BuiltinNames.end() && *Iter == Name;
-}
-
-static bool isSafeToNotRemapBuiltin(Function *F) {
-  constexpr std::size_t NumUnsafeBuiltins{8};
-  // SPIRV builtins with kernel capabilities in alphabetical order.
-  //
-  // These builtins might need remapping, but are not supported by the remapper,
-  // so we should abort kernel fusion if we find them during remapping.
-  constexpr std::array<StringLiteral, NumUnsafeBuiltins> UnsafeBuiltIns{
-      "EnqueuedWorkgroupSize",
-      "NumEnqueuedSubgroups",
-      "NumSubgroups",
-      "SubgroupId",
-      "SubgroupLocalInvocationId",
-      "SubgroupMaxSize",
-      "SubgroupSize",
-      "WorkDim"};
-  constexpr StringLiteral SPIRVBuiltinNamespace{"spirv"};
-  constexpr StringLiteral SPIRVBuiltinPrefix{"BuiltIn"};
-
-  auto Name = F->getName();
-  if (!(Name.contains(SPIRVBuiltinNamespace) &&
-        Name.contains(SPIRVBuiltinPrefix))) {
-    return true;
-  }
-  // Drop "spirv" namespace name and "BuiltIn" prefix.
-  Name = Name.drop_front(Name.find(SPIRVBuiltinPrefix) +
-                         SPIRVBuiltinPrefix.size());
-  // Check that Name does not start with any name in UnsafeBuiltIns
-  const auto *Iter =
-      std::upper_bound(UnsafeBuiltIns.begin(), UnsafeBuiltIns.end(), Name);
-  return Iter == UnsafeBuiltIns.begin() || !Name.starts_with(*(Iter - 1));
-}
-
 Expected<Function *>
 jit_compiler::Remapper::remapBuiltins(Function *F, const NDRange &SrcNDRange,
                                       const NDRange &FusedNDRange) {
@@ -544,12 +510,14 @@ jit_compiler::Remapper::remapBuiltins(Function *F, const NDRange &SrcNDRange,
     return Cached;
   }
 
+  if (auto K = TargetInfo.getBuiltinKind(F)) {
+    // Remap given builtin. Depending on the target, the builtin might be
+    // defined in the module, so check this before looking at the body.
+    return Cached = initFunction(*K, F, SrcNDRange, FusedNDRange);
+  }
+
   if (F->isDeclaration()) {
-    if (isIndexSpaceGetterBuiltin(F)) {
-      // Remap given builtin.
-      return Cached = initFunction(F, SrcNDRange, FusedNDRange);
-    }
-    if (isSafeToNotRemapBuiltin(F)) {
+    if (TargetInfo.isSafeToNotRemapBuiltin(F)) {
       // No need to remap.
       return Cached = F;
     }
@@ -15,11 +15,24 @@ class Function;
 class IRBuilderBase;
 class LLVMContext;
 class Module;
+class TargetFusionInfo;
 class Value;
 template <typename T> class ArrayRef;
 } // namespace llvm
 
 namespace jit_compiler {
+/// Index space getter builtins that are remapped when fusing kernels with
+/// heterogeneous ND-ranges.
+enum class BuiltinKind : uint8_t {
+  GlobalSizeRemapper,
+  LocalSizeRemapper,
+  NumWorkGroupsRemapper,
+  GlobalOffsetRemapper,
+  GlobalIDRemapper,
+  LocalIDRemapper,
+  GroupIDRemapper,
+};
+
 /// barrier builtin name
 constexpr llvm::StringLiteral BarrierName{"_Z22__spirv_ControlBarrierjjj"};
 /// get_global_size builtin name
@@ -45,6 +58,12 @@ constexpr llvm::StringLiteral GetLocalIDName{
 /// get_global_id builtin name
 constexpr llvm::StringLiteral GetGlobalIDName{
     "_Z33__spirv_BuiltInGlobalInvocationIdi"};
+/// get_sub_group_id builtin name
+constexpr llvm::StringLiteral GetSubGroupIDName{
+    "_Z25__spirv_BuiltInSubgroupIdv"};
+/// get_sub_group_local_id builtin name
+constexpr llvm::StringLiteral GetSubGroupLocalIDName{
+    "_Z40__spirv_BuiltInSubgroupLocalInvocationIdv"};
 /// offload_wi_finish_wrapper name
 constexpr llvm::StringLiteral OffloadFinishWrapperName{
     "__itt_offload_wi_finish_wrapper"};
@@ -56,8 +75,10 @@ constexpr llvm::StringLiteral OffloadStartWrapperName{
 /// @return The result of calling get_global_linear_id
 ///
 /// @param Builder The builder.
+/// @param TargetInfo Target-specific information to query the global ID.
 /// @param FusedNDRange The range of the fused kernel.
 llvm::Value *getGlobalLinearID(llvm::IRBuilderBase &Builder,
+                               const llvm::TargetFusionInfo &TargetInfo,
                                const NDRange &FusedNDRange);
 
 ///
@@ -68,6 +89,9 @@ llvm::Value *createSPIRVCall(llvm::IRBuilderBase &Builder, llvm::StringRef N,
 
 class Remapper {
 public:
+  explicit Remapper(const llvm::TargetFusionInfo &TargetInfo)
+      : TargetInfo{TargetInfo} {}
+
   ///
   /// Remaps index space getters builtins.
   llvm::Expected<llvm::Function *> remapBuiltins(llvm::Function *F,
@@ -75,6 +99,15 @@ public:
                                                  const NDRange &FusedNDRange);
 
 private:
+  ///
+  /// Create the function replacing builtin \p OldF of kind \p K, or return
+  /// \p OldF if it does not need to be remapped.
+  llvm::Function *initFunction(BuiltinKind K, llvm::Function *OldF,
+                               const NDRange &SrcNDRange,
+                               const NDRange &FusedNDRange);
+
+  const llvm::TargetFusionInfo &TargetInfo;
+
   std::map<std::tuple<llvm::Function *, const NDRange &, const NDRange &>,
            llvm::Function *>
       Cache;
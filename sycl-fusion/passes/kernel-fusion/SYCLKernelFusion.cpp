@@ -10,6 +10,7 @@
 
 #include "Kernel.h"
 #include "NDRangesHelper.h"
+#include "barriers/BarrierElimination.h"
 #include "debug/PassDebug.h"
 #include "internalization/Internalization.h"
 #include "kernel-fusion/Builtins.h"
@@ -198,7 +199,8 @@ static bool needsGuard(const jit_compiler::NDRange &SrcNDRange,
 static FusionInsertPoints addGuard(IRBuilderBase &Builder,
                                    const jit_compiler::NDRange &SrcNDRange,
                                    const jit_compiler::NDRange &FusedNDRange,
-                                   bool IsLast) {
+                                   bool IsLast,
+                                   const TargetFusionInfo &TargetInfo) {
   // Guard:
 
   // entry:
@@ -221,7 +223,8 @@ static FusionInsertPoints addGuard(IRBuilderBase &Builder,
   auto *Exit = BasicBlock::Create(C, "", F);
   auto *CallInsertion = BasicBlock::Create(C, "", F, Exit); // If
 
-  auto *GlobalLinearID = jit_compiler::getGlobalLinearID(Builder, FusedNDRange);
+  auto *GlobalLinearID =
+      jit_compiler::getGlobalLinearID(Builder, TargetInfo, FusedNDRange);
 
   const auto GI = jit_compiler::NDRange::linearize(SrcNDRange.getGlobalSize());
   auto *Cond = Builder.CreateICmpULT(GlobalLinearID, Builder.getInt64(GI));
@@ -237,7 +240,8 @@ createFusionCall(IRBuilderBase &Builder, Function *F,
                  const jit_compiler::NDRange &FusedNDRange, bool IsLast,
                  int BarriersFlags, jit_compiler::Remapper &Remapper,
                  bool ShouldRemap, TargetFusionInfo &TargetInfo) {
-  const auto IPs = addGuard(Builder, SrcNDRange, FusedNDRange, IsLast);
+  const auto IPs =
+      addGuard(Builder, SrcNDRange, FusedNDRange, IsLast, TargetInfo);
 
   if (ShouldRemap) {
     auto FOrErr = Remapper.remapBuiltins(F, SrcNDRange, FusedNDRange);
@@ -262,7 +266,23 @@ createFusionCall(IRBuilderBase &Builder, Function *F,
 
   // Insert barrier if needed
   if (!IsLast && BarriersFlags > 0) {
-    TargetInfo.createBarrierCall(Builder, BarriersFlags);
+    auto *Barrier = TargetInfo.createBarrierCall(Builder, BarriersFlags);
+    // Mark the barrier, so SYCLBarrierElimination can later remove or narrow
+    // it if the stages it separates do not share data across work-items. The
+    // pass needs the number of dimensions and an upper bound of the
+    // work-group extent to reason about the work-items accessing an address.
+    const auto &Extent = FusedNDRange.hasSpecificLocalSize()
+                             ? FusedNDRange.getLocalSize()
+                             : FusedNDRange.getGlobalSize();
+    auto &C = Builder.getContext();
+    Barrier->setMetadata(
+        SYCLBarrierElimination::Key,
+        MDNode::get(
+            C, {ConstantAsMetadata::get(Builder.getInt32(BarriersFlags)),
+                ConstantAsMetadata::get(
+                    Builder.getInt32(FusedNDRange.getDimensions())),
+                ConstantAsMetadata::get(Builder.getInt64(
+                    *std::max_element(Extent.begin(), Extent.end())))}));
   }
 
   // Set insert point for future insertions
@@ -504,6 +524,16 @@ Error SYCLKernelFusion::fuseKernel(
   MDCollection.attachToFunction(FusedFunction);
   // Add metadata for reqd_work_group_size and work_group_size_hint
   attachKernelAttributeMD(LLVMCtx, FusedFunction, FusedKernelInfo);
+  // Keep target-specific kernel metadata with an identical value on each input
+  // function, e.g., a required sub-group size.
+  for (const auto &UniformKey : TargetInfo.getUniformKernelMetadataKeys()) {
+    auto *MD = InputFunctions.front().F->getMetadata(UniformKey);
+    if (MD && llvm::all_of(InputFunctions, [&](const auto &KF) {
+          return KF.F->getMetadata(UniformKey) == MD;
+        })) {
+      FusedFunction->setMetadata(UniformKey, MD);
+    }
+  }
 
   // Mark the fused function as a kernel by calling TargetFusionInfo, because
   // this is target-specific.
@@ -531,7 +561,7 @@ Error SYCLKernelFusion::fuseKernel(
     const auto BarriersEnd = InputFunctions.size() - 1;
     const auto IsHeterogeneousNDRangesList =
         hasHeterogeneousNDRangesList(InputFunctions);
-    jit_compiler::Remapper Remapper;
+    jit_compiler::Remapper Remapper{TargetInfo};
 
     Error DeferredErrs = Error::success();
     for (auto &KF : InputFunctions) {
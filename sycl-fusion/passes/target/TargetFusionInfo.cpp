@@ -8,6 +8,8 @@
 
 #include "TargetFusionInfo.h"
 
+#include "kernel-fusion/Builtins.h"
+
 #include "llvm/IR/Constants.h"
 #include "llvm/IR/InstrTypes.h"
 #include "llvm/IR/Instructions.h"
@@ -33,8 +35,20 @@ public:
 
   virtual ArrayRef<StringRef> getUniformKernelAttributes() const { return {}; }
 
-  virtual void createBarrierCall(IRBuilderBase &Builder,
-                                 int BarrierFlags) const = 0;
+  virtual ArrayRef<StringRef> getUniformKernelMetadataKeys() const {
+    return {};
+  }
+
+  virtual CallInst *createBarrierCall(IRBuilderBase &Builder,
+                                      int BarrierFlags) const = 0;
+
+  virtual CallInst *createSubGroupBarrierCall(IRBuilderBase &Builder,
+                                              int BarrierFlags) const = 0;
+
+  virtual unsigned getMaxSubGroupSize(const Function &Kernel) const = 0;
+
+  virtual std::optional<IndexSpaceQuery>
+  getIndexSpaceQuery(const CallBase *Call) const = 0;
 
   virtual unsigned getPrivateAddressSpace() const = 0;
 
@@ -45,6 +59,22 @@ public:
                              [[maybe_unused]] ArrayRef<size_t> LocalSize,
                              [[maybe_unused]] unsigned AddressSpace) const {}
 
+  virtual std::optional<jit_compiler::BuiltinKind>
+  getBuiltinKind(Function *F) const = 0;
+
+  virtual std::optional<uint32_t>
+  getBuiltinDimension([[maybe_unused]] Function *F) const {
+    return {};
+  }
+
+  virtual bool isSafeToNotRemapBuiltin(Function *F) const = 0;
+
+  virtual Value *getGlobalIDWithoutOffset(IRBuilderBase &Builder,
+                                          uint32_t Idx) const = 0;
+
+  virtual void
+  setMetadataForGeneratedFunction([[maybe_unused]] Function *F) const {}
+
 protected:
   llvm::Module *LLVMMod;
 };
@@ -124,49 +154,62 @@ public:
     }
   }
 
-  void createBarrierCall(IRBuilderBase &Builder,
-                         int BarrierFlags) const override {
-    if (BarrierFlags == -1) {
-      return;
-    }
-    assert((BarrierFlags == 1 || BarrierFlags == 2 || BarrierFlags == 3) &&
-           "Invalid barrier flags");
-
-    static const auto FnAttrs = AttributeSet::get(
-        LLVMMod->getContext(),
-        {Attribute::get(LLVMMod->getContext(), Attribute::AttrKind::Convergent),
-         Attribute::get(LLVMMod->getContext(), Attribute::AttrKind::NoUnwind)});
-
-    static constexpr StringLiteral N{"_Z22__spirv_ControlBarrierjjj"};
-
-    Function *F = LLVMMod->getFunction(N);
-    if (!F) {
-      constexpr auto Linkage = GlobalValue::LinkageTypes::ExternalLinkage;
+  CallInst *createBarrierCall(IRBuilderBase &Builder,
+                              int BarrierFlags) const override {
+    return createControlBarrier(Builder, BarrierFlags,
+                                /*Scope : Workgroup = */ 2);
+  }
 
-      auto *Ty = FunctionType::get(
-          Builder.getVoidTy(),
-          {Builder.getInt32Ty(), Builder.getInt32Ty(), Builder.getInt32Ty()},
-          false /* isVarArg*/);
+  CallInst *createSubGroupBarrierCall(IRBuilderBase &Builder,
+                                      int BarrierFlags) const override {
+    return createControlBarrier(Builder, BarrierFlags,
+                                /*Scope : Subgroup = */ 3);
+  }
 
-      F = Function::Create(Ty, Linkage, N, *LLVMMod);
+  ArrayRef<StringRef> getUniformKernelMetadataKeys() const override {
+    static SmallVector<StringRef> Keys{{"intel_reqd_sub_group_size"}};
+    return Keys;
+  }
 
-      F->setAttributes(
-          AttributeList::get(LLVMMod->getContext(), FnAttrs, {}, {}));
-      F->setCallingConv(CallingConv::SPIR_FUNC);
+  unsigned getMaxSubGroupSize(const Function &Kernel) const override {
+    // A kernel requiring a sub-group size is always launched with it.
+    if (auto *MD = Kernel.getMetadata("intel_reqd_sub_group_size")) {
+      return mdconst::extract<ConstantInt>(MD->getOperand(0))->getZExtValue();
     }
+    // Otherwise, the device chooses the sub-group size. The SPIR-V devices
+    // supported by kernel fusion use at most 32 (GPU) or 64 (CPU) work-items.
+    return 64;
+  }
 
-    // See
-    // https://registry.khronos.org/SPIR-V/specs/unified1/SPIRV.html#Memory_Semantics_-id-
-    SmallVector<Value *> Args{
-        Builder.getInt32(/*Exec Scope : Workgroup = */ 2),
-        Builder.getInt32(/*Exec Scope : Workgroup = */ 2),
-        Builder.getInt32(0x10 | (BarrierFlags % 2 == 1 ? 0x100 : 0x0) |
-                         ((BarrierFlags >> 1 == 1 ? 0x200 : 0x0)))};
-
-    auto *BarrierCallInst = Builder.CreateCall(F, Args);
-    BarrierCallInst->setAttributes(
-        AttributeList::get(LLVMMod->getContext(), FnAttrs, {}, {}));
-    BarrierCallInst->setCallingConv(CallingConv::SPIR_FUNC);
+  std::optional<IndexSpaceQuery>
+  getIndexSpaceQuery(const CallBase *Call) const override {
+    auto *F = Call->getCalledFunction();
+    if (!F) {
+      return {};
+    }
+    if (F->getName() == jit_compiler::GetSubGroupIDName) {
+      return IndexSpaceQuery{IndexSpaceQuery::SubGroupID, 0};
+    }
+    if (F->getName() == jit_compiler::GetSubGroupLocalIDName) {
+      return IndexSpaceQuery{IndexSpaceQuery::SubGroupLocalID, 0};
+    }
+    auto Kind = getBuiltinKind(F);
+    if (!Kind) {
+      return {};
+    }
+    if (*Kind != jit_compiler::BuiltinKind::GlobalIDRemapper &&
+        *Kind != jit_compiler::BuiltinKind::LocalIDRemapper) {
+      return IndexSpaceQuery{IndexSpaceQuery::WorkGroupUniform, 0};
+    }
+    // The dimension is passed as the only argument.
+    auto *Dim = dyn_cast<ConstantInt>(Call->getArgOperand(0));
+    if (!Dim || Dim->getZExtValue() > 2) {
+      return {};
+    }
+    return IndexSpaceQuery{*Kind == jit_compiler::BuiltinKind::GlobalIDRemapper
+                               ? IndexSpaceQuery::GlobalID
+                               : IndexSpaceQuery::LocalID,
+                           static_cast<uint32_t>(Dim->getZExtValue())};
   }
 
   // Corresponds to definition of spir_private and spir_local in
@@ -206,6 +249,123 @@ public:
                               MDNode::get(KernelFunc->getContext(), NewInfo));
     }
   }
+
+  std::optional<jit_compiler::BuiltinKind>
+  getBuiltinKind(Function *F) const override {
+    using jit_compiler::BuiltinKind;
+    // This array is sorted by key value
+    constexpr std::array<std::pair<StringLiteral, BuiltinKind>, 7> Map{
+        {{jit_compiler::GetGlobalSizeName, BuiltinKind::GlobalSizeRemapper},
+         {jit_compiler::GetGroupIDName, BuiltinKind::GroupIDRemapper},
+         {jit_compiler::GetGlobalOffsetName,
+          BuiltinKind::GlobalOffsetRemapper},
+         {jit_compiler::GetNumWorkGroupsName,
+          BuiltinKind::NumWorkGroupsRemapper},
+         {jit_compiler::GetLocalSizeName, BuiltinKind::LocalSizeRemapper},
+         {jit_compiler::GetLocalIDName, BuiltinKind::LocalIDRemapper},
+         {jit_compiler::GetGlobalIDName, BuiltinKind::GlobalIDRemapper}}};
+    const auto Name = F->getName();
+    const auto *Iter = llvm::lower_bound(
+        Map, Name, [](const auto &Entry, StringRef Key) {
+          return Entry.first < Key;
+        });
+    if (Iter == Map.end() || Iter->first != Name) {
+      return {};
+    }
+    return Iter->second;
+  }
+
+  bool isSafeToNotRemapBuiltin(Function *F) const override {
+    constexpr std::size_t NumUnsafeBuiltins{8};
+    // SPIRV builtins with kernel capabilities in alphabetical order.
+    //
+    // These builtins might need remapping, but are not supported by the
+    // remapper, so we should abort kernel fusion if we find them during
+    // remapping.
+    constexpr std::array<StringLiteral, NumUnsafeBuiltins> UnsafeBuiltIns{
+        "EnqueuedWorkgroupSize",
+        "NumEnqueuedSubgroups",
+        "NumSubgroups",
+        "SubgroupId",
+        "SubgroupLocalInvocationId",
+        "SubgroupMaxSize",
+        "SubgroupSize",
+        "WorkDim"};
+    constexpr StringLiteral SPIRVBuiltinNamespace{"spirv"};
+    constexpr StringLiteral SPIRVBuiltinPrefix{"BuiltIn"};
+
+    auto Name = F->getName();
+    if (!(Name.contains(SPIRVBuiltinNamespace) &&
+          Name.contains(SPIRVBuiltinPrefix))) {
+      return true;
+    }
+    // Drop "spirv" namespace name and "BuiltIn" prefix.
+    Name = Name.drop_front(Name.find(SPIRVBuiltinPrefix) +
+                           SPIRVBuiltinPrefix.size());
+    // Check that Name does not start with any name in UnsafeBuiltIns
+    const auto *Iter =
+        std::upper_bound(UnsafeBuiltIns.begin(), UnsafeBuiltIns.end(), Name);
+    return Iter == UnsafeBuiltIns.begin() || !Name.starts_with(*(Iter - 1));
+  }
+
+  Value *getGlobalIDWithoutOffset(IRBuilderBase &Builder,
+                                  uint32_t Idx) const override {
+    // ND-ranges requiring remapping must not have an offset (see
+    // isValidCombination), so the global ID can be used as is.
+    return jit_compiler::createSPIRVCall(Builder, jit_compiler::GetGlobalIDName,
+                                         Builder.getInt32(Idx));
+  }
+
+  void setMetadataForGeneratedFunction(Function *F) const override {
+    F->setCallingConv(CallingConv::SPIR_FUNC);
+  }
+
+private:
+  CallInst *createControlBarrier(IRBuilderBase &Builder, int BarrierFlags,
+                                 uint32_t Scope) const {
+    if (BarrierFlags == -1) {
+      return nullptr;
+    }
+    assert((BarrierFlags == 1 || BarrierFlags == 2 || BarrierFlags == 3) &&
+           "Invalid barrier flags");
+
+    static const auto FnAttrs = AttributeSet::get(
+        LLVMMod->getContext(),
+        {Attribute::get(LLVMMod->getContext(), Attribute::AttrKind::Convergent),
+         Attribute::get(LLVMMod->getContext(), Attribute::AttrKind::NoUnwind)});
+
+    static constexpr StringLiteral N{"_Z22__spirv_ControlBarrierjjj"};
+
+    Function *F = LLVMMod->getFunction(N);
+    if (!F) {
+      constexpr auto Linkage = GlobalValue::LinkageTypes::ExternalLinkage;
+
+      auto *Ty = FunctionType::get(
+          Builder.getVoidTy(),
+          {Builder.getInt32Ty(), Builder.getInt32Ty(), Builder.getInt32Ty()},
+          false /* isVarArg*/);
+
+      F = Function::Create(Ty, Linkage, N, *LLVMMod);
+
+      F->setAttributes(
+          AttributeList::get(LLVMMod->getContext(), FnAttrs, {}, {}));
+      F->setCallingConv(CallingConv::SPIR_FUNC);
+    }
+
+    // See
+    // https://registry.khronos.org/SPIR-V/specs/unified1/SPIRV.html#Memory_Semantics_-id-
+    SmallVector<Value *> Args{
+        Builder.getInt32(/*Exec Scope = */ Scope),
+        Builder.getInt32(/*Memory Scope = */ Scope),
+        Builder.getInt32(0x10 | (BarrierFlags % 2 == 1 ? 0x100 : 0x0) |
+                         ((BarrierFlags >> 1 == 1 ? 0x200 : 0x0)))};
+
+    auto *BarrierCallInst = Builder.CreateCall(F, Args);
+    BarrierCallInst->setAttributes(
+        AttributeList::get(LLVMMod->getContext(), FnAttrs, {}, {}));
+    BarrierCallInst->setCallingConv(CallingConv::SPIR_FUNC);
+    return BarrierCallInst;
+  }
 };
 
 //
@@ -266,21 +426,186 @@ public:
     return Keys;
   }
 
-  void createBarrierCall(IRBuilderBase &Builder,
-                         int BarrierFlags) const override {
+  CallInst *createBarrierCall(IRBuilderBase &Builder,
+                              int BarrierFlags) const override {
     if (BarrierFlags == -1) {
-      return;
+      return nullptr;
     }
     // Emit a call to llvm.nvvm.barrier0. From the user manual of the NVPTX
     // backend: "The ‘@llvm.nvvm.barrier0()’ intrinsic emits a PTX bar.sync 0
     // instruction, equivalent to the __syncthreads() call in CUDA."
-    Builder.CreateIntrinsic(Intrinsic::NVVMIntrinsics::nvvm_barrier0, {}, {});
+    return Builder.CreateIntrinsic(Intrinsic::NVVMIntrinsics::nvvm_barrier0,
+                                   {}, {});
+  }
+
+  CallInst *createSubGroupBarrierCall(IRBuilderBase &Builder,
+                                      int BarrierFlags) const override {
+    if (BarrierFlags == -1) {
+      return nullptr;
+    }
+    // Sub-groups map to warps. bar.warp.sync with a full mask synchronizes all
+    // threads of the warp and orders their memory accesses, equivalent to
+    // __syncwarp() in CUDA.
+    return Builder.CreateIntrinsic(
+        Intrinsic::NVVMIntrinsics::nvvm_bar_warp_sync, {},
+        {Builder.getInt32(~0U)});
+  }
+
+  // Sub-groups map to warps.
+  unsigned getMaxSubGroupSize(const Function &) const override { return 32; }
+
+  std::optional<IndexSpaceQuery>
+  getIndexSpaceQuery(const CallBase *Call) const override {
+    auto *F = Call->getCalledFunction();
+    if (!F) {
+      return {};
+    }
+    switch (F->getIntrinsicID()) {
+    case Intrinsic::nvvm_read_ptx_sreg_tid_x:
+      return IndexSpaceQuery{IndexSpaceQuery::LocalID, 0};
+    case Intrinsic::nvvm_read_ptx_sreg_tid_y:
+      return IndexSpaceQuery{IndexSpaceQuery::LocalID, 1};
+    case Intrinsic::nvvm_read_ptx_sreg_tid_z:
+      return IndexSpaceQuery{IndexSpaceQuery::LocalID, 2};
+    case Intrinsic::nvvm_read_ptx_sreg_ntid_x:
+    case Intrinsic::nvvm_read_ptx_sreg_ntid_y:
+    case Intrinsic::nvvm_read_ptx_sreg_ntid_z:
+    case Intrinsic::nvvm_read_ptx_sreg_ctaid_x:
+    case Intrinsic::nvvm_read_ptx_sreg_ctaid_y:
+    case Intrinsic::nvvm_read_ptx_sreg_ctaid_z:
+    case Intrinsic::nvvm_read_ptx_sreg_nctaid_x:
+    case Intrinsic::nvvm_read_ptx_sreg_nctaid_y:
+    case Intrinsic::nvvm_read_ptx_sreg_nctaid_z:
+    case Intrinsic::nvvm_read_ptx_sreg_warpsize:
+      return IndexSpaceQuery{IndexSpaceQuery::WorkGroupUniform, 0};
+    case Intrinsic::nvvm_read_ptx_sreg_laneid:
+      return IndexSpaceQuery{IndexSpaceQuery::SubGroupLocalID, 0};
+    default:
+      break;
+    }
+    auto Builtin = parseIndexSpaceBuiltin(F->getName());
+    if (!Builtin) {
+      return {};
+    }
+    if (Builtin->first != jit_compiler::BuiltinKind::GlobalIDRemapper &&
+        Builtin->first != jit_compiler::BuiltinKind::LocalIDRemapper) {
+      return IndexSpaceQuery{IndexSpaceQuery::WorkGroupUniform, 0};
+    }
+    return IndexSpaceQuery{Builtin->first ==
+                                   jit_compiler::BuiltinKind::GlobalIDRemapper
+                               ? IndexSpaceQuery::GlobalID
+                               : IndexSpaceQuery::LocalID,
+                           Builtin->second};
   }
 
   // Corresponds to the definitions in the LLVM NVPTX backend user guide:
   // https://llvm.org/docs/NVPTXUsage.html#address-spaces
   unsigned getPrivateAddressSpace() const override { return 0; }
   unsigned getLocalAddressSpace() const override { return 3; }
+
+  std::optional<jit_compiler::BuiltinKind>
+  getBuiltinKind(Function *F) const override {
+    if (auto Builtin = parseIndexSpaceBuiltin(F->getName())) {
+      return Builtin->first;
+    }
+    return {};
+  }
+
+  std::optional<uint32_t> getBuiltinDimension(Function *F) const override {
+    if (auto Builtin = parseIndexSpaceBuiltin(F->getName())) {
+      return Builtin->second;
+    }
+    return {};
+  }
+
+  bool isSafeToNotRemapBuiltin(Function *F) const override {
+    // The index space getters from libspirv are remapped as a whole. Any other
+    // read of a special register depending on the index space, i.e., on the
+    // position of the work-item or the shape of the launch, cannot be
+    // remapped. This includes the thread, block and grid IDs and sizes, but
+    // also the lane, warp and grid identifiers.
+    constexpr StringLiteral SRegPrefix{"llvm.nvvm.read.ptx.sreg."};
+    if (!F->getName().starts_with(SRegPrefix)) {
+      return true;
+    }
+    switch (F->getIntrinsicID()) {
+    case Intrinsic::nvvm_read_ptx_sreg_warpsize:
+    case Intrinsic::nvvm_read_ptx_sreg_smid:
+    case Intrinsic::nvvm_read_ptx_sreg_nsmid:
+    case Intrinsic::nvvm_read_ptx_sreg_clock:
+    case Intrinsic::nvvm_read_ptx_sreg_clock64:
+    case Intrinsic::nvvm_read_ptx_sreg_pm0:
+    case Intrinsic::nvvm_read_ptx_sreg_pm1:
+    case Intrinsic::nvvm_read_ptx_sreg_pm2:
+    case Intrinsic::nvvm_read_ptx_sreg_pm3:
+      return true;
+    default:
+      // The environment registers are set up by the driver and do not depend
+      // on the index space either.
+      return F->getName().drop_front(SRegPrefix.size()).starts_with("envreg");
+    }
+  }
+
+  Value *getGlobalIDWithoutOffset(IRBuilderBase &Builder,
+                                  uint32_t Idx) const override {
+    // global_id(x) = ctaid(x) * ntid(x) + tid(x)
+    static constexpr Intrinsic::ID TID[]{Intrinsic::nvvm_read_ptx_sreg_tid_x,
+                                         Intrinsic::nvvm_read_ptx_sreg_tid_y,
+                                         Intrinsic::nvvm_read_ptx_sreg_tid_z};
+    static constexpr Intrinsic::ID NTID[]{
+        Intrinsic::nvvm_read_ptx_sreg_ntid_x,
+        Intrinsic::nvvm_read_ptx_sreg_ntid_y,
+        Intrinsic::nvvm_read_ptx_sreg_ntid_z};
+    static constexpr Intrinsic::ID CTAID[]{
+        Intrinsic::nvvm_read_ptx_sreg_ctaid_x,
+        Intrinsic::nvvm_read_ptx_sreg_ctaid_y,
+        Intrinsic::nvvm_read_ptx_sreg_ctaid_z};
+    assert(Idx < 3 && "Invalid index");
+    const auto ReadSReg = [&](Intrinsic::ID ID) {
+      return Builder.CreateZExt(Builder.CreateIntrinsic(ID, {}, {}),
+                                Builder.getInt64Ty());
+    };
+    return Builder.CreateAdd(
+        Builder.CreateMul(ReadSReg(CTAID[Idx]), ReadSReg(NTID[Idx])),
+        ReadSReg(TID[Idx]));
+  }
+
+private:
+  ///
+  /// Parse the name of an index space getter builtin from libspirv, e.g.,
+  /// "_Z28__spirv_GlobalInvocationId_xv", into its kind and dimension.
+  static std::optional<std::pair<jit_compiler::BuiltinKind, uint32_t>>
+  parseIndexSpaceBuiltin(StringRef Name) {
+    using jit_compiler::BuiltinKind;
+    constexpr std::array<std::pair<StringLiteral, BuiltinKind>, 7> Map{
+        {{"GlobalInvocationId", BuiltinKind::GlobalIDRemapper},
+         {"GlobalOffset", BuiltinKind::GlobalOffsetRemapper},
+         {"GlobalSize", BuiltinKind::GlobalSizeRemapper},
+         {"LocalInvocationId", BuiltinKind::LocalIDRemapper},
+         {"NumWorkgroups", BuiltinKind::NumWorkGroupsRemapper},
+         {"WorkgroupId", BuiltinKind::GroupIDRemapper},
+         {"WorkgroupSize", BuiltinKind::LocalSizeRemapper}}};
+    // Drop the mangling: "_Z<length>" prefix and "v" (no arguments) suffix.
+    size_t Length;
+    if (!Name.consume_front("_Z") || Name.consumeInteger(10, Length) ||
+        Name.size() != Length + 1 || !Name.consume_back("v") ||
+        !Name.consume_front("__spirv_") || Name.size() < 2 ||
+        Name[Name.size() - 2] != '_') {
+      return {};
+    }
+    const char DimChar = Name.back();
+    if (DimChar < 'x' || DimChar > 'z') {
+      return {};
+    }
+    const auto Base = Name.drop_back(2);
+    for (const auto &Entry : Map) {
+      if (Entry.first == Base) {
+        return std::make_pair(Entry.second,
+                              static_cast<uint32_t>(DimChar - 'x'));
+      }
+    }
+    return {};
+  }
 };
 #endif // FUSION_JIT_SUPPORT_PTX
 
@@ -323,9 +648,46 @@ TargetFusionInfo::getKernelMetadataKeys() const {
   return Impl->getKernelMetadataKeys();
 }
 
-void TargetFusionInfo::createBarrierCall(IRBuilderBase &Builder,
-                                         int BarrierFlags) const {
-  Impl->createBarrierCall(Builder, BarrierFlags);
+CallInst *TargetFusionInfo::createBarrierCall(IRBuilderBase &Builder,
+                                              int BarrierFlags) const {
+  return Impl->createBarrierCall(Builder, BarrierFlags);
+}
+
+CallInst *TargetFusionInfo::createSubGroupBarrierCall(IRBuilderBase &Builder,
+                                                      int BarrierFlags) const {
+  return Impl->createSubGroupBarrierCall(Builder, BarrierFlags);
+}
+
+unsigned TargetFusionInfo::getMaxSubGroupSize(const Function &Kernel) const {
+  return Impl->getMaxSubGroupSize(Kernel);
+}
+
+std::optional<IndexSpaceQuery>
+TargetFusionInfo::getIndexSpaceQuery(const CallBase *Call) const {
+  return Impl->getIndexSpaceQuery(Call);
+}
+
+std::optional<jit_compiler::BuiltinKind>
+TargetFusionInfo::getBuiltinKind(Function *F) const {
+  return Impl->getBuiltinKind(F);
+}
+
+std::optional<uint32_t>
+TargetFusionInfo::getBuiltinDimension(Function *F) const {
+  return Impl->getBuiltinDimension(F);
+}
+
+bool TargetFusionInfo::isSafeToNotRemapBuiltin(Function *F) const {
+  return Impl->isSafeToNotRemapBuiltin(F);
+}
+
+Value *TargetFusionInfo::getGlobalIDWithoutOffset(IRBuilderBase &Builder,
+                                                  uint32_t Idx) const {
+  return Impl->getGlobalIDWithoutOffset(Builder, Idx);
+}
+
+void TargetFusionInfo::setMetadataForGeneratedFunction(Function *F) const {
+  Impl->setMetadataForGeneratedFunction(F);
 }
 
 unsigned TargetFusionInfo::getPrivateAddressSpace() const {
@@ -347,6 +709,11 @@ TargetFusionInfo::getUniformKernelAttributes() const {
   return Impl->getUniformKernelAttributes();
 }
 
+llvm::ArrayRef<llvm::StringRef>
+TargetFusionInfo::getUniformKernelMetadataKeys() const {
+  return Impl->getUniformKernelMetadataKeys();
+}
+
 //
 // MetadataCollection
 //
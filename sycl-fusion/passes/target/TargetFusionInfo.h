@@ -13,10 +13,39 @@
 #include "llvm/IR/IRBuilder.h"
 #include "llvm/IR/Module.h"
 
+#include <optional>
+
+namespace jit_compiler {
+enum class BuiltinKind : uint8_t;
+} // namespace jit_compiler
+
 namespace llvm {
 
 class TargetFusionInfoImpl;
 
+///
+/// Classification of a builtin call querying the index space from the
+/// perspective of the work-items of a single work-group.
+struct IndexSpaceQuery {
+  enum Kind : uint8_t {
+    /// Same value for all work-items of a work-group, e.g., the group ID.
+    WorkGroupUniform,
+    /// The local ID in dimension Dim.
+    LocalID,
+    /// The global ID in dimension Dim. It only differs from the local ID by a
+    /// work-group uniform value, which is not exposed to the caller, so both
+    /// must not be treated as the same value.
+    GlobalID,
+    /// The ID of the work-item's sub-group in the work-group.
+    SubGroupID,
+    /// The ID of the work-item in its sub-group.
+    SubGroupLocalID
+  };
+
+  Kind K;
+  uint32_t Dim;
+};
+
 ///
 /// Common interface to target-specific logic around handling of kernel
 /// functions.
@@ -55,7 +84,31 @@ public:
   /// kernel.
   llvm::ArrayRef<llvm::StringRef> getUniformKernelAttributes() const;
 
-  void createBarrierCall(IRBuilderBase &Builder, int BarrierFlags) const;
+  ///
+  /// Get the target-specific list of kernel function metadata that should be
+  /// attached to the fused kernel if it is identical on all input kernels.
+  llvm::ArrayRef<llvm::StringRef> getUniformKernelMetadataKeys() const;
+
+  ///
+  /// Create a work-group barrier ordering the memory operations specified by
+  /// \p BarrierFlags. Returns nullptr if no barrier is required.
+  CallInst *createBarrierCall(IRBuilderBase &Builder, int BarrierFlags) const;
+
+  ///
+  /// Create a barrier with the same semantics as the barrier created by
+  /// createBarrierCall, but only synchronizing the work-items of a sub-group.
+  CallInst *createSubGroupBarrierCall(IRBuilderBase &Builder,
+                                      int BarrierFlags) const;
+
+  ///
+  /// Upper bound of the number of work-items in a sub-group of \p Kernel.
+  unsigned getMaxSubGroupSize(const Function &Kernel) const;
+
+  ///
+  /// Classify \p Call if it queries the index space, e.g., the global ID of
+  /// the work-item.
+  std::optional<IndexSpaceQuery>
+  getIndexSpaceQuery(const CallBase *Call) const;
 
   unsigned getPrivateAddressSpace() const;
 
@@ -65,6 +118,32 @@ public:
                                   ArrayRef<size_t> LocalSize,
                                   unsigned AddressSpace) const;
 
+  ///
+  /// Get the kind of \p F if it is an index space getter builtin that needs to
+  /// be remapped when fusing kernels with heterogeneous ND-ranges.
+  std::optional<jit_compiler::BuiltinKind> getBuiltinKind(Function *F) const;
+
+  ///
+  /// Get the dimension queried by the index space getter builtin \p F, if the
+  /// target uses a separate builtin for each dimension. Otherwise, the
+  /// dimension is passed as the only argument to the builtin.
+  std::optional<uint32_t> getBuiltinDimension(Function *F) const;
+
+  ///
+  /// Check whether the declaration \p F, which is not an index space getter
+  /// builtin, can be called unchanged from a kernel with remapped ND-range.
+  bool isSafeToNotRemapBuiltin(Function *F) const;
+
+  ///
+  /// Get the global ID of the current work-item in the (mirrored) dimension
+  /// \p Idx of the fused kernel as a 64-bit integer.
+  Value *getGlobalIDWithoutOffset(IRBuilderBase &Builder, uint32_t Idx) const;
+
+  ///
+  /// Set target-specific attributes, e.g., the calling convention, on a
+  /// helper function \p F generated during fusion.
+  void setMetadataForGeneratedFunction(Function *F) const;
+
 private:
   using ImplPtr = std::shared_ptr<TargetFusionInfoImpl>;
 
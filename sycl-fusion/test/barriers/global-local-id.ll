@@ -0,0 +1,58 @@
+; RUN: opt -load-pass-plugin %shlibdir/SYCLKernelFusion%shlibext \
+; RUN: -passes=sycl-barrier-elimination -S %s | FileCheck %s
+
+; Check that accesses indexed by the global ID and by the local ID are not
+; considered the same access. With a nonzero global offset, both differ even
+; if the kernel is launched with a single work-group.
+
+target datalayout = "e-i64:64-v16:16-v24:32-v32:32-v48:64-v96:128-v192:256-v256:256-v512:512-v1024:1024-n8:16:32:64"
+target triple = "spir64-unknown-unknown"
+
+declare spir_func i64 @_Z33__spirv_BuiltInGlobalInvocationIdi(i32)
+declare spir_func i64 @_Z32__spirv_BuiltInLocalInvocationIdi(i32)
+declare spir_func void @_Z22__spirv_ControlBarrierjjj(i32, i32, i32)
+
+; The second stage reads the elements written by other work-items.
+
+; CHECK-LABEL: define spir_kernel void @global_then_local(
+; CHECK: store float 1.000000e+00
+; CHECK-NEXT: call spir_func void @_Z22__spirv_ControlBarrierjjj(i32 2, i32 2, i32 784)
+; CHECK: load float
+define spir_kernel void @global_then_local(ptr addrspace(1) noalias %A,
+                                           ptr addrspace(1) noalias %B) {
+entry:
+  %gid = call spir_func i64 @_Z33__spirv_BuiltInGlobalInvocationIdi(i32 0)
+  %a.gid = getelementptr inbounds float, ptr addrspace(1) %A, i64 %gid
+  store float 1.000000e+00, ptr addrspace(1) %a.gid
+  call spir_func void @_Z22__spirv_ControlBarrierjjj(i32 2, i32 2, i32 784), !sycl.kernel.fusion.barrier !0
+  %lid = call spir_func i64 @_Z32__spirv_BuiltInLocalInvocationIdi(i32 0)
+  %a.lid = getelementptr inbounds float, ptr addrspace(1) %A, i64 %lid
+  %val = load float, ptr addrspace(1) %a.lid
+  %gid2 = call spir_func i64 @_Z33__spirv_BuiltInGlobalInvocationIdi(i32 0)
+  %b.gid = getelementptr inbounds float, ptr addrspace(1) %B, i64 %gid2
+  store float %val, ptr addrspace(1) %b.gid
+  ret void
+}
+
+; Each work-item only reads the element it wrote itself.
+
+; CHECK-LABEL: define spir_kernel void @global_then_global(
+; CHECK: store float 1.000000e+00
+; CHECK-NOT: __spirv_ControlBarrier
+; CHECK: ret void
+define spir_kernel void @global_then_global(ptr addrspace(1) noalias %A,
+                                            ptr addrspace(1) noalias %B) {
+entry:
+  %gid = call spir_func i64 @_Z33__spirv_BuiltInGlobalInvocationIdi(i32 0)
+  %a.gid = getelementptr inbounds float, ptr addrspace(1) %A, i64 %gid
+  store float 1.000000e+00, ptr addrspace(1) %a.gid
+  call spir_func void @_Z22__spirv_ControlBarrierjjj(i32 2, i32 2, i32 784), !sycl.kernel.fusion.barrier !0
+  %gid2 = call spir_func i64 @_Z33__spirv_BuiltInGlobalInvocationIdi(i32 0)
+  %a.gid2 = getelementptr inbounds float, ptr addrspace(1) %A, i64 %gid2
+  %val = load float, ptr addrspace(1) %a.gid2
+  %b.gid = getelementptr inbounds float, ptr addrspace(1) %B, i64 %gid2
+  store float %val, ptr addrspace(1) %b.gid
+  ret void
+}
+
+!0 = !{i32 1, i32 1, i64 64}
@@ -0,0 +1,98 @@
+; RUN: opt -load-pass-plugin %shlibdir/SYCLKernelFusion%shlibext \
+; RUN: -passes=sycl-barrier-elimination -S %s | FileCheck %s
+
+; Check the bound of the sub-group size used to prove that the accesses of a
+; sub-group stay within a window of its own. Each sub-group writes elements
+; [sg_id * N, sg_id * N + size) and reads elements [sg_id * N + 1,
+; sg_id * N + size], so the windows do not overlap if N > size. Without a
+; required sub-group size, SPIR-V devices may use up to 64 work-items.
+
+target datalayout = "e-i64:64-v16:16-v24:32-v32:32-v48:64-v96:128-v192:256-v256:256-v512:512-v1024:1024-n8:16:32:64"
+target triple = "spir64-unknown-unknown"
+
+declare spir_func i32 @_Z25__spirv_BuiltInSubgroupIdv()
+declare spir_func i32 @_Z40__spirv_BuiltInSubgroupLocalInvocationIdv()
+declare spir_func void @_Z22__spirv_ControlBarrierjjj(i32, i32, i32)
+
+; N = 65 exceeds the largest sub-group size.
+
+; CHECK-LABEL: define spir_kernel void @default_size_narrowed(
+; CHECK: store i32 1
+; CHECK-NEXT: call spir_func void @_Z22__spirv_ControlBarrierjjj(i32 3, i32 3, i32 784)
+; CHECK-NOT: __spirv_ControlBarrier
+; CHECK: ret void
+define spir_kernel void @default_size_narrowed(ptr addrspace(1) noalias %A,
+                                               ptr addrspace(1) noalias %B) {
+entry:
+  %sg = call spir_func i32 @_Z25__spirv_BuiltInSubgroupIdv()
+  %sg.ext = zext i32 %sg to i64
+  %sgl = call spir_func i32 @_Z40__spirv_BuiltInSubgroupLocalInvocationIdv()
+  %sgl.ext = zext i32 %sgl to i64
+  %base = mul i64 %sg.ext, 65
+  %idx = add i64 %base, %sgl.ext
+  %a.idx = getelementptr inbounds i32, ptr addrspace(1) %A, i64 %idx
+  store i32 1, ptr addrspace(1) %a.idx
+  call spir_func void @_Z22__spirv_ControlBarrierjjj(i32 2, i32 2, i32 784), !sycl.kernel.fusion.barrier !0
+  %next = add i64 %idx, 1
+  %a.next = getelementptr inbounds i32, ptr addrspace(1) %A, i64 %next
+  %val = load i32, ptr addrspace(1) %a.next
+  %b.idx = getelementptr inbounds i32, ptr addrspace(1) %B, i64 %idx
+  store i32 %val, ptr addrspace(1) %b.idx
+  ret void
+}
+
+; N = 33 is only enough for sub-groups of up to 32 work-items.
+
+; CHECK-LABEL: define spir_kernel void @default_size_kept(
+; CHECK: store i32 1
+; CHECK-NEXT: call spir_func void @_Z22__spirv_ControlBarrierjjj(i32 2, i32 2, i32 784)
+define spir_kernel void @default_size_kept(ptr addrspace(1) noalias %A,
+                                           ptr addrspace(1) noalias %B) {
+entry:
+  %sg = call spir_func i32 @_Z25__spirv_BuiltInSubgroupIdv()
+  %sg.ext = zext i32 %sg to i64
+  %sgl = call spir_func i32 @_Z40__spirv_BuiltInSubgroupLocalInvocationIdv()
+  %sgl.ext = zext i32 %sgl to i64
+  %base = mul i64 %sg.ext, 33
+  %idx = add i64 %base, %sgl.ext
+  %a.idx = getelementptr inbounds i32, ptr addrspace(1) %A, i64 %idx
+  store i32 1, ptr addrspace(1) %a.idx
+  call spir_func void @_Z22__spirv_ControlBarrierjjj(i32 2, i32 2, i32 784), !sycl.kernel.fusion.barrier !0
+  %next = add i64 %idx, 1
+  %a.next = getelementptr inbounds i32, ptr addrspace(1) %A, i64 %next
+  %val = load i32, ptr addrspace(1) %a.next
+  %b.idx = getelementptr inbounds i32, ptr addrspace(1) %B, i64 %idx
+  store i32 %val, ptr addrspace(1) %b.idx
+  ret void
+}
+
+; With a required sub-group size of 32, N = 33 is enough.
+
+; CHECK-LABEL: define spir_kernel void @reqd_size_narrowed(
+; CHECK: store i32 1
+; CHECK-NEXT: call spir_func void @_Z22__spirv_ControlBarrierjjj(i32 3, i32 3, i32 784)
+; CHECK-NOT: __spirv_ControlBarrier
+; CHECK: ret void
+define spir_kernel void @reqd_size_narrowed(ptr addrspace(1) noalias %A,
+                                            ptr addrspace(1) noalias %B)
+    !intel_reqd_sub_group_size !1 {
+entry:
+  %sg = call spir_func i32 @_Z25__spirv_BuiltInSubgroupIdv()
+  %sg.ext = zext i32 %sg to i64
+  %sgl = call spir_func i32 @_Z40__spirv_BuiltInSubgroupLocalInvocationIdv()
+  %sgl.ext = zext i32 %sgl to i64
+  %base = mul i64 %sg.ext, 33
+  %idx = add i64 %base, %sgl.ext
+  %a.idx = getelementptr inbounds i32, ptr addrspace(1) %A, i64 %idx
+  store i32 1, ptr addrspace(1) %a.idx
+  call spir_func void @_Z22__spirv_ControlBarrierjjj(i32 2, i32 2, i32 784), !sycl.kernel.fusion.barrier !0
+  %next = add i64 %idx, 1
+  %a.next = getelementptr inbounds i32, ptr addrspace(1) %A, i64 %next
+  %val = load i32, ptr addrspace(1) %a.next
+  %b.idx = getelementptr inbounds i32, ptr addrspace(1) %B, i64 %idx
+  store i32 %val, ptr addrspace(1) %b.idx
+  ret void
+}
+
+!0 = !{i32 3, i32 1, i64 256}
+!1 = !{i32 32}
@@ -0,0 +1,50 @@
+; RUN: opt -load-pass-plugin %shlibdir/SYCLKernelFusion%shlibext \
+; RUN: -sycl-info-path %S/kernel-info.yaml \
+; RUN: -passes=sycl-internalization -S %s | FileCheck %s
+
+; Check the promotion of USM pointers indexed by GEP instructions. Indices are
+; remapped in units of the promoted element type, so a pointer is only promoted
+; if all GEPs on it index elements of the same size, e.g., not if some of them
+; compute byte offsets.
+
+target datalayout = "e-i64:64-v16:16-v24:32-v32:32-v48:64-v96:128-v192:256-v256:256-v512:512-v1024:1024-n8:16:32:64"
+target triple = "spir64-unknown-unknown"
+
+; %Bytes is indexed both in bytes and in elements and stays in global memory.
+; %Elems is promoted to local memory, with its index remapped to the local size.
+; %Floats is indexed with a different element type of the same size and is
+; promoted to private memory, which removes the argument.
+
+; CHECK-LABEL: define spir_kernel void @fused_0(
+; CHECK-SAME: ptr addrspace(1) %Bytes, ptr addrspace(3) %Elems, i64 %Idx)
+; CHECK-NOT: !sycl.kernel.promote
+; CHECK: entry:
+; CHECK: %[[ALLOCA:[0-9A-Za-z]+]] = alloca [1 x {{i32|float}}], align 4
+; CHECK: %[[PRIV:[0-9A-Za-z]+]] = getelementptr inbounds [1 x {{i32|float}}], ptr %[[ALLOCA]], i64 0, i64 0
+; CHECK: %[[BYTE:[0-9A-Za-z]+]] = getelementptr inbounds i8, ptr addrspace(1) %Bytes, i64 4
+; CHECK: %[[ELEM:[0-9A-Za-z]+]] = getelementptr inbounds i32, ptr addrspace(1) %Bytes, i64 %Idx
+; CHECK: %[[REM:[0-9A-Za-z]+]] = urem i64 %Idx, 16
+; CHECK: getelementptr inbounds i32, ptr addrspace(3) %Elems, i64 %[[REM]]
+; CHECK: getelementptr inbounds float, ptr %[[PRIV]], i64 0
+; CHECK: getelementptr inbounds i32, ptr %[[PRIV]], i64 0
+define spir_kernel void @fused_0(ptr addrspace(1) %Bytes,
+                                 ptr addrspace(1) %Elems,
+                                 ptr addrspace(1) %Floats, i64 %Idx)
+    !sycl.kernel.promote !0 !sycl.kernel.promote.localsize !1 {
+entry:
+  %B = getelementptr inbounds i8, ptr addrspace(1) %Bytes, i64 4
+  %V = load i32, ptr addrspace(1) %B
+  %E = getelementptr inbounds i32, ptr addrspace(1) %Bytes, i64 %Idx
+  store i32 %V, ptr addrspace(1) %E
+  %L = getelementptr inbounds i32, ptr addrspace(1) %Elems, i64 %Idx
+  store i32 %V, ptr addrspace(1) %L
+  %F = getelementptr inbounds float, ptr addrspace(1) %Floats, i64 %Idx
+  store float 1.0, ptr addrspace(1) %F
+  %I = getelementptr inbounds i32, ptr addrspace(1) %Floats, i64 %Idx
+  %W = load i32, ptr addrspace(1) %I
+  store i32 %W, ptr addrspace(1) %L
+  ret void
+}
+
+!0 = !{!"local", !"local", !"private", !"none"}
+!1 = !{i64 16, i64 16, i64 1, !""}
@@ -0,0 +1,86 @@
+; REQUIRES: cuda
+; RUN: opt -load-pass-plugin %shlibdir/SYCLKernelFusion%shlibext \
+; RUN: -sycl-info-path %S/ptx-kernel-info.yaml \
+; RUN: -passes=sycl-kernel-fusion -S %s | FileCheck %s
+
+; Check that direct reads of the NVPTX special registers abort the fusion of
+; kernels with heterogeneous ND-ranges if they depend on the index space, as
+; they cannot be remapped, and are left unchanged otherwise.
+
+target datalayout = "e-i64:64-i128:128-v16:16-v32:32-n16:32:64"
+target triple = "nvptx64-nvidia-cuda"
+
+declare i32 @llvm.nvvm.read.ptx.sreg.tid.x()
+declare i32 @llvm.nvvm.read.ptx.sreg.warpsize()
+
+define weak_odr hidden i64 @_Z28__spirv_GlobalInvocationId_xv() {
+entry:
+  %tid = call i32 @llvm.nvvm.read.ptx.sreg.tid.x()
+  %res = zext i32 %tid to i64
+  ret i64 %res
+}
+
+define void @KernelThree(ptr addrspace(1) %A) {
+entry:
+  %ws = call i32 @llvm.nvvm.read.ptx.sreg.warpsize()
+  store i32 %ws, ptr addrspace(1) %A
+  ret void
+}
+
+define void @KernelFour(ptr addrspace(1) %B) {
+entry:
+  %gid = call i64 @_Z28__spirv_GlobalInvocationId_xv()
+  %ptr = getelementptr inbounds i64, ptr addrspace(1) %B, i64 %gid
+  store i64 %gid, ptr addrspace(1) %ptr
+  ret void
+}
+
+define void @KernelFive(ptr addrspace(1) %A) {
+entry:
+  store i32 0, ptr addrspace(1) %A
+  ret void
+}
+
+define void @KernelSix(ptr addrspace(1) %B) {
+entry:
+  %tid = call i32 @llvm.nvvm.read.ptx.sreg.tid.x()
+  %ptr = getelementptr inbounds i32, ptr addrspace(1) %B, i32 %tid
+  store i32 %tid, ptr addrspace(1) %ptr
+  ret void
+}
+
+declare !sycl.kernel.fused !13 !sycl.kernel.nd-ranges !15 !sycl.kernel.nd-range !16 void @fused_kernel_ok()
+
+declare !sycl.kernel.fused !17 !sycl.kernel.nd-ranges !15 !sycl.kernel.nd-range !16 void @fused_kernel_sreg()
+
+; The warp size does not depend on the index space, while the libspirv getter
+; called by KernelFour, which reads the thread ID, is replaced as a whole.
+
+; CHECK-LABEL: define {{.*}}void @fused_ok(
+; CHECK: call i32 @llvm.nvvm.read.ptx.sreg.warpsize()
+; CHECK: call i64 @__global_id_remapper_1_48_1_1_0_0_0_2_8_8_1_0_0_0__Z28__spirv_GlobalInvocationId_xv()
+; CHECK: ret void
+
+; KernelSix reads the thread ID directly, so no fused kernel is created.
+
+; CHECK-NOT: define {{.*}}@fused_sreg
+; CHECK: !nvvm.annotations = !{![[ANNOTATION:.*]]}
+; CHECK: ![[ANNOTATION]] = !{ptr @fused_ok, !"kernel", i32 1}
+
+!nvvm.annotations = !{!10, !11, !30, !31}
+
+!10 = !{ptr @KernelThree, !"kernel", i32 1}
+!11 = !{ptr @KernelFour, !"kernel", i32 1}
+!13 = !{!"fused_ok", !14}
+!14 = !{!"KernelThree", !"KernelFour"}
+!15 = !{!20, !21}
+!16 = !{i32 2, !22, !23, !23}
+!17 = !{!"fused_sreg", !18}
+!18 = !{!"KernelFive", !"KernelSix"}
+!20 = !{i32 2, !22, !23, !23}
+!21 = !{i32 1, !24, !23, !23}
+!22 = !{i64 8, i64 8, i64 1}
+!23 = !{i64 0, i64 0, i64 0}
+!24 = !{i64 48, i64 1, i64 1}
+!30 = !{ptr @KernelFive, !"kernel", i32 1}
+!31 = !{ptr @KernelSix, !"kernel", i32 1}
@@ -0,0 +1,147 @@
+; REQUIRES: cuda
+; RUN: opt -load-pass-plugin %shlibdir/SYCLKernelFusion%shlibext \
+; RUN: -sycl-info-path %S/ptx-kernel-info.yaml \
+; RUN: -passes=sycl-kernel-fusion -S %s | FileCheck %s
+
+; Check the remapping of the index space getters from libspirv when fusing
+; kernels with heterogeneous ND-ranges for the NVPTX target.
+; KernelOne is launched on a 2D range of 8x8 work-items, KernelTwo on a 1D
+; range of 48 work-items. The fused kernel is launched on the 8x8 range, so
+; KernelTwo is guarded and its getters are replaced by remappers computing the
+; values from the fused kernel's global linear ID.
+
+target datalayout = "e-i64:64-i128:128-v16:16-v32:32-n16:32:64"
+target triple = "nvptx64-nvidia-cuda"
+
+declare i32 @llvm.nvvm.read.ptx.sreg.tid.x()
+declare i32 @llvm.nvvm.read.ptx.sreg.ntid.x()
+declare i32 @llvm.nvvm.read.ptx.sreg.ctaid.x()
+declare i32 @llvm.nvvm.read.ptx.sreg.nctaid.x()
+declare i32 @llvm.nvvm.read.ptx.sreg.ntid.y()
+declare i32 @llvm.nvvm.read.ptx.sreg.nctaid.y()
+
+define weak_odr hidden i64 @_Z28__spirv_GlobalInvocationId_xv() {
+entry:
+  %ctaid = call i32 @llvm.nvvm.read.ptx.sreg.ctaid.x()
+  %ntid = call i32 @llvm.nvvm.read.ptx.sreg.ntid.x()
+  %tid = call i32 @llvm.nvvm.read.ptx.sreg.tid.x()
+  %mul = mul i32 %ctaid, %ntid
+  %add = add i32 %mul, %tid
+  %res = zext i32 %add to i64
+  ret i64 %res
+}
+
+define weak_odr hidden i64 @_Z20__spirv_GlobalSize_xv() {
+entry:
+  %nctaid = call i32 @llvm.nvvm.read.ptx.sreg.nctaid.x()
+  %ntid = call i32 @llvm.nvvm.read.ptx.sreg.ntid.x()
+  %mul = mul i32 %nctaid, %ntid
+  %res = zext i32 %mul to i64
+  ret i64 %res
+}
+
+define weak_odr hidden i64 @_Z20__spirv_GlobalSize_yv() {
+entry:
+  %nctaid = call i32 @llvm.nvvm.read.ptx.sreg.nctaid.y()
+  %ntid = call i32 @llvm.nvvm.read.ptx.sreg.ntid.y()
+  %mul = mul i32 %nctaid, %ntid
+  %res = zext i32 %mul to i64
+  ret i64 %res
+}
+
+define void @KernelOne(ptr addrspace(1) %A) {
+entry:
+  %gid = call i64 @_Z28__spirv_GlobalInvocationId_xv()
+  %ptr = getelementptr inbounds i64, ptr addrspace(1) %A, i64 %gid
+  store i64 %gid, ptr addrspace(1) %ptr
+  ret void
+}
+
+define void @KernelTwo(ptr addrspace(1) %B) {
+entry:
+  %gid = call i64 @_Z28__spirv_GlobalInvocationId_xv()
+  %gsx = call i64 @_Z20__spirv_GlobalSize_xv()
+  %gsy = call i64 @_Z20__spirv_GlobalSize_yv()
+  %gs = mul i64 %gsx, %gsy
+  %ptr = getelementptr inbounds i64, ptr addrspace(1) %B, i64 %gid
+  store i64 %gs, ptr addrspace(1) %ptr
+  ret void
+}
+
+declare !sycl.kernel.fused !13 !sycl.kernel.nd-ranges !15 !sycl.kernel.nd-range !16 void @fused_kernel()
+
+; KernelOne runs on the fused ND-range, so it keeps calling the original
+; getter. KernelTwo is guarded by its number of work-items and calls the
+; remappers.
+
+; CHECK-LABEL: define {{.*}}void @fused_0(
+; CHECK-SAME: ptr addrspace(1) %KernelOne_A, ptr addrspace(1) %KernelTwo_B)
+; CHECK-NEXT: entry:
+; CHECK-NEXT: %[[GID0:.*]] = call i64 @_Z28__spirv_GlobalInvocationId_xv()
+; CHECK: store i64 %[[GID0]]
+; CHECK: call void @llvm.nvvm.barrier0()
+; CHECK: %[[LINEAR:.*]] = call i64 @__global_linear_id_2_8_8_1_0_0_0()
+; CHECK-NEXT: %[[COND:.*]] = icmp ult i64 %[[LINEAR]], 48
+; CHECK-NEXT: br i1 %[[COND]], label %[[CALL:[0-9]+]], label %[[EXIT:[0-9]+]]
+; CHECK: [[CALL]]:
+; CHECK-NEXT: %[[GID1:.*]] = call i64 @__global_id_remapper_1_48_1_1_0_0_0_2_8_8_1_0_0_0__Z28__spirv_GlobalInvocationId_xv()
+; CHECK-NEXT: %[[GSX:.*]] = call i64 @__global_size_remapper_1_48_1_1_0_0_0_2_8_8_1_0_0_0__Z20__spirv_GlobalSize_xv()
+; CHECK-NEXT: %[[GSY:.*]] = call i64 @__global_size_remapper_1_48_1_1_0_0_0_2_8_8_1_0_0_0__Z20__spirv_GlobalSize_yv()
+; CHECK: br label %[[EXIT]]
+; CHECK: [[EXIT]]:
+; CHECK-NEXT: ret void
+
+; The global linear ID is computed from the special registers of the fused
+; ND-range: global_id(1) + global_id(0) * global_size(1), with the dimensions
+; mirrored, as the x register holds the rightmost SYCL dimension.
+
+; CHECK-LABEL: define internal i64 @__global_linear_id_2_8_8_1_0_0_0(
+; CHECK-DAG: call i32 @llvm.nvvm.read.ptx.sreg.ctaid.x()
+; CHECK-DAG: call i32 @llvm.nvvm.read.ptx.sreg.ntid.x()
+; CHECK-DAG: call i32 @llvm.nvvm.read.ptx.sreg.tid.x()
+; CHECK-DAG: call i32 @llvm.nvvm.read.ptx.sreg.ctaid.y()
+; CHECK-DAG: call i32 @llvm.nvvm.read.ptx.sreg.ntid.y()
+; CHECK-DAG: call i32 @llvm.nvvm.read.ptx.sreg.tid.y()
+; CHECK: %[[SCALED:.*]] = mul i64 %{{.*}}, 8
+; CHECK-NEXT: %[[RES:.*]] = add i64 %{{.*}}, %[[SCALED]]
+; CHECK-NEXT: ret i64 %[[RES]]
+
+; The global ID of the 1D range is the linear ID of the fused range.
+
+; CHECK-LABEL: define internal i64 @__global_id_remapper_1_48_1_1_0_0_0_2_8_8_1_0_0_0__Z28__spirv_GlobalInvocationId_xv(
+; CHECK-NEXT: entry:
+; CHECK-NEXT: %[[LINEAR:.*]] = call i64 @__global_linear_id_2_8_8_1_0_0_0()
+; CHECK-NEXT: %[[RES:.*]] = udiv i64 %[[LINEAR]], 1
+; CHECK-NEXT: ret i64 %[[RES]]
+
+; The global size is the one of the original ND-range, and 1 for dimensions it
+; does not have.
+
+; CHECK-LABEL: define internal i64 @__global_size_remapper_1_48_1_1_0_0_0_2_8_8_1_0_0_0__Z20__spirv_GlobalSize_xv(
+; CHECK-NEXT: entry:
+; CHECK-NEXT: ret i64 48
+
+; CHECK-LABEL: define internal i64 @__global_size_remapper_1_48_1_1_0_0_0_2_8_8_1_0_0_0__Z20__spirv_GlobalSize_yv(
+; CHECK-NEXT: entry:
+; CHECK-NEXT: ret i64 1
+
+; The input kernels are removed and the fused kernel is annotated instead.
+
+; CHECK-NOT: define {{.*}}@KernelOne
+; CHECK-NOT: define {{.*}}@KernelTwo
+; CHECK: !nvvm.annotations = !{![[ANNOTATION:.*]]}
+; CHECK: ![[ANNOTATION]] = !{ptr @fused_0, !"kernel", i32 1}
+
+!nvvm.annotations = !{!10, !11}
+
+!10 = !{ptr @KernelOne, !"kernel", i32 1}
+!11 = !{ptr @KernelTwo, !"kernel", i32 1}
+!13 = !{!"fused_0", !14}
+!14 = !{!"KernelOne", !"KernelTwo"}
+!15 = !{!17, !18}
+!16 = !{i32 2, !19, !20, !20}
+!17 = !{i32 2, !19, !20, !20}
+!18 = !{i32 1, !21, !20, !20}
+!19 = !{i64 8, i64 8, i64 1}
+!20 = !{i64 0, i64 0, i64 0}
+!21 = !{i64 48, i64 1, i64 1}
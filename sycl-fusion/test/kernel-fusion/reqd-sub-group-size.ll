@@ -0,0 +1,57 @@
+; RUN: opt -load-pass-plugin %shlibdir/SYCLKernelFusion%shlibext \
+; RUN: -sycl-info-path %S/spirv-kernel-info.yaml \
+; RUN: -passes=sycl-kernel-fusion -S %s | FileCheck %s
+
+; Check that the fused kernel keeps the required sub-group size of the input
+; kernels if they all require the same one.
+
+target datalayout = "e-i64:64-v16:16-v24:32-v32:32-v48:64-v96:128-v192:256-v256:256-v512:512-v1024:1024-n8:16:32:64"
+target triple = "spir64-unknown-unknown"
+
+define spir_kernel void @KernelA(ptr addrspace(1) %A) !intel_reqd_sub_group_size !1 {
+entry:
+  store i32 0, ptr addrspace(1) %A
+  ret void
+}
+
+define spir_kernel void @KernelB(ptr addrspace(1) %B) !intel_reqd_sub_group_size !1 {
+entry:
+  store i32 1, ptr addrspace(1) %B
+  ret void
+}
+
+define spir_kernel void @KernelC(ptr addrspace(1) %C) !intel_reqd_sub_group_size !1 {
+entry:
+  store i32 2, ptr addrspace(1) %C
+  ret void
+}
+
+define spir_kernel void @KernelD(ptr addrspace(1) %D) !intel_reqd_sub_group_size !2 {
+entry:
+  store i32 3, ptr addrspace(1) %D
+  ret void
+}
+
+declare !sycl.kernel.fused !10 !sycl.kernel.nd-ranges !12 !sycl.kernel.nd-range !13 spir_kernel void @fused_kernel_same()
+
+declare !sycl.kernel.fused !20 !sycl.kernel.nd-ranges !12 !sycl.kernel.nd-range !13 spir_kernel void @fused_kernel_different()
+
+; CHECK-LABEL: define spir_kernel void @fused_same(
+; CHECK-SAME: !intel_reqd_sub_group_size ![[SG16:[0-9]+]]
+
+; CHECK-LABEL: define spir_kernel void @fused_different(
+; CHECK-NOT: !intel_reqd_sub_group_size
+; CHECK: ret void
+
+; CHECK: ![[SG16]] = !{i32 16}
+
+!1 = !{i32 16}
+!2 = !{i32 32}
+!10 = !{!"fused_same", !11}
+!11 = !{!"KernelA", !"KernelB"}
+!12 = !{!13, !13}
+!13 = !{i32 1, !14, !15, !15}
+!14 = !{i64 64, i64 1, i64 1}
+!15 = !{i64 0, i64 0, i64 0}
+!20 = !{!"fused_different", !21}
+!21 = !{!"KernelC", !"KernelD"}
@@ -0,0 +1,35 @@
+# -*- Python -*-
+
+import os
+
+import lit.formats
+
+from lit.llvm import llvm_config
+
+# Configuration file for the 'lit' test runner.
+
+# name: The name of this test suite.
+config.name = "SYCL-FUSION"
+
+# testFormat: The test format to use to interpret tests.
+config.test_format = lit.formats.ShTest(not llvm_config.use_lit_shell)
+
+# suffixes: A list of file extensions to treat as test files.
+config.suffixes = [".ll"]
+
+# test_source_root: The root path where tests are located.
+config.test_source_root = os.path.dirname(__file__)
+
+# test_exec_root: The root path where tests should be run.
+config.test_exec_root = config.sycl_fusion_obj_root
+
+llvm_config.use_default_substitutions()
+
+llvm_config.add_tool_substitutions(["opt"], config.llvm_tools_dir)
+
+config.substitutions.append(("%shlibext", config.llvm_shlib_ext))
+config.substitutions.append(("%shlibdir", config.llvm_shlib_dir))
+
+# The NVPTX specific parts of the passes are only built with the NVPTX target.
+if "NVPTX" in config.llvm_targets_to_build.split(";"):
+    config.available_features.add("cuda")
@@ -0,0 +1,139 @@
+//==------- JITContextTest.cpp - Unit tests for the fused kernel cache -----==//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#include "JITContext.h"
+#include "gtest/gtest.h"
+
+using namespace jit_compiler;
+
+static CacheKeyT makeKey(const std::string &KernelName) {
+  return CacheKeyT{{KernelName}, {}, -1, {}, {}, std::nullopt};
+}
+
+// Compile a fake kernel, i.e., add a binary of Size bytes to the context.
+static SYCLKernelInfo makeKernel(JITContext &Ctx, const std::string &Name,
+                                 size_t Size) {
+  KernelBinary &Binary =
+      Ctx.emplaceKernelBinary(std::string(Size, 'x'), BinaryFormat::SPIRV);
+  SYCLKernelBinaryInfo BinInfo;
+  BinInfo.Format = BinaryFormat::SPIRV;
+  BinInfo.AddressBits = 64;
+  BinInfo.BinaryStart = Binary.address();
+  BinInfo.BinarySize = Binary.size();
+  return SYCLKernelInfo{Name, {}, {}, BinInfo};
+}
+
+TEST(JITContext, HitsAndMisses) {
+  JITContext Ctx;
+  CacheKeyT Key = makeKey("A");
+  EXPECT_FALSE(Ctx.getCacheEntry(Key));
+
+  SYCLKernelInfo Kernel = makeKernel(Ctx, "fused_A", 10);
+  Ctx.addCacheEntry(Key, Kernel);
+  auto Cached = Ctx.getCacheEntry(Key);
+  ASSERT_TRUE(Cached);
+  EXPECT_EQ(Cached->Name, "fused_A");
+  EXPECT_EQ(Cached->BinaryInfo.BinaryStart, Kernel.BinaryInfo.BinaryStart);
+  CacheKeyT OtherKey = makeKey("B");
+  EXPECT_FALSE(Ctx.getCacheEntry(OtherKey));
+
+  CacheStatistics Stats = Ctx.getCacheStatistics();
+  EXPECT_EQ(Stats.Hits, 1u);
+  EXPECT_EQ(Stats.Misses, 2u);
+  EXPECT_EQ(Stats.Evictions, 0u);
+  EXPECT_EQ(Stats.NumEntries, 1u);
+  EXPECT_EQ(Stats.SizeInBytes, 10u);
+}
+
+TEST(JITContext, EvictLeastRecentlyUsed) {
+  JITContext Ctx;
+  CacheKeyT KeyA = makeKey("A");
+  CacheKeyT KeyB = makeKey("B");
+  CacheKeyT KeyC = makeKey("C");
+  SYCLKernelInfo A = makeKernel(Ctx, "fused_A", 10);
+  SYCLKernelInfo B = makeKernel(Ctx, "fused_B", 10);
+  SYCLKernelInfo C = makeKernel(Ctx, "fused_C", 10);
+  Ctx.addCacheEntry(KeyA, A, /*MaxCacheSize*/ 25);
+  Ctx.addCacheEntry(KeyB, B, /*MaxCacheSize*/ 25);
+  // Use A, so that B becomes the least-recently used entry.
+  EXPECT_TRUE(Ctx.getCacheEntry(KeyA));
+  Ctx.addCacheEntry(KeyC, C, /*MaxCacheSize*/ 25);
+
+  EXPECT_TRUE(Ctx.getCacheEntry(KeyA));
+  EXPECT_FALSE(Ctx.getCacheEntry(KeyB));
+  EXPECT_TRUE(Ctx.getCacheEntry(KeyC));
+  // The context released the binary of the evicted entry only.
+  EXPECT_TRUE(Ctx.getKernelBinary(A.BinaryInfo.BinaryStart));
+  EXPECT_FALSE(Ctx.getKernelBinary(B.BinaryInfo.BinaryStart));
+  EXPECT_TRUE(Ctx.getKernelBinary(C.BinaryInfo.BinaryStart));
+
+  CacheStatistics Stats = Ctx.getCacheStatistics();
+  EXPECT_EQ(Stats.Hits, 3u);
+  EXPECT_EQ(Stats.Misses, 1u);
+  EXPECT_EQ(Stats.Evictions, 1u);
+  EXPECT_EQ(Stats.NumEntries, 2u);
+  EXPECT_EQ(Stats.SizeInBytes, 20u);
+}
+
+TEST(JITContext, KeepNewEntry) {
+  JITContext Ctx;
+  CacheKeyT KeyA = makeKey("A");
+  CacheKeyT KeyB = makeKey("B");
+  SYCLKernelInfo A = makeKernel(Ctx, "fused_A", 10);
+  SYCLKernelInfo B = makeKernel(Ctx, "fused_B", 30);
+  Ctx.addCacheEntry(KeyA, A, /*MaxCacheSize*/ 20);
+  // The new entry exceeds the bound on its own, but it is never evicted.
+  Ctx.addCacheEntry(KeyB, B, /*MaxCacheSize*/ 20);
+
+  EXPECT_FALSE(Ctx.getCacheEntry(KeyA));
+  EXPECT_TRUE(Ctx.getCacheEntry(KeyB));
+  CacheStatistics Stats = Ctx.getCacheStatistics();
+  EXPECT_EQ(Stats.Evictions, 1u);
+  EXPECT_EQ(Stats.NumEntries, 1u);
+  EXPECT_EQ(Stats.SizeInBytes, 30u);
+}
+
+TEST(JITContext, EvictedBinaryOutlivesEntry) {
+  JITContext Ctx;
+  CacheKeyT KeyA = makeKey("A");
+  CacheKeyT KeyB = makeKey("B");
+  SYCLKernelInfo A = makeKernel(Ctx, "fused_A", 10);
+  SYCLKernelInfo B = makeKernel(Ctx, "fused_B", 10);
+  // Hold on to the binary of A, like the runtime does after registering it.
+  std::shared_ptr<KernelBinary> Registered =
+      Ctx.getKernelBinary(A.BinaryInfo.BinaryStart);
+  Ctx.addCacheEntry(KeyA, A, /*MaxCacheSize*/ 10);
+  Ctx.addCacheEntry(KeyB, B, /*MaxCacheSize*/ 10);
+
+  EXPECT_FALSE(Ctx.getCacheEntry(KeyA));
+  EXPECT_FALSE(Ctx.getKernelBinary(A.BinaryInfo.BinaryStart));
+  ASSERT_TRUE(Registered);
+  EXPECT_EQ(Registered.use_count(), 1);
+  EXPECT_EQ(Registered->address(), A.BinaryInfo.BinaryStart);
+  EXPECT_EQ(Registered->size(), 10u);
+}
+
+TEST(JITContext, DuplicateEntryReleasesBinary) {
+  JITContext Ctx;
+  CacheKeyT Key = makeKey("A");
+  SYCLKernelInfo First = makeKernel(Ctx, "fused_A", 10);
+  SYCLKernelInfo Second = makeKernel(Ctx, "fused_A", 10);
+  Ctx.addCacheEntry(Key, First);
+  // Adding the same fusion again, e.g., after a concurrent compilation, keeps
+  // the cached kernel and drops the new binary.
+  Ctx.addCacheEntry(Key, Second);
+
+  auto Cached = Ctx.getCacheEntry(Key);
+  ASSERT_TRUE(Cached);
+  EXPECT_EQ(Cached->BinaryInfo.BinaryStart, First.BinaryInfo.BinaryStart);
+  EXPECT_TRUE(Ctx.getKernelBinary(First.BinaryInfo.BinaryStart));
+  EXPECT_FALSE(Ctx.getKernelBinary(Second.BinaryInfo.BinaryStart));
+  CacheStatistics Stats = Ctx.getCacheStatistics();
+  EXPECT_EQ(Stats.NumEntries, 1u);
+  EXPECT_EQ(Stats.SizeInBytes, 10u);
+}
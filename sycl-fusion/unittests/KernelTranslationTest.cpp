@@ -0,0 +1,181 @@
+//==--- KernelTranslationTest.cpp - Unit tests for loading input kernels ---==//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#include "translation/KernelTranslation.h"
+#include "llvm/AsmParser/Parser.h"
+#include "llvm/Bitcode/BitcodeWriter.h"
+#include "llvm/IR/InstIterator.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/Support/SourceMgr.h"
+#include "llvm/Testing/Support/Error.h"
+#include "gtest/gtest.h"
+
+using namespace jit_compiler;
+using namespace jit_compiler::translation;
+using namespace llvm;
+
+// Compile a fake device image, i.e., add the bitcode of the module in IR to
+// the context.
+static KernelBinary &makeBitcodeBinary(JITContext &Ctx, const char *IR) {
+  LLVMContext C;
+  SMDiagnostic Err;
+  std::unique_ptr<Module> Mod = parseAssemblyString(IR, Err, C);
+  if (!Mod) {
+    Err.print("KernelTranslationTest", errs());
+  }
+  EXPECT_TRUE(Mod);
+  std::string Bitcode;
+  raw_string_ostream OS{Bitcode};
+  if (Mod) {
+    WriteBitcodeToFile(*Mod, OS);
+  }
+  OS.flush();
+  return Ctx.emplaceKernelBinary(std::move(Bitcode), BinaryFormat::LLVM);
+}
+
+static SYCLKernelInfo makeKernel(const std::string &Name,
+                                 KernelBinary &Binary) {
+  SYCLKernelBinaryInfo BinInfo;
+  BinInfo.Format = BinaryFormat::LLVM;
+  BinInfo.BinaryStart = Binary.address();
+  BinInfo.BinarySize = Binary.size();
+  return SYCLKernelInfo{Name, {}, {}, BinInfo};
+}
+
+static bool hasCallTo(Function &F, StringRef Name) {
+  for (const Instruction &I : instructions(F)) {
+    const auto *Call = dyn_cast<CallInst>(&I);
+    const Function *Callee = Call ? Call->getCalledFunction() : nullptr;
+    if (Callee && Callee->getName() == Name) {
+      return true;
+    }
+  }
+  return false;
+}
+
+TEST(KernelTranslation, MaterializeReachableFunctions) {
+  JITContext Ctx;
+  KernelBinary &Binary = makeBitcodeBinary(Ctx, R"(
+    target triple = "spir64-unknown-unknown"
+
+    @Table = internal addrspace(1) constant [1 x ptr] [ptr @fromTable]
+
+    define internal spir_func void @fromTable() {
+      ret void
+    }
+
+    define internal spir_func void @helper() {
+      ret void
+    }
+
+    define internal spir_func void @otherHelper() {
+      ret void
+    }
+
+    define spir_kernel void @KernelA() {
+      call spir_func void @helper()
+      ret void
+    }
+
+    define spir_kernel void @KernelB() {
+      call spir_func void @helper()
+      ret void
+    }
+
+    define spir_kernel void @Unfused() {
+      call spir_func void @otherHelper()
+      ret void
+    }
+  )");
+  std::vector<SYCLKernelInfo> Kernels{makeKernel("KernelA", Binary),
+                                      makeKernel("KernelB", Binary)};
+  LLVMContext C;
+  auto ModOrErr = KernelTranslator::loadKernels(C, Kernels);
+  ASSERT_THAT_EXPECTED(ModOrErr, Succeeded());
+  Module &Mod = **ModOrErr;
+
+  // The fused kernels, their callees and the functions referenced by global
+  // variables are materialized.
+  for (StringRef Name : {"KernelA", "KernelB", "helper", "fromTable"}) {
+    Function *F = Mod.getFunction(Name);
+    ASSERT_NE(F, nullptr) << Name.str();
+    EXPECT_FALSE(F->isDeclaration()) << Name.str();
+  }
+  // The other kernels and the functions only they call are never loaded.
+  EXPECT_EQ(Mod.getFunction("Unfused"), nullptr);
+  EXPECT_EQ(Mod.getFunction("otherHelper"), nullptr);
+  EXPECT_EQ(Kernels[0].BinaryInfo.AddressBits, 64u);
+}
+
+TEST(KernelTranslation, LowerBuiltinVariables) {
+  JITContext Ctx;
+  KernelBinary &Binary = makeBitcodeBinary(Ctx, R"(
+    target triple = "spir64-unknown-unknown"
+
+    @__spirv_BuiltInGlobalInvocationId =
+        external addrspace(1) constant <3 x i64>
+    @__spirv_BuiltInSubgroupLocalInvocationId =
+        external addrspace(1) constant i32
+
+    define spir_kernel void @Kernel(ptr addrspace(1) %Out) {
+      %Ids = load <3 x i64>, ptr addrspace(4) addrspacecast (
+          ptr addrspace(1) @__spirv_BuiltInGlobalInvocationId
+          to ptr addrspace(4))
+      %X = extractelement <3 x i64> %Ids, i64 0
+      %YPtr = getelementptr inbounds i8,
+          ptr addrspace(1) @__spirv_BuiltInGlobalInvocationId, i64 8
+      %Y = load i64, ptr addrspace(1) %YPtr
+      %Lane = load i32,
+          ptr addrspace(1) @__spirv_BuiltInSubgroupLocalInvocationId
+      %LaneExt = zext i32 %Lane to i64
+      %Sum = add i64 %X, %Y
+      %Res = add i64 %Sum, %LaneExt
+      store i64 %Res, ptr addrspace(1) %Out
+      ret void
+    }
+  )");
+  std::vector<SYCLKernelInfo> Kernels{makeKernel("Kernel", Binary)};
+  LLVMContext C;
+  auto ModOrErr = KernelTranslator::loadKernels(C, Kernels);
+  ASSERT_THAT_EXPECTED(ModOrErr, Succeeded());
+  Module &Mod = **ModOrErr;
+
+  // The loads are replaced with calls, like in modules translated from SPIR-V.
+  EXPECT_EQ(Mod.getNamedGlobal("__spirv_BuiltInGlobalInvocationId"), nullptr);
+  EXPECT_EQ(Mod.getNamedGlobal("__spirv_BuiltInSubgroupLocalInvocationId"),
+            nullptr);
+  Function *Kernel = Mod.getFunction("Kernel");
+  ASSERT_NE(Kernel, nullptr);
+  EXPECT_TRUE(hasCallTo(*Kernel, "_Z33__spirv_BuiltInGlobalInvocationIdi"));
+  EXPECT_TRUE(
+      hasCallTo(*Kernel, "_Z40__spirv_BuiltInSubgroupLocalInvocationIdv"));
+  for (const Instruction &I : instructions(*Kernel)) {
+    EXPECT_FALSE(isa<LoadInst>(I));
+  }
+}
+
+TEST(KernelTranslation, UnsupportedBuiltinVariableUse) {
+  JITContext Ctx;
+  KernelBinary &Binary = makeBitcodeBinary(Ctx, R"(
+    target triple = "spir64-unknown-unknown"
+
+    @__spirv_BuiltInGlobalInvocationId =
+        external addrspace(1) constant <3 x i64>
+
+    declare spir_func void @escape(ptr addrspace(1))
+
+    define spir_kernel void @Kernel() {
+      call spir_func void @escape(
+          ptr addrspace(1) @__spirv_BuiltInGlobalInvocationId)
+      ret void
+    }
+  )");
+  std::vector<SYCLKernelInfo> Kernels{makeKernel("Kernel", Binary)};
+  LLVMContext C;
+  EXPECT_THAT_EXPECTED(KernelTranslator::loadKernels(C, Kernels), Failed());
+}
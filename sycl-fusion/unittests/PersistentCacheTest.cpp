@@ -0,0 +1,186 @@
+//==--- PersistentCacheTest.cpp - Unit tests for the on-disk kernel cache --==//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#include "cache/PersistentCache.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Testing/Support/Error.h"
+#include "llvm/Testing/Support/SupportHelpers.h"
+#include "gtest/gtest.h"
+
+#include <chrono>
+
+using namespace jit_compiler;
+using namespace jit_compiler::cache;
+using namespace llvm;
+
+static CacheKeyT makeKey(const std::string &KernelName) {
+  return CacheKeyT{{KernelName}, {}, -1, {}, {}, std::nullopt};
+}
+
+// Compile a fake kernel, i.e., add a binary with the given contents to the
+// context.
+static SYCLKernelInfo makeKernel(JITContext &Ctx, const std::string &Name,
+                                 const std::string &Contents) {
+  KernelBinary &Binary =
+      Ctx.emplaceKernelBinary(std::string(Contents), BinaryFormat::SPIRV);
+  SYCLArgumentDescriptor Args;
+  Args.Kinds = {ParameterKind::Pointer, ParameterKind::StdLayout};
+  Args.UsageMask = {ArgUsage::Used, ArgUsage::Unused};
+  SYCLKernelBinaryInfo BinInfo;
+  BinInfo.Format = BinaryFormat::SPIRV;
+  BinInfo.AddressBits = 64;
+  BinInfo.BinaryStart = Binary.address();
+  BinInfo.BinarySize = Binary.size();
+  return SYCLKernelInfo{Name, Args, {}, BinInfo};
+}
+
+static std::string getKey(const SYCLKernelInfo &Kernel,
+                          BinaryFormat Format = BinaryFormat::SPIRV) {
+  return PersistentCache::computeKey(makeKey(Kernel.Name), Format, {Kernel});
+}
+
+static std::string getEntryPath(const unittest::TempDir &Dir, StringRef Key) {
+  return Dir.path(("llvmcache-" + Key).str()).str().str();
+}
+
+static std::string readFile(StringRef Path) {
+  ErrorOr<std::unique_ptr<MemoryBuffer>> MB = MemoryBuffer::getFile(Path);
+  EXPECT_TRUE(bool(MB));
+  return MB ? (*MB)->getBuffer().str() : std::string{};
+}
+
+static void writeFile(StringRef Path, StringRef Contents) {
+  std::error_code EC;
+  raw_fd_ostream OS{Path, EC};
+  ASSERT_FALSE(EC);
+  OS << Contents;
+}
+
+TEST(PersistentCache, RoundTrip) {
+  unittest::TempDir Dir{"fusion-cache", /*Unique*/ true};
+  JITContext StoreCtx;
+  SYCLKernelInfo Kernel = makeKernel(StoreCtx, "fused_A", "binary A");
+  std::string Key = getKey(Kernel);
+  ASSERT_THAT_ERROR(PersistentCache::store(Dir.path(), Key, Kernel),
+                    Succeeded());
+
+  // Look the entry up from another context, like a subsequent process does.
+  JITContext LookupCtx;
+  auto Cached = PersistentCache::lookup(Dir.path(), Key, LookupCtx);
+  ASSERT_TRUE(Cached);
+  EXPECT_EQ(Cached->Name, "fused_A");
+  EXPECT_EQ(Cached->Args.Kinds, Kernel.Args.Kinds);
+  EXPECT_EQ(Cached->Args.UsageMask, Kernel.Args.UsageMask);
+  EXPECT_EQ(Cached->BinaryInfo.Format, BinaryFormat::SPIRV);
+  EXPECT_EQ(Cached->BinaryInfo.AddressBits, 64u);
+  // The binary is owned by the context it was looked up from.
+  auto Binary = LookupCtx.getKernelBinary(Cached->BinaryInfo.BinaryStart);
+  ASSERT_TRUE(Binary);
+  EXPECT_EQ(Cached->BinaryInfo.BinarySize, Binary->size());
+  EXPECT_EQ(StringRef(reinterpret_cast<const char *>(Binary->address()),
+                      Binary->size()),
+            "binary A");
+}
+
+TEST(PersistentCache, KeyMismatch) {
+  unittest::TempDir Dir{"fusion-cache", /*Unique*/ true};
+  JITContext Ctx;
+  SYCLKernelInfo A = makeKernel(Ctx, "fused_A", "binary A");
+  SYCLKernelInfo B = makeKernel(Ctx, "fused_B", "binary A");
+  SYCLKernelInfo OtherBinary = makeKernel(Ctx, "fused_A", "binary B");
+  std::string Key = getKey(A);
+  EXPECT_EQ(Key, getKey(makeKernel(Ctx, "fused_A", "binary A")));
+  // The key depends on the kernels, on their code and on the output format.
+  EXPECT_NE(Key, getKey(B));
+  EXPECT_NE(Key, getKey(OtherBinary));
+  EXPECT_NE(Key, getKey(A, BinaryFormat::PTX));
+
+  ASSERT_THAT_ERROR(PersistentCache::store(Dir.path(), Key, A), Succeeded());
+  EXPECT_FALSE(PersistentCache::lookup(Dir.path(), getKey(OtherBinary), Ctx));
+  EXPECT_TRUE(PersistentCache::lookup(Dir.path(), Key, Ctx));
+}
+
+TEST(PersistentCache, RejectCorruptEntries) {
+  unittest::TempDir Dir{"fusion-cache", /*Unique*/ true};
+  JITContext Ctx;
+  SYCLKernelInfo Kernel = makeKernel(Ctx, "fused_A", "binary A");
+  std::string Key = getKey(Kernel);
+  std::string Path = getEntryPath(Dir, Key);
+  ASSERT_THAT_ERROR(PersistentCache::store(Dir.path(), Key, Kernel),
+                    Succeeded());
+  std::string Entry = readFile(Path);
+  ASSERT_TRUE(PersistentCache::lookup(Dir.path(), Key, Ctx));
+
+  // Truncated binary.
+  writeFile(Path, StringRef(Entry).drop_back());
+  EXPECT_FALSE(PersistentCache::lookup(Dir.path(), Key, Ctx));
+  // Truncated before the size of the kernel information.
+  writeFile(Path, StringRef(Entry).take_front(4));
+  EXPECT_FALSE(PersistentCache::lookup(Dir.path(), Key, Ctx));
+  // Trailing data after the binary.
+  writeFile(Path, Entry + "x");
+  EXPECT_FALSE(PersistentCache::lookup(Dir.path(), Key, Ctx));
+  // Entry of another version of the cache layout.
+  std::string OtherMagic = Entry;
+  OtherMagic[0] = '?';
+  writeFile(Path, OtherMagic);
+  EXPECT_FALSE(PersistentCache::lookup(Dir.path(), Key, Ctx));
+  // Malformed kernel information, the magic is followed by a 64-bit size.
+  std::string BadInfo = Entry;
+  size_t InfoStart = BadInfo.find("KernelName");
+  ASSERT_NE(InfoStart, std::string::npos);
+  BadInfo.replace(InfoStart, 10, "[[[[[[[[[[");
+  writeFile(Path, BadInfo);
+  EXPECT_FALSE(PersistentCache::lookup(Dir.path(), Key, Ctx));
+
+  // The intact entry is still accepted.
+  writeFile(Path, Entry);
+  EXPECT_TRUE(PersistentCache::lookup(Dir.path(), Key, Ctx));
+}
+
+TEST(PersistentCache, PruneBySize) {
+  unittest::TempDir Dir{"fusion-cache", /*Unique*/ true};
+  JITContext Ctx;
+  std::vector<std::string> Paths;
+  uint64_t EntrySize = 0;
+  auto Now = std::chrono::system_clock::now();
+  for (int I = 0; I < 3; ++I) {
+    std::string Name = "fused_" + std::to_string(I);
+    SYCLKernelInfo Kernel = makeKernel(Ctx, Name, std::string(100, 'x'));
+    std::string Key = getKey(Kernel);
+    ASSERT_THAT_ERROR(PersistentCache::store(Dir.path(), Key, Kernel),
+                      Succeeded());
+    Paths.push_back(getEntryPath(Dir, Key));
+    // Entries are evicted in order of their last access, make the first one
+    // the least recently used.
+    int FD;
+    ASSERT_FALSE(sys::fs::openFileForWrite(Paths.back(), FD,
+                                           sys::fs::CD_OpenExisting,
+                                           sys::fs::OF_Append));
+    auto Time = Now - std::chrono::hours(3 - I);
+    EXPECT_FALSE(sys::fs::setLastAccessAndModificationTime(FD, Time, Time));
+    sys::fs::closeFile(FD);
+    uint64_t Size;
+    ASSERT_FALSE(sys::fs::file_size(Paths.back(), Size));
+    EntrySize = std::max(EntrySize, Size);
+  }
+
+  // Without a policy, nothing is pruned.
+  ASSERT_THAT_ERROR(PersistentCache::prune(Dir.path(), ""), Succeeded());
+  EXPECT_TRUE(sys::fs::exists(Paths[0]));
+  EXPECT_THAT_ERROR(PersistentCache::prune(Dir.path(), "cache_size_bytes=x"),
+                    Failed());
+
+  // Room for two entries.
+  std::string Policy = "cache_size_bytes=" + std::to_string(2 * EntrySize);
+  ASSERT_THAT_ERROR(PersistentCache::prune(Dir.path(), Policy), Succeeded());
+  EXPECT_FALSE(sys::fs::exists(Paths[0]));
+  EXPECT_TRUE(sys::fs::exists(Paths[1]));
+  EXPECT_TRUE(sys::fs::exists(Paths[2]));
+}
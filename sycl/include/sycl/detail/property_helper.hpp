@@ -43,13 +43,17 @@ enum DataLessPropKind {
   QueuePriorityNormal = 16,
   QueuePriorityLow = 17,
   QueuePriorityHigh = 18,
+  FusionBackgroundJIT = 19,
+  FusionAuto = 20,
   // Indicates the last known dataless property.
-  LastKnownDataLessPropKind = 18,
+  LastKnownDataLessPropKind = 20,
   // Exceeding 32 may cause ABI breaking change on some of OSes.
   DataLessPropKindSize = 32
 };
 
-// List of all properties with data IDs
+// List of all properties with data IDs. New kinds are appended, so existing
+// kinds keep their values. PropWithDataKindSize is only used as an inline bound
+// by get_property and is not part of the library ABI.
 enum PropWithDataKind {
   BufferUseMutex = 0,
   BufferContextBound = 1,
@@ -58,7 +62,8 @@ enum PropWithDataKind {
   BufferMemChannel = 4,
   AccPropBufferLocation = 5,
   QueueComputeIndex = 6,
-  PropWithDataKindSize = 7,
+  FusionPromoteUSM = 7,
+  PropWithDataKindSize = 8,
 };
 
 // Base class for dataless properties, needed to check that the type of an
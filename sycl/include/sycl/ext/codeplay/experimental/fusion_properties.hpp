@@ -12,6 +12,10 @@
 #include <sycl/detail/property_helper.hpp>
 #include <sycl/properties/property_traits.hpp>
 
+#include <cstddef>
+#include <utility>
+#include <vector>
+
 namespace sycl {
 __SYCL_INLINE_VER_NAMESPACE(_V1) {
 namespace ext::codeplay::experimental::property {
@@ -26,8 +30,49 @@ class no_barriers : public detail::DataLessProperty<detail::FusionNoBarrier> {};
 
 class force_fusion : public detail::DataLessProperty<detail::FusionForce> {};
 
+class background_jit
+    : public detail::DataLessProperty<detail::FusionBackgroundJIT> {};
+
+///
+/// Request promotion of USM allocations to private or local memory in the
+/// fused kernel.
+///
+/// By passing this property to complete_fusion(), the user asserts that the
+/// listed allocations only hold intermediate results of the fused kernels,
+/// i.e., their contents are neither read after the fused kernel, nor written
+/// before the first kernel in the fusion. Promotion is only performed for
+/// kernel arguments pointing to the start of a listed allocation.
+class promote_usm : public detail::PropertyWithData<detail::FusionPromoteUSM> {
+public:
+  enum class target { private_memory, local_memory };
+
+  struct allocation {
+    const void *ptr;
+    size_t num_elements;
+    size_t element_size;
+    target promotion;
+  };
+
+  template <typename T>
+  promote_usm(const T *ptr, size_t num_elements,
+              target promotion = target::private_memory)
+      : MAllocations{{ptr, num_elements, sizeof(T), promotion}} {}
+
+  promote_usm(std::vector<allocation> allocations)
+      : MAllocations(std::move(allocations)) {}
+
+  const std::vector<allocation> &get_allocations() const {
+    return MAllocations;
+  }
+
+private:
+  std::vector<allocation> MAllocations;
+};
+
 namespace queue {
 class enable_fusion : public detail::DataLessProperty<detail::FusionEnable> {};
+
+class auto_fusion : public detail::DataLessProperty<detail::FusionAuto> {};
 } // namespace queue
 
 } // namespace ext::codeplay::experimental::property
@@ -60,10 +105,22 @@ template <>
 struct is_property<ext::codeplay::experimental::property::force_fusion>
     : std::true_type {};
 
+template <>
+struct is_property<ext::codeplay::experimental::property::background_jit>
+    : std::true_type {};
+
+template <>
+struct is_property<ext::codeplay::experimental::property::promote_usm>
+    : std::true_type {};
+
 template <>
 struct is_property<ext::codeplay::experimental::property::queue::enable_fusion>
     : std::true_type {};
 
+template <>
+struct is_property<ext::codeplay::experimental::property::queue::auto_fusion>
+    : std::true_type {};
+
 // Buffer property trait specializations
 template <typename T, int Dimensions, typename AllocatorT>
 struct is_property_of<ext::codeplay::experimental::property::promote_private,
@@ -98,5 +155,9 @@ struct is_property_of<
     ext::codeplay::experimental::property::queue::enable_fusion, queue>
     : std::true_type {};
 
+template <>
+struct is_property_of<ext::codeplay::experimental::property::queue::auto_fusion,
+                      queue> : std::true_type {};
+
 } // __SYCL_INLINE_VER_NAMESPACE(_V1)
 } // namespace sycl
@@ -83,6 +83,11 @@ public:
   /// The wrapped queue is not in "fusion mode" anymore after this calls
   /// returns, until the next start_fusion().
   ///
+  /// If the background_jit property is passed and no fused kernel for this
+  /// fusion is available yet, the kernels are submitted without fusion right
+  /// away and the fused kernel is JIT-compiled on a background thread. Later
+  /// identical fusions use the fused kernel once it is ready.
+  ///
   /// @param properties Properties to take into account when performing fusion.
   event complete_fusion(const property_list &propList = {});
 
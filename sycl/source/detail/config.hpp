@@ -20,7 +20,9 @@
 #include <cstdlib>
 #include <mutex>
 #include <string>
+#include <unordered_map>
 #include <utility>
+#include <vector>
 
 namespace sycl {
 __SYCL_INLINE_VER_NAMESPACE(_V1) {
@@ -607,6 +609,115 @@ private:
   }
 };
 
+// Maximum accumulated size in bytes of the fused kernel binaries held by the
+// in-memory fusion cache. Zero disables eviction.
+template <> class SYCLConfig<SYCL_FUSION_CACHE_MAX_SIZE> {
+  using BaseT = SYCLConfigBase<SYCL_FUSION_CACHE_MAX_SIZE>;
+
+public:
+  static size_t get() {
+    constexpr size_t DefaultValue = 64 * 1024 * 1024;
+
+    const char *ValStr = getCachedValue();
+
+    if (!ValStr)
+      return DefaultValue;
+
+    // std::stoull accepts negative numbers and trailing characters.
+    std::string Val{ValStr};
+    size_t End = 0;
+    try {
+      if (Val.find('-') == std::string::npos) {
+        size_t Result = std::stoull(Val, &End);
+        if (End == Val.size())
+          return Result;
+      }
+    } catch (...) {
+    }
+    throw INVALID_CONFIG_EXCEPTION(BaseT,
+                                   "Value \"" + Val + "\" must be a number");
+  }
+
+  static void reset() { (void)getCachedValue(/*ResetCache=*/true); }
+
+  static const char *getName() { return BaseT::MConfigName; }
+
+private:
+  static const char *getCachedValue(bool ResetCache = false) {
+    static const char *ValStr = BaseT::getRawValue();
+    if (ResetCache)
+      ValStr = BaseT::getRawValue();
+    return ValStr;
+  }
+};
+
+// Kernels to JIT-specialize on the values of their scalar arguments. The value
+// is a semicolon-separated list of entries "<kernel name>[:<arg>,<arg>,...]",
+// where the optional argument indices select the arguments to specialize on.
+// Without indices, the kernel is specialized on all its scalar arguments.
+template <> class SYCLConfig<SYCL_JIT_SPECIALIZE_KERNELS> {
+  using BaseT = SYCLConfigBase<SYCL_JIT_SPECIALIZE_KERNELS>;
+
+public:
+  // Maps kernel names to the selected argument indices. An empty list selects
+  // all scalar arguments.
+  using ParsedValue = std::unordered_map<std::string, std::vector<size_t>>;
+
+  static const ParsedValue &get() { return getCachedValue(); }
+
+  static void reset() { (void)getCachedValue(/*ResetCache=*/true); }
+
+  static const char *getName() { return BaseT::MConfigName; }
+
+private:
+  static ParsedValue parseValue() {
+    ParsedValue Result;
+    const char *ValueRaw = BaseT::getRawValue();
+    if (!ValueRaw)
+      return Result;
+
+    std::string ValueStr{ValueRaw};
+    size_t Start = 0;
+    while (Start < ValueStr.size()) {
+      size_t End = ValueStr.find(';', Start);
+      if (End == std::string::npos)
+        End = ValueStr.size();
+      std::string Entry = ValueStr.substr(Start, End - Start);
+      Start = End + 1;
+      if (Entry.empty())
+        continue;
+
+      size_t Colon = Entry.find(':');
+      std::vector<size_t> &Indices = Result[Entry.substr(0, Colon)];
+      if (Colon == std::string::npos)
+        continue;
+      std::string IndicesStr = Entry.substr(Colon + 1);
+      size_t IdxStart = 0;
+      while (IdxStart < IndicesStr.size()) {
+        size_t IdxEnd = IndicesStr.find(',', IdxStart);
+        if (IdxEnd == std::string::npos)
+          IdxEnd = IndicesStr.size();
+        std::string IdxStr = IndicesStr.substr(IdxStart, IdxEnd - IdxStart);
+        IdxStart = IdxEnd + 1;
+        try {
+          Indices.push_back(std::stoull(IdxStr));
+        } catch (...) {
+          throw INVALID_CONFIG_EXCEPTION(
+              BaseT, "Argument index \"" + IdxStr + "\" must be a number");
+        }
+      }
+    }
+    return Result;
+  }
+
+  static const ParsedValue &getCachedValue(bool ResetCache = false) {
+    static ParsedValue Val = parseValue();
+    if (ResetCache)
+      Val = parseValue();
+    return Val;
+  }
+};
+
 #undef INVALID_CONFIG_EXCEPTION
 
 } // namespace detail
@@ -215,6 +215,7 @@ public:
   const PropertyRange &getKernelParamOptInfo() const {
     return KernelParamOptInfo;
   }
+  const PropertyRange &getKernelArgPacking() const { return KernelArgPacking; }
   const PropertyRange &getAssertUsed() const { return AssertUsed; }
   const PropertyRange &getProgramMetadata() const { return ProgramMetadata; }
   const PropertyRange &getExportedSymbols() const { return ExportedSymbols; }
@@ -223,6 +224,7 @@ public:
     return DeviceRequirements;
   }
   const PropertyRange &getHostPipes() const { return HostPipes; }
+  const PropertyRange &getFusionBitcode() const { return FusionBitcode; }
 
   std::uintptr_t getImageID() const {
     assert(Bin && "Image ID is not available without a binary image.");
@@ -241,12 +243,14 @@ protected:
   RTDeviceBinaryImage::PropertyRange SpecConstDefaultValuesMap;
   RTDeviceBinaryImage::PropertyRange DeviceLibReqMask;
   RTDeviceBinaryImage::PropertyRange KernelParamOptInfo;
+  RTDeviceBinaryImage::PropertyRange KernelArgPacking;
   RTDeviceBinaryImage::PropertyRange AssertUsed;
   RTDeviceBinaryImage::PropertyRange ProgramMetadata;
   RTDeviceBinaryImage::PropertyRange ExportedSymbols;
   RTDeviceBinaryImage::PropertyRange DeviceGlobals;
   RTDeviceBinaryImage::PropertyRange DeviceRequirements;
   RTDeviceBinaryImage::PropertyRange HostPipes;
+  RTDeviceBinaryImage::PropertyRange FusionBitcode;
 };
 
 // Dynamically allocated device binary image, which de-allocates its binary
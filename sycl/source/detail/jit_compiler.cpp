@@ -12,19 +12,29 @@
 #include <detail/jit_compiler.hpp>
 #include <detail/kernel_bundle_impl.hpp>
 #include <detail/kernel_impl.hpp>
+#include <detail/persistent_device_code_cache.hpp>
 #include <detail/queue_impl.hpp>
 #include <detail/sycl_mem_obj_t.hpp>
+#include <detail/thread_pool.hpp>
 #include <sycl/detail/pi.hpp>
 #include <sycl/ext/codeplay/experimental/fusion_properties.hpp>
 #include <sycl/kernel_bundle.hpp>
 
+#include <atomic>
+
 namespace sycl {
 __SYCL_INLINE_VER_NAMESPACE(_V1) {
 namespace detail {
 
 jit_compiler::jit_compiler() : MJITContext{new ::jit_compiler::JITContext{}} {}
 
-jit_compiler::~jit_compiler() = default;
+jit_compiler::~jit_compiler() {
+  // Wait for a running background compilation before destroying the state it
+  // refers to.
+  if (MBackgroundJITPool) {
+    MBackgroundJITPool->finishAndWait();
+  }
+}
 
 static ::jit_compiler::BinaryFormat
 translateBinaryImageFormat(pi::PiDeviceBinaryType Type) {
@@ -148,7 +158,14 @@ struct PromotionInformation {
   std::vector<bool> UsedParams;
 };
 
-using PromotionMap = std::unordered_map<SYCLMemObjI *, PromotionInformation>;
+// Promotion information is keyed by the buffer memory object for accessors and
+// by the start of the allocation for USM pointers.
+using PromotionMap = std::unordered_map<const void *, PromotionInformation>;
+
+using USMAllocation =
+    ext::codeplay::experimental::property::promote_usm::allocation;
+
+using USMPromotionList = std::vector<USMAllocation>;
 
 static inline void printPerformanceWarning(const std::string &Message) {
   if (detail::SYCLConfig<detail::SYCL_RT_WARNING_LEVEL>::get() > 0) {
@@ -193,9 +210,9 @@ static Promotion getInternalizationInfo(Requirement *Req) {
   return (AccPromotion != Promotion::None) ? AccPromotion : BuffPromotion;
 }
 
-static std::optional<size_t> getLocalSize(NDRDescT NDRange, Requirement *Req,
+static std::optional<size_t> getLocalSize(NDRDescT NDRange,
+                                          size_t NumElementsMem,
                                           Promotion Target) {
-  auto NumElementsMem = static_cast<SYCLMemObjT *>(Req->MSYCLMemObj)->size();
   if (Target == Promotion::Private) {
     auto NumWorkItems = NDRange.GlobalSize.size();
     // For private internalization, the local size is
@@ -215,6 +232,26 @@ static std::optional<size_t> getLocalSize(NDRDescT NDRange, Requirement *Req,
   return 0;
 }
 
+static std::optional<size_t> getLocalSize(NDRDescT NDRange, Requirement *Req,
+                                          Promotion Target) {
+  auto NumElementsMem = static_cast<SYCLMemObjT *>(Req->MSYCLMemObj)->size();
+  return getLocalSize(NDRange, NumElementsMem, Target);
+}
+
+// Find the allocation requested for promotion that contains Ptr.
+static const USMAllocation *findUSMAllocation(const USMPromotionList &List,
+                                              const void *Ptr) {
+  const auto *Addr = static_cast<const char *>(Ptr);
+  for (const auto &Alloc : List) {
+    const auto *Start = static_cast<const char *>(Alloc.ptr);
+    if (Addr >= Start &&
+        Addr < Start + Alloc.num_elements * Alloc.element_size) {
+      return &Alloc;
+    }
+  }
+  return nullptr;
+}
+
 static bool accessorEquals(Requirement *Req, Requirement *Other) {
   return Req->MOffset == Other->MOffset &&
          Req->MAccessRange == Other->MAccessRange &&
@@ -368,6 +405,86 @@ static void resolveInternalization(ArgDesc &Arg, unsigned KernelIndex,
   }
 }
 
+static void resolveUSMInternalization(ArgDesc &Arg, unsigned KernelIndex,
+                                      unsigned ArgFunctionIndex,
+                                      NDRDescT NDRange,
+                                      const USMPromotionList &USMPromotions,
+                                      PromotionMap &Promotions) {
+  assert(Arg.MType == kernel_param_kind_t::kind_pointer);
+
+  // At this point, the argument is still stored in the kernel functor.
+  const void *Ptr = *static_cast<void **>(Arg.MPtr);
+  const auto *Alloc = findUSMAllocation(USMPromotions, Ptr);
+  if (!Alloc) {
+    return;
+  }
+
+  if (Ptr != Alloc->ptr) {
+    // The JIT compiler remaps indices relative to the start of the allocation,
+    // so accesses through a pointer into the middle of the allocation cannot
+    // be promoted. Deactivate promotion for all uses of the allocation.
+    printPerformanceWarning("Not performing specified USM promotion, because "
+                            "the allocation is accessed through an offset "
+                            "pointer");
+    auto Entry = Promotions.try_emplace(
+        Alloc->ptr,
+        PromotionInformation{Promotion::None, KernelIndex, ArgFunctionIndex,
+                             nullptr, NDRange, 0, std::vector<bool>()});
+    Entry.first->second.PromotionTarget = Promotion::None;
+    return;
+  }
+
+  auto ThisPromotionTarget =
+      (Alloc->promotion ==
+       ext::codeplay::experimental::property::promote_usm::target::local_memory)
+          ? Promotion::Local
+          : Promotion::Private;
+  auto ThisLocalSize =
+      getLocalSize(NDRange, Alloc->num_elements, ThisPromotionTarget);
+  if (ThisLocalSize.has_value()) {
+    // Each work-item (private) or work-group (local) must own a non-empty chunk
+    // of the allocation of the same size.
+    size_t NumChunks = NDRange.GlobalSize.size();
+    if (ThisPromotionTarget == Promotion::Local) {
+      NumChunks /= NDRange.LocalSize.size();
+    }
+    if (ThisLocalSize.value() == 0 ||
+        ThisLocalSize.value() * NumChunks != Alloc->num_elements) {
+      printPerformanceWarning("Not performing specified USM promotion, "
+                              "because the allocation cannot be evenly "
+                              "distributed across the ND-range");
+      ThisLocalSize = {};
+    }
+  } else {
+    printPerformanceWarning("Work-group size for local promotion not "
+                            "specified, not performing internalization");
+  }
+
+  if (Promotions.count(Ptr)) {
+    // We previously encountered a pointer to the same allocation.
+    auto &PreviousDefinition = Promotions.at(Ptr);
+    if (PreviousDefinition.PromotionTarget == Promotion::None) {
+      return;
+    }
+    if (!ThisLocalSize.has_value() ||
+        PreviousDefinition.LocalSize != ThisLocalSize.value()) {
+      printPerformanceWarning("Not performing specified USM promotion due to "
+                              "work-group size mismatch");
+      PreviousDefinition.PromotionTarget = Promotion::None;
+    }
+    return;
+  }
+
+  if (!ThisLocalSize.has_value()) {
+    ThisPromotionTarget = Promotion::None;
+    ThisLocalSize = 0;
+  }
+  Promotions.emplace(Ptr, PromotionInformation{ThisPromotionTarget, KernelIndex,
+                                               ArgFunctionIndex, nullptr,
+                                               NDRange, ThisLocalSize.value(),
+                                               std::vector<bool>()});
+}
+
 // Identify a parameter by the argument description, the kernel index and the
 // parameter index in that kernel.
 struct Param {
@@ -549,6 +666,25 @@ static ParamIterator preProcessArguments(
       return ++Arg;
     }
   } else if (Arg->Arg.MType == kernel_param_kind_t::kind_pointer) {
+    // Check if the USM allocation pointed to should be promoted. Only the first
+    // argument for the allocation is internalized, later arguments with the
+    // same pointer value become identical to it.
+    auto Internalization =
+        PromotedAccs.find(*static_cast<void **>(Arg->Arg.MPtr));
+    if (Internalization != PromotedAccs.end()) {
+      auto &Info = Internalization->second;
+      if ((Info.PromotionTarget == Promotion::Private ||
+           Info.PromotionTarget == Promotion::Local) &&
+          Info.KernelIndex == Arg->KernelIndex &&
+          Info.ArgIndex == Arg->ArgIndex) {
+        InternalizeParams.emplace_back(
+            ::jit_compiler::Parameter{Arg->KernelIndex, Arg->ArgIndex},
+            (Info.PromotionTarget == Promotion::Private)
+                ? ::jit_compiler::Internalization::Private
+                : ::jit_compiler::Internalization::Local,
+            Info.LocalSize);
+      }
+    }
     // No identical parameter exists, so add this to the list.
     NonIdenticalParams.emplace_back(Arg->Arg, Arg->KernelIndex, Arg->ArgIndex,
                                     true);
@@ -559,7 +695,8 @@ static ParamIterator preProcessArguments(
 
 static void
 updatePromotedArgs(const ::jit_compiler::SYCLKernelInfo &FusedKernelInfo,
-                   NDRDescT NDRange, std::vector<ArgDesc> &FusedArgs,
+                   NDRDescT NDRange, const USMPromotionList &USMPromotions,
+                   std::vector<ArgDesc> &FusedArgs,
                    std::vector<std::vector<char>> &FusedArgStorage) {
   auto &ArgUsageInfo = FusedKernelInfo.Args.UsageMask;
   assert(ArgUsageInfo.size() == FusedArgs.size());
@@ -568,7 +705,25 @@ updatePromotedArgs(const ::jit_compiler::SYCLKernelInfo &FusedKernelInfo,
         (ArgUsageInfo[ArgIndex] & ::jit_compiler::ArgUsage::PromotedPrivate);
     bool PromotedToLocal =
         (ArgUsageInfo[ArgIndex] & ::jit_compiler::ArgUsage::PromotedLocal);
-    if (PromotedToLocal || PromotedToPrivate) {
+    if ((PromotedToLocal || PromotedToPrivate) &&
+        FusedArgs[ArgIndex].MType == kernel_param_kind_t::kind_pointer) {
+      // Privately promoted USM pointers have been removed from the fused
+      // kernel. Pointers promoted to local memory are replaced by a local
+      // memory argument, in the same way as handler.cpp does for local
+      // accessors.
+      if (PromotedToLocal) {
+        const auto *Alloc = findUSMAllocation(
+            USMPromotions, *static_cast<void **>(FusedArgs[ArgIndex].MPtr));
+        assert(Alloc && "No USM allocation for promoted pointer");
+        auto LocalSize =
+            getLocalSize(NDRange, Alloc->num_elements, Promotion::Local);
+        int SizeInBytes = Alloc->element_size * LocalSize.value();
+        FusedArgs[ArgIndex] =
+            ArgDesc{kernel_param_kind_t::kind_std_layout, nullptr, SizeInBytes,
+                    static_cast<int>(ArgIndex)};
+      }
+      ++ArgIndex;
+    } else if (PromotedToLocal || PromotedToPrivate) {
       // For each internalized accessor, we need to override four arguments
       // (see 'addArgsForGlobalAccessor' in handler.cpp for reference), i.e.,
       // the pointer itself, plus twice the range and the offset.
@@ -620,6 +775,43 @@ updatePromotedArgs(const ::jit_compiler::SYCLKernelInfo &FusedKernelInfo,
   }
 }
 
+static ::jit_compiler::SYCLKernelBinaryInfo
+getJITBinaryInfo(const RTDeviceBinaryImage &DeviceImage) {
+  auto &RawDeviceImage = DeviceImage.getRawData();
+  auto DeviceImageSize = static_cast<size_t>(RawDeviceImage.BinaryEnd -
+                                             RawDeviceImage.BinaryStart);
+  // Set 0 as the number of address bits, because the JIT compiler can set
+  // this field based on information from SPIR-V/LLVM module's data-layout.
+  auto BinaryImageFormat = translateBinaryImageFormat(DeviceImage.getFormat());
+  ::jit_compiler::SYCLKernelBinaryInfo BinInfo{
+      BinaryImageFormat, 0, RawDeviceImage.BinaryStart, DeviceImageSize};
+  // If the device image was compiled with -fsycl-embed-ir, its LLVM bitcode
+  // is available in the image properties. Loading it is much cheaper than
+  // translating the SPIR-V back to LLVM IR.
+  const auto &FusionBitcode = DeviceImage.getFusionBitcode();
+  if (BinaryImageFormat == ::jit_compiler::BinaryFormat::SPIRV &&
+      FusionBitcode.isAvailable() && FusionBitcode.size() > 0) {
+    ByteArray Bitcode =
+        DeviceBinaryProperty(*FusionBitcode.begin()).asByteArray();
+    // Drop the leading size of the byte array.
+    Bitcode.dropBytes(8);
+    BinInfo = ::jit_compiler::SYCLKernelBinaryInfo{
+        ::jit_compiler::BinaryFormat::LLVM, 0, Bitcode.begin(),
+        Bitcode.size()};
+  }
+  return BinInfo;
+}
+
+static ::jit_compiler::NDRange getJITNDRange(const NDRDescT &NDRDesc) {
+  constexpr auto SYCLTypeToIndices = [](auto Val) -> ::jit_compiler::Indices {
+    return {Val.get(0), Val.get(1), Val.get(2)};
+  };
+  return {static_cast<int>(NDRDesc.Dims),
+          SYCLTypeToIndices(NDRDesc.GlobalSize),
+          SYCLTypeToIndices(NDRDesc.LocalSize),
+          SYCLTypeToIndices(NDRDesc.GlobalOffset)};
+}
+
 std::unique_ptr<detail::CG>
 jit_compiler::fuseKernels(QueueImplPtr Queue,
                           std::vector<ExecCGCommand *> &InputKernels,
@@ -641,6 +833,15 @@ jit_compiler::fuseKernels(QueueImplPtr Queue,
   unsigned KernelIndex = 0;
   ParamList FusedParams;
   PromotionMap PromotedAccs;
+  // USM allocations the user asserted to only hold intermediate results.
+  USMPromotionList USMPromotions;
+  if (PropList.has_property<
+          ext::codeplay::experimental::property::promote_usm>()) {
+    USMPromotions =
+        PropList
+            .get_property<ext::codeplay::experimental::property::promote_usm>()
+            .get_allocations();
+  }
   // TODO(Lukas, ONNX-399): Collect information about streams and auxiliary
   // resources (which contain reductions) and figure out how to fuse them.
   for (auto &RawCmd : InputKernels) {
@@ -669,6 +870,11 @@ jit_compiler::fuseKernels(QueueImplPtr Queue,
           detail::ProgramManager::getInstance().getEliminatedKernelArgMask(
               KernelCG->MOSModuleHandle, Program, KernelName);
     }
+    if (detail::ProgramManager::getInstance().getKernelArgPacking(DeviceImage,
+                                                                  KernelName)) {
+      printPerformanceWarning("Cannot fuse kernel with packed arguments");
+      return nullptr;
+    }
 
     // Collect information about the arguments of this kernel.
 
@@ -700,6 +906,11 @@ jit_compiler::fuseKernels(QueueImplPtr Queue,
         if (Arg.MType == kernel_param_kind_t::kind_accessor) {
           resolveInternalization(Arg, KernelIndex, ArgFunctionIndex,
                                  KernelCG->MNDRDesc, PromotedAccs);
+        } else if (Arg.MType == kernel_param_kind_t::kind_pointer &&
+                   !USMPromotions.empty()) {
+          resolveUSMInternalization(Arg, KernelIndex, ArgFunctionIndex,
+                                    KernelCG->MNDRDesc, USMPromotions,
+                                    PromotedAccs);
         }
         FusedParams.emplace_back(Arg, KernelIndex, ArgFunctionIndex, true);
         ++ArgFunctionIndex;
@@ -710,30 +921,14 @@ jit_compiler::fuseKernels(QueueImplPtr Queue,
 
     // TODO(Lukas, ONNX-399): Check for the correct kernel bundle state of the
     // device image?
-    auto &RawDeviceImage = DeviceImage->getRawData();
-    auto DeviceImageSize = static_cast<size_t>(RawDeviceImage.BinaryEnd -
-                                               RawDeviceImage.BinaryStart);
-    // Set 0 as the number of address bits, because the JIT compiler can set
-    // this field based on information from SPIR-V/LLVM module's data-layout.
-    auto BinaryImageFormat =
-        translateBinaryImageFormat(DeviceImage->getFormat());
-    if (BinaryImageFormat == ::jit_compiler::BinaryFormat::INVALID) {
+    auto BinInfo = getJITBinaryInfo(*DeviceImage);
+    if (BinInfo.Format == ::jit_compiler::BinaryFormat::INVALID) {
       printPerformanceWarning("No suitable IR available for fusion");
       return nullptr;
     }
-    ::jit_compiler::SYCLKernelBinaryInfo BinInfo{
-        BinaryImageFormat, 0, RawDeviceImage.BinaryStart, DeviceImageSize};
-
-    constexpr auto SYCLTypeToIndices = [](auto Val) -> ::jit_compiler::Indices {
-      return {Val.get(0), Val.get(1), Val.get(2)};
-    };
 
     auto &CurrentNDR = KernelCG->MNDRDesc;
-    const ::jit_compiler::NDRange JITCompilerNDR{
-        static_cast<int>(CurrentNDR.Dims),
-        SYCLTypeToIndices(CurrentNDR.GlobalSize),
-        SYCLTypeToIndices(CurrentNDR.LocalSize),
-        SYCLTypeToIndices(CurrentNDR.GlobalOffset)};
+    const ::jit_compiler::NDRange JITCompilerNDR = getJITNDRange(CurrentNDR);
 
     Ranges.push_back(JITCompilerNDR);
     InputKernelInfo.emplace_back(KernelName, ArgDescriptor, JITCompilerNDR,
@@ -805,20 +1000,43 @@ jit_compiler::fuseKernels(QueueImplPtr Queue,
   static size_t FusedKernelNameIndex = 0;
   std::stringstream FusedKernelName;
   FusedKernelName << "fused_" << FusedKernelNameIndex++;
-  ::jit_compiler::Config JITConfig;
   bool DebugEnabled =
       detail::SYCLConfig<detail::SYCL_RT_WARNING_LEVEL>::get() > 0;
-  JITConfig.set<::jit_compiler::option::JITEnableVerbose>(DebugEnabled);
-  JITConfig.set<::jit_compiler::option::JITEnableCaching>(
-      detail::SYCLConfig<detail::SYCL_ENABLE_FUSION_CACHING>::get());
-
   ::jit_compiler::BinaryFormat TargetFormat = getTargetFormat(Queue);
-  JITConfig.set<::jit_compiler::option::JITTargetFormat>(TargetFormat);
 
-  auto FusionResult = ::jit_compiler::KernelFusion::fuseKernels(
-      *MJITContext, std::move(JITConfig), InputKernelInfo, InputKernelNames,
-      FusedKernelName.str(), ParamIdentities, BarrierFlags, InternalizeParams,
-      JITConstants);
+  // Background compilation relies on the JIT cache to hand the fused kernel to
+  // later, identical fusions, so it requires caching to be enabled.
+  bool BackgroundJIT =
+      PropList.has_property<
+          ext::codeplay::experimental::property::background_jit>() &&
+      detail::SYCLConfig<detail::SYCL_ENABLE_FUSION_CACHING>::get();
+
+  auto FusionResult = [&] {
+    // With background compilation, only the caches are probed here. This does
+    // not use the LLVM context, so it must not wait for a compilation running
+    // in the background.
+    std::unique_lock<std::mutex> Lock{MJITMutex, std::defer_lock};
+    if (!BackgroundJIT) {
+      Lock.lock();
+    }
+    return ::jit_compiler::KernelFusion::fuseKernels(
+        *MJITContext, createJITConfig(TargetFormat, BackgroundJIT),
+        InputKernelInfo, InputKernelNames, FusedKernelName.str(),
+        ParamIdentities, BarrierFlags, InternalizeParams, JITConstants);
+  }();
+
+  if (FusionResult.failed() && BackgroundJIT) {
+    // No fused kernel available yet. Execute the kernels without fusion for
+    // now and compile the fused kernel in the background.
+    printPerformanceWarning(
+        "Fused kernel not yet available, executing kernels without fusion");
+    fuseKernelsInBackground(TargetFormat, std::move(InputKernelInfo),
+                            std::move(InputKernelNames), FusedKernelName.str(),
+                            std::move(ParamIdentities), BarrierFlags,
+                            std::move(InternalizeParams),
+                            std::move(JITConstants));
+    return nullptr;
+  }
 
   if (FusionResult.failed()) {
     if (DebugEnabled) {
@@ -829,6 +1047,15 @@ jit_compiler::fuseKernels(QueueImplPtr Queue,
     return nullptr;
   }
 
+  if (DebugEnabled &&
+      detail::SYCLConfig<detail::SYCL_ENABLE_FUSION_CACHING>::get()) {
+    auto Stats = MJITContext->getCacheStatistics();
+    std::cerr << "INFO: Fusion cache: " << Stats.Hits << " hits, "
+              << Stats.Misses << " misses, " << Stats.Evictions
+              << " evictions, " << Stats.NumEntries << " entries using "
+              << Stats.SizeInBytes << " bytes\n";
+  }
+
   auto &FusedKernelInfo = FusionResult.getKernelInfo();
 
   std::vector<ArgDesc> FusedArgs;
@@ -840,7 +1067,7 @@ jit_compiler::fuseKernels(QueueImplPtr Queue,
     FusedArgs.emplace_back(Arg.MType, Arg.MPtr, Arg.MSize, FusedArgIndex++);
   }
 
-  // Update the kernel arguments for internalized accessors.
+  // Update the kernel arguments for internalized accessors and USM pointers.
   const auto NDRDesc = [](const auto &ND) -> NDRDescT {
     constexpr auto ToSYCLType = [](const auto &Indices) -> sycl::range<3> {
       return {Indices[0], Indices[1], Indices[2]};
@@ -852,21 +1079,28 @@ jit_compiler::fuseKernels(QueueImplPtr Queue,
     NDRDesc.GlobalOffset = ToSYCLType(ND.getOffset());
     return NDRDesc;
   }(FusedKernelInfo.NDR);
-  updatePromotedArgs(FusedKernelInfo, NDRDesc, FusedArgs, ArgsStorage);
+  updatePromotedArgs(FusedKernelInfo, NDRDesc, USMPromotions, FusedArgs,
+                     ArgsStorage);
 
   OSModuleHandle Handle = OSUtil::DummyModuleHandle;
   if (!FusionResult.cached()) {
-    auto PIDeviceBinaries = createPIDeviceBinary(FusedKernelInfo, TargetFormat);
-    detail::ProgramManager::getInstance().addImages(PIDeviceBinaries);
-    Handle = OSUtil::getOSModuleHandle(PIDeviceBinaries->DeviceBinaries);
-    CachedModules.emplace(FusedKernelInfo.Name, Handle);
+    Handle = registerFusedKernel(FusionResult, TargetFormat);
   } else {
     if (DebugEnabled) {
       std::cerr << "INFO: Re-using existing device binary for fused kernel\n";
     }
     // Retrieve an OSModuleHandle for the cached binary.
-    assert(CachedModules.count(FusedKernelInfo.Name) && "No cached binary");
-    Handle = CachedModules.at(FusedKernelInfo.Name);
+    std::lock_guard<std::mutex> Lock{MFusedKernelsMutex};
+    auto CachedModule = CachedModules.find(FusedKernelInfo.Name);
+    if (CachedModule == CachedModules.end()) {
+      // A background compilation might have added the kernel to the JIT cache,
+      // but not yet registered its binary with the runtime.
+      assert(BackgroundJIT && "No cached binary");
+      printPerformanceWarning(
+          "Fused kernel not yet available, executing kernels without fusion");
+      return nullptr;
+    }
+    Handle = CachedModule->second;
   }
 
   // Create a kernel bundle for the fused kernel.
@@ -888,8 +1122,286 @@ jit_compiler::fuseKernels(QueueImplPtr Queue,
   return FusedCG;
 }
 
+bool jit_compiler::specializeKernel(QueueImplPtr Queue,
+                                    CGExecKernel &KernelCG) {
+  const auto &Selection =
+      detail::SYCLConfig<detail::SYCL_JIT_SPECIALIZE_KERNELS>::get();
+  auto Selected = Selection.find(KernelCG.MKernelName);
+  if (Selected == Selection.end()) {
+    return false;
+  }
+  // An empty list of indices selects all scalar arguments.
+  const std::vector<size_t> &SelectedArgs = Selected->second;
+
+  auto Backend = Queue->getDeviceImplPtr()->getBackend();
+  if (Backend != backend::ext_oneapi_level_zero &&
+      Backend != backend::opencl && Backend != backend::ext_oneapi_cuda) {
+    return false;
+  }
+  if (KernelCG.MSyclKernel != nullptr &&
+      KernelCG.MSyclKernel->isCreatedFromSource()) {
+    printPerformanceWarning("Cannot specialize kernel created from source");
+    return false;
+  }
+  if (KernelCG.MNDRDesc.GlobalSize[0] == 0 &&
+      KernelCG.MNDRDesc.NumWorkGroups[0] != 0) {
+    printPerformanceWarning(
+        "Cannot specialize kernel with hierarchical parallelism");
+    return false;
+  }
+  // The specialized kernel is launched without the original kernel bundle, so
+  // it would lose the values of specialization constants set on the bundle.
+  if (KernelCG.MKernelBundle &&
+      KernelCG.MKernelBundle->contains_specialization_constants()) {
+    printPerformanceWarning(
+        "Cannot specialize kernel with specialization constants");
+    return false;
+  }
+
+  auto [DeviceImage, Program] = retrieveKernelBinary(Queue, &KernelCG);
+  if (!DeviceImage || !Program) {
+    printPerformanceWarning("No suitable IR available for specialization");
+    return false;
+  }
+  auto BinInfo = getJITBinaryInfo(*DeviceImage);
+  if (BinInfo.Format == ::jit_compiler::BinaryFormat::INVALID) {
+    printPerformanceWarning("No suitable IR available for specialization");
+    return false;
+  }
+  const KernelArgMask *EliminatedArgs =
+      detail::ProgramManager::getInstance().getEliminatedKernelArgMask(
+          KernelCG.MOSModuleHandle, Program, KernelCG.MKernelName);
+  if (detail::ProgramManager::getInstance().getKernelArgPacking(
+          DeviceImage, KernelCG.MKernelName)) {
+    printPerformanceWarning("Cannot specialize kernel with packed arguments");
+    return false;
+  }
+
+  auto Args = KernelCG.MArgs;
+  std::sort(Args.begin(), Args.end(), [](const ArgDesc &A, const ArgDesc &B) {
+    return A.MIndex < B.MIndex;
+  });
+
+  // The arguments of the command group stay in place, the specialized kernel
+  // only ignores the arguments replaced by constants through its argument
+  // usage mask. The values of standard layout arguments are copied by the JIT
+  // compiler, so they do not need to outlive this call.
+  ::jit_compiler::SYCLArgumentDescriptor ArgDescriptor;
+  std::vector<::jit_compiler::JITConstant> JITConstants;
+  size_t ArgIndex = 0;
+  unsigned ArgFunctionIndex = 0;
+  for (auto &Arg : Args) {
+    ArgDescriptor.Kinds.push_back(translateArgType(Arg.MType));
+    bool Eliminated = EliminatedArgs && !EliminatedArgs->empty() &&
+                      (*EliminatedArgs)[ArgIndex++];
+    ArgDescriptor.UsageMask.emplace_back(!Eliminated);
+    if (Eliminated) {
+      continue;
+    }
+    bool IsSelected =
+        SelectedArgs.empty() ||
+        std::find(SelectedArgs.begin(), SelectedArgs.end(),
+                  static_cast<size_t>(Arg.MIndex)) != SelectedArgs.end();
+    if (IsSelected && Arg.MType == kernel_param_kind_t::kind_std_layout &&
+        Arg.MPtr) {
+      JITConstants.emplace_back(
+          ::jit_compiler::Parameter{0, ArgFunctionIndex}, Arg.MPtr,
+          Arg.MSize);
+    }
+    ++ArgFunctionIndex;
+  }
+  if (JITConstants.empty()) {
+    return false;
+  }
+
+  ::jit_compiler::SYCLKernelInfo KernelInfo{
+      KernelCG.MKernelName, ArgDescriptor, getJITNDRange(KernelCG.MNDRDesc),
+      BinInfo};
+
+  static std::atomic<size_t> SpecializedKernelNameIndex{0};
+  std::string SpecializedKernelName =
+      "specialized_" + std::to_string(SpecializedKernelNameIndex++);
+  ::jit_compiler::BinaryFormat TargetFormat = getTargetFormat(Queue);
+  bool DebugEnabled =
+      detail::SYCLConfig<detail::SYCL_RT_WARNING_LEVEL>::get() > 0;
+
+  auto SpecResult = [&] {
+    std::lock_guard<std::mutex> Lock{MJITMutex};
+    return ::jit_compiler::KernelFusion::specializeKernel(
+        *MJITContext, createJITConfig(TargetFormat, /*LookupOnly*/ false),
+        KernelInfo, SpecializedKernelName, JITConstants);
+  }();
+  if (SpecResult.failed()) {
+    if (DebugEnabled) {
+      std::cerr << "ERROR: JIT compilation for kernel specialization failed "
+                   "with message:\n"
+                << SpecResult.getErrorMessage() << "\n";
+    }
+    return false;
+  }
+
+  auto &SpecKernelInfo = SpecResult.getKernelInfo();
+  OSModuleHandle Handle = OSUtil::DummyModuleHandle;
+  if (!SpecResult.cached()) {
+    Handle = registerFusedKernel(SpecResult, TargetFormat);
+  } else {
+    std::lock_guard<std::mutex> Lock{MFusedKernelsMutex};
+    auto CachedModule = CachedModules.find(SpecKernelInfo.Name);
+    if (CachedModule == CachedModules.end()) {
+      return false;
+    }
+    Handle = CachedModule->second;
+  }
+
+  // Launch the specialized kernel instead of the original one. The kernel
+  // object and bundle refer to the original kernel, so the program manager
+  // builds the specialized kernel from its registered binary instead. Kernels
+  // with specialization constants were rejected above, so the bundle holds no
+  // state the specialized kernel needs.
+  KernelCG.MKernelName = SpecKernelInfo.Name;
+  KernelCG.MOSModuleHandle = Handle;
+  KernelCG.MSyclKernel = nullptr;
+  KernelCG.MKernelBundle = nullptr;
+  return true;
+}
+
+::jit_compiler::Config
+jit_compiler::createJITConfig(::jit_compiler::BinaryFormat TargetFormat,
+                              bool LookupOnly) {
+  ::jit_compiler::Config JITConfig;
+  bool DebugEnabled =
+      detail::SYCLConfig<detail::SYCL_RT_WARNING_LEVEL>::get() > 0;
+  JITConfig.set<::jit_compiler::option::JITEnableVerbose>(DebugEnabled);
+  JITConfig.set<::jit_compiler::option::JITEnableCaching>(
+      detail::SYCLConfig<detail::SYCL_ENABLE_FUSION_CACHING>::get());
+  JITConfig.set<::jit_compiler::option::JITPersistentCacheDir>(
+      PersistentDeviceCodeCache::getFusionCacheDir());
+  JITConfig.set<::jit_compiler::option::JITPersistentCachePolicy>(
+      PersistentDeviceCodeCache::getFusionCachePruningPolicy());
+  JITConfig.set<::jit_compiler::option::JITTargetFormat>(TargetFormat);
+  JITConfig.set<::jit_compiler::option::JITCacheLookupOnly>(LookupOnly);
+  JITConfig.set<::jit_compiler::option::JITCacheMaxSize>(
+      detail::SYCLConfig<detail::SYCL_FUSION_CACHE_MAX_SIZE>::get());
+  return JITConfig;
+}
+
+OSModuleHandle jit_compiler::registerFusedKernel(
+    const ::jit_compiler::FusionResult &FusionResult,
+    ::jit_compiler::BinaryFormat Format) {
+  const auto &FusedKernelInfo = FusionResult.getKernelInfo();
+  std::lock_guard<std::mutex> Lock{MFusedKernelsMutex};
+  auto CachedModule = CachedModules.find(FusedKernelInfo.Name);
+  if (CachedModule != CachedModules.end()) {
+    return CachedModule->second;
+  }
+  auto PIDeviceBinaries = createPIDeviceBinary(
+      FusedKernelInfo, FusionResult.getBinary(), Format);
+  detail::ProgramManager::getInstance().addImages(PIDeviceBinaries);
+  OSModuleHandle Handle =
+      OSUtil::getOSModuleHandle(PIDeviceBinaries->DeviceBinaries);
+  CachedModules.emplace(FusedKernelInfo.Name, Handle);
+  return Handle;
+}
+
+// Returns a key identifying the configuration of a fusion, i.e., everything
+// the JIT compiler takes into account when fusing the kernels.
+static std::string getFusionKey(
+    const std::vector<::jit_compiler::SYCLKernelInfo> &InputKernelInfo,
+    const ::jit_compiler::ParamIdentList &ParamIdentities, int BarrierFlags,
+    const std::vector<::jit_compiler::ParameterInternalization>
+        &InternalizeParams,
+    const std::vector<::jit_compiler::JITConstant> &JITConstants) {
+  std::string Key;
+  auto Add = [&Key](const auto &Value) {
+    Key.append(reinterpret_cast<const char *>(&Value), sizeof(Value));
+  };
+  auto AddString = [&](const std::string &Str) {
+    Add(Str.size());
+    Key.append(Str);
+  };
+  auto AddParam = [&](const ::jit_compiler::Parameter &Param) {
+    Add(Param.KernelIdx);
+    Add(Param.ParamIdx);
+  };
+  Add(InputKernelInfo.size());
+  for (const auto &Info : InputKernelInfo) {
+    AddString(Info.Name);
+    Add(Info.NDR.getDimensions());
+    Add(Info.NDR.getGlobalSize());
+    Add(Info.NDR.getLocalSize());
+    Add(Info.NDR.getOffset());
+  }
+  Add(ParamIdentities.size());
+  for (const auto &Identity : ParamIdentities) {
+    AddParam(Identity.LHS);
+    AddParam(Identity.RHS);
+  }
+  Add(BarrierFlags);
+  Add(InternalizeParams.size());
+  for (const auto &Intern : InternalizeParams) {
+    AddParam(Intern.Param);
+    Add(Intern.Intern);
+    Add(Intern.LocalSize);
+  }
+  Add(JITConstants.size());
+  for (const auto &Constant : JITConstants) {
+    AddParam(Constant.Param);
+    AddString(Constant.Value);
+  }
+  return Key;
+}
+
+void jit_compiler::fuseKernelsInBackground(
+    ::jit_compiler::BinaryFormat TargetFormat,
+    std::vector<::jit_compiler::SYCLKernelInfo> &&InputKernelInfo,
+    std::vector<std::string> &&InputKernelNames,
+    const std::string &FusedKernelName,
+    ::jit_compiler::ParamIdentList &&ParamIdentities, int BarrierFlags,
+    std::vector<::jit_compiler::ParameterInternalization> &&InternalizeParams,
+    std::vector<::jit_compiler::JITConstant> &&JITConstants) {
+  std::string Key = getFusionKey(InputKernelInfo, ParamIdentities,
+                                 BarrierFlags, InternalizeParams, JITConstants);
+  {
+    std::lock_guard<std::mutex> Lock{MFusedKernelsMutex};
+    // Only compile each fusion once at a time, and don't retry fusions which
+    // failed to compile.
+    if (!MPendingFusions.insert(Key).second) {
+      return;
+    }
+    if (!MBackgroundJITPool) {
+      MBackgroundJITPool = std::make_unique<ThreadPool>(1);
+    }
+  }
+  // The input binaries are owned by the program manager and outlive the job,
+  // everything else is copied into the job.
+  MBackgroundJITPool->submit([=]() {
+    auto Identities = ParamIdentities;
+    auto FusionResult = [&] {
+      std::lock_guard<std::mutex> Lock{MJITMutex};
+      return ::jit_compiler::KernelFusion::fuseKernels(
+          *MJITContext, createJITConfig(TargetFormat, /*LookupOnly*/ false),
+          InputKernelInfo, InputKernelNames, FusedKernelName, Identities,
+          BarrierFlags, InternalizeParams, JITConstants);
+    }();
+    if (FusionResult.failed()) {
+      // Keep the configuration marked as pending, so fusions which cannot
+      // succeed are not retried over and over again.
+      printPerformanceWarning(
+          "Background JIT compilation for kernel fusion failed with message:\n" +
+          FusionResult.getErrorMessage());
+      return;
+    }
+    if (!FusionResult.cached()) {
+      registerFusedKernel(FusionResult, TargetFormat);
+    }
+    std::lock_guard<std::mutex> Lock{MFusedKernelsMutex};
+    MPendingFusions.erase(Key);
+  });
+}
+
 pi_device_binaries jit_compiler::createPIDeviceBinary(
     const ::jit_compiler::SYCLKernelInfo &FusedKernelInfo,
+    std::shared_ptr<const void> BinaryOwner,
     ::jit_compiler::BinaryFormat Format) {
 
   const char *TargetSpec = nullptr;
@@ -960,7 +1472,8 @@ pi_device_binaries jit_compiler::createPIDeviceBinary(
 
   DeviceBinariesCollection Collection;
   Collection.addDeviceBinary(
-      std::move(Binary), FusedKernelInfo.BinaryInfo.BinaryStart,
+      std::move(Binary), std::move(BinaryOwner),
+      FusedKernelInfo.BinaryInfo.BinaryStart,
       FusedKernelInfo.BinaryInfo.BinarySize, TargetSpec, BinFormat);
 
   JITDeviceBinaries.push_back(std::move(Collection));
@@ -12,23 +12,35 @@
 #include <detail/scheduler/commands.hpp>
 #include <detail/scheduler/scheduler.hpp>
 
+#include <mutex>
+#include <set>
 #include <unordered_map>
 
 namespace jit_compiler {
 enum class BinaryFormat : uint32_t;
+class Config;
 class JITContext;
 struct SYCLKernelInfo;
 struct SYCLKernelAttribute;
+struct ParameterIdentity;
+struct ParameterInternalization;
+struct JITConstant;
 using ArgUsageMask = std::vector<unsigned char>;
+using ParamIdentList = std::vector<ParameterIdentity>;
 } // namespace jit_compiler
 
 struct pi_device_binaries_struct;
 struct _pi_offload_entry_struct;
 
+// For testing purposes
+class MockJITCompiler;
+
 namespace sycl {
 __SYCL_INLINE_VER_NAMESPACE(_V1) {
 namespace detail {
 
+class ThreadPool;
+
 class jit_compiler {
 
 public:
@@ -36,6 +48,12 @@ public:
   fuseKernels(QueueImplPtr Queue, std::vector<ExecCGCommand *> &InputKernels,
               const property_list &);
 
+  /// Replace the kernel of a command group by a variant specialized on the
+  /// values of its scalar arguments, if the kernel is selected for
+  /// specialization by SYCL_JIT_SPECIALIZE_KERNELS. Returns true if the
+  /// command group was updated.
+  bool specializeKernel(QueueImplPtr Queue, CGExecKernel &KernelCG);
+
   static jit_compiler &get_instance() {
     static jit_compiler instance{};
     return instance;
@@ -49,8 +67,32 @@ private:
   jit_compiler &operator=(const jit_compiler &) = delete;
   jit_compiler &operator=(const jit_compiler &&) = delete;
 
+  static ::jit_compiler::Config
+  createJITConfig(::jit_compiler::BinaryFormat TargetFormat, bool LookupOnly);
+
+  /// Register the binary of a newly compiled fused kernel with the program
+  /// manager and remember its module handle for later cache hits. A kernel
+  /// which is already registered under the same name, e.g., because it was
+  /// evicted from the JIT cache and compiled again, reuses its registration.
+  OSModuleHandle
+  registerFusedKernel(const ::jit_compiler::FusionResult &FusionResult,
+                      ::jit_compiler::BinaryFormat Format);
+
+  /// Compile a fused kernel on a background thread, so that it is available
+  /// from the JIT cache for later fusions of the same kernels.
+  void fuseKernelsInBackground(
+      ::jit_compiler::BinaryFormat TargetFormat,
+      std::vector<::jit_compiler::SYCLKernelInfo> &&InputKernelInfo,
+      std::vector<std::string> &&InputKernelNames,
+      const std::string &FusedKernelName,
+      ::jit_compiler::ParamIdentList &&ParamIdentities, int BarrierFlags,
+      std::vector<::jit_compiler::ParameterInternalization>
+          &&InternalizeParams,
+      std::vector<::jit_compiler::JITConstant> &&JITConstants);
+
   pi_device_binaries
   createPIDeviceBinary(const ::jit_compiler::SYCLKernelInfo &FusedKernelInfo,
+                       std::shared_ptr<const void> BinaryOwner,
                        ::jit_compiler::BinaryFormat Format);
 
   std::vector<uint8_t>
@@ -65,6 +107,22 @@ private:
   std::unordered_map<std::string, OSModuleHandle> CachedModules;
 
   std::unique_ptr<::jit_compiler::JITContext> MJITContext;
+
+  // Serializes the JIT compilations, which all use the single LLVMContext of
+  // the JIT context, and may run on background threads.
+  std::mutex MJITMutex;
+
+  // Protects the registered fused binaries, which are also updated by
+  // background compilations.
+  std::mutex MFusedKernelsMutex;
+
+  // Configurations of the fusions which are being compiled in the background,
+  // or which failed to compile there.
+  std::set<std::string> MPendingFusions;
+
+  std::unique_ptr<ThreadPool> MBackgroundJITPool;
+
+  friend class ::MockJITCompiler;
 };
 
 } // namespace detail
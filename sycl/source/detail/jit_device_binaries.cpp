@@ -81,8 +81,8 @@ void DeviceBinaryContainer::addProperty(PropertySetContainer &&Cont) {
 }
 
 pi_device_binary_struct DeviceBinaryContainer::getPIDeviceBinary(
-    const unsigned char *BinaryStart, size_t BinarySize, const char *TargetSpec,
-    pi_device_binary_type Format) {
+    std::shared_ptr<const void> Owner, const unsigned char *BinaryStart,
+    size_t BinarySize, const char *TargetSpec, pi_device_binary_type Format) {
   pi_device_binary_struct DeviceBinary;
   DeviceBinary.Version = PI_DEVICE_BINARY_VERSION;
   DeviceBinary.Kind = PI_DEVICE_BINARY_OFFLOAD_KIND_SYCL;
@@ -91,8 +91,7 @@ pi_device_binary_struct DeviceBinaryContainer::getPIDeviceBinary(
   DeviceBinary.LinkOptions = "";
   DeviceBinary.ManifestStart = nullptr;
   DeviceBinary.ManifestEnd = nullptr;
-  // It is safe to use these pointers here, as their lifetime is managed by
-  // the JITContext.
+  BinaryOwner = std::move(Owner);
   DeviceBinary.BinaryStart = BinaryStart;
   DeviceBinary.BinaryEnd = BinaryStart + BinarySize;
   DeviceBinary.DeviceTargetSpec = TargetSpec;
@@ -104,18 +103,17 @@ pi_device_binary_struct DeviceBinaryContainer::getPIDeviceBinary(
   return DeviceBinary;
 }
 
-void DeviceBinariesCollection::addDeviceBinary(DeviceBinaryContainer &&Cont,
-                                               const unsigned char *BinaryStart,
-                                               size_t BinarySize,
-                                               const char *TargetSpec,
-                                               pi_device_binary_type Format) {
+void DeviceBinariesCollection::addDeviceBinary(
+    DeviceBinaryContainer &&Cont, std::shared_ptr<const void> BinaryOwner,
+    const unsigned char *BinaryStart, size_t BinarySize,
+    const char *TargetSpec, pi_device_binary_type Format) {
   // Adding to the vectors might trigger reallocation, which would invalidate
   // the pointers used for PI structs if a PI struct has already been created
   // via getPIDeviceStruct(). Forbid calls to this method after the first PI
   // struct has been created.
   assert(Fused && "Adding to container would invalidate existing PI structs");
-  PIBinaries.push_back(
-      Cont.getPIDeviceBinary(BinaryStart, BinarySize, TargetSpec, Format));
+  PIBinaries.push_back(Cont.getPIDeviceBinary(
+      std::move(BinaryOwner), BinaryStart, BinarySize, TargetSpec, Format));
   Binaries.push_back(std::move(Cont));
 }
 
@@ -109,13 +109,17 @@ public:
 
   void addProperty(PropertySetContainer &&Cont);
 
-  pi_device_binary_struct getPIDeviceBinary(const unsigned char *BinaryStart,
-                                            size_t BinarySize,
-                                            const char *TargetSpec,
-                                            pi_device_binary_type Format);
+  /// Creates the PI struct for the binary. The container shares the
+  /// ownership of the binary through BinaryOwner, as the JIT compiler may
+  /// evict it from its cache.
+  pi_device_binary_struct
+  getPIDeviceBinary(std::shared_ptr<const void> BinaryOwner,
+                    const unsigned char *BinaryStart, size_t BinarySize,
+                    const char *TargetSpec, pi_device_binary_type Format);
 
 private:
   bool Fused = true;
+  std::shared_ptr<const void> BinaryOwner;
   std::vector<OffloadEntryContainer> OffloadEntries;
   std::vector<_pi_offload_entry_struct> PIOffloadEntries;
   std::vector<PropertySetContainer> PropertySets;
@@ -138,6 +142,7 @@ public:
   operator=(const DeviceBinariesCollection &) = delete;
 
   void addDeviceBinary(DeviceBinaryContainer &&Cont,
+                       std::shared_ptr<const void> BinaryOwner,
                        const unsigned char *BinaryStart, size_t BinarySize,
                        const char *TargetSpec, pi_device_binary_type Format);
   pi_device_binaries getPIDeviceStruct();
@@ -8,6 +8,8 @@
 
 #pragma once
 #include <detail/device_binary_image.hpp>
+#include <algorithm>
+#include <cstdint>
 #include <vector>
 
 namespace sycl {
@@ -30,6 +32,58 @@ inline KernelArgMask createKernelArgMask(const ByteArray &Bytes) {
   }
   return Result;
 }
+
+/// Describes how the device compiler packed kernel arguments holding accessor
+/// ranges and offsets into a single by-value argument. Argument indices are
+/// the ones after dead argument elimination and before packing.
+struct KernelArgPacking {
+  struct Field {
+    std::uint32_t ArgIndex;
+    std::uint32_t Offset;
+    std::uint32_t Size;
+  };
+  /// Index of the packed argument in the kernel.
+  std::uint32_t PackedArgIndex = 0;
+  /// Size of the packed argument in bytes.
+  std::uint32_t PackedSize = 0;
+  /// Packed arguments, sorted by their indices.
+  std::vector<Field> Fields;
+
+  /// Returns the field for the argument with index ArgIndex, or nullptr if
+  /// the argument is not packed.
+  const Field *findField(std::uint32_t ArgIndex) const {
+    auto It = lowerBound(ArgIndex);
+    return It != Fields.end() && It->ArgIndex == ArgIndex ? &*It : nullptr;
+  }
+
+  /// Returns the index the argument with index ArgIndex has in the kernel
+  /// after the packed arguments are removed from it.
+  std::uint32_t getIndexAfterPacking(std::uint32_t ArgIndex) const {
+    return ArgIndex - (lowerBound(ArgIndex) - Fields.begin());
+  }
+
+private:
+  std::vector<Field>::const_iterator lowerBound(std::uint32_t ArgIndex) const {
+    return std::lower_bound(Fields.begin(), Fields.end(), ArgIndex,
+                            [](const Field &F, std::uint32_t Idx) {
+                              return F.ArgIndex < Idx;
+                            });
+  }
+};
+
+inline KernelArgPacking createKernelArgPacking(ByteArray Bytes) {
+  // Skip the size of the array in bits.
+  Bytes.dropBytes(8);
+  KernelArgPacking Result;
+  std::tie(Result.PackedArgIndex, Result.PackedSize) =
+      Bytes.consume<std::uint32_t, std::uint32_t>();
+  while (!Bytes.empty()) {
+    auto [ArgIndex, Offset, Size] =
+        Bytes.consume<std::uint32_t, std::uint32_t, std::uint32_t>();
+    Result.Fields.push_back({ArgIndex, Offset, Size});
+  }
+  return Result;
+}
 } // namespace detail
 } // __SYCL_INLINE_VER_NAMESPACE(_V1)
 } // namespace sycl
@@ -360,6 +360,29 @@ bool PersistentDeviceCodeCache::isEnabled() {
   return CacheIsEnabled;
 }
 
+std::string PersistentDeviceCodeCache::getFusionCacheDir() {
+  if (!isEnabled())
+    return {};
+  std::string cache_root{getRootDir()};
+  if (cache_root.empty()) {
+    trace("Disable persistent fusion cache due to unconfigured cache root.");
+    return {};
+  }
+  return cache_root + "/fusion";
+}
+
+std::string PersistentDeviceCodeCache::getFusionCachePruningPolicy() {
+  if (SYCLConfig<SYCL_CACHE_EVICTION_DISABLE>::get())
+    return {};
+  static auto MaxSize = getNumParam<SYCL_CACHE_MAX_SIZE>(
+      DEFAULT_MAX_FUSION_CACHE_SIZE);
+  static auto Threshold = getNumParam<SYCL_CACHE_THRESHOLD>(
+      DEFAULT_FUSION_CACHE_THRESHOLD);
+  // Zero values disable the respective kind of eviction.
+  return "prune_interval=0s:prune_after=" + std::to_string(Threshold * 24) +
+         "h:cache_size_bytes=" + std::to_string(MaxSize) + "m";
+}
+
 /* Returns path for device code cache root directory
  */
 std::string PersistentDeviceCodeCache::getRootDir() {
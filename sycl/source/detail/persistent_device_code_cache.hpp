@@ -159,6 +159,13 @@ private:
   static constexpr unsigned long DEFAULT_MAX_DEVICE_IMAGE_SIZE =
       1024 * 1024 * 1024;
 
+  /* Default value for maximum size of the kernel fusion cache in megabytes */
+  static constexpr unsigned long DEFAULT_MAX_FUSION_CACHE_SIZE = 8192;
+
+  /* Default value for the eviction threshold of the kernel fusion cache in
+   * days */
+  static constexpr unsigned long DEFAULT_FUSION_CACHE_THRESHOLD = 7;
+
 public:
   /* Get directory name for storing current cache item
    */
@@ -184,6 +191,20 @@ public:
                             const std::string &BuildOptionsString,
                             const RT::PiProgram &NativePrg);
 
+  /* Returns the directory storing kernels created by the kernel fusion JIT
+   * compiler or an empty string if the persistent cache is disabled. The
+   * directory is placed next to the device code cache:
+   *   <cache_root>/fusion/llvmcache-<fusion_hash>
+   */
+  static std::string getFusionCacheDir();
+
+  /* Returns the eviction policy for the kernel fusion cache in the format
+   * accepted by llvm::parseCachePruningPolicy or an empty string if eviction
+   * is disabled. Honors SYCL_CACHE_MAX_SIZE (megabytes) and
+   * SYCL_CACHE_THRESHOLD (days).
+   */
+  static std::string getFusionCachePruningPolicy();
+
   /* Sends message to std:cerr stream when SYCL_CACHE_TRACE environemnt is set*/
   static void trace(const std::string &msg) {
     static const char *TraceEnabled = SYCLConfig<SYCL_CACHE_TRACE>::get();
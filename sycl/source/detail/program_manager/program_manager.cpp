@@ -1237,6 +1237,16 @@ void ProgramManager::addImages(pi_device_binaries DeviceBinary) {
             createKernelArgMask(DeviceBinaryProperty(Info).asByteArray());
     }
 
+    // Fill the kernel argument packing map
+    const RTDeviceBinaryImage::PropertyRange &KAPRange =
+        Img->getKernelArgPacking();
+    if (KAPRange.isAvailable()) {
+      KernelNameToArgPackingMap &ArgPackingMap = m_KernelArgPackings[Img.get()];
+      for (const auto &Info : KAPRange)
+        ArgPackingMap[Info->Name] =
+            createKernelArgPacking(DeviceBinaryProperty(Info).asByteArray());
+    }
+
     // Fill maps for kernel bundles
     if (EntriesB != EntriesE) {
       std::lock_guard<std::mutex> KernelIDsGuard(m_KernelIDsMutex);
@@ -1585,6 +1595,37 @@ const KernelArgMask *ProgramManager::getEliminatedKernelArgMask(
   return getEliminatedKernelArgMask(NativePrg, KernelName);
 }
 
+const KernelArgPacking *
+ProgramManager::getKernelArgPacking(pi::PiProgram NativePrg,
+                                    const std::string &KernelName) {
+  // Bail out if no arguments were packed in our images
+  if (m_KernelArgPackings.empty())
+    return nullptr;
+
+  const RTDeviceBinaryImage *Img = nullptr;
+  {
+    std::lock_guard<std::mutex> Lock(MNativeProgramsMutex);
+    auto ImgIt = NativePrograms.find(NativePrg);
+    if (ImgIt != NativePrograms.end())
+      Img = ImgIt->second;
+  }
+
+  // Unlike the eliminated argument masks, the packing can't be looked up in
+  // other images: an image built without packing may contain a kernel with
+  // the same name.
+  return Img ? getKernelArgPacking(Img, KernelName) : nullptr;
+}
+
+const KernelArgPacking *
+ProgramManager::getKernelArgPacking(const RTDeviceBinaryImage *Img,
+                                    const std::string &KernelName) {
+  auto MapIt = m_KernelArgPackings.find(Img);
+  if (MapIt == m_KernelArgPackings.end())
+    return nullptr;
+  auto PackingIt = MapIt->second.find(KernelName);
+  return PackingIt != MapIt->second.end() ? &PackingIt->second : nullptr;
+}
+
 static bundle_state getBinImageState(const RTDeviceBinaryImage *BinImage) {
   auto IsAOTBinary = [](const char *Format) {
     return (
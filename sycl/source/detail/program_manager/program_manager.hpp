@@ -193,6 +193,23 @@ public:
   getEliminatedKernelArgMask(OSModuleHandle M, pi::PiProgram NativePrg,
                              const std::string &KernelName);
 
+  /// Returns the layout of the argument the device compiler packed accessor
+  /// fields of the requested kernel into, or nullptr if the kernel has no
+  /// packed arguments.
+  /// \param NativePrg the PI program associated with the kernel.
+  /// \param KernelName the name of the kernel.
+  const KernelArgPacking *getKernelArgPacking(pi::PiProgram NativePrg,
+                                              const std::string &KernelName);
+
+  /// Returns the layout of the packed argument of the requested kernel within
+  /// the device image, or nullptr if the kernel has no packed arguments.
+  /// Unlike the lookup by native program, this also works for programs not
+  /// built by the program manager, e.g., linked ones.
+  /// \param Img the device image containing the kernel.
+  /// \param KernelName the name of the kernel.
+  const KernelArgPacking *getKernelArgPacking(const RTDeviceBinaryImage *Img,
+                                              const std::string &KernelName);
+
   // The function returns the unique SYCL kernel identifier associated with a
   // kernel name.
   kernel_id getSYCLKernelID(const std::string &KernelName);
@@ -431,6 +448,13 @@ private:
   std::unordered_map<const RTDeviceBinaryImage *, KernelNameToArgMaskMap>
       m_EliminatedKernelArgMasks;
 
+  using KernelNameToArgPackingMap =
+      std::unordered_map<std::string, KernelArgPacking>;
+  /// Maps binary image and kernel name pairs to the layouts of the arguments
+  /// accessor fields were packed into during device code optimization.
+  std::unordered_map<const RTDeviceBinaryImage *, KernelNameToArgPackingMap>
+      m_KernelArgPackings;
+
   /// True iff a SPIR-V file has been specified with an environment variable
   bool m_UseSpvFile = false;
 
@@ -470,6 +470,13 @@ void queue_impl::wait(const detail::code_location &CodeLoc) {
   TelemetryEvent = instrumentationProlog(CodeLoc, Name, StreamID, IId);
 #endif
 
+  // Kernels collected for automatic fusion are fused and enqueued now, waiting
+  // on their events would otherwise abort the fusion.
+  if (isAutoFusionEnabled())
+    Scheduler::getInstance().completeAutoFusion(
+        std::hash<typename std::shared_ptr<queue_impl>::element_type *>()(
+            this));
+
   std::vector<std::weak_ptr<event_impl>> WeakEvents;
   std::vector<event> SharedEvents;
   {
@@ -25,6 +25,7 @@
 #include <sycl/event.hpp>
 #include <sycl/exception.hpp>
 #include <sycl/exception_list.hpp>
+#include <sycl/ext/codeplay/experimental/fusion_properties.hpp>
 #include <sycl/handler.hpp>
 #include <sycl/properties/context_properties.hpp>
 #include <sycl/properties/queue_properties.hpp>
@@ -163,6 +164,16 @@ public:
             "Queue compute index must be a non-negative number less than "
             "device's number of available compute queue indices.");
     }
+    if (has_property<
+            ext::codeplay::experimental::property::queue::auto_fusion>()) {
+      if (!MIsInorder ||
+          !has_property<
+              ext::codeplay::experimental::property::queue::enable_fusion>())
+        throw sycl::exception(
+            make_error_code(errc::invalid),
+            "Automatic kernel fusion requires an in-order queue with the "
+            "enable_fusion property.");
+    }
     if (!Context->isDeviceValid(Device)) {
       if (!Context->is_host() && Context->getBackend() == backend::opencl)
         throw sycl::invalid_object_error(
@@ -632,6 +643,17 @@ public:
             this));
   }
 
+  /// Check whether kernels submitted to this queue are fused automatically.
+  ///
+  /// \return true if the queue was created with the auto_fusion property.
+  bool isAutoFusionEnabled() const {
+    return MIsInorder &&
+           has_property<
+               ext::codeplay::experimental::property::queue::auto_fusion>() &&
+           has_property<
+               ext::codeplay::experimental::property::queue::enable_fusion>();
+  }
+
   event memcpyToDeviceGlobal(const std::shared_ptr<queue_impl> &Self,
                              void *DeviceGlobalPtr, const void *Src,
                              bool IsDeviceImageScope, size_t NumBytes,
@@ -30,6 +30,7 @@
 #include <sycl/sampler.hpp>
 
 #include <cassert>
+#include <cstring>
 #include <optional>
 #include <string>
 #include <vector>
@@ -2179,11 +2180,30 @@ static pi_result SetKernelParamsAndLaunch(
     const std::shared_ptr<device_image_impl> &DeviceImageImpl,
     RT::PiKernel Kernel, NDRDescT &NDRDesc, std::vector<RT::PiEvent> &RawEvents,
     RT::PiEvent *OutEvent, const KernelArgMask *EliminatedArgMask,
+    const KernelArgPacking *ArgPacking,
     const std::function<void *(Requirement *Req)> &getMemAllocationFunc) {
   const PluginPtr &Plugin = Queue->getPlugin();
 
+  // Values of the arguments which the device compiler packed into one, set
+  // with a single call once all of them are collected.
+  std::vector<unsigned char> PackedArg;
+  if (ArgPacking)
+    PackedArg.resize(ArgPacking->PackedSize);
+
   auto setFunc = [&Plugin, Kernel, &DeviceImageImpl, &getMemAllocationFunc,
-                  &Queue](detail::ArgDesc &Arg, size_t NextTrueIndex) {
+                  &Queue, ArgPacking,
+                  &PackedArg](detail::ArgDesc &Arg, size_t NextTrueIndex) {
+    if (ArgPacking) {
+      if (const KernelArgPacking::Field *Field =
+              ArgPacking->findField(NextTrueIndex)) {
+        assert(Arg.MType == kernel_param_kind_t::kind_std_layout &&
+               Arg.MSize == static_cast<int>(Field->Size) &&
+               "Unexpected packed kernel argument");
+        std::memcpy(PackedArg.data() + Field->Offset, Arg.MPtr, Field->Size);
+        return;
+      }
+      NextTrueIndex = ArgPacking->getIndexAfterPacking(NextTrueIndex);
+    }
     switch (Arg.MType) {
     case kernel_param_kind_t::kind_stream:
       break;
@@ -2245,6 +2265,9 @@ static pi_result SetKernelParamsAndLaunch(
   };
 
   applyFuncOnFilteredArgs(EliminatedArgMask, Args, setFunc);
+  if (ArgPacking)
+    Plugin->call<PiApiKind::piKernelSetArg>(Kernel, ArgPacking->PackedArgIndex,
+                                            PackedArg.size(), PackedArg.data());
 
   adjustNDRangePerKernel(NDRDesc, Kernel, *(Queue->getDeviceImplPtr()));
 
@@ -2376,6 +2399,19 @@ pi_int32 enqueueImpKernel(
             OSModuleHandle, ContextImpl, DeviceImpl, KernelName, nullptr);
   }
 
+  // Programs created by linking device images are not known to the program
+  // manager, so look the packing up by the device image where there is one.
+  const std::shared_ptr<device_image_impl> &KernelImageImpl =
+      DeviceImageImpl || !MSyclKernel ? DeviceImageImpl
+                                      : MSyclKernel->getDeviceImage();
+  const RTDeviceBinaryImage *BinImage =
+      KernelImageImpl ? KernelImageImpl->get_bin_image_ref() : nullptr;
+  const KernelArgPacking *ArgPacking =
+      BinImage ? detail::ProgramManager::getInstance().getKernelArgPacking(
+                     BinImage, KernelName)
+               : detail::ProgramManager::getInstance().getKernelArgPacking(
+                     Program, KernelName);
+
   // We may need more events for the launch, so we make another reference.
   std::vector<RT::PiEvent> &EventsWaitList = RawEvents;
 
@@ -2411,7 +2447,8 @@ pi_int32 enqueueImpKernel(
 
     Error = SetKernelParamsAndLaunch(Queue, Args, DeviceImageImpl, Kernel,
                                      NDRDesc, EventsWaitList, OutEvent,
-                                     EliminatedArgMask, getMemAllocationFunc);
+                                     EliminatedArgMask, ArgPacking,
+                                     getMemAllocationFunc);
   }
   if (PI_SUCCESS != Error) {
     // If we have got non-success error code, let's analyze it to emit nice
@@ -2919,9 +2956,10 @@ bool ExecCGCommand::readyForCleanup() const {
   return Command::readyForCleanup();
 }
 
-KernelFusionCommand::KernelFusionCommand(QueueImplPtr Queue)
+KernelFusionCommand::KernelFusionCommand(QueueImplPtr Queue,
+                                         bool IsAutoFusion)
     : Command(Command::CommandType::FUSION, Queue),
-      MStatus(FusionStatus::ACTIVE) {
+      MStatus(FusionStatus::ACTIVE), MIsAutoFusion(IsAutoFusion) {
   emitInstrumentationDataProxy();
 }
 
@@ -688,7 +688,7 @@ class KernelFusionCommand : public Command {
 public:
   enum class FusionStatus { ACTIVE, CANCELLED, COMPLETE, DELETED };
 
-  explicit KernelFusionCommand(QueueImplPtr Queue);
+  explicit KernelFusionCommand(QueueImplPtr Queue, bool IsAutoFusion = false);
 
   void printDot(std::ostream &Stream) const final;
   void emitInstrumentationData() final;
@@ -709,6 +709,10 @@ public:
 
   bool readyForDeletion() const { return MStatus == FusionStatus::DELETED; }
 
+  /// Check whether this fusion was started by the runtime for a queue with the
+  /// auto_fusion property rather than by the user.
+  bool isAutoFusion() const { return MIsAutoFusion; }
+
 private:
   pi_int32 enqueueImp() final;
 
@@ -717,6 +721,8 @@ private:
   std::vector<Command *> MAuxiliaryCommands;
 
   FusionStatus MStatus;
+
+  bool MIsAutoFusion;
 };
 
 } // namespace detail
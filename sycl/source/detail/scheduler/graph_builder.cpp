@@ -1349,7 +1349,8 @@ Command *Scheduler::GraphBuilder::connectDepEvent(
   return ConnectCmd;
 }
 
-void Scheduler::GraphBuilder::startFusion(QueueImplPtr Queue) {
+void Scheduler::GraphBuilder::startFusion(QueueImplPtr Queue,
+                                          bool IsAutoFusion) {
   auto QUniqueID = std::hash<QueueImplPtr>()(Queue);
   if (isInFusionMode(QUniqueID)) {
     throw sycl::exception{sycl::make_error_code(sycl::errc::invalid),
@@ -1366,7 +1367,8 @@ void Scheduler::GraphBuilder::startFusion(QueueImplPtr Queue) {
     cleanupCommand(OldFusionCmd->second.release());
     MFusionMap.erase(OldFusionCmd);
   }
-  MFusionMap.emplace(QUniqueID, std::make_unique<KernelFusionCommand>(Queue));
+  MFusionMap.emplace(QUniqueID,
+                     std::make_unique<KernelFusionCommand>(Queue, IsAutoFusion));
 }
 
 void Scheduler::GraphBuilder::removeNodeFromGraph(
@@ -1631,6 +1633,149 @@ bool Scheduler::GraphBuilder::isInFusionMode(QueueIdT Id) {
   return FusionList->second->isActive();
 }
 
+static bool haveSameNDRange(const NDRDescT &LHS, const NDRDescT &RHS) {
+  return LHS.Dims == RHS.Dims && LHS.GlobalSize == RHS.GlobalSize &&
+         LHS.LocalSize == RHS.LocalSize &&
+         LHS.GlobalOffset == RHS.GlobalOffset &&
+         LHS.NumWorkGroups == RHS.NumWorkGroups;
+}
+
+// Check whether Consumer uses a buffer written by Producer or a USM pointer
+// also passed to Producer. USM accesses are not known to the runtime, so any
+// pointer shared between the two kernels is treated as a dependency.
+static bool isProducerConsumerPair(CGExecKernel &Producer,
+                                   CGExecKernel &Consumer) {
+  for (Requirement *ConsumerReq : Consumer.getRequirements()) {
+    for (Requirement *ProducerReq : Producer.getRequirements()) {
+      if (ConsumerReq->MSYCLMemObj == ProducerReq->MSYCLMemObj &&
+          ProducerReq->MAccessMode != access::mode::read) {
+        return true;
+      }
+    }
+  }
+  for (const ArgDesc &ConsumerArg : Consumer.MArgs) {
+    if (ConsumerArg.MType != kernel_param_kind_t::kind_pointer) {
+      continue;
+    }
+    for (const ArgDesc &ProducerArg : Producer.MArgs) {
+      if (ProducerArg.MType == kernel_param_kind_t::kind_pointer &&
+          ProducerArg.MSize == ConsumerArg.MSize &&
+          std::memcmp(ProducerArg.MPtr, ConsumerArg.MPtr, ConsumerArg.MSize) ==
+              0) {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+bool Scheduler::GraphBuilder::prepareAutoFusion(
+    CG &CommandGroup, bool HasAuxiliaryResources, const QueueImplPtr &Queue,
+    std::vector<Command *> &ToEnqueue) {
+#if SYCL_EXT_CODEPLAY_KERNEL_FUSION
+  // Streams and reductions rely on auxiliary resources and commands that
+  // cannot be attached to a fused kernel.
+  bool IsFusible = CommandGroup.getType() == CG::Kernel &&
+                   !static_cast<CGExecKernel &>(CommandGroup)
+                        .MKernelName.empty() &&
+                   !HasAuxiliaryResources;
+  auto QUniqueID = std::hash<QueueImplPtr>()(Queue);
+  if (!isInFusionMode(QUniqueID)) {
+    return IsFusible;
+  }
+  auto *FusionCmd = findFusionList(QUniqueID)->second.get();
+  if (!FusionCmd->isAutoFusion()) {
+    // Leave fusion started by the user alone.
+    return false;
+  }
+  auto &CmdList = FusionCmd->getFusionList();
+  if (CmdList.empty()) {
+    return IsFusible;
+  }
+  if (!IsFusible) {
+    completeAutoFusion(QUniqueID, "a command that cannot be fused", ToEnqueue);
+    return false;
+  }
+
+  auto &Kernel = static_cast<CGExecKernel &>(CommandGroup);
+  auto &FirstKernel = static_cast<CGExecKernel &>(CmdList.front()->getCG());
+  if (!haveSameNDRange(Kernel.MNDRDesc, FirstKernel.MNDRDesc)) {
+    completeAutoFusion(QUniqueID,
+                       "kernel '" + Kernel.MKernelName +
+                           "' with a different ND-range",
+                       ToEnqueue);
+    return true;
+  }
+  bool ConsumesFusionList =
+      std::any_of(CmdList.begin(), CmdList.end(), [&](ExecCGCommand *Cmd) {
+        return isProducerConsumerPair(static_cast<CGExecKernel &>(Cmd->getCG()),
+                                      Kernel);
+      });
+  if (!ConsumesFusionList) {
+    completeAutoFusion(QUniqueID,
+                       "kernel '" + Kernel.MKernelName +
+                           "' not consuming results of the list",
+                       ToEnqueue);
+  }
+  return true;
+#else  // SYCL_EXT_CODEPLAY_KERNEL_FUSION
+  (void)CommandGroup;
+  (void)HasAuxiliaryResources;
+  (void)Queue;
+  (void)ToEnqueue;
+  return false;
+#endif // SYCL_EXT_CODEPLAY_KERNEL_FUSION
+}
+
+void Scheduler::GraphBuilder::completeAutoFusion(
+    QueueIdT Queue, const std::string &Reason,
+    std::vector<Command *> &ToEnqueue) {
+  if (!isInFusionMode(Queue)) {
+    return;
+  }
+  auto *FusionCmd = findFusionList(Queue)->second.get();
+  if (!FusionCmd->isAutoFusion()) {
+    return;
+  }
+  auto &CmdList = FusionCmd->getFusionList();
+  std::string KernelNames;
+  for (auto *Cmd : CmdList) {
+    KernelNames += (KernelNames.empty() ? "'" : ", '") +
+                   static_cast<CGExecKernel &>(Cmd->getCG()).MKernelName + "'";
+  }
+  // Fusing a single kernel has no benefit, but still requires JIT compilation.
+  if (CmdList.size() < 2) {
+    if (!CmdList.empty()) {
+      printFusionInfo("Automatic fusion: not fusing single kernel " +
+                      KernelNames + ", list closed by " + Reason);
+    }
+    cancelFusion(FusionCmd->getQueue(), ToEnqueue);
+    return;
+  }
+  printFusionInfo("Automatic fusion: fusing " + std::to_string(CmdList.size()) +
+                  " kernels (" + KernelNames +
+                  ") with the same ND-range and producer-consumer "
+                  "dependencies, list closed by " +
+                  Reason);
+  completeFusion(FusionCmd->getQueue(), ToEnqueue, property_list{});
+}
+
+void Scheduler::GraphBuilder::cancelAutoFusion(
+    std::vector<Command *> &ToEnqueue) {
+  for (auto &Entry : MFusionMap) {
+    KernelFusionCommand *FusionCmd = Entry.second.get();
+    if (!FusionCmd->isActive() || !FusionCmd->isAutoFusion()) {
+      continue;
+    }
+    if (!FusionCmd->getFusionList().empty()) {
+      printFusionInfo("Automatic fusion: not fusing " +
+                      std::to_string(FusionCmd->getFusionList().size()) +
+                      " kernel(s), list closed by runtime teardown");
+    }
+    cancelFusion(FusionCmd->getQueue(), ToEnqueue);
+  }
+}
+
 } // namespace detail
 } // __SYCL_INLINE_VER_NAMESPACE(_V1)
 } // namespace sycl
@@ -12,6 +12,10 @@
 #include <detail/scheduler/scheduler.hpp>
 #include <detail/stream_impl.hpp>
 #include <sycl/device_selector.hpp>
+#include <sycl/feature_test.hpp>
+#if SYCL_EXT_CODEPLAY_KERNEL_FUSION
+#include <detail/jit_compiler.hpp>
+#endif // SYCL_EXT_CODEPLAY_KERNEL_FUSION
 
 #include <chrono>
 #include <cstdio>
@@ -109,12 +113,34 @@ EventImplPtr Scheduler::addCG(std::unique_ptr<detail::CG> CommandGroup,
         Stream->initStreamHost(Queue);
       }
     }
+#if SYCL_EXT_CODEPLAY_KERNEL_FUSION
+    // JIT-specialize selected kernels on the values of their scalar
+    // arguments. This happens before taking the graph lock, as it might
+    // involve JIT compilation.
+    if (!Queue->is_host() && Streams.empty() && AuxiliaryResources.empty() &&
+        !SYCLConfig<SYCL_JIT_SPECIALIZE_KERNELS>::get().empty()) {
+      jit_compiler::get_instance().specializeKernel(Queue, *CGExecKernelPtr);
+    }
+#endif // SYCL_EXT_CODEPLAY_KERNEL_FUSION
   }
 
+  std::vector<Command *> AutoFusionCmds;
   bool ShouldEnqueue = true;
   {
     WriteLockT Lock = acquireWriteLock();
 
+    // For queues with automatic fusion, close the active fusion list if this
+    // command group cannot join it, and start a new list if none is active.
+    // This happens under the same lock as adding the command group, so no other
+    // submission to the queue can close or start a list in between.
+    if (Queue->isAutoFusionEnabled() &&
+        MGraphBuilder.prepareAutoFusion(
+            *CommandGroup, !Streams.empty() || !AuxiliaryResources.empty(),
+            Queue, AutoFusionCmds) &&
+        !MGraphBuilder.isInFusionMode(std::hash<QueueImplPtr>()(Queue))) {
+      MGraphBuilder.startFusion(Queue, /*IsAutoFusion=*/true);
+    }
+
     Command *NewCmd = nullptr;
     switch (Type) {
     case CG::UpdateHost:
@@ -140,6 +166,10 @@ EventImplPtr Scheduler::addCG(std::unique_ptr<detail::CG> CommandGroup,
     NewEvent->setSubmissionTime();
   }
 
+  // The commands of a closed automatic fusion list precede the new command.
+  if (!AutoFusionCmds.empty())
+    enqueueCommandForCG(nullptr, AutoFusionCmds);
+
   if (ShouldEnqueue) {
     enqueueCommandForCG(NewEvent, AuxiliaryCmds);
 
@@ -394,6 +424,19 @@ Scheduler::Scheduler() {
 Scheduler::~Scheduler() { DefaultHostQueue.reset(); }
 
 void Scheduler::releaseResources() {
+  // The commands of an automatic fusion list keep their queue alive, so the
+  // list cannot be closed when the queue is destroyed. Enqueue the collected
+  // kernels unfused now, instead of losing them.
+  {
+    std::vector<Command *> ToEnqueue;
+    {
+      WriteLockT Lock = acquireWriteLock();
+      MGraphBuilder.cancelAutoFusion(ToEnqueue);
+    }
+    if (!ToEnqueue.empty())
+      enqueueCommandForCG(nullptr, ToEnqueue);
+  }
+
   //  There might be some commands scheduled for post enqueue cleanup that
   //  haven't been freed because of the graph mutex being locked at the time,
   //  clean them up now.
@@ -563,8 +606,18 @@ void Scheduler::cleanupAuxiliaryResources(BlockingT Blocking) {
 thread_local bool Scheduler::ForceDeferredMemObjRelease = false;
 
 void Scheduler::startFusion(QueueImplPtr Queue) {
-  WriteLockT Lock = acquireWriteLock();
-  MGraphBuilder.startFusion(Queue);
+  std::vector<Command *> ToEnqueue;
+  {
+    WriteLockT Lock = acquireWriteLock();
+    // Fusion requested by the user takes precedence over automatic fusion.
+    if (Queue->isAutoFusionEnabled())
+      MGraphBuilder.completeAutoFusion(std::hash<QueueImplPtr>()(Queue),
+                                       "fusion started by the user",
+                                       ToEnqueue);
+    MGraphBuilder.startFusion(Queue);
+  }
+  if (!ToEnqueue.empty())
+    enqueueCommandForCG(nullptr, ToEnqueue);
 }
 
 void Scheduler::cancelFusion(QueueImplPtr Queue) {
@@ -594,12 +647,27 @@ bool Scheduler::isInFusionMode(QueueIdT queue) {
   return MGraphBuilder.isInFusionMode(queue);
 }
 
+void Scheduler::completeAutoFusion(QueueIdT Queue) {
+  std::vector<Command *> ToEnqueue;
+  {
+    WriteLockT Lock = acquireWriteLock();
+    MGraphBuilder.completeAutoFusion(Queue, "synchronization", ToEnqueue);
+  }
+  enqueueCommandForCG(nullptr, ToEnqueue);
+}
+
 void Scheduler::printFusionWarning(const std::string &Message) {
   if (detail::SYCLConfig<detail::SYCL_RT_WARNING_LEVEL>::get() > 0) {
     std::cerr << "WARNING: " << Message << "\n";
   }
 }
 
+void Scheduler::printFusionInfo(const std::string &Message) {
+  if (detail::SYCLConfig<detail::SYCL_RT_WARNING_LEVEL>::get() > 0) {
+    std::cerr << "INFO: " << Message << "\n";
+  }
+}
+
 KernelFusionCommand *Scheduler::isPartOfActiveFusion(Command *Cmd) {
   auto CmdType = Cmd->getType();
   switch (CmdType) {
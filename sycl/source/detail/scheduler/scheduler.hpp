@@ -448,6 +448,13 @@ public:
 
   bool isInFusionMode(QueueIdT Queue);
 
+  /// Completes the fusion list collected automatically for a queue with the
+  /// auto_fusion property, e.g., before waiting on the queue. Does nothing if
+  /// no automatic fusion is active for the queue.
+  ///
+  /// \param Queue is the unique ID of the queue.
+  void completeAutoFusion(QueueIdT Queue);
+
   Scheduler();
   ~Scheduler();
   void releaseResources();
@@ -612,7 +619,7 @@ protected:
                              const DepDesc &Dep,
                              std::vector<Command *> &ToCleanUp);
 
-    void startFusion(QueueImplPtr Queue);
+    void startFusion(QueueImplPtr Queue, bool IsAutoFusion = false);
 
     void cancelFusion(QueueImplPtr Queue, std::vector<Command *> &ToEnqueue);
 
@@ -622,6 +629,34 @@ protected:
 
     bool isInFusionMode(QueueIdT queue);
 
+    /// Decides how a command group submitted to a queue with the auto_fusion
+    /// property interacts with the automatic fusion list of that queue. If the
+    /// command group cannot join the active list, the list is completed (or
+    /// cancelled if it holds a single kernel). Fusion started by the user is
+    /// never altered.
+    ///
+    /// \param CommandGroup is the command group about to be added.
+    /// \param HasAuxiliaryResources is true if the command group uses streams
+    /// or reductions, which prevent fusion.
+    /// \param Queue is the queue the command group is submitted to.
+    /// \param ToEnqueue is the list of commands to enqueue after the lock is
+    /// released.
+    /// \returns true if the command group should be added to an automatic
+    /// fusion list, starting a new one if none is active.
+    bool prepareAutoFusion(CG &CommandGroup, bool HasAuxiliaryResources,
+                           const QueueImplPtr &Queue,
+                           std::vector<Command *> &ToEnqueue);
+
+    /// Completes the active automatic fusion list of a queue, reporting
+    /// \p Reason as the reason for closing the list.
+    void completeAutoFusion(QueueIdT Queue, const std::string &Reason,
+                            std::vector<Command *> &ToEnqueue);
+
+    /// Cancels the active automatic fusion lists of all queues, so the
+    /// collected kernels are enqueued unfused. Fusion started by the user is
+    /// not affected.
+    void cancelAutoFusion(std::vector<Command *> &ToEnqueue);
+
     std::vector<SYCLMemObjI *> MMemObjs;
 
   private:
@@ -894,6 +929,8 @@ protected:
 private:
   static void printFusionWarning(const std::string &Message);
 
+  static void printFusionInfo(const std::string &Message);
+
   static KernelFusionCommand *isPartOfActiveFusion(Command *Cmd);
 };
 
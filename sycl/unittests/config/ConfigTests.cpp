@@ -229,3 +229,92 @@ TEST(ConfigTests, CheckConfigProcessing) {
             sycl::detail::SYCLConfig<
                 sycl::detail::SYCL_PRINT_EXECUTION_GRAPH>::get());
 }
+
+TEST(ConfigTests, CheckJITSpecializeKernelsProcessing) {
+  using SpecializeConfig =
+      sycl::detail::SYCLConfig<sycl::detail::SYCL_JIT_SPECIALIZE_KERNELS>;
+  auto SetConfig = [](const char *Value) {
+#ifdef _WIN32
+    _putenv_s("SYCL_JIT_SPECIALIZE_KERNELS", Value);
+#else
+    setenv("SYCL_JIT_SPECIALIZE_KERNELS", Value, 1);
+#endif
+    SpecializeConfig::reset();
+  };
+
+  // Check kernels with and without argument indices, and empty entries
+  SetConfig("KernelA;;KernelB:0,2;KernelC:");
+  const SpecializeConfig::ParsedValue &Parsed = SpecializeConfig::get();
+  EXPECT_EQ(Parsed.size(), 3u);
+  ASSERT_EQ(Parsed.count("KernelA"), 1u);
+  EXPECT_TRUE(Parsed.at("KernelA").empty());
+  ASSERT_EQ(Parsed.count("KernelB"), 1u);
+  EXPECT_EQ(Parsed.at("KernelB"), (std::vector<size_t>{0, 2}));
+  ASSERT_EQ(Parsed.count("KernelC"), 1u);
+  EXPECT_TRUE(Parsed.at("KernelC").empty());
+
+  // Check invalid argument index
+  try {
+    SetConfig("KernelA:1,x");
+    throw std::logic_error("sycl::exception didn't throw");
+  } catch (sycl::exception &e) {
+    EXPECT_EQ(std::string("Invalid value for SYCL_JIT_SPECIALIZE_KERNELS "
+                          "environment variable: Argument index \"x\" must be "
+                          "a number"),
+              e.what());
+  } catch (...) {
+    FAIL() << "Check invalid argument index failed";
+  }
+
+#ifdef _WIN32
+  _putenv_s("SYCL_JIT_SPECIALIZE_KERNELS", "");
+#else
+  unsetenv("SYCL_JIT_SPECIALIZE_KERNELS");
+#endif
+  SpecializeConfig::reset();
+  EXPECT_TRUE(SpecializeConfig::get().empty());
+}
+
+TEST(ConfigTests, CheckFusionCacheMaxSizeProcessing) {
+  using MaxSizeConfig =
+      sycl::detail::SYCLConfig<sycl::detail::SYCL_FUSION_CACHE_MAX_SIZE>;
+  auto SetConfig = [](const char *Value) {
+#ifdef _WIN32
+    _putenv_s("SYCL_FUSION_CACHE_MAX_SIZE", Value);
+#else
+    setenv("SYCL_FUSION_CACHE_MAX_SIZE", Value, 1);
+#endif
+    MaxSizeConfig::reset();
+  };
+
+  SetConfig("1024");
+  EXPECT_EQ(MaxSizeConfig::get(), 1024u);
+
+  // Zero disables the bound
+  SetConfig("0");
+  EXPECT_EQ(MaxSizeConfig::get(), 0u);
+
+  for (const char *Invalid : {"abc", "12abc", "-1"}) {
+    SetConfig(Invalid);
+    try {
+      MaxSizeConfig::get();
+      throw std::logic_error("sycl::exception didn't throw");
+    } catch (sycl::exception &e) {
+      EXPECT_EQ(std::string("Invalid value for SYCL_FUSION_CACHE_MAX_SIZE "
+                            "environment variable: Value \"") +
+                    Invalid + "\" must be a number",
+                e.what());
+    } catch (...) {
+      FAIL() << "Check invalid value \"" << Invalid << "\" failed";
+    }
+  }
+
+  // Check the default of 64 MiB
+#ifdef _WIN32
+  _putenv_s("SYCL_FUSION_CACHE_MAX_SIZE", "");
+#else
+  unsetenv("SYCL_FUSION_CACHE_MAX_SIZE");
+#endif
+  MaxSizeConfig::reset();
+  EXPECT_EQ(MaxSizeConfig::get(), size_t{64 * 1024 * 1024});
+}
@@ -0,0 +1,146 @@
+//==------- KernelArgPacking.cpp --- packed kernel arguments unit test -----==//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#include <sycl/sycl.hpp>
+
+#include <helpers/MockKernelInfo.hpp>
+#include <helpers/PiImage.hpp>
+#include <helpers/PiMock.hpp>
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <map>
+
+class KAPTestKernel;
+constexpr const char KAPTestKernelName[] = "KAPTestKernel";
+
+namespace sycl {
+__SYCL_INLINE_VER_NAMESPACE(_V1) {
+namespace detail {
+static constexpr const kernel_param_desc_t KAPSignatures[] = {
+    {kernel_param_kind_t::kind_std_layout, sizeof(int), 0},
+    {kernel_param_kind_t::kind_std_layout, sizeof(int), sizeof(int)},
+    {kernel_param_kind_t::kind_std_layout, sizeof(int), 2 * sizeof(int)}};
+
+template <>
+struct KernelInfo<KAPTestKernel> : public unittest::MockKernelInfoBase {
+  static constexpr unsigned getNumParams() { return 3; }
+  static constexpr const kernel_param_desc_t &getParamDesc(unsigned Idx) {
+    return KAPSignatures[Idx];
+  }
+  static constexpr const char *getName() { return KAPTestKernelName; }
+  static constexpr int64_t getKernelSize() { return 3 * sizeof(int); }
+};
+} // namespace detail
+} // __SYCL_INLINE_VER_NAMESPACE(_V1)
+} // namespace sycl
+
+static sycl::unittest::PiImage generateKAPTestKernelImage() {
+  using namespace sycl::unittest;
+
+  // The 2nd and 3rd arguments are packed into the 2nd one, in reverse order.
+  std::vector<std::uint32_t> Packing{/*PackedArgIndex=*/1, /*PackedSize=*/8,
+                                     1, 4, sizeof(int),
+                                     2, 0, sizeof(int)};
+  const std::uint64_t SizeInBits = Packing.size() * sizeof(std::uint32_t) * 8;
+  std::vector<char> DescData(sizeof(SizeInBits) +
+                             Packing.size() * sizeof(std::uint32_t));
+  std::memcpy(DescData.data(), &SizeInBits, sizeof(SizeInBits));
+  std::memcpy(DescData.data() + sizeof(SizeInBits), Packing.data(),
+              Packing.size() * sizeof(std::uint32_t));
+  PiProperty KAPKernelProp{KAPTestKernelName, std::move(DescData),
+                           PI_PROPERTY_TYPE_BYTE_ARRAY};
+  PiArray<PiProperty> ImgKAP{std::move(KAPKernelProp)};
+
+  PiPropertySet PropSet;
+  PropSet.insert(__SYCL_PI_PROPERTY_SET_KERNEL_ARG_PACKING, std::move(ImgKAP));
+
+  std::vector<unsigned char> Bin{12, 13, 14, 15, 16, 17}; // Random data
+
+  PiArray<PiOffloadEntry> Entries = makeEmptyKernels({KAPTestKernelName});
+
+  PiImage Img{PI_DEVICE_BINARY_TYPE_SPIRV,            // Format
+              __SYCL_PI_DEVICE_BINARY_TARGET_SPIRV64, // DeviceTargetSpec
+              "",                                     // Compile options
+              "",                                     // Link options
+              std::move(Bin),
+              std::move(Entries),
+              std::move(PropSet)};
+
+  return Img;
+}
+
+static sycl::unittest::PiImage KAPImg = generateKAPTestKernelImage();
+static sycl::unittest::PiImageArray<1> KAPImgArray{&KAPImg};
+
+static std::map<pi_uint32, std::vector<unsigned char>> SetArgs;
+
+static pi_result redefinedKernelSetArg(pi_kernel, pi_uint32 ArgIndex,
+                                       size_t ArgSize, const void *ArgValue) {
+  auto *Bytes = static_cast<const unsigned char *>(ArgValue);
+  SetArgs[ArgIndex].assign(Bytes, Bytes + ArgSize);
+  return PI_SUCCESS;
+}
+
+// Checks that the arguments packed by the device compiler were set with a
+// single call, and that the indices of the other arguments are not affected.
+static void checkSetArgs() {
+  ASSERT_EQ(SetArgs.size(), 2u);
+  int Expected[] = {1};
+  ASSERT_EQ(SetArgs[0].size(), sizeof(int));
+  EXPECT_EQ(std::memcmp(SetArgs[0].data(), Expected, sizeof(int)), 0);
+
+  int ExpectedPacked[] = {3, 2};
+  ASSERT_EQ(SetArgs[1].size(), sizeof(ExpectedPacked));
+  EXPECT_EQ(
+      std::memcmp(SetArgs[1].data(), ExpectedPacked, sizeof(ExpectedPacked)),
+      0);
+}
+
+TEST(KernelArgPacking, PackedArgsAreSetOnce) {
+  sycl::unittest::PiMock Mock;
+  sycl::platform Plt = Mock.getPlatform();
+  Mock.redefineBefore<sycl::detail::PiApiKind::piKernelSetArg>(
+      redefinedKernelSetArg);
+  SetArgs.clear();
+
+  sycl::queue Queue{Plt.get_devices()[0]};
+  int A = 1, B = 2, C = 3;
+  Queue.single_task<KAPTestKernel>([=] { (void)(A + B + C); }).wait();
+
+  checkSetArgs();
+}
+
+// The program created by linking is not built by the program manager, so the
+// packing has to be found through the device image of the kernel.
+TEST(KernelArgPacking, PackedArgsOfLinkedKernel) {
+  sycl::unittest::PiMock Mock;
+  sycl::platform Plt = Mock.getPlatform();
+  Mock.redefineBefore<sycl::detail::PiApiKind::piKernelSetArg>(
+      redefinedKernelSetArg);
+  SetArgs.clear();
+
+  const sycl::device Dev = Plt.get_devices()[0];
+  sycl::queue Queue{Dev};
+  auto InputBundle =
+      sycl::get_kernel_bundle<KAPTestKernel, sycl::bundle_state::input>(
+          Queue.get_context(), {Dev});
+  auto ObjBundle = sycl::compile(InputBundle, InputBundle.get_devices());
+  auto ExecBundle = sycl::link(ObjBundle, ObjBundle.get_devices());
+
+  int A = 1, B = 2, C = 3;
+  Queue
+      .submit([&](sycl::handler &CGH) {
+        CGH.use_kernel_bundle(ExecBundle);
+        CGH.single_task<KAPTestKernel>([=] { (void)(A + B + C); });
+      })
+      .wait();
+
+  checkSetArgs();
+}
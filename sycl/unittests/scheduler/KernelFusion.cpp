@@ -8,20 +8,26 @@
 
 #include "SchedulerTest.hpp"
 #include "SchedulerTestUtils.hpp"
+#include <detail/config.hpp>
+#include <detail/jit_compiler.hpp>
 
 #include <helpers/PiMock.hpp>
 #include <helpers/ScopedEnvVar.hpp>
 #include <helpers/TestKernel.hpp>
 
+#include <sycl/ext/codeplay/experimental/fusion_properties.hpp>
+
+#include <chrono>
+#include <future>
+#include <mutex>
 #include <vector>
 
 using namespace sycl;
 using EventImplPtr = std::shared_ptr<detail::event_impl>;
 
 template <typename T, int Dim>
-detail::Command *CreateTaskCommand(MockScheduler &MS,
-                                   detail::QueueImplPtr DevQueue,
-                                   buffer<T, Dim> &buf) {
+std::unique_ptr<detail::CG> CreateTaskCG(detail::QueueImplPtr DevQueue,
+                                         buffer<T, Dim> &buf) {
   MockHandlerCustomFinalize MockCGH(DevQueue, false);
 
   auto acc = buf.get_access(static_cast<sycl::handler &>(MockCGH));
@@ -33,7 +39,14 @@ detail::Command *CreateTaskCommand(MockScheduler &MS,
   MockCGH.use_kernel_bundle(ExecBundle);
   MockCGH.single_task<TestKernel<>>([] {});
 
-  auto CmdGrp = MockCGH.finalize();
+  return MockCGH.finalize();
+}
+
+template <typename T, int Dim>
+detail::Command *CreateTaskCommand(MockScheduler &MS,
+                                   detail::QueueImplPtr DevQueue,
+                                   buffer<T, Dim> &buf) {
+  auto CmdGrp = CreateTaskCG(DevQueue, buf);
 
   std::vector<detail::Command *> ToEnqueue;
   detail::Command *NewCmd = MS.addCG(std::move(CmdGrp), DevQueue, ToEnqueue);
@@ -148,3 +161,245 @@ TEST_F(SchedulerTest, CancelKernelFusion) {
   EXPECT_TRUE(dependsOnViaEvent(placeHolderCmd, fusionCmd4));
   EXPECT_TRUE(dependsOnViaEvent(placeHolderCmd, fusionCmd1));
 }
+
+TEST_F(SchedulerTest, PromoteUSMProperty) {
+  using promote_usm = ext::codeplay::experimental::property::promote_usm;
+  int Ints[16];
+  float Floats[4];
+  std::vector<promote_usm::allocation> Allocations{
+      {Ints, 16, sizeof(int), promote_usm::target::local_memory},
+      {Floats, 4, sizeof(float), promote_usm::target::private_memory}};
+  property_list Props{ext::codeplay::experimental::property::no_barriers{},
+                      promote_usm{Allocations}};
+
+  // The kind of the property is within the range checked by get_property, so
+  // the allocations can be retrieved from the property list passed to
+  // complete_fusion.
+  EXPECT_LT(promote_usm::getKind(),
+            detail::PropWithDataKind::PropWithDataKindSize);
+  ASSERT_TRUE(Props.has_property<promote_usm>());
+  const auto &Promoted = Props.get_property<promote_usm>().get_allocations();
+  ASSERT_EQ(Promoted.size(), 2u);
+  EXPECT_EQ(Promoted[0].ptr, Ints);
+  EXPECT_EQ(Promoted[0].num_elements, 16u);
+  EXPECT_EQ(Promoted[0].element_size, sizeof(int));
+  EXPECT_EQ(Promoted[0].promotion, promote_usm::target::local_memory);
+  EXPECT_EQ(Promoted[1].ptr, Floats);
+  EXPECT_EQ(Promoted[1].promotion, promote_usm::target::private_memory);
+
+  // The typed constructor derives the element size from the pointer and
+  // defaults to private promotion.
+  property_list TypedProps{promote_usm{Floats, 4}};
+  const auto &Typed = TypedProps.get_property<promote_usm>().get_allocations();
+  ASSERT_EQ(Typed.size(), 1u);
+  EXPECT_EQ(Typed[0].element_size, sizeof(float));
+  EXPECT_EQ(Typed[0].num_elements, 4u);
+  EXPECT_EQ(Typed[0].promotion, promote_usm::target::private_memory);
+
+  EXPECT_FALSE(property_list{}.has_property<promote_usm>());
+}
+
+#if SYCL_EXT_CODEPLAY_KERNEL_FUSION
+TEST_F(SchedulerTest, AutoKernelFusion) {
+  unittest::PiMock Mock;
+  platform Plt = Mock.getPlatform();
+  if (!CheckTestExecRequirements(Plt))
+    return;
+
+  queue QueueDev(context(Plt), default_selector_v,
+                 {property::queue::in_order{},
+                  ext::codeplay::experimental::property::queue::enable_fusion{},
+                  ext::codeplay::experimental::property::queue::auto_fusion{}});
+  MockScheduler MS;
+
+  detail::QueueImplPtr QueueDevImpl = detail::getSyclObjImpl(QueueDev);
+  auto QUniqueID = std::hash<detail::QueueImplPtr>()(QueueDevImpl);
+
+  // Test scenario: Submit a kernel accessing one buffer, which should start an
+  // automatic fusion list. Then submit a kernel accessing an unrelated buffer,
+  // which should close the list. As the list only contains a single kernel, it
+  // is cancelled rather than fused. Last, submit another kernel accessing the
+  // second buffer, which should join the list started for the second kernel.
+
+  buffer<int, 1> b1{range<1>{4}};
+  buffer<int, 1> b2{range<1>{4}};
+
+  std::vector<detail::Command *> ToEnqueue;
+  auto CG1 = CreateTaskCG(QueueDevImpl, b1);
+  EXPECT_TRUE(MS.prepareAutoFusion(*CG1, QueueDevImpl, ToEnqueue));
+  EXPECT_EQ(ToEnqueue.size(), 0u);
+  EXPECT_FALSE(MS.isInFusionMode(QUniqueID));
+  MS.startAutoFusion(QueueDevImpl);
+  auto *Cmd1 = MS.addCG(std::move(CG1), QueueDevImpl, ToEnqueue);
+
+  auto CG2 = CreateTaskCG(QueueDevImpl, b2);
+  EXPECT_TRUE(MS.prepareAutoFusion(*CG2, QueueDevImpl, ToEnqueue));
+  EXPECT_FALSE(MS.isInFusionMode(QUniqueID));
+  // The list filled by cancelFusion should contain the first kernel and the
+  // placeholder command.
+  EXPECT_EQ(ToEnqueue.size(), 2u);
+  EXPECT_TRUE(containsCommand(Cmd1, ToEnqueue));
+
+  ToEnqueue.clear();
+  MS.startAutoFusion(QueueDevImpl);
+  MS.addCG(std::move(CG2), QueueDevImpl, ToEnqueue);
+
+  auto CG3 = CreateTaskCG(QueueDevImpl, b2);
+  EXPECT_TRUE(MS.prepareAutoFusion(*CG3, QueueDevImpl, ToEnqueue));
+  EXPECT_TRUE(MS.isInFusionMode(QUniqueID));
+  EXPECT_EQ(ToEnqueue.size(), 0u);
+  MS.addCG(std::move(CG3), QueueDevImpl, ToEnqueue);
+
+  MS.cancelFusion(QueueDevImpl, ToEnqueue);
+}
+
+TEST_F(SchedulerTest, AutoKernelFusionTeardown) {
+  unittest::PiMock Mock;
+  platform Plt = Mock.getPlatform();
+  if (!CheckTestExecRequirements(Plt))
+    return;
+
+  context Ctx{Plt};
+  queue AutoQueue(
+      Ctx, default_selector_v,
+      {property::queue::in_order{},
+       ext::codeplay::experimental::property::queue::enable_fusion{},
+       ext::codeplay::experimental::property::queue::auto_fusion{}});
+  queue UserQueue(Ctx, default_selector_v);
+  MockScheduler MS;
+
+  detail::QueueImplPtr AutoQueueImpl = detail::getSyclObjImpl(AutoQueue);
+  detail::QueueImplPtr UserQueueImpl = detail::getSyclObjImpl(UserQueue);
+  auto AutoID = std::hash<detail::QueueImplPtr>()(AutoQueueImpl);
+  auto UserID = std::hash<detail::QueueImplPtr>()(UserQueueImpl);
+
+  // Test scenario: Collect a kernel for automatic fusion and one for fusion
+  // started by the user. Closing the automatic fusion lists on teardown
+  // should enqueue the first kernel unfused and leave the user's fusion alone.
+
+  buffer<int, 1> b1{range<1>{4}};
+  buffer<int, 1> b2{range<1>{4}};
+
+  std::vector<detail::Command *> ToEnqueue;
+  auto CG1 = CreateTaskCG(AutoQueueImpl, b1);
+  EXPECT_TRUE(MS.prepareAutoFusion(*CG1, AutoQueueImpl, ToEnqueue));
+  MS.startAutoFusion(AutoQueueImpl);
+  auto *AutoCmd = MS.addCG(std::move(CG1), AutoQueueImpl, ToEnqueue);
+  MS.startFusion(UserQueueImpl);
+  auto *UserCmd = CreateTaskCommand(MS, UserQueueImpl, b2);
+  EXPECT_TRUE(MS.isInFusionMode(AutoID));
+  EXPECT_TRUE(MS.isInFusionMode(UserID));
+
+  ToEnqueue.clear();
+  MS.cancelAutoFusion(ToEnqueue);
+  EXPECT_FALSE(MS.isInFusionMode(AutoID));
+  EXPECT_TRUE(MS.isInFusionMode(UserID));
+  // The kernel and the placeholder command of the automatic fusion list.
+  EXPECT_EQ(ToEnqueue.size(), 2u);
+  EXPECT_TRUE(containsCommand(AutoCmd, ToEnqueue));
+  EXPECT_FALSE(containsCommand(UserCmd, ToEnqueue));
+
+  MS.cancelFusion(UserQueueImpl, ToEnqueue);
+}
+
+TEST_F(SchedulerTest, BackgroundKernelFusion) {
+  unittest::PiMock Mock;
+  platform Plt = Mock.getPlatform();
+  if (!CheckTestExecRequirements(Plt))
+    return;
+
+  // Background compilation relies on the fusion cache.
+  unittest::ScopedEnvVar CachingVar{
+      "SYCL_ENABLE_FUSION_CACHING", "1",
+      detail::SYCLConfig<detail::SYCL_ENABLE_FUSION_CACHING>::reset};
+
+  queue QueueDev(context(Plt), default_selector_v);
+  MockScheduler MS;
+
+  detail::QueueImplPtr QueueDevImpl = detail::getSyclObjImpl(QueueDev);
+
+  // Test scenario: Fuse the same two kernels twice with background
+  // compilation. The fused kernel is not in the JIT cache and the mock device
+  // image cannot be fused, so neither fusion waits for the JIT compiler. Both
+  // fall back to running the kernels unfused, while the first one leaves the
+  // failing compilation to the background thread.
+
+  buffer<int, 1> b1{range<1>{4}};
+  buffer<int, 1> b2{range<1>{4}};
+
+  for (int I = 0; I < 2; ++I) {
+    MS.startFusion(QueueDevImpl);
+    auto *Cmd1 = CreateTaskCommand(MS, QueueDevImpl, b1);
+    auto *Cmd2 = CreateTaskCommand(MS, QueueDevImpl, b2);
+
+    std::vector<detail::Command *> ToEnqueue;
+    MS.completeFusion(
+        QueueDevImpl, ToEnqueue,
+        {ext::codeplay::experimental::property::background_jit{}});
+
+    // The list should contain both kernels and the placeholder command, as
+    // for a cancelled fusion.
+    EXPECT_EQ(ToEnqueue.size(), 3u);
+    EXPECT_TRUE(containsCommand(Cmd1, ToEnqueue));
+    EXPECT_TRUE(containsCommand(Cmd2, ToEnqueue));
+  }
+}
+
+class MockJITCompiler {
+public:
+  static std::mutex &getJITMutex() {
+    return detail::jit_compiler::get_instance().MJITMutex;
+  }
+};
+
+TEST_F(SchedulerTest, BackgroundKernelFusionInProgress) {
+  unittest::PiMock Mock;
+  platform Plt = Mock.getPlatform();
+  if (!CheckTestExecRequirements(Plt))
+    return;
+
+  unittest::ScopedEnvVar CachingVar{
+      "SYCL_ENABLE_FUSION_CACHING", "1",
+      detail::SYCLConfig<detail::SYCL_ENABLE_FUSION_CACHING>::reset};
+
+  queue QueueDev(context(Plt), default_selector_v);
+  MockScheduler MS;
+
+  detail::QueueImplPtr QueueDevImpl = detail::getSyclObjImpl(QueueDev);
+
+  // Test scenario: Hold the lock serializing the JIT compilations, as a long
+  // compilation in the background does. Fusing kernels with background
+  // compilation must not wait for it, but run the kernels unfused right away,
+  // and leave the compilation of the fused kernel to the background thread,
+  // which is blocked until the lock is released.
+
+  buffer<int, 1> b1{range<1>{4}};
+  buffer<int, 1> b2{range<1>{4}};
+  buffer<int, 1> b3{range<1>{4}};
+
+  MS.startFusion(QueueDevImpl);
+  auto *Cmd1 = CreateTaskCommand(MS, QueueDevImpl, b1);
+  auto *Cmd2 = CreateTaskCommand(MS, QueueDevImpl, b2);
+  auto *Cmd3 = CreateTaskCommand(MS, QueueDevImpl, b3);
+
+  std::vector<detail::Command *> ToEnqueue;
+  std::unique_lock<std::mutex> JITLock{MockJITCompiler::getJITMutex()};
+  auto Completed = std::async(std::launch::async, [&] {
+    MS.completeFusion(
+        QueueDevImpl, ToEnqueue,
+        {ext::codeplay::experimental::property::background_jit{}});
+  });
+  bool CompletedWhileCompiling =
+      Completed.wait_for(std::chrono::seconds{30}) == std::future_status::ready;
+  JITLock.unlock();
+  Completed.wait();
+  ASSERT_TRUE(CompletedWhileCompiling);
+
+  // The list should contain the three kernels and the placeholder command, as
+  // for a cancelled fusion.
+  EXPECT_EQ(ToEnqueue.size(), 4u);
+  EXPECT_TRUE(containsCommand(Cmd1, ToEnqueue));
+  EXPECT_TRUE(containsCommand(Cmd2, ToEnqueue));
+  EXPECT_TRUE(containsCommand(Cmd3, ToEnqueue));
+}
+#endif // SYCL_EXT_CODEPLAY_KERNEL_FUSION
@@ -207,6 +207,28 @@ public:
                     std::vector<sycl::detail::Command *> &ToEnqueue) {
     MGraphBuilder.cancelFusion(Queue, ToEnqueue);
   }
+
+  sycl::detail::EventImplPtr
+  completeFusion(sycl::detail::QueueImplPtr Queue,
+                 std::vector<sycl::detail::Command *> &ToEnqueue,
+                 const sycl::property_list &PropList) {
+    return MGraphBuilder.completeFusion(Queue, ToEnqueue, PropList);
+  }
+
+  void startAutoFusion(sycl::detail::QueueImplPtr Queue) {
+    MGraphBuilder.startFusion(Queue, /*IsAutoFusion=*/true);
+  }
+
+  bool prepareAutoFusion(sycl::detail::CG &CommandGroup,
+                         sycl::detail::QueueImplPtr Queue,
+                         std::vector<sycl::detail::Command *> &ToEnqueue) {
+    return MGraphBuilder.prepareAutoFusion(
+        CommandGroup, /*HasAuxiliaryResources=*/false, Queue, ToEnqueue);
+  }
+
+  void cancelAutoFusion(std::vector<sycl::detail::Command *> &ToEnqueue) {
+    MGraphBuilder.cancelAutoFusion(ToEnqueue);
+  }
 };
 
 void addEdge(sycl::detail::Command *User, sycl::detail::Command *Dep,